@@ -6,10 +6,13 @@
 extern "C" {
 #endif
 
+piconsole_program_lcd_back_buffer;
+
 piconsole_program_init
 {
     constexpr static RGB565 color{ color::cyan<RGB565>() };
     LCD_MODEL &lcd{ os.get_lcd() };
+    lcd.set_back_buffer(&_piconsole_program_lcd_back_buffer);
     lcd.fill(color);
     lcd.text("Initializing program...", {
       .x = 8, .y = 8,
@@ -104,24 +107,11 @@ piconsole_program_update
     {
        lcd.rectangle(color::black<RGB565>(), 56, 48, 8, 8); 
     }
-    lcd.show();
+    lcd.flip();
 }
 
 #ifdef __cplusplus
 }
 #endif
 
-int __attribute__((section(".piconsole.program.main"))) main()
-{
-    multicore_fifo_push_blocking(FIFOCodes::program_launch_success);
-    OS& os{ OS::get() };
-    _piconsole_program_init(os);
-    while (true)
-    {
-        const std::uint32_t fifo{ multicore_fifo_pop_blocking() };
-        if (fifo == FIFOCodes::os_updated)
-        {
-            _piconsole_program_update(os);
-        }
-    }
-}
+piconsole_program_main
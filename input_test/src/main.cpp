@@ -117,21 +117,4 @@ piconsole_program_update
 }
 #endif
 
-int __attribute__((section(".piconsole.program.main"))) main()
-{
-    multicore_fifo_push_blocking(FIFOCodes::program_launch_success);
-    OS& os{ OS::get() };
-    if (!os.is_initialized())
-    {
-      os.init();
-    }
-    _piconsole_program_init(os);
-    while (true)
-    {
-        const std::uint32_t fifo{ multicore_fifo_pop_blocking() };
-        if (fifo == FIFOCodes::os_updated)
-        {
-            _piconsole_program_update(os);
-        }
-    }
-}
+piconsole_program_main
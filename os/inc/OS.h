@@ -4,6 +4,8 @@
 #include "debug.h"
 #include "path.h"
 #include "PICOnsole_defines.h"
+#include "frame_pacer.h"
+#include "program_layout.h"
 #include "interfaces/LCD.h"
 #include "interfaces/SD.h"
 #include "interfaces/Speaker.h"
@@ -22,18 +24,38 @@ extern "C"
 #if _PICONSOLE_OS
     extern OS __piconsole_os[];
     extern void* __piconsole_os_end[];
-#elif _PICONSOLE_PROGRAM
-    // TODO: Find a way to link these in from the OS's ELF?
-    OS *__piconsole_os{ reinterpret_cast<OS*>(0x200000c0) };
-    void* __piconsole_os_end { reinterpret_cast<void**>(0x20000468) };
 #endif
 }
 
 class OS {
 public:
+    // What the last load_program() had to do to get the program into flash
+    struct LoadStats
+    {
+        // Where the program was placed; see ProgramSlotIndex
+        std::uint32_t slot_address{ 0u };
+        // Other programs pushed out of flash to make room
+        std::uint32_t slots_evicted{ 0u };
+        // Absolute addresses adjusted to move the program from where it was linked into its slot
+        std::uint32_t relocations_applied{ 0u };
+        // Sectors that already held the program's bytes
+        std::uint32_t sectors_skipped{ 0u };
+        std::uint32_t sectors_erased{ 0u };
+        // Erased sectors that then had pages programmed; a sector the program leaves blank is only erased
+        std::uint32_t sectors_programmed{ 0u };
+        // Bytes of segments read from the SD card, and what they unpacked to; the same unless the ELF was packed
+        std::uint32_t segment_bytes_read{ 0u };
+        std::uint32_t segment_bytes_loaded{ 0u };
+        // The ELF was still resident in its slot, so only the RAM segments were loaded
+        bool was_resident{ false };
+        // The ELF had a LoadManifest, so none of its other headers were read
+        bool from_manifest{ false };
+        std::uint64_t load_time_us{ 0u };
+    };
+
     PICONSOLE_MEMBER_FUNC ~OS() {}
 
-    PICONSOLE_FUNC static OS& get() { return *reinterpret_cast<OS*>(0x200000c0); }
+    PICONSOLE_FUNC static OS& get() { return *reinterpret_cast<OS*>(piconsole_os_address); }
 
     PICONSOLE_MEMBER_FUNC bool init();
     PICONSOLE_MEMBER_FUNC bool uninit(bool cleanly = true);
@@ -54,17 +76,37 @@ public:
     GETTER PICONSOLE_MEMBER_FUNC const Speaker& get_speaker() const { return speaker; }
     GETTER PICONSOLE_MEMBER_FUNC InputMap& get_input() { return input; }
     GETTER PICONSOLE_MEMBER_FUNC const InputMap& get_input() const { return input; }
+    // Target frame rate, catch-up and frame time stats for the running program
+    GETTER PICONSOLE_MEMBER_FUNC FramePacer& get_frame_pacer() { return frame_pacer; }
+    GETTER PICONSOLE_MEMBER_FUNC const FramePacer& get_frame_pacer() const { return frame_pacer; }
 
     GETTER PICONSOLE_MEMBER_FUNC std::string_view get_current_program_path() { return {current_program_path, std::strlen(current_program_path)}; }
     GETTER PICONSOLE_MEMBER_FUNC std::string_view get_current_program_directory() { return path::dir_name(current_program_path); }
 
+    // Loads the ELF at `path` into a slot in program flash and launches it. Programs still resident from an earlier
+    //   load are launched straight from their slot; otherwise the least recently launched programs make room. An ELF
+    //   packed by tools/program_packer.py is unpacked as it's loaded, and loaded from its LoadManifest without
+    //   reading any other headers.
     KEEP virtual bool __no_inline_not_in_flash_func(load_program)(std::string_view path);
+    // Whether the ELF at `path` is still in a slot, unchanged since it was written there, so loading it is quick
+    GETTER PICONSOLE_MEMBER_FUNC bool is_program_resident(const char* path) const;
+    GETTER PICONSOLE_MEMBER_FUNC const LoadStats& get_last_load_stats() const { return last_load_stats; }
     KEEP PICONSOLE_MEMBER_FUNC bool stop_program();
     KEEP PICONSOLE_MEMBER_FUNC void show_program_error(std::string_view message);
     KEEP PICONSOLE_MEMBER_FUNC void show_fatal_program_error(std::string_view message);
+    // Saves what's on screen to `path` as a 16 bit BMP, streamed from the framebuffer a few rows at a time.
+    // Also taken by holding Start and Y together, into screenshot_directory, in the OS or while running a program
+    //   that acknowledges its updates (see FIFOCodes::program_launch_success).
+    KEEP PICONSOLE_MEMBER_FUNC bool capture_screenshot(const char* path);
+
+    constexpr static const char* screenshot_directory{ "/screenshots" };
 
 private:
     PICONSOLE_MEMBER_FUNC void show_color_test();
+    // Reads input and tells the program to run its next update
+    PICONSOLE_MEMBER_FUNC void send_program_update();
+    // Captures a screenshot the moment the screenshot chord goes down
+    PICONSOLE_MEMBER_FUNC void check_screenshot_chord();
     KEEP PICONSOLE_MEMBER_FUNC void show_os_error(std::string_view message);
     KEEP PICONSOLE_MEMBER_FUNC void show_fatal_os_error(std::string_view message);
 
@@ -79,8 +121,27 @@ private:
 #endif
     I2SSpeaker speaker;
     InputMap input;
+    FramePacer frame_pacer;
 
     char current_program_path[SDCard::max_path_length + 1] { 0 };
+    LoadStats last_load_stats{};
+    // Number of the next screenshot file to try
+    std::uint32_t next_screenshot_number{ 0 };
+    bool screenshot_chord_held{ false };
     bool program_running{ false };
+    // Whether the running program pushes program_updated, so the OS knows when core1 is idle
+    bool program_acknowledges_updates{ false };
     bool initialized{ false };
 };
+
+#if _PICONSOLE_PROGRAM
+// Where the OS put itself and the framebuffer, worked out from the OS's size; see program_layout.h
+static_assert(alignof(LCD_MODEL::buffer_type) <= 4u, "The LCD buffer is expected to start at the next 4 byte boundary");
+extern "C"
+{
+    OS *__piconsole_os{ reinterpret_cast<OS*>(piconsole_os_address) };
+    void* __piconsole_os_end { reinterpret_cast<void**>(piconsole_os_address + sizeof(OS)) };
+    std::uint8_t *__piconsole_lcd_buffer { reinterpret_cast<std::uint8_t*>(piconsole_lcd_buffer_address(sizeof(OS))) };
+    void **__piconsole_lcd_buffer_end { reinterpret_cast<void**>(piconsole_lcd_buffer_address(sizeof(OS)) + LCD_MODEL::buffer_size) };
+}
+#endif
@@ -2,15 +2,32 @@
 #include "PICOnsole_defines.h"
 #include "debug.h"
 #include "OS.h"
+#include "lz4.h"
 #include "path.h"
 #include "program.h"
+#include "video_player.h"
 #include "interfaces/Input.h"
 #include "interfaces/LCD.h"
 #include "interfaces/SD.h"
 #include "interfaces/Speaker.h"
 #include "interfaces/Vibrator.h"
+#include "gfx/blend.h"
+#include "gfx/bmp.h"
 #include "gfx/color.h"
+#include "gfx/convert.h"
+#include "gfx/display_list.h"
+#include "gfx/font.h"
+#include "gfx/glyph_blitter.h"
+#include "gfx/indexed_framebuffer.h"
+#include "gfx/post_process.h"
+#include "gfx/qoi.h"
+#include "gfx/region.h"
+#include "gfx/screenshot.h"
+#include "gfx/shapes.h"
 #include "gfx/sprite.h"
+#include "gfx/sprite_atlas.h"
+#include "gfx/strip_renderer.h"
 #include "gfx/text.h"
+#include "gfx/tilemap.h"
 #include "gfx/typeface.h"
-#include "gfx/typefaces/ascii_5px.h"
+#include "gfx/fonts/ascii_5px.h"
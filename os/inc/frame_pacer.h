@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include "PICOnsole_defines.h"
+
+// Decides when the OS sends the program its next update, at a fixed rate instead of as fast as the OS loop spins.
+// Every tick of the target rate is one fixed timestep of program logic. A tick that arrives while the program is
+//   still busy with the last one is a missed deadline; with catch-up, up to get_max_catch_up() missed ticks are run
+//   back to back as soon as the program is free, otherwise they're dropped.
+// The OS core sleeps until the next tick or until something wakes it, and the time both cores spend on each frame
+//   is measured along the way.
+// Programs that don't report finishing their updates (see FIFOCodes::program_launch_success) can't be waited for, so
+//   they're sent one update every tick, or every max_sleep_us when uncapped, with no catch-up.
+class FramePacer
+{
+public:
+    struct Stats
+    {
+        // Ticks of the target rate, including missed ones
+        std::uint32_t ticks{ 0u };
+        // Updates the program has finished; like the program times, only counted for programs that report them
+        std::uint32_t updates{ 0u };
+        // Ticks that came around while the program was still updating
+        std::uint32_t missed_deadlines{ 0u };
+        // Missed ticks that were never run because catch-up was off or already max_catch_up ticks behind
+        std::uint32_t dropped_ticks{ 0u };
+        // Microseconds core1 spent in the last program update, and a running average and the maximum
+        std::uint32_t program_time_us{ 0u };
+        std::uint32_t average_program_time_us{ 0u };
+        std::uint32_t max_program_time_us{ 0u };
+        // Microseconds core0 spent awake in OS::update() over the last tick, not counting interrupts while asleep
+        std::uint32_t os_time_us{ 0u };
+        std::uint32_t average_os_time_us{ 0u };
+        std::uint32_t max_os_time_us{ 0u };
+    };
+
+    constexpr static std::uint32_t default_frame_rate{ 60u };
+    // Longest the OS sleeps when uncapped, so it still gets to things like stopping the vibrator
+    constexpr static std::uint32_t max_sleep_us{ 1'000'000u / default_frame_rate };
+
+    // 0 runs the program uncapped: each update is sent as soon as the last one finishes. Takes effect from the
+    //   next tick.
+    PICONSOLE_MEMBER_FUNC void set_target_frame_rate(std::uint32_t frames_per_second);
+    GETTER PICONSOLE_MEMBER_FUNC std::uint32_t get_target_frame_rate() const { return frame_rate; }
+    GETTER PICONSOLE_MEMBER_FUNC std::uint32_t get_frame_time_us() const { return frame_time_us; }
+    // How many missed ticks may be queued to run back to back; 0 drops them, keeping the game in sync with
+    //   real time only by running slower
+    PICONSOLE_MEMBER_FUNC void set_max_catch_up(std::uint32_t ticks) { max_catch_up = ticks; }
+    GETTER PICONSOLE_MEMBER_FUNC std::uint32_t get_max_catch_up() const { return max_catch_up; }
+
+    GETTER PICONSOLE_MEMBER_FUNC const Stats& get_stats() const { return stats; }
+    PICONSOLE_MEMBER_FUNC void reset_stats() { stats = Stats{}; }
+
+    // OS side
+    // Starts pacing a newly launched program from `now_us`; `acknowledges_updates` if it pushes program_updated
+    PICONSOLE_MEMBER_FUNC void start(std::uint64_t now_us, bool acknowledges_updates);
+    // Call every time the OS wakes; returns true if the program should be sent an update now
+    PICONSOLE_MEMBER_FUNC bool poll(std::uint64_t now_us, bool program_running);
+    // Call when the program reports it finished an update; returns true if it should be sent another now
+    PICONSOLE_MEMBER_FUNC bool on_program_updated(std::uint64_t now_us);
+    // Adds time the OS core was awake to the current tick
+    PICONSOLE_MEMBER_FUNC void add_os_time(std::uint32_t busy_us) { os_busy_us += busy_us; }
+    // When the OS should wake up next if nothing else wakes it first
+    GETTER PICONSOLE_MEMBER_FUNC std::uint64_t get_wake_time(std::uint64_t now_us) const;
+
+private:
+    // Marks an update as sent at `now_us`
+    PICONSOLE_MEMBER_FUNC void send_update(std::uint64_t now_us);
+    // Queues `ticks` missed ticks for catch-up, dropping whatever doesn't fit
+    PICONSOLE_MEMBER_FUNC void queue_missed(std::uint32_t ticks);
+
+    std::uint32_t frame_rate{ default_frame_rate };
+    std::uint32_t frame_time_us{ 1'000'000u / default_frame_rate };
+    std::uint32_t max_catch_up{ 0u };
+    std::uint64_t next_tick_us{ 0u };
+    // Set when the rate changes so the next poll() starts ticking from then rather than from the old schedule
+    bool restart_ticks{ false };
+    // When the update the program is working on was sent
+    std::uint64_t update_sent_us{ 0u };
+    bool update_in_flight{ false };
+    bool program_acknowledges_updates{ true };
+    // Missed ticks still to be run
+    std::uint32_t queued_ticks{ 0u };
+    std::uint32_t os_busy_us{ 0u };
+    Stats stats{};
+};
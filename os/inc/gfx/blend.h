@@ -0,0 +1,256 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/sprite.h"
+
+// Blending of RGB565 pixels in the framebuffer's byte swapped layout.
+// The scalar functions taking and returning RGB565 unpack each channel and are the reference the span kernels match
+//   bit for bit. The span kernels work on two pixels per 32 bit word: one REV16 turns a word of two stored pixels
+//   into two standard RGB565 pixels, whose channels are split between two masks so every channel has room above
+//   it, and a single multiply then weights three channels at once.
+// Alpha is 0-255 and is rounded to one of 33 weights, so 255 is exactly the foreground and 0 exactly the background.
+namespace gfx::blend
+{
+constexpr std::uint32_t max_weight{ 32u };
+
+// Weight out of max_weight for an 8 bit alpha
+GETTER constexpr std::uint32_t to_weight(std::uint8_t alpha)
+{
+    return (static_cast<std::uint32_t>(alpha) + 4u) >> 3;
+}
+// Weight for each 4 bit alpha of a mask, 15 being opaque
+constexpr std::array<std::uint8_t, 16> alpha4_weights{ 0, 2, 4, 6, 9, 11, 13, 15, 17, 19, 21, 23, 26, 28, 30, 32 };
+
+namespace detail
+{
+struct Channels
+{
+    std::uint32_t r;
+    std::uint32_t g;
+    std::uint32_t b;
+};
+
+GETTER constexpr Channels unpack(RGB565 color)
+{
+    const std::uint32_t value{ static_cast<std::uint32_t>(color.data >> 8 | (color.data & 0xFFu) << 8) };
+    return Channels{ .r = value >> 11, .g = (value >> 5) & 0x3Fu, .b = value & 0x1Fu };
+}
+GETTER constexpr RGB565 pack(Channels channels)
+{
+    const std::uint32_t value{ channels.r << 11 | channels.g << 5 | channels.b };
+    return RGB565{ static_cast<std::uint16_t>(value >> 8 | (value & 0xFFu) << 8) };
+}
+
+using gfx::detail::swap_pair_bytes;
+
+// A pair of standard pixels P1:P0 splits into P1.g, P0.r, P0.b and, shifted down 5, P1.r, P1.b, P0.g. Each channel
+//   then has at least 5 spare bits above it, enough for a product with a weight of up to 32 or a carry.
+constexpr std::uint32_t low_mask{ 0x07E0F81Fu };
+constexpr std::uint32_t high_mask{ 0xF81F07E0u };
+// One standard pixel spread over a word as g and r, b
+constexpr std::uint32_t spread_mask{ 0x07E0F81Fu };
+
+// Weights `over` against `under`, both pairs of standard pixels
+GETTER constexpr std::uint32_t mix_pair(std::uint32_t under, std::uint32_t over, std::uint32_t weight)
+{
+    const std::uint32_t inverse{ max_weight - weight };
+    const std::uint32_t low{ ((over & low_mask) * weight + (under & low_mask) * inverse) >> 5 & low_mask };
+    const std::uint32_t high{ (((over & high_mask) >> 5) * weight + ((under & high_mask) >> 5) * inverse) & high_mask };
+    return low | high;
+}
+// Adds two pairs of standard pixels, saturating each channel
+GETTER constexpr std::uint32_t add_pair(std::uint32_t a, std::uint32_t b)
+{
+    const auto add_saturated{
+        [](std::uint32_t x, std::uint32_t y, std::uint32_t mask)
+        {
+            const std::uint32_t sum{ x + y };
+            // Channels that overflowed set the bit above them; smear it down over the 5 or 6 channel bits
+            std::uint32_t overflow{ (sum & ~mask & (mask << 1)) >> 1 };
+            overflow |= overflow >> 1;
+            overflow |= overflow >> 2;
+            overflow |= overflow >> 2;
+            return (sum | overflow) & mask;
+        }
+    };
+    constexpr std::uint32_t shifted_mask{ high_mask >> 5 };
+    return add_saturated(a & low_mask, b & low_mask, low_mask)
+        | add_saturated((a & high_mask) >> 5, (b & high_mask) >> 5, shifted_mask) << 5;
+}
+// Weights one stored pixel against another
+GETTER constexpr std::uint16_t mix_pixel(std::uint16_t under, std::uint16_t over, std::uint32_t weight)
+{
+    const auto spread{
+        [](std::uint16_t stored)
+        {
+            const std::uint32_t value{ static_cast<std::uint32_t>(stored >> 8 | (stored & 0xFFu) << 8) };
+            return (value | value << 16) & spread_mask;
+        }
+    };
+    const std::uint32_t mixed{ (spread(over) * weight + spread(under) * (max_weight - weight)) >> 5 & spread_mask };
+    const std::uint32_t value{ (mixed | mixed >> 16) & 0xFFFFu };
+    return static_cast<std::uint16_t>(value >> 8 | (value & 0xFFu) << 8);
+}
+
+// Runs `blend_pair(under, over)` on pairs of stored pixels, with the destination word aligned, and
+//   `blend_pixel(under, over)` on a leading or trailing odd pixel. `source` may be `destination`.
+template <typename TBlendPair, typename TBlendPixel>
+inline void blend_pixels(std::uint16_t* destination, const std::uint16_t* source, std::size_t count,
+    TBlendPair&& blend_pair, TBlendPixel&& blend_pixel)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if ((reinterpret_cast<std::uintptr_t>(destination) & 0b10u) != 0)
+    {
+        *destination = blend_pixel(*destination, *source++);
+        ++destination;
+        --count;
+    }
+    gfx::detail::pixel_pair_t* out{ reinterpret_cast<gfx::detail::pixel_pair_t*>(destination) };
+    if ((reinterpret_cast<std::uintptr_t>(source) & 0b10u) == 0)
+    {
+        const gfx::detail::pixel_pair_t* in{ reinterpret_cast<const gfx::detail::pixel_pair_t*>(source) };
+        for (; count >= 2; count -= 2)
+        {
+            *out = blend_pair(*out, *in++);
+            ++out;
+        }
+        source = reinterpret_cast<const std::uint16_t*>(in);
+    }
+    else
+    {
+        for (; count >= 2; count -= 2, source += 2)
+        {
+            *out = blend_pair(*out, source[0] | static_cast<std::uint32_t>(source[1]) << 16);
+            ++out;
+        }
+    }
+    if (count != 0)
+    {
+        std::uint16_t* const last{ reinterpret_cast<std::uint16_t*>(out) };
+        *last = blend_pixel(*last, *source);
+    }
+}
+
+GETTER inline std::uint16_t* raw(std::span<RGB565> pixels) { return reinterpret_cast<std::uint16_t*>(pixels.data()); }
+GETTER inline const std::uint16_t* raw(std::span<const RGB565> pixels)
+{
+    return reinterpret_cast<const std::uint16_t*>(pixels.data());
+}
+}
+
+// Reference blends of single pixels
+
+// `over` drawn with `alpha` on top of `under`
+GETTER constexpr RGB565 mix(RGB565 under, RGB565 over, std::uint8_t alpha)
+{
+    const std::uint32_t weight{ to_weight(alpha) };
+    const detail::Channels a{ detail::unpack(under) };
+    const detail::Channels b{ detail::unpack(over) };
+    const auto channel{ [weight](std::uint32_t x, std::uint32_t y) { return (y * weight + x * (max_weight - weight)) >> 5; } };
+    return detail::pack({ .r = channel(a.r, b.r), .g = channel(a.g, b.g), .b = channel(a.b, b.b) });
+}
+// Channels added together, clamped to full brightness; for glows, sparks and flashes
+GETTER constexpr RGB565 add(RGB565 a, RGB565 b)
+{
+    const detail::Channels x{ detail::unpack(a) };
+    const detail::Channels y{ detail::unpack(b) };
+    return detail::pack({ .r = std::min(x.r + y.r, 0x1Fu), .g = std::min(x.g + y.g, 0x3Fu), .b = std::min(x.b + y.b, 0x1Fu) });
+}
+// Channels multiplied together; white leaves the other color unchanged and black gives black. For shadows and tinting.
+GETTER constexpr RGB565 multiply(RGB565 a, RGB565 b)
+{
+    const detail::Channels x{ detail::unpack(a) };
+    const detail::Channels y{ detail::unpack(b) };
+    return detail::pack({ .r = (x.r * y.r + 0x1Fu) >> 5, .g = (x.g * y.g + 0x3Fu) >> 6, .b = (x.b * y.b + 0x1Fu) >> 5 });
+}
+
+// Row kernels. Each blends the first min(destination.size(), source.size()) pixels of `source` onto `destination`;
+//   `source` may be the destination itself.
+
+// Draws `source` with a constant `alpha` over `destination`
+inline void mix(std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha)
+{
+    const std::uint32_t weight{ to_weight(alpha) };
+    detail::blend_pixels(detail::raw(destination), detail::raw(source), std::min(destination.size(), source.size()),
+        [weight](std::uint32_t under, std::uint32_t over)
+        {
+            return detail::swap_pair_bytes(detail::mix_pair(detail::swap_pair_bytes(under), detail::swap_pair_bytes(over), weight));
+        },
+        [weight](std::uint16_t under, std::uint16_t over) { return detail::mix_pixel(under, over, weight); });
+}
+// Draws `source` over `destination` with a 4 bit alpha per pixel, e.g. an anti-aliased or soft edged sprite.
+// `alphas` holds two alphas per byte, the leftmost pixel's in the high nibble like SpriteFormat::Indexed4, and
+//   source[i] uses alpha number `first_alpha + i`.
+inline void mix_masked(std::span<RGB565> destination, std::span<const RGB565> source,
+    std::span<const std::uint8_t> alphas, std::size_t first_alpha = 0)
+{
+    const std::size_t count{ std::min({ destination.size(), source.size(), alphas.size() * 2u - std::min(first_alpha, alphas.size() * 2u) }) };
+    std::uint16_t* const out{ detail::raw(destination) };
+    const std::uint16_t* const in{ detail::raw(source) };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        const std::size_t alpha_index{ first_alpha + i };
+        const std::uint32_t alpha{ (alphas[alpha_index / 2u] >> ((alpha_index & 1u) != 0 ? 0u : 4u)) & 0x0Fu };
+        // Most of a mask is usually fully transparent or fully opaque
+        if (alpha == 0x0Fu)
+        {
+            out[i] = in[i];
+        }
+        else if (alpha != 0u)
+        {
+            out[i] = detail::mix_pixel(out[i], in[i], alpha4_weights[alpha]);
+        }
+    }
+}
+// Adds `source` onto `destination`
+inline void add(std::span<RGB565> destination, std::span<const RGB565> source)
+{
+    detail::blend_pixels(detail::raw(destination), detail::raw(source), std::min(destination.size(), source.size()),
+        [](std::uint32_t under, std::uint32_t over)
+        {
+            return detail::swap_pair_bytes(detail::add_pair(detail::swap_pair_bytes(under), detail::swap_pair_bytes(over)));
+        },
+        [](std::uint16_t under, std::uint16_t over) { return add(RGB565{ under }, RGB565{ over }).data; });
+}
+// Multiplies `destination` by `source`
+inline void multiply(std::span<RGB565> destination, std::span<const RGB565> source)
+{
+    const std::size_t count{ std::min(destination.size(), source.size()) };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        destination[i] = multiply(destination[i], source[i]);
+    }
+}
+// Writes `source` mixed towards `color` by `alpha` to `destination`, e.g. flashing a sprite white when it's hit
+inline void tint(std::span<RGB565> destination, std::span<const RGB565> source, RGB565 color, std::uint8_t alpha)
+{
+    const std::uint32_t weight{ to_weight(alpha) };
+    const std::uint32_t inverse{ max_weight - weight };
+    // The color's half of every mix is the same, so it's weighted once up front
+    const std::uint32_t color_pair{ detail::swap_pair_bytes(color.data | static_cast<std::uint32_t>(color.data) << 16) };
+    const std::uint32_t color_low{ (color_pair & detail::low_mask) * weight };
+    const std::uint32_t color_high{ ((color_pair & detail::high_mask) >> 5) * weight };
+    detail::blend_pixels(detail::raw(destination), detail::raw(source), std::min(destination.size(), source.size()),
+        [=](std::uint32_t, std::uint32_t over)
+        {
+            const std::uint32_t pair{ detail::swap_pair_bytes(over) };
+            const std::uint32_t low{ (color_low + (pair & detail::low_mask) * inverse) >> 5 & detail::low_mask };
+            const std::uint32_t high{ (color_high + ((pair & detail::high_mask) >> 5) * inverse) & detail::high_mask };
+            return detail::swap_pair_bytes(low | high);
+        },
+        [=](std::uint16_t, std::uint16_t over) { return detail::mix_pixel(over, color.data, weight); });
+}
+// Draws `color` with `alpha` over `destination`, e.g. for a translucent panel or a shadow
+inline void fill(std::span<RGB565> destination, RGB565 color, std::uint8_t alpha)
+{
+    tint(destination, destination, color, alpha);
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+
+// 16 bit BMP files in standard RGB565 (BI_BITFIELDS), which is what the framebuffer holds once each pixel's bytes are
+//   swapped back, so an image can be written without converting colors. Rows are stored top-down.
+namespace gfx::bmp
+{
+constexpr std::size_t file_header_size{ 14 };
+constexpr std::size_t info_header_size{ 40 };
+// Red, green and blue masks following the info header
+constexpr std::size_t masks_size{ 12 };
+constexpr std::size_t headers_size{ file_header_size + info_header_size + masks_size };
+// Pixel data starts one SD sector in, the headers padded with zeroes, so every following write is sector aligned
+constexpr std::size_t pixel_data_offset{ 512 };
+static_assert(headers_size <= pixel_data_offset);
+
+// Rows are padded to a multiple of 4 bytes
+GETTER constexpr std::size_t get_row_size(std::size_t width) { return (width * 2u + 3u) & ~std::size_t{ 3u }; }
+GETTER constexpr std::size_t get_file_size(std::size_t width, std::size_t height)
+{
+    return pixel_data_offset + get_row_size(width) * height;
+}
+
+namespace detail
+{
+inline void put_u16(std::uint8_t* out, std::uint32_t value)
+{
+    out[0] = static_cast<std::uint8_t>(value);
+    out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+inline void put_u32(std::uint8_t* out, std::uint32_t value)
+{
+    put_u16(out, value);
+    put_u16(out + 2, value >> 16);
+}
+}
+
+// Writes the headers of a `width` by `height` RGB565 bitmap, padded to pixel_data_offset bytes
+inline void write_rgb565_header(std::span<std::uint8_t, pixel_data_offset> out, std::uint32_t width, std::uint32_t height)
+{
+    std::fill(out.begin(), out.end(), std::uint8_t{ 0u });
+    std::uint8_t* file_header{ out.data() };
+    file_header[0] = 'B';
+    file_header[1] = 'M';
+    detail::put_u32(file_header + 2, static_cast<std::uint32_t>(get_file_size(width, height)));
+    detail::put_u32(file_header + 10, pixel_data_offset);
+
+    std::uint8_t* info_header{ file_header + file_header_size };
+    detail::put_u32(info_header, info_header_size);
+    detail::put_u32(info_header + 4, width);
+    // A negative height means the first row in the file is the top of the image
+    detail::put_u32(info_header + 8, static_cast<std::uint32_t>(-static_cast<std::int32_t>(height)));
+    // Planes, bits per pixel and BI_BITFIELDS compression
+    detail::put_u16(info_header + 12, 1u);
+    detail::put_u16(info_header + 14, 16u);
+    detail::put_u32(info_header + 16, 3u);
+    detail::put_u32(info_header + 20, static_cast<std::uint32_t>(get_row_size(width) * height));
+    // 72 DPI
+    detail::put_u32(info_header + 24, 2835u);
+    detail::put_u32(info_header + 28, 2835u);
+
+    std::uint8_t* masks{ info_header + info_header_size };
+    detail::put_u32(masks, 0xF800u);
+    detail::put_u32(masks + 4, 0x07E0u);
+    detail::put_u32(masks + 8, 0x001Fu);
+}
+}
@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "debug.h"
+#include "gfx/color.h"
+#include "gfx/sprite.h"
+#include "interfaces/SD.h"
+
+// Conversion of whole rows of image pixels into the framebuffer's byte swapped RGB565, for loading images that weren't
+//   prepared for the panel. Rows are read a word at a time and written two pixels per store, so converting a row
+//   costs far less than the RGB565(r, g, b) constructor per pixel and read_pixels() keeps up with the SD card.
+namespace gfx::convert
+{
+enum class PixelFormat : std::uint8_t
+{
+    // Red, green and blue bytes
+    RGB888,
+    // Standard little endian RGB565, as most image tools write it
+    RGB565,
+    // One brightness byte
+    Gray8
+};
+
+GETTER constexpr std::size_t get_bytes_per_pixel(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::RGB888:
+        return 3u;
+    case PixelFormat::RGB565:
+        return 2u;
+    case PixelFormat::Gray8:
+        return 1u;
+    }
+    return 0u;
+}
+
+// Ordered dithering for 8 bit sources: a 4x4 Bayer threshold is added to each channel before it's cut down to 5 or 6
+//   bits, trading banding in gradients for a fine fixed pattern. `x` and `y` are where destination[0] is in the image
+//   so rows converted separately line up.
+struct Dither
+{
+    std::uint32_t x{ 0u };
+    std::uint32_t y{ 0u };
+};
+
+namespace detail
+{
+constexpr std::array<std::array<std::uint8_t, 4>, 4> bayer_4x4{ {
+    { 0, 8, 2, 10 },
+    { 12, 4, 14, 6 },
+    { 3, 11, 1, 9 },
+    { 15, 7, 13, 5 }
+} };
+
+// The stored RGB565 value of an 8 bit per channel color, without going through the standard layout
+GETTER constexpr std::uint32_t to_stored(std::uint32_t r, std::uint32_t g, std::uint32_t b)
+{
+    return (r & 0xF8u) | g >> 5 | (g & 0x1Cu) << 11 | (b & 0xF8u) << 5;
+}
+// to_stored() with `threshold` (0-15) spread over each channel's truncated bits
+GETTER constexpr std::uint32_t to_stored_dithered(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t threshold)
+{
+    return to_stored(std::min(r + (threshold >> 1), 0xFFu), std::min(g + (threshold >> 2), 0xFFu),
+        std::min(b + (threshold >> 1), 0xFFu));
+}
+
+// Writes `count` pixels to `destination` two per store, getting them from `next_pixel()` in order
+template <typename TNextPixel>
+inline void write_pixels(std::uint16_t* destination, std::size_t count, TNextPixel&& next_pixel)
+{
+    if (count != 0 && (reinterpret_cast<std::uintptr_t>(destination) & 0b10u) != 0)
+    {
+        *destination++ = static_cast<std::uint16_t>(next_pixel());
+        --count;
+    }
+    gfx::detail::pixel_pair_t* out{ reinterpret_cast<gfx::detail::pixel_pair_t*>(destination) };
+    for (; count >= 2; count -= 2)
+    {
+        const std::uint32_t first{ next_pixel() };
+        *out++ = first | next_pixel() << 16;
+    }
+    if (count != 0)
+    {
+        *reinterpret_cast<std::uint16_t*>(out) = static_cast<std::uint16_t>(next_pixel());
+    }
+}
+
+GETTER inline bool is_word_aligned(const void* pointer) { return (reinterpret_cast<std::uintptr_t>(pointer) & 0b11u) == 0; }
+}
+
+// Converts RGB888 bytes, three per pixel, to destination.size() pixels or as many as `source` holds
+inline void from_rgb888(std::span<RGB565> destination, std::span<const std::uint8_t> source)
+{
+    std::size_t count{ std::min(destination.size(), source.size() / 3u) };
+    std::uint16_t* out{ reinterpret_cast<std::uint16_t*>(destination.data()) };
+    const std::uint8_t* in{ source.data() };
+    if (detail::is_word_aligned(in) && detail::is_word_aligned(out))
+    {
+        // Four pixels are exactly three words
+        const gfx::detail::pixel_pair_t* words{ reinterpret_cast<const gfx::detail::pixel_pair_t*>(in) };
+        gfx::detail::pixel_pair_t* pairs{ reinterpret_cast<gfx::detail::pixel_pair_t*>(out) };
+        for (; count >= 4; count -= 4, words += 3)
+        {
+            const std::uint32_t a{ words[0] };
+            const std::uint32_t b{ words[1] };
+            const std::uint32_t c{ words[2] };
+            *pairs++ = detail::to_stored(a & 0xFFu, a >> 8 & 0xFFu, a >> 16 & 0xFFu)
+                | detail::to_stored(a >> 24, b & 0xFFu, b >> 8 & 0xFFu) << 16;
+            *pairs++ = detail::to_stored(b >> 16 & 0xFFu, b >> 24, c & 0xFFu)
+                | detail::to_stored(c >> 8 & 0xFFu, c >> 16 & 0xFFu, c >> 24) << 16;
+        }
+        in = reinterpret_cast<const std::uint8_t*>(words);
+        out = reinterpret_cast<std::uint16_t*>(pairs);
+    }
+    detail::write_pixels(out, count,
+        [&in]()
+        {
+            const std::uint32_t pixel{ detail::to_stored(in[0], in[1], in[2]) };
+            in += 3;
+            return pixel;
+        });
+}
+inline void from_rgb888(std::span<RGB565> destination, std::span<const std::uint8_t> source, Dither dither)
+{
+    const std::size_t count{ std::min(destination.size(), source.size() / 3u) };
+    const std::array<std::uint8_t, 4>& thresholds{ detail::bayer_4x4[dither.y & 3u] };
+    const std::uint8_t* in{ source.data() };
+    std::uint32_t x{ dither.x };
+    detail::write_pixels(reinterpret_cast<std::uint16_t*>(destination.data()), count,
+        [&]()
+        {
+            const std::uint32_t pixel{ detail::to_stored_dithered(in[0], in[1], in[2], thresholds[x++ & 3u]) };
+            in += 3;
+            return pixel;
+        });
+}
+
+// Converts standard little endian RGB565 bytes, two per pixel, by swapping each pixel's bytes
+inline void from_rgb565(std::span<RGB565> destination, std::span<const std::uint8_t> source)
+{
+    std::size_t count{ std::min(destination.size(), source.size() / 2u) };
+    std::uint16_t* out{ reinterpret_cast<std::uint16_t*>(destination.data()) };
+    const std::uint8_t* in{ source.data() };
+    if (detail::is_word_aligned(in) && detail::is_word_aligned(out))
+    {
+        const gfx::detail::pixel_pair_t* words{ reinterpret_cast<const gfx::detail::pixel_pair_t*>(in) };
+        gfx::detail::pixel_pair_t* pairs{ reinterpret_cast<gfx::detail::pixel_pair_t*>(out) };
+        for (; count >= 2; count -= 2)
+        {
+            *pairs++ = gfx::detail::swap_pair_bytes(*words++);
+        }
+        in = reinterpret_cast<const std::uint8_t*>(words);
+        out = reinterpret_cast<std::uint16_t*>(pairs);
+    }
+    detail::write_pixels(out, count,
+        [&in]()
+        {
+            const std::uint32_t pixel{ static_cast<std::uint32_t>(in[0]) << 8 | in[1] };
+            in += 2;
+            return pixel;
+        });
+}
+
+// Converts 8 bit grayscale, one byte per pixel
+inline void from_gray8(std::span<RGB565> destination, std::span<const std::uint8_t> source)
+{
+    std::size_t count{ std::min(destination.size(), source.size()) };
+    std::uint16_t* out{ reinterpret_cast<std::uint16_t*>(destination.data()) };
+    const std::uint8_t* in{ source.data() };
+    if (detail::is_word_aligned(in) && detail::is_word_aligned(out))
+    {
+        const gfx::detail::pixel_pair_t* words{ reinterpret_cast<const gfx::detail::pixel_pair_t*>(in) };
+        gfx::detail::pixel_pair_t* pairs{ reinterpret_cast<gfx::detail::pixel_pair_t*>(out) };
+        for (; count >= 4; count -= 4)
+        {
+            const std::uint32_t levels{ *words++ };
+            const auto gray{ [](std::uint32_t level) { return detail::to_stored(level, level, level); } };
+            *pairs++ = gray(levels & 0xFFu) | gray(levels >> 8 & 0xFFu) << 16;
+            *pairs++ = gray(levels >> 16 & 0xFFu) | gray(levels >> 24) << 16;
+        }
+        in = reinterpret_cast<const std::uint8_t*>(words);
+        out = reinterpret_cast<std::uint16_t*>(pairs);
+    }
+    detail::write_pixels(out, count,
+        [&in]()
+        {
+            const std::uint32_t level{ *in++ };
+            return detail::to_stored(level, level, level);
+        });
+}
+inline void from_gray8(std::span<RGB565> destination, std::span<const std::uint8_t> source, Dither dither)
+{
+    const std::size_t count{ std::min(destination.size(), source.size()) };
+    const std::array<std::uint8_t, 4>& thresholds{ detail::bayer_4x4[dither.y & 3u] };
+    const std::uint8_t* in{ source.data() };
+    std::uint32_t x{ dither.x };
+    detail::write_pixels(reinterpret_cast<std::uint16_t*>(destination.data()), count,
+        [&]()
+        {
+            const std::uint32_t level{ *in++ };
+            return detail::to_stored_dithered(level, level, level, thresholds[x++ & 3u]);
+        });
+}
+
+// Converts from any PixelFormat; `dither` is ignored for RGB565, which has nothing to dither
+inline void from_format(PixelFormat format, std::span<RGB565> destination, std::span<const std::uint8_t> source,
+    std::optional<Dither> dither = std::nullopt)
+{
+    switch (format)
+    {
+    case PixelFormat::RGB888:
+        if (dither.has_value())
+        {
+            from_rgb888(destination, source, dither.value());
+        }
+        else
+        {
+            from_rgb888(destination, source);
+        }
+        break;
+    case PixelFormat::RGB565:
+        from_rgb565(destination, source);
+        break;
+    case PixelFormat::Gray8:
+        if (dither.has_value())
+        {
+            from_gray8(destination, source, dither.value());
+        }
+        else
+        {
+            from_gray8(destination, source);
+        }
+        break;
+    }
+}
+
+// Reads destination.size() pixels in `format` from `reader` and converts them as they arrive, through a TChunkSize
+//   byte buffer on the stack instead of a copy of the whole image. The default chunk is three SD sectors, a whole
+//   number of pixels in every format. Images with rows wider than `destination` should be read a row at a time with
+//   the row's dither position.
+template <std::size_t TChunkSize = 1536>
+bool read_pixels(SDCard::FileReader& reader, PixelFormat format, std::span<RGB565> destination,
+    std::optional<Dither> dither = std::nullopt)
+{
+    static_assert(TChunkSize % 12u == 0u, "Chunks need to hold a whole number of pixels in every format");
+    alignas(4) std::array<std::uint8_t, TChunkSize> chunk;
+    const std::size_t bytes_per_pixel{ get_bytes_per_pixel(format) };
+    const std::size_t chunk_pixels{ TChunkSize / bytes_per_pixel };
+    while (!destination.empty())
+    {
+        const std::size_t pixels{ std::min(destination.size(), chunk_pixels) };
+        const std::span<std::uint8_t> bytes{ chunk.data(), pixels * bytes_per_pixel };
+        if (!reader.read_bytes(bytes))
+        {
+            print("convert::read_pixels failed to read %u pixels\n", static_cast<unsigned>(pixels));
+            return false;
+        }
+        from_format(format, destination.first(pixels), bytes, dither);
+        if (dither.has_value())
+        {
+            dither->x += static_cast<std::uint32_t>(pixels);
+        }
+        destination = destination.subspan(pixels);
+    }
+    return true;
+}
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "PICOnsole_defines.h"
+#include "gfx/region.h"
+#include "gfx/shapes.h"
+#include "gfx/sprite.h"
+
+namespace gfx
+{
+// Records drawing calls so they can be replayed later, either straight onto an LCD or strip by strip through a
+//   StripRenderer. Strings and pixel data are referenced rather than copied, so they must outlive the list.
+// Text settings and sprite blits are much bigger than the rest of a command, so they're kept in their own smaller
+//   pools, `TMaxTexts` and `TMaxSpriteBlits` long, and commands refer to them by index. Sprites drawn with the
+//   default blit don't take one.
+template <typename TLCD, std::size_t TMaxCommands = 32, std::size_t TMaxTexts = 8, std::size_t TMaxSpriteBlits = 8>
+class DisplayList
+{
+public:
+    using ColorFormat = typename TLCD::ColorFormat;
+    using TextSettings = typename TLCD::TextSettings;
+    using TextLayout = typename TLCD::TextLayout;
+    constexpr static std::size_t max_commands{ TMaxCommands };
+    constexpr static std::size_t max_texts{ TMaxTexts };
+    constexpr static std::size_t max_sprite_blits{ TMaxSpriteBlits };
+    static_assert(TMaxTexts < 0xFFFFu && TMaxSpriteBlits < 0xFFFFu, "Pool indices are 16 bit");
+    // Command::extra for a sprite drawn with the default blit
+    constexpr static std::uint16_t no_extra{ 0xFFFFu };
+
+    struct Command
+    {
+        enum class Type : std::uint8_t
+        {
+            Fill,
+            Rectangle,
+            FilledRectangle,
+            Text,
+            CenteredText,
+            Layout,
+            Blit,
+            Sprite
+        } type{ Type::Fill };
+        // Index of a text command's settings in the list's text settings, or of a sprite command's blit in its
+        //   sprite blits
+        std::uint16_t extra{ no_extra };
+        ColorFormat color{};
+        Rect rect{};
+        std::string_view string{};
+        std::span<const ColorFormat> pixels{};
+        const TextLayout* layout{ nullptr };
+        const gfx::Sprite* sprite{ nullptr };
+        shapes::Point position{};
+    };
+
+    bool fill(ColorFormat color)
+    {
+        return push(Command{ .type = Command::Type::Fill, .color = color });
+    }
+    bool rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        return push(Command{ .type = Command::Type::Rectangle, .color = color, .rect = make_rect(x, y, width, height) });
+    }
+    bool filled_rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        return push(Command{ .type = Command::Type::FilledRectangle, .color = color, .rect = make_rect(x, y, width, height) });
+    }
+    bool text(std::string_view string, TextSettings settings = {})
+    {
+        return push_text(Command{ .type = Command::Type::Text, .string = string }, settings);
+    }
+    bool centered_text(std::string_view string, TextSettings settings = {})
+    {
+        return push_text(Command{ .type = Command::Type::CenteredText, .string = string }, settings);
+    }
+    // The layout is referenced rather than copied, so it must outlive the list
+    bool text(const TextLayout& layout)
+    {
+        return push(Command{ .type = Command::Type::Layout, .layout = &layout });
+    }
+    bool blit(std::span<const ColorFormat> pixels, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        return push(Command{ .type = Command::Type::Blit, .rect = make_rect(x, y, width, height), .pixels = pixels });
+    }
+    // The sprite is referenced rather than copied, so it must outlive the list
+    bool sprite(const gfx::Sprite& sprite, std::int32_t x, std::int32_t y, const SpriteBlit& blit = {})
+    {
+        Command command{ .type = Command::Type::Sprite, .sprite = &sprite, .position = { x, y } };
+        if (is_default(blit))
+        {
+            return push(command);
+        }
+        if (full() || sprite_blit_count == max_sprite_blits)
+        {
+            return false;
+        }
+        command.extra = static_cast<std::uint16_t>(sprite_blit_count);
+        sprite_blits[sprite_blit_count++] = blit;
+        return push(command);
+    }
+
+    void clear()
+    {
+        count = 0;
+        text_count = 0;
+        sprite_blit_count = 0;
+    }
+    GETTER bool empty() const { return count == 0; }
+    GETTER bool full() const { return count == max_commands; }
+    GETTER std::size_t size() const { return count; }
+    GETTER std::span<const Command> get_commands() const { return { commands.data(), count }; }
+    GETTER const TextSettings& get_text_settings(const Command& command) const { return text_settings[command.extra]; }
+    GETTER SpriteBlit get_sprite_blit(const Command& command) const
+    {
+        return command.extra == no_extra ? SpriteBlit{} : sprite_blits[command.extra];
+    }
+
+    // Replays every command in order onto any target with the same drawing functions as ColorLCD
+    template <typename TTarget>
+    void render(TTarget& target) const
+    {
+        for (const Command& command : get_commands())
+        {
+            const Rect& rect{ command.rect };
+            switch (command.type)
+            {
+            case Command::Type::Fill:
+                target.fill(command.color);
+                break;
+            case Command::Type::Rectangle:
+                target.rectangle(command.color, rect.x, rect.y, rect.width, rect.height);
+                break;
+            case Command::Type::FilledRectangle:
+                target.filled_rectangle(command.color, rect.x, rect.y, rect.width, rect.height);
+                break;
+            case Command::Type::Text:
+                target.text(command.string, get_text_settings(command));
+                break;
+            case Command::Type::CenteredText:
+                target.centered_text(command.string, get_text_settings(command));
+                break;
+            case Command::Type::Layout:
+                target.text(*command.layout);
+                break;
+            case Command::Type::Blit:
+                target.blit(command.pixels, rect.x, rect.y, rect.width, rect.height);
+                break;
+            case Command::Type::Sprite:
+                target.sprite(*command.sprite, command.position.x, command.position.y, get_sprite_blit(command));
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr Rect make_rect(std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        return Rect{
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y),
+            .width = static_cast<std::uint32_t>(width), .height = static_cast<std::uint32_t>(height)
+        };
+    }
+    static bool is_default(const SpriteBlit& blit)
+    {
+        return blit.source.empty() && blit.flip == Flip::None && blit.palette.empty();
+    }
+    bool push_text(Command command, const TextSettings& settings)
+    {
+        if (full() || text_count == max_texts)
+        {
+            return false;
+        }
+        command.extra = static_cast<std::uint16_t>(text_count);
+        text_settings[text_count++] = settings;
+        return push(command);
+    }
+    bool push(const Command& command)
+    {
+        if (full())
+        {
+            return false;
+        }
+        commands[count++] = command;
+        return true;
+    }
+
+    std::array<Command, TMaxCommands> commands{};
+    std::size_t count{ 0 };
+    std::array<TextSettings, TMaxTexts> text_settings{};
+    std::size_t text_count{ 0 };
+    std::array<SpriteBlit, TMaxSpriteBlits> sprite_blits{};
+    std::size_t sprite_blit_count{ 0 };
+};
+}
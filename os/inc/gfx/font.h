@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include "PICOnsole_defines.h"
+
+namespace gfx
+{
+// Metrics of one glyph in a Font and where its bitmap lives
+struct Glyph
+{
+    // Index of the glyph's first row in Font::rows; there is one byte per row of the font, leftmost pixel in bit 7
+    std::uint16_t row_offset{ 0u };
+    // Width of the glyph's bitmap; 0 for glyphs with nothing to draw, which have no rows
+    std::uint8_t width{ 0u };
+    // Distance from this glyph's origin to the next one's
+    std::uint8_t advance{ 0u };
+    // Blank columns between the origin and the bitmap
+    std::uint8_t bearing{ 0u };
+    std::uint8_t reserved{ 0u };
+};
+static_assert(sizeof(Glyph) == 6, "Glyphs are read straight out of font blobs");
+
+inline constexpr Glyph missing_glyph{};
+
+// Compact proportional bitmap font covering every codepoint from `first` to `last`.
+// Fonts are generated by tools/font_compiler.py from BDF files or PNG sheets, either as a constexpr header or as a
+//   blob that can be used in place with from_blob().
+struct Font
+{
+    // Every glyph has this many rows
+    std::uint8_t height{ 0u };
+    // Blank rows between lines
+    std::uint8_t line_spacing{ 1u };
+    char first{ ' ' };
+    char last{ '~' };
+    std::span<const Glyph> glyphs{};
+    std::span<const std::uint8_t> rows{};
+
+    // Font blobs start with this, followed by a version byte
+    constexpr static std::string_view blob_magic{ "PFNT" };
+    constexpr static std::uint8_t blob_version{ 1u };
+    constexpr static std::size_t blob_header_size{ 12u };
+    constexpr static std::uint32_t tab_width{ 4u };
+
+    GETTER constexpr bool contains(char character) const
+    {
+        return static_cast<unsigned char>(character) >= static_cast<unsigned char>(first)
+            && static_cast<unsigned char>(character) <= static_cast<unsigned char>(last);
+    }
+    GETTER constexpr const Glyph& get_glyph(char character) const
+    {
+        if (!contains(character))
+        {
+            return missing_glyph;
+        }
+        return glyphs[static_cast<unsigned char>(character) - static_cast<unsigned char>(first)];
+    }
+    GETTER constexpr bool is_printable(char character) const { return get_glyph(character).width != 0u; }
+    // Characters outside the font take up as much space as a space; tabs take up tab_width spaces
+    GETTER constexpr std::uint32_t get_advance(char character) const
+    {
+        if (character == '\t')
+        {
+            return get_advance(' ') * tab_width;
+        }
+        if (!contains(character))
+        {
+            return contains(' ') ? get_glyph(' ').advance : 0u;
+        }
+        return get_glyph(character).advance;
+    }
+    // Row `row` of the glyph's bitmap, shifted so its leftmost pixel is in the highest of `advance` bits
+    GETTER constexpr std::uint32_t get_cell_row(const Glyph& glyph, std::size_t row) const
+    {
+        if (glyph.width == 0u || row >= height)
+        {
+            return 0u;
+        }
+        return static_cast<std::uint32_t>(rows[glyph.row_offset + row] >> (8u - glyph.width))
+            << (glyph.advance - glyph.bearing - glyph.width);
+    }
+    GETTER constexpr std::uint32_t get_line_height() const { return height + line_spacing; }
+    // Width of a single line of text, including the last glyph's advance
+    GETTER constexpr std::uint32_t get_string_width(std::string_view string) const
+    {
+        std::uint32_t width{ 0u };
+        for (char character : string)
+        {
+            width += get_advance(character);
+        }
+        return width;
+    }
+
+    // Uses a blob written by tools/font_compiler.py in place, so the blob must outlive the font.
+    // Returns nothing if the blob is malformed or not 2 byte aligned.
+    GETTER static std::optional<Font> from_blob(std::span<const std::uint8_t> blob)
+    {
+        if (blob.size() < blob_header_size
+            || reinterpret_cast<std::uintptr_t>(blob.data()) % alignof(Glyph) != 0
+            || std::string_view{ reinterpret_cast<const char*>(blob.data()), blob_magic.size() } != blob_magic
+            || blob[4] != blob_version)
+        {
+            return std::nullopt;
+        }
+        Font font{ .height = blob[5], .line_spacing = blob[6], .first = static_cast<char>(blob[7]), .last = static_cast<char>(blob[8]) };
+        const std::size_t row_count{ static_cast<std::size_t>(blob[10] | blob[11] << 8) };
+        if (static_cast<unsigned char>(font.last) < static_cast<unsigned char>(font.first))
+        {
+            return std::nullopt;
+        }
+        const std::size_t glyph_count{ static_cast<std::size_t>(blob[8] - blob[7] + 1) };
+        if (blob.size() < blob_header_size + glyph_count * sizeof(Glyph) + row_count)
+        {
+            return std::nullopt;
+        }
+        font.glyphs = { reinterpret_cast<const Glyph*>(blob.data() + blob_header_size), glyph_count };
+        font.rows = blob.subspan(blob_header_size + glyph_count * sizeof(Glyph), row_count);
+        for (const Glyph& glyph : font.glyphs)
+        {
+            if (glyph.width > 8u || glyph.bearing + glyph.width > glyph.advance
+                || (glyph.width != 0u && glyph.row_offset + font.height > row_count))
+            {
+                return std::nullopt;
+            }
+        }
+        return font;
+    }
+};
+
+// The OS's built in 5px font
+const Font& get_ascii_font();
+}
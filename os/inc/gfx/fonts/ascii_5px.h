@@ -0,0 +1,207 @@
+#pragma once
+// Generated by tools/font_compiler.py from ascii_5px.bdf; regenerate rather than editing by hand
+#include <array>
+#include <cstdint>
+#include "gfx/font.h"
+
+namespace gfx::fonts
+{
+constexpr inline std::array<Glyph, 95> ascii_5px_glyphs{ {
+    { .row_offset = 0, .width = 0, .advance = 6, .bearing = 0 }, // space
+    { .row_offset = 0, .width = 1, .advance = 6, .bearing = 1 }, // !
+    { .row_offset = 5, .width = 3, .advance = 6, .bearing = 1 }, // "
+    { .row_offset = 10, .width = 5, .advance = 6, .bearing = 0 }, // #
+    { .row_offset = 15, .width = 5, .advance = 6, .bearing = 0 }, // $
+    { .row_offset = 20, .width = 5, .advance = 6, .bearing = 0 }, // %
+    { .row_offset = 25, .width = 5, .advance = 6, .bearing = 0 }, // &
+    { .row_offset = 30, .width = 1, .advance = 6, .bearing = 2 }, // '
+    { .row_offset = 35, .width = 2, .advance = 6, .bearing = 1 }, // (
+    { .row_offset = 40, .width = 2, .advance = 6, .bearing = 2 }, // )
+    { .row_offset = 45, .width = 5, .advance = 6, .bearing = 0 }, // *
+    { .row_offset = 50, .width = 5, .advance = 6, .bearing = 0 }, // +
+    { .row_offset = 55, .width = 2, .advance = 6, .bearing = 1 }, // ,
+    { .row_offset = 60, .width = 5, .advance = 6, .bearing = 0 }, // -
+    { .row_offset = 65, .width = 2, .advance = 6, .bearing = 1 }, // .
+    { .row_offset = 70, .width = 5, .advance = 6, .bearing = 0 }, // /
+    { .row_offset = 75, .width = 4, .advance = 6, .bearing = 0 }, // 0
+    { .row_offset = 80, .width = 4, .advance = 6, .bearing = 0 }, // 1
+    { .row_offset = 85, .width = 4, .advance = 6, .bearing = 0 }, // 2
+    { .row_offset = 90, .width = 4, .advance = 6, .bearing = 0 }, // 3
+    { .row_offset = 95, .width = 4, .advance = 6, .bearing = 0 }, // 4
+    { .row_offset = 100, .width = 4, .advance = 6, .bearing = 0 }, // 5
+    { .row_offset = 105, .width = 4, .advance = 6, .bearing = 0 }, // 6
+    { .row_offset = 110, .width = 4, .advance = 6, .bearing = 0 }, // 7
+    { .row_offset = 115, .width = 4, .advance = 6, .bearing = 0 }, // 8
+    { .row_offset = 120, .width = 4, .advance = 6, .bearing = 0 }, // 9
+    { .row_offset = 125, .width = 2, .advance = 6, .bearing = 1 }, // :
+    { .row_offset = 130, .width = 2, .advance = 6, .bearing = 1 }, // ;
+    { .row_offset = 135, .width = 5, .advance = 6, .bearing = 0 }, // <
+    { .row_offset = 140, .width = 5, .advance = 6, .bearing = 0 }, // =
+    { .row_offset = 145, .width = 5, .advance = 6, .bearing = 0 }, // >
+    { .row_offset = 150, .width = 5, .advance = 6, .bearing = 0 }, // ?
+    { .row_offset = 155, .width = 5, .advance = 6, .bearing = 0 }, // @
+    { .row_offset = 160, .width = 5, .advance = 6, .bearing = 0 }, // A
+    { .row_offset = 165, .width = 5, .advance = 6, .bearing = 0 }, // B
+    { .row_offset = 170, .width = 5, .advance = 6, .bearing = 0 }, // C
+    { .row_offset = 175, .width = 5, .advance = 6, .bearing = 0 }, // D
+    { .row_offset = 180, .width = 5, .advance = 6, .bearing = 0 }, // E
+    { .row_offset = 185, .width = 5, .advance = 6, .bearing = 0 }, // F
+    { .row_offset = 190, .width = 5, .advance = 6, .bearing = 0 }, // G
+    { .row_offset = 195, .width = 5, .advance = 6, .bearing = 0 }, // H
+    { .row_offset = 200, .width = 5, .advance = 6, .bearing = 0 }, // I
+    { .row_offset = 205, .width = 5, .advance = 6, .bearing = 0 }, // J
+    { .row_offset = 210, .width = 5, .advance = 6, .bearing = 0 }, // K
+    { .row_offset = 215, .width = 5, .advance = 6, .bearing = 0 }, // L
+    { .row_offset = 220, .width = 5, .advance = 6, .bearing = 0 }, // M
+    { .row_offset = 225, .width = 5, .advance = 6, .bearing = 0 }, // N
+    { .row_offset = 230, .width = 5, .advance = 6, .bearing = 0 }, // O
+    { .row_offset = 235, .width = 5, .advance = 6, .bearing = 0 }, // P
+    { .row_offset = 240, .width = 5, .advance = 6, .bearing = 0 }, // Q
+    { .row_offset = 245, .width = 5, .advance = 6, .bearing = 0 }, // R
+    { .row_offset = 250, .width = 5, .advance = 6, .bearing = 0 }, // S
+    { .row_offset = 255, .width = 5, .advance = 6, .bearing = 0 }, // T
+    { .row_offset = 260, .width = 5, .advance = 6, .bearing = 0 }, // U
+    { .row_offset = 265, .width = 5, .advance = 6, .bearing = 0 }, // V
+    { .row_offset = 270, .width = 5, .advance = 6, .bearing = 0 }, // W
+    { .row_offset = 275, .width = 5, .advance = 6, .bearing = 0 }, // X
+    { .row_offset = 280, .width = 5, .advance = 6, .bearing = 0 }, // Y
+    { .row_offset = 285, .width = 5, .advance = 6, .bearing = 0 }, // Z
+    { .row_offset = 290, .width = 2, .advance = 6, .bearing = 1 }, // [
+    { .row_offset = 295, .width = 5, .advance = 6, .bearing = 0 }, // backslash
+    { .row_offset = 300, .width = 2, .advance = 6, .bearing = 2 }, // ]
+    { .row_offset = 305, .width = 5, .advance = 6, .bearing = 0 }, // ^
+    { .row_offset = 310, .width = 5, .advance = 6, .bearing = 0 }, // _
+    { .row_offset = 315, .width = 3, .advance = 6, .bearing = 1 }, // `
+    { .row_offset = 320, .width = 5, .advance = 6, .bearing = 0 }, // a
+    { .row_offset = 325, .width = 4, .advance = 6, .bearing = 0 }, // b
+    { .row_offset = 330, .width = 4, .advance = 6, .bearing = 0 }, // c
+    { .row_offset = 335, .width = 4, .advance = 6, .bearing = 1 }, // d
+    { .row_offset = 340, .width = 5, .advance = 6, .bearing = 0 }, // e
+    { .row_offset = 345, .width = 4, .advance = 6, .bearing = 0 }, // f
+    { .row_offset = 350, .width = 4, .advance = 6, .bearing = 0 }, // g
+    { .row_offset = 355, .width = 5, .advance = 6, .bearing = 0 }, // h
+    { .row_offset = 360, .width = 1, .advance = 6, .bearing = 1 }, // i
+    { .row_offset = 365, .width = 4, .advance = 6, .bearing = 0 }, // j
+    { .row_offset = 370, .width = 3, .advance = 6, .bearing = 0 }, // k
+    { .row_offset = 375, .width = 2, .advance = 6, .bearing = 1 }, // l
+    { .row_offset = 380, .width = 5, .advance = 6, .bearing = 0 }, // m
+    { .row_offset = 385, .width = 4, .advance = 6, .bearing = 0 }, // n
+    { .row_offset = 390, .width = 4, .advance = 6, .bearing = 0 }, // o
+    { .row_offset = 395, .width = 4, .advance = 6, .bearing = 0 }, // p
+    { .row_offset = 400, .width = 4, .advance = 6, .bearing = 0 }, // q
+    { .row_offset = 405, .width = 4, .advance = 6, .bearing = 0 }, // r
+    { .row_offset = 410, .width = 4, .advance = 6, .bearing = 0 }, // s
+    { .row_offset = 415, .width = 3, .advance = 6, .bearing = 0 }, // t
+    { .row_offset = 420, .width = 4, .advance = 6, .bearing = 0 }, // u
+    { .row_offset = 425, .width = 5, .advance = 6, .bearing = 0 }, // v
+    { .row_offset = 430, .width = 5, .advance = 6, .bearing = 0 }, // w
+    { .row_offset = 435, .width = 4, .advance = 6, .bearing = 0 }, // x
+    { .row_offset = 440, .width = 4, .advance = 6, .bearing = 0 }, // y
+    { .row_offset = 445, .width = 4, .advance = 6, .bearing = 0 }, // z
+    { .row_offset = 450, .width = 3, .advance = 6, .bearing = 0 }, // {
+    { .row_offset = 455, .width = 1, .advance = 6, .bearing = 2 }, // |
+    { .row_offset = 460, .width = 3, .advance = 6, .bearing = 2 }, // }
+    { .row_offset = 465, .width = 5, .advance = 6, .bearing = 0 }, // ~
+} };
+constexpr inline std::array<std::uint8_t, 470> ascii_5px_rows{ {
+    0b10000000, 0b10000000, 0b10000000, 0b00000000, 0b10000000, // !
+    0b10100000, 0b10100000, 0b00000000, 0b00000000, 0b00000000, // "
+    0b01010000, 0b11111000, 0b01010000, 0b11111000, 0b01010000, // #
+    0b01111000, 0b10100000, 0b01110000, 0b00101000, 0b11110000, // $
+    0b11001000, 0b10010000, 0b00100000, 0b01001000, 0b10011000, // %
+    0b00100000, 0b01010000, 0b01100000, 0b10011000, 0b01101000, // &
+    0b10000000, 0b10000000, 0b00000000, 0b00000000, 0b00000000, // '
+    0b01000000, 0b10000000, 0b10000000, 0b10000000, 0b01000000, // (
+    0b10000000, 0b01000000, 0b01000000, 0b01000000, 0b10000000, // )
+    0b00100000, 0b10101000, 0b01110000, 0b01010000, 0b10001000, // *
+    0b00100000, 0b00100000, 0b11111000, 0b00100000, 0b00100000, // +
+    0b00000000, 0b00000000, 0b00000000, 0b01000000, 0b10000000, // ,
+    0b00000000, 0b00000000, 0b11111000, 0b00000000, 0b00000000, // -
+    0b00000000, 0b00000000, 0b00000000, 0b11000000, 0b11000000, // .
+    0b00001000, 0b00010000, 0b00100000, 0b01000000, 0b10000000, // /
+    0b01100000, 0b10010000, 0b10010000, 0b10010000, 0b01100000, // 0
+    0b01100000, 0b10100000, 0b00100000, 0b00100000, 0b11110000, // 1
+    0b01100000, 0b10010000, 0b00100000, 0b01000000, 0b11110000, // 2
+    0b01100000, 0b10010000, 0b00100000, 0b10010000, 0b01100000, // 3
+    0b10100000, 0b10100000, 0b11110000, 0b00100000, 0b00100000, // 4
+    0b11110000, 0b10000000, 0b11100000, 0b00010000, 0b11100000, // 5
+    0b01100000, 0b10000000, 0b11100000, 0b10010000, 0b01100000, // 6
+    0b11110000, 0b00100000, 0b00100000, 0b01000000, 0b01000000, // 7
+    0b01100000, 0b10010000, 0b01100000, 0b10010000, 0b01100000, // 8
+    0b01100000, 0b10010000, 0b01110000, 0b00010000, 0b11100000, // 9
+    0b11000000, 0b11000000, 0b00000000, 0b11000000, 0b11000000, // :
+    0b11000000, 0b11000000, 0b00000000, 0b01000000, 0b10000000, // ;
+    0b00011000, 0b01100000, 0b10000000, 0b01100000, 0b00011000, // <
+    0b00000000, 0b11111000, 0b00000000, 0b11111000, 0b00000000, // =
+    0b11000000, 0b00110000, 0b00001000, 0b00110000, 0b11000000, // >
+    0b01110000, 0b10001000, 0b00110000, 0b00000000, 0b00100000, // ?
+    0b01110000, 0b10101000, 0b10111000, 0b10000000, 0b01110000, // @
+    0b00100000, 0b01010000, 0b01110000, 0b10001000, 0b10001000, // A
+    0b11100000, 0b10010000, 0b11110000, 0b10001000, 0b11110000, // B
+    0b01110000, 0b10001000, 0b10000000, 0b10001000, 0b01110000, // C
+    0b11100000, 0b10010000, 0b10001000, 0b10001000, 0b11110000, // D
+    0b11111000, 0b10000000, 0b11110000, 0b10000000, 0b11111000, // E
+    0b11111000, 0b10000000, 0b11110000, 0b10000000, 0b10000000, // F
+    0b01110000, 0b10000000, 0b10011000, 0b10001000, 0b01110000, // G
+    0b10001000, 0b10001000, 0b11111000, 0b10001000, 0b10001000, // H
+    0b11111000, 0b00100000, 0b00100000, 0b00100000, 0b11111000, // I
+    0b11111000, 0b00001000, 0b00001000, 0b10001000, 0b01110000, // J
+    0b10001000, 0b10010000, 0b10100000, 0b11010000, 0b10001000, // K
+    0b10000000, 0b10000000, 0b10000000, 0b10000000, 0b11111000, // L
+    0b10001000, 0b11011000, 0b10101000, 0b10001000, 0b10001000, // M
+    0b10001000, 0b11001000, 0b10101000, 0b10011000, 0b10001000, // N
+    0b01110000, 0b10001000, 0b10001000, 0b10001000, 0b01110000, // O
+    0b11110000, 0b10001000, 0b11110000, 0b10000000, 0b10000000, // P
+    0b01110000, 0b10001000, 0b10001000, 0b10011000, 0b01111000, // Q
+    0b11110000, 0b10001000, 0b11110000, 0b10010000, 0b10001000, // R
+    0b01111000, 0b10000000, 0b01110000, 0b00001000, 0b11110000, // S
+    0b11111000, 0b00100000, 0b00100000, 0b00100000, 0b00100000, // T
+    0b10001000, 0b10001000, 0b10001000, 0b10001000, 0b01110000, // U
+    0b10001000, 0b10001000, 0b01010000, 0b01010000, 0b00100000, // V
+    0b10001000, 0b10001000, 0b10101000, 0b10101000, 0b01010000, // W
+    0b10001000, 0b01010000, 0b00100000, 0b01010000, 0b10001000, // X
+    0b10001000, 0b01010000, 0b00100000, 0b00100000, 0b00100000, // Y
+    0b11111000, 0b00010000, 0b00100000, 0b01000000, 0b11111000, // Z
+    0b11000000, 0b10000000, 0b10000000, 0b10000000, 0b11000000, // [
+    0b10000000, 0b01000000, 0b00100000, 0b00010000, 0b00001000, // backslash
+    0b11000000, 0b01000000, 0b01000000, 0b01000000, 0b11000000, // ]
+    0b00100000, 0b01010000, 0b10001000, 0b00000000, 0b00000000, // ^
+    0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b11111000, // _
+    0b10000000, 0b01000000, 0b00100000, 0b00000000, 0b00000000, // `
+    0b11100000, 0b00010000, 0b01110000, 0b10010000, 0b11101000, // a
+    0b10000000, 0b10000000, 0b11100000, 0b10010000, 0b11100000, // b
+    0b00000000, 0b01110000, 0b10000000, 0b10000000, 0b01110000, // c
+    0b00010000, 0b00010000, 0b01110000, 0b10010000, 0b01110000, // d
+    0b00000000, 0b01110000, 0b11111000, 0b10000000, 0b01110000, // e
+    0b00110000, 0b01000000, 0b11110000, 0b01000000, 0b01000000, // f
+    0b01100000, 0b10010000, 0b01110000, 0b00010000, 0b01100000, // g
+    0b10000000, 0b10000000, 0b11110000, 0b10001000, 0b10001000, // h
+    0b10000000, 0b00000000, 0b10000000, 0b10000000, 0b10000000, // i
+    0b00010000, 0b00000000, 0b00010000, 0b10010000, 0b01100000, // j
+    0b00000000, 0b10000000, 0b10100000, 0b11000000, 0b10100000, // k
+    0b10000000, 0b10000000, 0b10000000, 0b10000000, 0b11000000, // l
+    0b00000000, 0b11010000, 0b10101000, 0b10101000, 0b10101000, // m
+    0b00000000, 0b11100000, 0b10010000, 0b10010000, 0b10010000, // n
+    0b00000000, 0b01100000, 0b10010000, 0b10010000, 0b01100000, // o
+    0b00000000, 0b11100000, 0b10010000, 0b11100000, 0b10000000, // p
+    0b00000000, 0b01110000, 0b10010000, 0b01110000, 0b00010000, // q
+    0b00000000, 0b10100000, 0b11010000, 0b10000000, 0b10000000, // r
+    0b01110000, 0b10000000, 0b01100000, 0b00010000, 0b11100000, // s
+    0b01000000, 0b11100000, 0b01000000, 0b01000000, 0b00100000, // t
+    0b00000000, 0b10010000, 0b10010000, 0b10010000, 0b01110000, // u
+    0b00000000, 0b10001000, 0b10001000, 0b01010000, 0b00100000, // v
+    0b00000000, 0b10001000, 0b10001000, 0b10101000, 0b01010000, // w
+    0b00000000, 0b10010000, 0b01100000, 0b01100000, 0b10010000, // x
+    0b00000000, 0b10010000, 0b01100000, 0b00100000, 0b11000000, // y
+    0b00000000, 0b11110000, 0b00100000, 0b01000000, 0b11110000, // z
+    0b01100000, 0b01000000, 0b10000000, 0b01000000, 0b01100000, // {
+    0b10000000, 0b10000000, 0b10000000, 0b10000000, 0b10000000, // |
+    0b11000000, 0b01000000, 0b00100000, 0b01000000, 0b11000000, // }
+    0b00000000, 0b00000000, 0b01001000, 0b10110000, 0b00000000, // ~
+} };
+constexpr inline Font ascii_5px{
+    .height = 5, .line_spacing = 1,
+    .first = static_cast<char>(32), .last = static_cast<char>(126),
+    .glyphs = ascii_5px_glyphs, .rows = ascii_5px_rows
+};
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/font.h"
+
+namespace gfx::text
+{
+// Draws text rows straight into RGB565 pixel rows from a Font.
+// Glyph bits are consumed two at a time and looked up in a 4 entry table of pre-built pixel pairs, so every two
+//   pixels cost one 32 bit store. Opaque text writes foreground and background together in that same store.
+class GlyphBlitter
+{
+public:
+    constexpr GlyphBlitter(RGB565 color, std::optional<RGB565> background = std::nullopt)
+        : color{ color.data }, background{ background.value_or(RGB565{}).data }, opaque{ background.has_value() }
+    {
+        for (std::uint32_t pair{ 0u }; pair < pairs.size(); ++pair)
+        {
+            // The first pixel is at the lower address, which is the low half of a little endian word
+            pairs[pair] = get_pixel(pair & 0b10u) | static_cast<std::uint32_t>(get_pixel(pair & 0b01u)) << 16;
+        }
+    }
+
+    // Draws row `glyph_row` of every character in `string` into `pixels`, each character taking up its advance.
+    //   Rows past the font's height are blank line spacing. The first `skip` pixels of the row are left out and
+    //   drawing stops once `pixels` is full.
+    void draw_row(std::span<RGB565> pixels, std::string_view string, std::size_t glyph_row, const Font& font,
+        std::size_t skip = 0) const
+    {
+        Writer writer{ *this, pixels, skip };
+        for (char character : string)
+        {
+            if (character == '\t')
+            {
+                // Pushed a space at a time so no more than 24 bits are ever pending
+                for (std::size_t i{ 0 }; i < Font::tab_width; ++i)
+                {
+                    writer.push(0u, font.get_advance(' '));
+                }
+            }
+            else
+            {
+                writer.push(font.get_cell_row(font.get_glyph(character), glyph_row), font.get_advance(character));
+            }
+            if (writer.full())
+            {
+                return;
+            }
+        }
+        writer.flush();
+    }
+
+    constexpr RGB565 get_color() const { return RGB565{ color }; }
+
+    // Fills `pixels` with the background color
+    void fill(std::span<RGB565> pixels) const
+    {
+        if (!opaque)
+        {
+            return;
+        }
+        Writer writer{ *this, pixels };
+        while (!writer.full())
+        {
+            writer.push(0u, 16u);
+        }
+    }
+
+private:
+    using word_t = std::uint32_t __attribute__((may_alias));
+
+    // Streams bits out to pixels, writing single pixels only to reach word alignment or at the very end
+    class Writer
+    {
+    public:
+        Writer(const GlyphBlitter& blitter, std::span<RGB565> pixels, std::size_t skip = 0)
+            : blitter{ blitter }, out{ reinterpret_cast<std::uint16_t*>(pixels.data()) }, remaining{ pixels.size() },
+            skip{ skip }
+        {}
+
+        bool full() const { return remaining == 0; }
+
+        // Appends the low `count` bits of `new_bits`, first pixel in the highest bit
+        void push(std::uint32_t new_bits, std::uint32_t count)
+        {
+            bits = bits << count | new_bits;
+            bit_count += count;
+            for (; skip > 0 && bit_count > 0; --skip)
+            {
+                next_bits(1);
+            }
+            if ((reinterpret_cast<std::uintptr_t>(out) & 0b10u) != 0 && bit_count > 0 && remaining > 0)
+            {
+                write_single(next_bits(1));
+            }
+            while (bit_count >= 2 && remaining >= 2)
+            {
+                write_pair(next_bits(2));
+            }
+            if (remaining == 1 && bit_count >= 1)
+            {
+                write_single(next_bits(1));
+            }
+        }
+        // Writes a leftover odd pixel
+        void flush()
+        {
+            if (bit_count > 0 && remaining > 0)
+            {
+                write_single(next_bits(1));
+            }
+        }
+
+    private:
+        std::uint32_t next_bits(std::uint32_t count)
+        {
+            bit_count -= count;
+            return (bits >> bit_count) & ((1u << count) - 1u);
+        }
+        void write_single(std::uint32_t bit)
+        {
+            if (bit != 0 || blitter.opaque)
+            {
+                *out = blitter.get_pixel(bit);
+            }
+            ++out;
+            --remaining;
+        }
+        void write_pair(std::uint32_t pair)
+        {
+            if (blitter.opaque || pair == 0b11u)
+            {
+                *reinterpret_cast<word_t*>(out) = blitter.pairs[pair];
+            }
+            else if (pair == 0b10u)
+            {
+                out[0] = blitter.color;
+            }
+            else if (pair == 0b01u)
+            {
+                out[1] = blitter.color;
+            }
+            out += 2;
+            remaining -= 2;
+        }
+
+        const GlyphBlitter& blitter;
+        std::uint16_t* out;
+        std::size_t remaining;
+        std::size_t skip;
+        std::uint32_t bits{ 0u };
+        std::uint32_t bit_count{ 0u };
+    };
+
+    constexpr std::uint16_t get_pixel(std::uint32_t bit) const { return bit != 0 ? color : background; }
+
+    std::uint16_t color;
+    std::uint16_t background;
+    bool opaque;
+    std::array<std::uint32_t, 4> pairs{};
+};
+}
@@ -0,0 +1,329 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/region.h"
+#include "gfx/shapes.h"
+#include "gfx/sprite.h"
+#include "gfx/text.h"
+
+namespace gfx
+{
+// Color of an IndexedFramebuffer pixel: an entry in its palette.
+// The color:: helpers' grey levels become indices, so black is entry 0 and white is the last entry.
+struct PaletteIndex : public ColorFormat
+{
+    std::uint8_t index{ 0u };
+
+    constexpr PaletteIndex() = default;
+    constexpr PaletteIndex(std::uint8_t index) : index{ index } {}
+
+    constexpr bool operator==(const PaletteIndex&) const = default;
+};
+
+// Everything an LCD needs to stream an indexed framebuffer; see SPILCD::present_indexed()
+struct IndexedFrame
+{
+    const std::uint8_t* pixels{ nullptr };
+    // Bytes per row
+    std::size_t stride{ 0 };
+    SpriteFormat format{ SpriteFormat::Indexed8 };
+    std::span<const RGB565> palette{};
+    // Areas to send; each is expanded to RGB565 a row at a time while the previous row is going out over SPI
+    std::span<const Rect> regions{};
+};
+
+// Framebuffer of 8 or 4 bit palette indices, half or a quarter the size of an RGB565 one, that the LCD expands to
+//   RGB565 as it's sent. Programs own it, in place of the OS's RGB565 framebuffer, and draw to it much like a
+//   ColorLCD. Changing the palette resends the whole screen without redrawing anything, which makes fades and
+//   flashes cheap.
+// Don't draw to it or change its palette while the LCD is presenting it.
+template <SpriteFormat TFormat, std::size_t TWidth, std::size_t THeight>
+class IndexedFramebuffer
+{
+public:
+    static_assert(TFormat == SpriteFormat::Indexed8 || TFormat == SpriteFormat::Indexed4);
+    using ColorFormat = PaletteIndex;
+    constexpr static SpriteFormat format{ TFormat };
+    constexpr static std::size_t width{ TWidth };
+    constexpr static std::size_t height{ THeight };
+    constexpr static std::size_t stride{ Sprite::get_stride(TFormat, TWidth) };
+    constexpr static std::size_t buffer_size{ stride * THeight };
+    constexpr static std::size_t palette_size{ TFormat == SpriteFormat::Indexed8 ? 256u : 16u };
+    constexpr static std::uint8_t index_mask{ static_cast<std::uint8_t>(palette_size - 1u) };
+    constexpr static std::size_t max_dirty_regions{ 8 };
+    using DirtyRegions = gfx::DirtyRegions<max_dirty_regions>;
+    using TextSettings = text::PrintSettings<IndexedFramebuffer>;
+    using TextLayout = text::TextLayout<IndexedFramebuffer, text::get_max_text_lines<THeight>()>;
+
+    GETTER constexpr std::size_t get_width() const { return TWidth; }
+    GETTER constexpr std::size_t get_height() const { return THeight; }
+
+    // Drawing; like ColorLCD, coordinates are only clipped by the shape functions and filled_rectangle()
+    GETTER PaletteIndex get_pixel(std::size_t x, std::size_t y) const
+    {
+        return static_cast<std::uint8_t>(detail::get_index<TFormat>(pixels.data() + y * stride, x));
+    }
+    void set_pixel(PaletteIndex color, std::size_t x, std::size_t y)
+    {
+        mark_dirty(x, y, 1, 1);
+        write_pixel(color.index, x, y);
+    }
+    void fill(PaletteIndex color)
+    {
+        mark_all_dirty();
+        std::memset(pixels.data(), get_fill_byte(color), pixels.size());
+    }
+    void line_horizontal(PaletteIndex color, std::size_t x, std::size_t y, std::size_t width)
+    {
+        mark_dirty(x, y, width, 1);
+        write_span(color.index, x, y, width);
+    }
+    void line_vertical(PaletteIndex color, std::size_t x, std::size_t y, std::size_t height)
+    {
+        mark_dirty(x, y, 1, height);
+        for (std::size_t end_y{ y + height }; y < end_y; ++y)
+        {
+            write_pixel(color.index, x, y);
+        }
+    }
+    void line(PaletteIndex color, std::size_t start_x, std::size_t start_y, std::size_t end_x, std::size_t end_y)
+    {
+        shapes::line(*this, color,
+            { static_cast<std::int32_t>(start_x), static_cast<std::int32_t>(start_y) },
+            { static_cast<std::int32_t>(end_x), static_cast<std::int32_t>(end_y) });
+    }
+    void rectangle(PaletteIndex color, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        if (width == 0 || height == 0)
+        {
+            return;
+        }
+        line_horizontal(color, x, y, width);
+        line_horizontal(color, x, y + height - 1, width);
+        line_vertical(color, x, y, height);
+        line_vertical(color, x + width - 1, y, height);
+    }
+    void filled_rectangle(PaletteIndex color, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        if (x >= TWidth || y >= THeight)
+        {
+            return;
+        }
+        width = std::min(width, TWidth - x);
+        height = std::min(height, THeight - y);
+        mark_dirty(x, y, width, height);
+        for (std::size_t end_y{ y + height }; y < end_y; ++y)
+        {
+            write_span(color.index, x, y, width);
+        }
+    }
+    void text(std::string_view string, TextSettings settings = {})
+    {
+        text::print_text(*this, string, settings);
+    }
+    void centered_text(std::string_view string, TextSettings settings = {})
+    {
+        text::print_centered_text(*this, string, settings);
+    }
+    void text(const TextLayout& layout)
+    {
+        layout.render(*this);
+    }
+    // Draws an indexed sprite's indices, skipping its transparent index, with its top left corner at x, y.
+    // The framebuffer's palette is used rather than the sprite's; RGB565 sprites aren't drawn.
+    void sprite(const Sprite& sprite, std::int32_t x, std::int32_t y, const SpriteBlit& blit = {})
+    {
+        switch (sprite.get_format())
+        {
+        case SpriteFormat::Indexed8:
+            draw_indices<SpriteFormat::Indexed8>(sprite, x, y, blit);
+            break;
+        case SpriteFormat::Indexed4:
+            draw_indices<SpriteFormat::Indexed4>(sprite, x, y, blit);
+            break;
+        case SpriteFormat::RGB565:
+            break;
+        }
+    }
+
+    // Shapes; coordinates are signed and everything is clipped
+    void circle(PaletteIndex color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        shapes::circle(*this, color, { x, y }, radius);
+    }
+    void filled_circle(PaletteIndex color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        shapes::filled_circle(*this, color, { x, y }, radius);
+    }
+    void triangle(PaletteIndex color, shapes::Point a, shapes::Point b, shapes::Point c)
+    {
+        shapes::triangle(*this, color, a, b, c);
+    }
+    void filled_triangle(PaletteIndex color, shapes::Point a, shapes::Point b, shapes::Point c)
+    {
+        shapes::filled_triangle(*this, color, a, b, c);
+    }
+
+    // Palette
+    GETTER std::span<const RGB565> get_palette() const { return palette; }
+    // Copies up to palette_size colors into the palette starting at entry `first`. Everything on screen may change,
+    //   so the whole screen is sent next time.
+    void set_palette(std::span<const RGB565> colors, std::size_t first = 0)
+    {
+        if (first >= palette_size)
+        {
+            return;
+        }
+        const std::size_t count{ std::min(colors.size(), palette_size - first) };
+        std::copy(colors.begin(), colors.begin() + count, palette.begin() + first);
+        mark_all_dirty();
+    }
+    void set_palette_color(std::size_t index, RGB565 color) { set_palette({ &color, 1 }, index); }
+
+    // Dirty region tracking; present() only sends the regions marked since the last present()
+    void mark_dirty(std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        dirty_regions.add(Rect{
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y),
+            .width = static_cast<std::uint32_t>(width), .height = static_cast<std::uint32_t>(height)
+        }.clipped(TWidth, THeight));
+    }
+    void mark_all_dirty() { mark_dirty(0, 0, TWidth, THeight); }
+    GETTER const DirtyRegions& get_dirty_regions() const { return dirty_regions; }
+
+    GETTER std::span<std::uint8_t> get_pixels() { return pixels; }
+    GETTER std::span<const std::uint8_t> get_pixels() const { return pixels; }
+    GETTER IndexedFrame get_frame() const
+    {
+        return IndexedFrame{
+            .pixels = pixels.data(), .stride = stride, .format = TFormat, .palette = palette,
+            .regions = dirty_regions.get_regions()
+        };
+    }
+
+    // Starts sending the dirty regions to `lcd` and returns immediately; see SPILCD::present_indexed()
+    template <typename TLCD>
+    void present(TLCD& lcd, typename TLCD::present_callback_t callback = nullptr)
+    {
+        lcd.present_indexed(get_frame(), callback);
+        dirty_regions.clear();
+    }
+    // Sends the dirty regions to `lcd` and waits for them to go out
+    template <typename TLCD>
+    void show(TLCD& lcd)
+    {
+        present(lcd);
+        lcd.wait_present();
+    }
+
+private:
+    GETTER static std::uint8_t get_fill_byte(PaletteIndex color)
+    {
+        const std::uint8_t index{ static_cast<std::uint8_t>(color.index & index_mask) };
+        return TFormat == SpriteFormat::Indexed4 ? static_cast<std::uint8_t>(index << 4 | index) : index;
+    }
+    void write_pixel(std::uint8_t index, std::size_t x, std::size_t y)
+    {
+        if constexpr (TFormat == SpriteFormat::Indexed4)
+        {
+            // The left pixel of each pair is in the high nibble
+            std::uint8_t& pair{ pixels[y * stride + x / 2u] };
+            const std::uint32_t shift{ (x & 1u) != 0 ? 0u : 4u };
+            pair = static_cast<std::uint8_t>((pair & ~(0x0Fu << shift)) | (index & 0x0Fu) << shift);
+        }
+        else
+        {
+            pixels[y * stride + x] = index;
+        }
+    }
+    void write_span(std::uint8_t index, std::size_t x, std::size_t y, std::size_t width)
+    {
+        if (width == 0)
+        {
+            return;
+        }
+        if constexpr (TFormat == SpriteFormat::Indexed4)
+        {
+            std::size_t end_x{ x + width };
+            if ((x & 1u) != 0)
+            {
+                write_pixel(index, x++, y);
+            }
+            if ((end_x & 1u) != 0 && end_x > x)
+            {
+                write_pixel(index, --end_x, y);
+            }
+            if (end_x > x)
+            {
+                std::memset(pixels.data() + y * stride + x / 2u, get_fill_byte(index), (end_x - x) / 2u);
+            }
+        }
+        else
+        {
+            std::memset(pixels.data() + y * stride + x, index, width);
+        }
+    }
+    template <SpriteFormat TSpriteFormat>
+    void draw_indices(const Sprite& sprite, std::int32_t x, std::int32_t y, const SpriteBlit& blit)
+    {
+        const Rect source{
+            blit.source.empty()
+                ? Rect{ .width = static_cast<std::uint32_t>(sprite.get_width()), .height = static_cast<std::uint32_t>(sprite.get_height()) }
+                : blit.source.clipped(sprite.get_width(), sprite.get_height())
+        };
+        const std::int32_t start_x{ std::max(x, 0) };
+        const std::int32_t start_y{ std::max(y, 0) };
+        const std::int32_t end_x{ std::min(x + static_cast<std::int32_t>(source.width), static_cast<std::int32_t>(TWidth)) };
+        const std::int32_t end_y{ std::min(y + static_cast<std::int32_t>(source.height), static_cast<std::int32_t>(THeight)) };
+        if (source.empty() || start_x >= end_x || start_y >= end_y)
+        {
+            return;
+        }
+        const std::size_t visible_width{ static_cast<std::size_t>(end_x - start_x) };
+        mark_dirty(start_x, start_y, visible_width, end_y - start_y);
+        const bool flip_horizontal{ (static_cast<std::uint8_t>(blit.flip) & static_cast<std::uint8_t>(Flip::Horizontal)) != 0 };
+        const bool flip_vertical{ (static_cast<std::uint8_t>(blit.flip) & static_cast<std::uint8_t>(Flip::Vertical)) != 0 };
+        const std::size_t skipped_columns{ static_cast<std::size_t>(start_x - x) };
+        const std::size_t first_column{
+            flip_horizontal ? source.end_x() - 1u - skipped_columns : source.x + skipped_columns
+        };
+        const std::optional<std::uint16_t> transparent_index{ sprite.get_color_key() };
+        for (std::int32_t screen_y{ start_y }; screen_y < end_y; ++screen_y)
+        {
+            const std::size_t drawn_row{ static_cast<std::size_t>(screen_y - y) };
+            const std::uint8_t* const row{
+                sprite.get_row(flip_vertical ? source.end_y() - 1u - drawn_row : source.y + drawn_row)
+            };
+            if constexpr (TFormat == SpriteFormat::Indexed8 && TSpriteFormat == SpriteFormat::Indexed8)
+            {
+                if (!flip_horizontal && !transparent_index.has_value())
+                {
+                    // Same layout on both sides, so rows are a straight copy
+                    std::memcpy(pixels.data() + screen_y * stride + start_x, row + first_column, visible_width);
+                    continue;
+                }
+            }
+            std::size_t column{ first_column };
+            for (std::size_t i{ 0 }; i < visible_width; ++i)
+            {
+                const std::uint32_t index{ detail::get_index<TSpriteFormat>(row, column) };
+                column = flip_horizontal ? column - 1u : column + 1u;
+                if (!transparent_index.has_value() || index != transparent_index.value())
+                {
+                    write_pixel(static_cast<std::uint8_t>(index), start_x + i, screen_y);
+                }
+            }
+        }
+    }
+
+    alignas(4) std::array<std::uint8_t, buffer_size> pixels{};
+    std::array<RGB565, palette_size> palette{};
+    DirtyRegions dirty_regions;
+};
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "gfx/blend.h"
+#include "gfx/color.h"
+
+namespace gfx
+{
+// Color adjustment applied to pixels on their way to the panel, leaving the framebuffer itself untouched: a lookup
+//   table, either per channel or over every RGB565 color, followed by a fade towards a color.
+// The default PostProcess changes nothing, and show()/present() only pay for one when it does.
+class PostProcess
+{
+public:
+    constexpr static std::size_t color_lut_size{ 0x10000 };
+
+    // Fades every pixel towards `color`; 0 leaves pixels alone and 255 turns the whole screen `color`
+    void set_fade(RGB565 color, std::uint8_t amount)
+    {
+        fade_color = color;
+        fade_amount = amount;
+    }
+    // Fades towards black: 255 is full brightness and 0 a black screen
+    void set_brightness(std::uint8_t level) { set_fade(RGB565{ static_cast<std::uint16_t>(0u) }, 0xFFu - level); }
+    GETTER RGB565 get_fade_color() const { return fade_color; }
+    GETTER std::uint8_t get_fade_amount() const { return fade_amount; }
+
+    // Maps each channel through its own curve, given as 256 8 bit values like a gamma or color grading curve.
+    // The curves are sampled once for every 5 or 6 bit channel level, so they needn't outlive the call.
+    void set_channel_curves(std::span<const std::uint8_t, 256> red, std::span<const std::uint8_t, 256> green,
+        std::span<const std::uint8_t, 256> blue)
+    {
+        // Each level maps straight to its bits of a stored pixel, so a pixel is three lookups ORed together
+        for (std::uint32_t level{ 0u }; level < red_bits.size(); ++level)
+        {
+            const std::uint32_t expanded{ level << 3 | level >> 2 };
+            red_bits[level] = static_cast<std::uint16_t>(red[expanded] & 0xF8u);
+            blue_bits[level] = static_cast<std::uint16_t>((blue[expanded] & 0xF8u) << 5);
+        }
+        for (std::uint32_t level{ 0u }; level < green_bits.size(); ++level)
+        {
+            const std::uint32_t mapped{ green[level << 2 | level >> 4] };
+            green_bits[level] = static_cast<std::uint16_t>(mapped >> 5 | (mapped & 0x1Cu) << 11);
+        }
+        lut = Lut::Channels;
+    }
+    // Maps every pixel through `table`, indexed and filled with RGB565::data values. The table is 128 KB, so it
+    //   normally lives in flash and must outlive its use; rows with many different colors will miss the XIP cache.
+    void set_color_lut(std::span<const RGB565, color_lut_size> table)
+    {
+        color_lut = table.data();
+        lut = Lut::Colors;
+    }
+    void clear_lut()
+    {
+        color_lut = nullptr;
+        lut = Lut::None;
+    }
+
+    GETTER bool is_identity() const { return lut == Lut::None && fade_amount == 0u; }
+
+    // Writes the adjusted pixels of `source` to `destination`, which may be the same pixels
+    void apply(std::span<RGB565> destination, std::span<const RGB565> source) const
+    {
+        const std::size_t count{ std::min(destination.size(), source.size()) };
+        switch (lut)
+        {
+        case Lut::None:
+            if (fade_amount == 0u && destination.data() != source.data())
+            {
+                std::copy_n(source.begin(), count, destination.begin());
+            }
+            break;
+        case Lut::Channels:
+            for (std::size_t i{ 0 }; i < count; ++i)
+            {
+                const std::uint32_t pixel{ source[i].data };
+                destination[i].data = red_bits[pixel >> 3 & 0x1Fu] | blue_bits[pixel >> 8 & 0x1Fu]
+                    | green_bits[(pixel & 0x07u) << 3 | pixel >> 13];
+            }
+            break;
+        case Lut::Colors:
+            for (std::size_t i{ 0 }; i < count; ++i)
+            {
+                destination[i] = color_lut[source[i].data];
+            }
+            break;
+        }
+        if (fade_amount != 0u)
+        {
+            // After a lookup the pixels are already in `destination`
+            const std::span<const RGB565> faded{ lut == Lut::None ? source.first(count) : destination.first(count) };
+            blend::tint(destination, faded, fade_color, fade_amount);
+        }
+    }
+
+private:
+    enum class Lut : std::uint8_t
+    {
+        None,
+        Channels,
+        Colors
+    };
+
+    Lut lut{ Lut::None };
+    std::uint8_t fade_amount{ 0u };
+    RGB565 fade_color{ static_cast<std::uint16_t>(0u) };
+    // Stored pixel bits for each red, green and blue level
+    std::array<std::uint16_t, 32> red_bits{};
+    std::array<std::uint16_t, 64> green_bits{};
+    std::array<std::uint16_t, 32> blue_bits{};
+    const RGB565* color_lut{ nullptr };
+};
+}
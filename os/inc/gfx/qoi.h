@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "debug.h"
+#include "gfx/color.h"
+#include "gfx/convert.h"
+#include "interfaces/SD.h"
+
+// Streaming decoder for QOI ("Quite OK Image") files, a lossless format that typically stores game art in a third
+//   to a tenth of its raw size and decodes with a handful of operations per pixel.
+// Pixels are decoded straight into the destination, such as framebuffer rows or a sprite's pixels, from a small
+//   chunk buffer refilled from the SD card as it empties, so an image never needs to be in memory twice.
+// RGB565 has no alpha, so alpha is only used to pick out transparent pixels when asked to.
+namespace gfx::qoi
+{
+constexpr std::size_t header_size{ 14 };
+// Every file ends with seven 0x00 bytes and a 0x01
+constexpr std::size_t end_marker_size{ 8 };
+// Longest operation, QOI_OP_RGBA, including its tag byte
+constexpr std::size_t max_op_size{ 5 };
+
+struct Header
+{
+    std::uint32_t width{ 0u };
+    std::uint32_t height{ 0u };
+    // 3 for RGB, 4 for RGBA
+    std::uint8_t channels{ 0u };
+    // 0 for sRGB with linear alpha, 1 for all channels linear
+    std::uint8_t colorspace{ 0u };
+};
+
+namespace detail
+{
+constexpr std::uint8_t op_index{ 0x00u };
+constexpr std::uint8_t op_diff{ 0x40u };
+constexpr std::uint8_t op_luma{ 0x80u };
+constexpr std::uint8_t op_run{ 0xC0u };
+constexpr std::uint8_t op_rgb{ 0xFEu };
+constexpr std::uint8_t op_rgba{ 0xFFu };
+constexpr std::uint8_t op_mask{ 0xC0u };
+
+GETTER constexpr std::uint32_t read_big_endian(const std::uint8_t* bytes)
+{
+    return static_cast<std::uint32_t>(bytes[0]) << 24 | static_cast<std::uint32_t>(bytes[1]) << 16
+        | static_cast<std::uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+}
+
+// Decodes the pixels of one QOI file in order, stopping after each span it's given and carrying on from there in
+//   the next, so an image can be decoded a row at a time into rows that aren't next to each other.
+// Reads go through a TChunkSize byte buffer held by the decoder, a whole SD sector by default.
+template <std::size_t TChunkSize = 512>
+class StreamDecoder
+{
+public:
+    static_assert(TChunkSize >= header_size && TChunkSize > max_op_size, "Chunks need to hold the header and any operation");
+
+    explicit StreamDecoder(SDCard::FileReader& reader) : reader{ reader } {}
+
+    // Reads and checks the header; call once before decode()
+    bool read_header()
+    {
+        if (!reader.is_valid())
+        {
+            return false;
+        }
+        remaining_file_bytes = reader.get_size() - reader.get_current_offset();
+        if (remaining_file_bytes < header_size + end_marker_size)
+        {
+            print("qoi::StreamDecoder file is too small to be a QOI image\n");
+            return false;
+        }
+        std::array<std::uint8_t, header_size> bytes;
+        if (!reader.read_bytes(std::span<std::uint8_t>{ bytes }))
+        {
+            print("qoi::StreamDecoder failed to read header\n");
+            return false;
+        }
+        remaining_file_bytes -= header_size;
+        if (bytes[0] != 'q' || bytes[1] != 'o' || bytes[2] != 'i' || bytes[3] != 'f')
+        {
+            print("qoi::StreamDecoder bad magic\n");
+            return false;
+        }
+        header = Header{
+            .width = detail::read_big_endian(bytes.data() + 4),
+            .height = detail::read_big_endian(bytes.data() + 8),
+            .channels = bytes[12],
+            .colorspace = bytes[13]
+        };
+        if (header.width == 0u || header.height == 0u || (header.channels != 3u && header.channels != 4u))
+        {
+            print("qoi::StreamDecoder bad header (%lu x %lu, %u channels)\n", header.width, header.height, header.channels);
+            return false;
+        }
+        remaining_pixels = static_cast<std::uint64_t>(header.width) * header.height;
+        return true;
+    }
+    GETTER const Header& get_header() const { return header; }
+    GETTER std::uint64_t get_remaining_pixels() const { return remaining_pixels; }
+
+    // Decodes the next destination.size() pixels of the image into `destination`
+    bool decode(std::span<RGB565> destination)
+    {
+        if (destination.size() > remaining_pixels)
+        {
+            print("qoi::StreamDecoder asked for %u pixels with only %lu left\n", static_cast<unsigned>(destination.size()),
+                static_cast<unsigned long>(remaining_pixels));
+            return false;
+        }
+        remaining_pixels -= destination.size();
+        std::uint16_t* out{ reinterpret_cast<std::uint16_t*>(destination.data()) };
+        std::uint16_t* const end{ out + destination.size() };
+        while (out != end)
+        {
+            if (run != 0u)
+            {
+                const std::size_t count{ std::min(static_cast<std::size_t>(run), static_cast<std::size_t>(end - out)) };
+                std::fill_n(out, count, stored);
+                out += count;
+                run -= static_cast<std::uint32_t>(count);
+                continue;
+            }
+            if (chunk_end - chunk_position < max_op_size && !refill())
+            {
+                return false;
+            }
+            const std::uint8_t* in{ chunk.data() + chunk_position };
+            const std::uint8_t tag{ *in++ };
+            if (tag == detail::op_rgb)
+            {
+                r = in[0];
+                g = in[1];
+                b = in[2];
+                in += 3;
+            }
+            else if (tag == detail::op_rgba)
+            {
+                r = in[0];
+                g = in[1];
+                b = in[2];
+                a = in[3];
+                in += 4;
+            }
+            else
+            {
+                switch (tag & detail::op_mask)
+                {
+                case detail::op_index:
+                {
+                    const std::uint32_t pixel{ index[tag] };
+                    r = static_cast<std::uint8_t>(pixel);
+                    g = static_cast<std::uint8_t>(pixel >> 8);
+                    b = static_cast<std::uint8_t>(pixel >> 16);
+                    a = static_cast<std::uint8_t>(pixel >> 24);
+                    break;
+                }
+                case detail::op_diff:
+                    r += static_cast<std::uint8_t>((tag >> 4 & 0x03u) - 2u);
+                    g += static_cast<std::uint8_t>((tag >> 2 & 0x03u) - 2u);
+                    b += static_cast<std::uint8_t>((tag & 0x03u) - 2u);
+                    break;
+                case detail::op_luma:
+                {
+                    const std::uint8_t drb{ *in++ };
+                    const std::uint8_t dg{ static_cast<std::uint8_t>((tag & 0x3Fu) - 32u) };
+                    r += static_cast<std::uint8_t>(dg - 8u + (drb >> 4));
+                    g += dg;
+                    b += static_cast<std::uint8_t>(dg - 8u + (drb & 0x0Fu));
+                    break;
+                }
+                case detail::op_run:
+                    // Repeats of the last pixel, written out as a fill at the top of the loop. The pixel still goes
+                    //   in the index, which only matters for a run at the very start of the image.
+                    run = (tag & 0x3Fu) + 1u;
+                    chunk_position = static_cast<std::size_t>(in - chunk.data());
+                    add_to_index();
+                    continue;
+                }
+            }
+            chunk_position = static_cast<std::size_t>(in - chunk.data());
+            add_to_index();
+            stored = a < 0x80u && transparent_color.has_value() ? transparent_color->data
+                : static_cast<std::uint16_t>(convert::detail::to_stored(r, g, b));
+            *out++ = stored;
+        }
+        return true;
+    }
+
+    // Pixels less than half opaque are decoded as `color`, e.g. a sprite's color key, instead of their own color
+    void set_transparent_color(std::optional<RGB565> color) { transparent_color = color; }
+
+private:
+    void add_to_index()
+    {
+        index[(r * 3u + g * 5u + b * 7u + a * 11u) % index.size()] = static_cast<std::uint32_t>(r)
+            | static_cast<std::uint32_t>(g) << 8 | static_cast<std::uint32_t>(b) << 16 | static_cast<std::uint32_t>(a) << 24;
+    }
+    // Moves the unread bytes to the front of the chunk and reads as much of the file after them as fits
+    bool refill()
+    {
+        const std::size_t kept{ chunk_end - chunk_position };
+        std::memmove(chunk.data(), chunk.data() + chunk_position, kept);
+        chunk_position = 0;
+        chunk_end = kept;
+        const std::size_t count{ static_cast<std::size_t>(std::min<std::uint64_t>(chunk.size() - kept, remaining_file_bytes)) };
+        if (count == 0u)
+        {
+            // The end marker keeps any valid operation from running off the end of the file
+            print("qoi::StreamDecoder ran out of data\n");
+            return false;
+        }
+        if (!reader.read_bytes(std::span<std::uint8_t>{ chunk.data() + kept, count }))
+        {
+            print("qoi::StreamDecoder failed to read %u bytes\n", static_cast<unsigned>(count));
+            return false;
+        }
+        remaining_file_bytes -= count;
+        chunk_end += count;
+        return true;
+    }
+
+    SDCard::FileReader& reader;
+    Header header{};
+    std::uint64_t remaining_pixels{ 0u };
+    std::uint64_t remaining_file_bytes{ 0u };
+    // Previously seen pixels by hash, packed as r | g << 8 | b << 16 | a << 24
+    std::array<std::uint32_t, 64> index{};
+    // The last pixel, and as an RGB565::data value
+    std::uint8_t r{ 0u };
+    std::uint8_t g{ 0u };
+    std::uint8_t b{ 0u };
+    std::uint8_t a{ 0xFFu };
+    std::uint16_t stored{ 0u };
+    std::optional<RGB565> transparent_color{};
+    // Repeats of the last pixel still to be written
+    std::uint32_t run{ 0u };
+    std::size_t chunk_position{ 0 };
+    std::size_t chunk_end{ 0 };
+    alignas(4) std::array<std::uint8_t, TChunkSize> chunk;
+};
+
+// Decodes the QOI image at `path` into `lcd`'s draw buffer with its top left corner at (x, y), a row at a time
+//   straight into the framebuffer. The image must fit on screen.
+template <typename TLCD>
+bool draw(TLCD& lcd, const char* path, std::size_t x = 0, std::size_t y = 0)
+{
+    SDCard::FileReader reader{ path };
+    StreamDecoder decoder{ reader };
+    if (!decoder.read_header())
+    {
+        print("qoi::draw failed to read %s\n", path);
+        return false;
+    }
+    const Header& header{ decoder.get_header() };
+    if (x + header.width > lcd.get_width() || y + header.height > lcd.get_height())
+    {
+        print("qoi::draw image %s (%lu x %lu) doesn't fit at %u, %u\n", path, header.width, header.height,
+            static_cast<unsigned>(x), static_cast<unsigned>(y));
+        return false;
+    }
+    for (std::size_t row{ 0 }; row < header.height; ++row)
+    {
+        if (!decoder.decode(lcd.get_row(y + row).subspan(x, header.width)))
+        {
+            print("qoi::draw failed to decode row %u of %s\n", static_cast<unsigned>(row), path);
+            lcd.mark_dirty(x, y, header.width, row);
+            return false;
+        }
+    }
+    lcd.mark_dirty(x, y, header.width, header.height);
+    return true;
+}
+}
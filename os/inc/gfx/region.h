@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+
+namespace gfx
+{
+struct Rect
+{
+    std::uint32_t x{ 0u };
+    std::uint32_t y{ 0u };
+    std::uint32_t width{ 0u };
+    std::uint32_t height{ 0u };
+
+    GETTER constexpr std::uint32_t end_x() const { return x + width; }
+    GETTER constexpr std::uint32_t end_y() const { return y + height; }
+    GETTER constexpr std::uint32_t area() const { return width * height; }
+    GETTER constexpr bool empty() const { return width == 0u || height == 0u; }
+
+    GETTER constexpr bool contains(const Rect& other) const
+    {
+        return other.x >= x && other.y >= y
+            && other.end_x() <= end_x() && other.end_y() <= end_y();
+    }
+    // True if the two rects overlap or share an edge
+    GETTER constexpr bool touches(const Rect& other) const
+    {
+        return other.x <= end_x() && x <= other.end_x()
+            && other.y <= end_y() && y <= other.end_y();
+    }
+    GETTER constexpr Rect merged(const Rect& other) const
+    {
+        const std::uint32_t min_x{ std::min(x, other.x) };
+        const std::uint32_t min_y{ std::min(y, other.y) };
+        return Rect{
+            .x = min_x, .y = min_y,
+            .width = std::max(end_x(), other.end_x()) - min_x,
+            .height = std::max(end_y(), other.end_y()) - min_y
+        };
+    }
+    GETTER constexpr Rect clipped(std::uint32_t max_width, std::uint32_t max_height) const
+    {
+        if (x >= max_width || y >= max_height)
+        {
+            return Rect{};
+        }
+        return Rect{
+            .x = x, .y = y,
+            .width = std::min(width, max_width - x),
+            .height = std::min(height, max_height - y)
+        };
+    }
+
+    constexpr bool operator==(const Rect&) const = default;
+};
+
+// Small fixed-capacity set of damaged rectangles.
+// Overlapping or touching rects are merged as they're added; once the set is full, a new rect is merged into
+//   whichever existing region grows the least from it so the set never needs to allocate.
+template <std::size_t TMaxRegions>
+class DirtyRegions
+{
+public:
+    static_assert(TMaxRegions > 0);
+    constexpr static std::size_t max_regions{ TMaxRegions };
+
+    constexpr void add(Rect rect)
+    {
+        if (rect.empty())
+        {
+            return;
+        }
+        // Walk backwards as the most recently added region is the most likely to already cover this one
+        for (std::size_t i{ count }; i > 0; --i)
+        {
+            if (regions[i - 1].contains(rect))
+            {
+                return;
+            }
+        }
+        while (true)
+        {
+            bool merged_any{ false };
+            for (std::size_t i{ 0 }; i < count; )
+            {
+                if (regions[i].touches(rect))
+                {
+                    rect = rect.merged(regions[i]);
+                    remove(i);
+                    merged_any = true;
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            if (merged_any)
+            {
+                // The grown rect may now touch regions that were already checked
+                continue;
+            }
+            if (count < max_regions)
+            {
+                regions[count++] = rect;
+                return;
+            }
+            // Full and nothing overlaps, so fold it into the cheapest region and re-check for new overlaps
+            const std::size_t best{ find_cheapest_merge(rect) };
+            rect = rect.merged(regions[best]);
+            remove(best);
+        }
+    }
+    constexpr void clear() { count = 0; }
+
+    GETTER constexpr bool empty() const { return count == 0; }
+    GETTER constexpr std::size_t size() const { return count; }
+    GETTER constexpr std::span<const Rect> get_regions() const { return { regions.data(), count }; }
+    GETTER constexpr std::uint32_t get_total_area() const
+    {
+        std::uint32_t total{ 0u };
+        for (const Rect& region : get_regions())
+        {
+            total += region.area();
+        }
+        return total;
+    }
+
+private:
+    constexpr void remove(std::size_t index)
+    {
+        regions[index] = regions[--count];
+    }
+    GETTER constexpr std::size_t find_cheapest_merge(const Rect& rect) const
+    {
+        std::size_t best{ 0 };
+        std::uint32_t best_growth{ ~0u };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            const std::uint32_t growth{ rect.merged(regions[i]).area() - regions[i].area() };
+            if (growth < best_growth)
+            {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        return best;
+    }
+
+    std::array<Rect, TMaxRegions> regions{};
+    std::size_t count{ 0 };
+};
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "gfx/bmp.h"
+#include "gfx/post_process.h"
+#include "gfx/sprite.h"
+#include "interfaces/SD.h"
+
+namespace gfx
+{
+// Writes what `lcd` shows as a BMP (see bmp.h): its display buffer rotated by the scroll offset and post processed,
+//   as the panel sees it. Goes through `chunk` a whole number of rows at a time, headers first, so every write is a
+//   whole number of SD sectors. False if any write failed, leaving the file half written.
+template <typename TLCD, std::size_t TChunkSize>
+bool write_screenshot(SDCard::FileWriter& writer, const TLCD& lcd, std::span<typename TLCD::ColorFormat, TChunkSize> chunk)
+{
+    using ColorFormat = typename TLCD::ColorFormat;
+    constexpr std::size_t width{ TLCD::width };
+    constexpr std::size_t height{ TLCD::height };
+    constexpr std::size_t chunk_rows{ TChunkSize / width };
+    static_assert(bmp::get_row_size(width) == width * sizeof(ColorFormat), "Screenshot rows are written without padding");
+    static_assert(TChunkSize % width == 0u && height % chunk_rows == 0u, "Screenshots are written in whole chunks");
+    static_assert(TChunkSize * sizeof(ColorFormat) >= bmp::pixel_data_offset, "The BMP header is written from the chunk buffer");
+    const std::span<std::uint8_t> chunk_bytes{ reinterpret_cast<std::uint8_t*>(chunk.data()), chunk.size_bytes() };
+    if (!writer.preallocate(bmp::get_file_size(width, height)))
+    {
+        return false;
+    }
+    bmp::write_rgb565_header(chunk_bytes.template first<bmp::pixel_data_offset>(), width, height);
+    if (!writer.write_bytes(std::span<const std::uint8_t>{ chunk_bytes.first(bmp::pixel_data_offset) }))
+    {
+        return false;
+    }
+    const std::size_t scroll_offset{ lcd.get_scroll_offset() };
+    const PostProcess& post_process{ lcd.get_post_process() };
+    for (std::size_t y{ 0 }; y < height; y += chunk_rows)
+    {
+        for (std::size_t row{ 0 }; row < chunk_rows; ++row)
+        {
+            const std::span<const ColorFormat> source{ lcd.get_display_row(y + row) };
+            const std::span<ColorFormat> destination{ chunk.subspan(row * width, width) };
+            // The panel shows buffer column `scroll_offset` at the left edge of the screen
+            std::copy(source.begin() + scroll_offset, source.end(), destination.begin());
+            std::copy_n(source.begin(), scroll_offset, destination.end() - scroll_offset);
+            if (!post_process.is_identity())
+            {
+                post_process.apply(destination, destination);
+            }
+        }
+        // Back to standard RGB565, two pixels at a time
+        detail::pixel_pair_t* pairs{ reinterpret_cast<detail::pixel_pair_t*>(chunk.data()) };
+        for (std::size_t i{ 0 }; i < chunk.size() / 2u; ++i)
+        {
+            pairs[i] = detail::swap_pair_bytes(pairs[i]);
+        }
+        if (!writer.write_bytes(std::span<const std::uint8_t>{ chunk_bytes }))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
@@ -0,0 +1,421 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <span>
+#include <utility>
+#include "PICOnsole_defines.h"
+
+// Integer-only rasterization of lines, circles, ellipses, triangles and convex polygons.
+// Targets need get_width(), get_height(), set_pixel(color, x, y) and line_horizontal(color, x, y, width).
+// Coordinates are signed so shapes may hang off any edge of the target; everything is clipped before it reaches the
+//   target and fills only ever emit horizontal spans so they go through the target's fast line_horizontal.
+namespace gfx::shapes
+{
+struct Point
+{
+    std::int32_t x{ 0 };
+    std::int32_t y{ 0 };
+};
+
+template <typename TTarget, typename TColor>
+inline void plot(TTarget& target, TColor color, std::int32_t x, std::int32_t y)
+{
+    if (x >= 0 && y >= 0
+        && x < static_cast<std::int32_t>(target.get_width()) && y < static_cast<std::int32_t>(target.get_height()))
+    {
+        target.set_pixel(color, x, y);
+    }
+}
+
+// Draws the inclusive span [start_x, end_x] on row y
+template <typename TTarget, typename TColor>
+inline void span(TTarget& target, TColor color, std::int32_t start_x, std::int32_t end_x, std::int32_t y)
+{
+    if (y < 0 || y >= static_cast<std::int32_t>(target.get_height()))
+    {
+        return;
+    }
+    if (start_x > end_x)
+    {
+        std::swap(start_x, end_x);
+    }
+    start_x = std::max<std::int32_t>(start_x, 0);
+    end_x = std::min<std::int32_t>(end_x, static_cast<std::int32_t>(target.get_width()) - 1);
+    if (start_x > end_x)
+    {
+        return;
+    }
+    target.line_horizontal(color, start_x, y, end_x - start_x + 1);
+}
+
+namespace detail
+{
+// Steps n in [first, last] of a walk from `origin` by `step` (1 or -1) per step, for `length` steps, that land within
+//   [0, size); first > last if none do
+struct StepRange
+{
+    std::int64_t first;
+    std::int64_t last;
+};
+
+inline StepRange steps_within(std::int64_t origin, std::int32_t step, std::int64_t length, std::int64_t size)
+{
+    if (step > 0)
+    {
+        return { std::max<std::int64_t>(0, -origin), std::min(length, size - 1 - origin) };
+    }
+    return { std::max<std::int64_t>(0, origin - (size - 1)), std::min(length, origin) };
+}
+}
+
+// Bresenham line including both end points. It's clipped to the target before it's walked: the first and last steps
+//   along its longer axis that land on the target are worked out directly, and the walk starts at the first with the
+//   error term it would have had there, so a clipped line lights exactly the pixels the whole line would.
+// Lines must span less than 2^30 pixels along either axis.
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void line(TTarget& target, TColor color, Point start, Point end)
+{
+    const std::int32_t width{ static_cast<std::int32_t>(target.get_width()) };
+    const std::int32_t height{ static_cast<std::int32_t>(target.get_height()) };
+    if ((start.x < 0 && end.x < 0) || (start.y < 0 && end.y < 0)
+        || (start.x >= width && end.x >= width) || (start.y >= height && end.y >= height))
+    {
+        // Entirely off one side
+        return;
+    }
+    if (start.y == end.y)
+    {
+        span(target, color, start.x, end.x, start.y);
+        return;
+    }
+    // The walk takes one step along the major axis per pixel, and a step along the minor axis whenever the line has
+    //   moved half a pixel or more along it: at step n it's floor((2 * n * minor_length + major_length) /
+    //   (2 * major_length)) pixels along
+    const std::int32_t dx{ std::abs(end.x - start.x) };
+    const std::int32_t dy{ std::abs(end.y - start.y) };
+    const bool steep{ dy > dx };
+    const std::int32_t major_length{ steep ? dy : dx };
+    const std::int32_t minor_length{ steep ? dx : dy };
+    const std::int32_t step_x{ start.x < end.x ? 1 : -1 };
+    const std::int32_t step_y{ start.y < end.y ? 1 : -1 };
+    const std::int32_t major_origin{ steep ? start.y : start.x };
+    const std::int32_t minor_origin{ steep ? start.x : start.y };
+    const std::int32_t major_step{ steep ? step_y : step_x };
+    const std::int32_t minor_step{ steep ? step_x : step_y };
+    detail::StepRange steps{ detail::steps_within(major_origin, major_step, major_length, steep ? height : width) };
+    const detail::StepRange minor_steps{ detail::steps_within(minor_origin, minor_step, minor_length, steep ? width : height) };
+    if (minor_length == 0)
+    {
+        if (minor_steps.first > 0 || minor_steps.last < 0)
+        {
+            return;
+        }
+    }
+    else
+    {
+        // The steps whose minor offset is at least minor_steps.first and at most minor_steps.last
+        const std::int64_t doubled_minor{ 2 * static_cast<std::int64_t>(minor_length) };
+        if (minor_steps.first > 0)
+        {
+            const std::int64_t reach{ (2 * minor_steps.first - 1) * major_length };
+            steps.first = std::max(steps.first, (reach + doubled_minor - 1) / doubled_minor);
+        }
+        const std::int64_t reach{ (2 * minor_steps.last + 1) * major_length };
+        steps.last = std::min(steps.last, (reach + doubled_minor - 1) / doubled_minor - 1);
+    }
+    if (steps.first > steps.last)
+    {
+        return;
+    }
+    const std::int64_t position{ 2 * steps.first * minor_length + major_length };
+    const std::int32_t doubled_major{ 2 * major_length };
+    std::int32_t major{ static_cast<std::int32_t>(major_origin + major_step * steps.first) };
+    std::int32_t minor{ static_cast<std::int32_t>(minor_origin + minor_step * (position / doubled_major)) };
+    // How far past the minor axis' last step the line is, in 1 / (2 * major_length) pixels
+    std::int32_t error{ static_cast<std::int32_t>(position % doubled_major) };
+    for (std::int64_t count{ steps.last - steps.first }; count >= 0; --count)
+    {
+        if (steep)
+        {
+            target.set_pixel(color, minor, major);
+        }
+        else
+        {
+            target.set_pixel(color, major, minor);
+        }
+        major += major_step;
+        error += 2 * minor_length;
+        if (error >= doubled_major)
+        {
+            error -= doubled_major;
+            minor += minor_step;
+        }
+    }
+}
+
+// Midpoint circle outline
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void circle(TTarget& target, TColor color, Point center, std::int32_t radius)
+{
+    if (radius < 0)
+    {
+        return;
+    }
+    std::int32_t x{ radius };
+    std::int32_t y{ 0 };
+    std::int32_t error{ 1 - radius };
+    while (x >= y)
+    {
+        plot(target, color, center.x + x, center.y + y);
+        plot(target, color, center.x - x, center.y + y);
+        plot(target, color, center.x + x, center.y - y);
+        plot(target, color, center.x - x, center.y - y);
+        plot(target, color, center.x + y, center.y + x);
+        plot(target, color, center.x - y, center.y + x);
+        plot(target, color, center.x + y, center.y - x);
+        plot(target, color, center.x - y, center.y - x);
+        ++y;
+        if (error < 0)
+        {
+            error += 2 * y + 1;
+        }
+        else
+        {
+            --x;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// Midpoint circle filled with one span per row
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void filled_circle(TTarget& target, TColor color, Point center, std::int32_t radius)
+{
+    if (radius < 0)
+    {
+        return;
+    }
+    std::int32_t x{ radius };
+    std::int32_t y{ 0 };
+    std::int32_t error{ 1 - radius };
+    while (x >= y)
+    {
+        span(target, color, center.x - x, center.x + x, center.y + y);
+        if (y != 0)
+        {
+            span(target, color, center.x - x, center.x + x, center.y - y);
+        }
+        ++y;
+        if (error < 0)
+        {
+            error += 2 * y + 1;
+        }
+        else
+        {
+            // Rows at +-x are about to be left behind, so this is their widest point
+            if (x >= y)
+            {
+                span(target, color, center.x - (y - 1), center.x + (y - 1), center.y + x);
+                span(target, color, center.x - (y - 1), center.x + (y - 1), center.y - x);
+            }
+            --x;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+namespace detail
+{
+// Walks one quadrant of a midpoint ellipse, calling `emit(x, y, leaving_row)` for every point.
+// `leaving_row` is true for the last (widest) point visited on each row.
+template <typename TEmit>
+inline void walk_ellipse(std::int32_t radius_x, std::int32_t radius_y, TEmit&& emit)
+{
+    // Degenerate ellipses are straight lines, which would never leave either region below
+    if (radius_y == 0)
+    {
+        for (std::int32_t x{ 0 }; x <= radius_x; ++x)
+        {
+            emit(x, 0, x == radius_x);
+        }
+        return;
+    }
+    if (radius_x == 0)
+    {
+        for (std::int32_t y{ 0 }; y <= radius_y; ++y)
+        {
+            emit(0, y, true);
+        }
+        return;
+    }
+    // 64 bit, as the error terms pass 2^31 from radii of a few hundred
+    const std::int64_t a2{ static_cast<std::int64_t>(radius_x) * radius_x };
+    const std::int64_t b2{ static_cast<std::int64_t>(radius_y) * radius_y };
+    const std::int64_t four_a2{ 4 * a2 };
+    const std::int64_t four_b2{ 4 * b2 };
+    // Region 1: shallow part, stepping x every iteration
+    std::int32_t x{ 0 };
+    std::int32_t y{ radius_y };
+    for (std::int64_t sigma{ 2 * b2 + a2 * (1 - 2 * radius_y) }; b2 * x <= a2 * y; ++x)
+    {
+        const bool leaving_row{ sigma >= 0 };
+        emit(x, y, leaving_row);
+        if (leaving_row)
+        {
+            sigma += four_a2 * (1 - y);
+            --y;
+        }
+        sigma += b2 * (4 * x + 6);
+    }
+    // Region 1 stopped on row `last_y` without leaving it, or without reaching it at all
+    const std::int32_t last_y{ y };
+    const std::int32_t last_x{ x - 1 };
+    // Region 2: steep part, stepping y every iteration until it meets region 1's last row. Its own slope test can end
+    //   rows short of that on tall, thin ellipses, whose x reaches 0 early.
+    x = radius_x;
+    y = 0;
+    for (std::int64_t sigma{ 2 * a2 + b2 * (1 - 2 * radius_x) }; y <= last_y; ++y)
+    {
+        if (y == last_y)
+        {
+            // Join the two regions along the row they share; on short, wide ellipses that can be a long way
+            x = std::max(x, last_x);
+            for (std::int32_t gap_x{ last_x + 1 }; gap_x < x; ++gap_x)
+            {
+                emit(gap_x, y, false);
+            }
+        }
+        emit(x, y, true);
+        if (sigma >= 0 && x > 0)
+        {
+            sigma += four_b2 * (1 - x);
+            --x;
+        }
+        sigma += a2 * (4 * y + 6);
+    }
+}
+}
+
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void ellipse(TTarget& target, TColor color, Point center, std::int32_t radius_x, std::int32_t radius_y)
+{
+    if (radius_x < 0 || radius_y < 0)
+    {
+        return;
+    }
+    detail::walk_ellipse(radius_x, radius_y,
+        [&](std::int32_t x, std::int32_t y, bool)
+        {
+            plot(target, color, center.x + x, center.y + y);
+            plot(target, color, center.x - x, center.y + y);
+            plot(target, color, center.x + x, center.y - y);
+            plot(target, color, center.x - x, center.y - y);
+        });
+}
+
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void filled_ellipse(TTarget& target, TColor color, Point center, std::int32_t radius_x, std::int32_t radius_y)
+{
+    if (radius_x < 0 || radius_y < 0)
+    {
+        return;
+    }
+    detail::walk_ellipse(radius_x, radius_y,
+        [&](std::int32_t x, std::int32_t y, bool leaving_row)
+        {
+            if (!leaving_row)
+            {
+                return;
+            }
+            span(target, color, center.x - x, center.x + x, center.y + y);
+            if (y != 0)
+            {
+                span(target, color, center.x - x, center.x + x, center.y - y);
+            }
+        });
+}
+
+// Outline through each vertex in order, closed back to the first
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void polygon(TTarget& target, TColor color, std::span<const Point> vertices)
+{
+    if (vertices.empty())
+    {
+        return;
+    }
+    for (std::size_t i{ 1 }; i < vertices.size(); ++i)
+    {
+        line(target, color, vertices[i - 1], vertices[i]);
+    }
+    line(target, color, vertices.back(), vertices.front());
+}
+
+// Flat-shaded convex polygon; every row is a single span between the leftmost and rightmost edge crossing
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void filled_polygon(TTarget& target, TColor color, std::span<const Point> vertices)
+{
+    if (vertices.empty())
+    {
+        return;
+    }
+    std::int32_t min_y{ vertices.front().y };
+    std::int32_t max_y{ vertices.front().y };
+    for (const Point& vertex : vertices)
+    {
+        min_y = std::min(min_y, vertex.y);
+        max_y = std::max(max_y, vertex.y);
+    }
+    min_y = std::max<std::int32_t>(min_y, 0);
+    max_y = std::min<std::int32_t>(max_y, static_cast<std::int32_t>(target.get_height()) - 1);
+    for (std::int32_t y{ min_y }; y <= max_y; ++y)
+    {
+        std::int32_t left{ std::numeric_limits<std::int32_t>::max() };
+        std::int32_t right{ std::numeric_limits<std::int32_t>::min() };
+        for (std::size_t i{ 0 }; i < vertices.size(); ++i)
+        {
+            Point a{ vertices[i] };
+            Point b{ vertices[(i + 1) % vertices.size()] };
+            if (a.y > b.y)
+            {
+                std::swap(a, b);
+            }
+            if (y < a.y || y > b.y)
+            {
+                continue;
+            }
+            if (a.y == b.y)
+            {
+                left = std::min({ left, a.x, b.x });
+                right = std::max({ right, a.x, b.x });
+                continue;
+            }
+            // Rounded to nearest so shared edges between adjacent polygons line up
+            const std::int32_t dy{ b.y - a.y };
+            const std::int32_t numerator{ (b.x - a.x) * (y - a.y) * 2 + (b.x >= a.x ? dy : -dy) };
+            const std::int32_t x{ a.x + numerator / (dy * 2) };
+            left = std::min(left, x);
+            right = std::max(right, x);
+        }
+        if (left <= right)
+        {
+            span(target, color, left, right, y);
+        }
+    }
+}
+
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void triangle(TTarget& target, TColor color, Point a, Point b, Point c)
+{
+    const Point vertices[]{ a, b, c };
+    polygon(target, color, std::span<const Point>{ vertices });
+}
+
+template <typename TTarget, typename TColor>
+PICONSOLE_FUNC void filled_triangle(TTarget& target, TColor color, Point a, Point b, Point c)
+{
+    const Point vertices[]{ a, b, c };
+    filled_polygon(target, color, std::span<const Point>{ vertices });
+}
+}
@@ -1 +1,382 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/region.h"
+
+namespace gfx
+{
+enum class SpriteFormat : std::uint8_t
+{
+    RGB565,
+    // One palette index per byte
+    Indexed8,
+    // Two palette indices per byte, the leftmost pixel in the high nibble; every row starts on a new byte
+    Indexed4
+};
+
+enum class Flip : std::uint8_t
+{
+    None = 0b00u,
+    Horizontal = 0b01u,
+    Vertical = 0b10u,
+    Both = 0b11u
+};
+
+// How a sprite is mapped onto the screen by draw_sprite()
+struct SpriteBlit
+{
+    // Part of the sprite to draw; empty draws the whole sprite
+    Rect source{};
+    Flip flip{ Flip::None };
+    // Used instead of the sprite's own palette when set, e.g. for palette swapped enemies. Indexed sprites only.
+    std::span<const RGB565> palette{};
+};
+
+// Image in the framebuffer's RGB565 layout or palette indexed, with an optional transparent color.
+// Sprites either point at pixels that live elsewhere, such as constexpr data in flash, or own pixels loaded from
+//   the SD card.
+class Sprite
+{
+public:
+    // PICOSPRITE files, as written for the Python prototype, start with this
+    constexpr static std::string_view file_magic{ "PICOSPRITE" };
+
+    Sprite() = default;
+    // `pixels` must outlive the sprite
+    Sprite(std::span<const RGB565> pixels, std::size_t width, std::size_t height,
+        std::optional<RGB565> color_key = std::nullopt)
+        : data{ reinterpret_cast<const std::uint8_t*>(pixels.data()) }, width{ static_cast<std::uint16_t>(width) },
+        height{ static_cast<std::uint16_t>(height) }, format{ SpriteFormat::RGB565 },
+        has_color_key{ color_key.has_value() }, color_key{ color_key.value_or(RGB565{}).data }
+    {}
+    // `indices` and `palette` must outlive the sprite. The palette needs an entry for every possible index, so 16 or
+    //   256 of them.
+    Sprite(SpriteFormat format, std::span<const std::uint8_t> indices, std::size_t width, std::size_t height,
+        std::span<const RGB565> palette, std::optional<std::uint8_t> transparent_index = std::nullopt)
+        : data{ indices.data() }, width{ static_cast<std::uint16_t>(width) }, height{ static_cast<std::uint16_t>(height) },
+        format{ format }, has_color_key{ transparent_index.has_value() }, color_key{ transparent_index.value_or(0u) },
+        palette{ palette }
+    {}
+
+    // Reads a PICOSPRITE file into memory owned by the sprite
+    PICONSOLE_FUNC bool load(const char* path);
+    // Decodes a QOI image into memory owned by the sprite. With a color key, pixels less than half opaque become
+    //   transparent.
+    PICONSOLE_FUNC bool load_qoi(const char* path, std::optional<RGB565> color_key = std::nullopt);
+
+    GETTER constexpr std::size_t get_width() const { return width; }
+    GETTER constexpr std::size_t get_height() const { return height; }
+    GETTER constexpr SpriteFormat get_format() const { return format; }
+    GETTER constexpr bool empty() const { return width == 0u || height == 0u; }
+    GETTER constexpr bool is_indexed() const { return format != SpriteFormat::RGB565; }
+    GETTER constexpr std::size_t get_stride() const { return get_stride(format, width); }
+    // Bytes per row of a `width` pixel wide sprite
+    GETTER constexpr static std::size_t get_stride(SpriteFormat format, std::size_t width)
+    {
+        switch (format)
+        {
+        case SpriteFormat::RGB565:
+            return width * sizeof(RGB565);
+        case SpriteFormat::Indexed8:
+            return width;
+        case SpriteFormat::Indexed4:
+            return (width + 1u) / 2u;
+        }
+        return 0u;
+    }
+    // Start of row `y`'s pixels or indices
+    GETTER const std::uint8_t* get_row(std::size_t y) const { return get_data() + y * get_stride(); }
+    GETTER constexpr std::span<const RGB565> get_palette() const { return palette; }
+    // The palette can be swapped at any time; it must outlive the sprite
+    void set_palette(std::span<const RGB565> new_palette) { palette = new_palette; }
+    // Transparent RGB565 color for RGB565 sprites or transparent index for indexed ones
+    GETTER constexpr std::optional<std::uint16_t> get_color_key() const
+    {
+        return has_color_key ? std::optional<std::uint16_t>{ color_key } : std::nullopt;
+    }
+
+private:
+    GETTER const std::uint8_t* get_data() const { return storage.empty() ? data : storage.data(); }
+
+    // Pixels loaded from SD; when empty the sprite points at `data` instead
+    std::vector<std::uint8_t> storage{};
+    const std::uint8_t* data{ nullptr };
+    std::uint16_t width{ 0u };
+    std::uint16_t height{ 0u };
+    SpriteFormat format{ SpriteFormat::RGB565 };
+    bool has_color_key{ false };
+    std::uint16_t color_key{ 0u };
+    std::span<const RGB565> palette{};
+};
+
+namespace detail
+{
+using pixel_pair_t = std::uint32_t __attribute__((may_alias));
+
+// Swaps the bytes of both pixels in a pair, between the stored layout and standard RGB565. A single REV16.
+GETTER constexpr std::uint32_t swap_pair_bytes(std::uint32_t pair)
+{
+    return (pair & 0x00FF00FFu) << 8 | (pair >> 8 & 0x00FF00FFu);
+}
+
+// Copies `count` RGB565 pixels, two at a time with 32 bit loads and stores. Sources that are a pixel out of
+//   alignment with the destination are read as aligned words and shifted into place.
+inline void copy_pixels(std::uint16_t* destination, const std::uint16_t* source, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if ((reinterpret_cast<std::uintptr_t>(destination) & 0b10u) != 0)
+    {
+        *destination++ = *source++;
+        --count;
+    }
+    pixel_pair_t* out{ reinterpret_cast<pixel_pair_t*>(destination) };
+    if ((reinterpret_cast<std::uintptr_t>(source) & 0b10u) == 0)
+    {
+        const pixel_pair_t* in{ reinterpret_cast<const pixel_pair_t*>(source) };
+        for (; count >= 2; count -= 2)
+        {
+            *out++ = *in++;
+        }
+        source = reinterpret_cast<const std::uint16_t*>(in);
+    }
+    else if (count >= 2)
+    {
+        // The aligned word holding source[0] also holds the pixel before it, which is shifted out
+        const pixel_pair_t* in{ reinterpret_cast<const pixel_pair_t*>(source - 1) };
+        std::uint32_t previous{ *in++ };
+        for (; count >= 2; count -= 2)
+        {
+            const std::uint32_t next{ *in++ };
+            *out++ = previous >> 16 | next << 16;
+            previous = next;
+        }
+        source = reinterpret_cast<const std::uint16_t*>(in) - 1;
+    }
+    if (count != 0)
+    {
+        *reinterpret_cast<std::uint16_t*>(out) = *source;
+    }
+}
+
+// Copies `count` pixels from `source` leftwards, so destination[i] = source[-i]
+inline void copy_pixels_reversed(std::uint16_t* destination, const std::uint16_t* source, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if ((reinterpret_cast<std::uintptr_t>(destination) & 0b10u) != 0)
+    {
+        *destination++ = *source--;
+        --count;
+    }
+    pixel_pair_t* out{ reinterpret_cast<pixel_pair_t*>(destination) };
+    for (; count >= 2; count -= 2, source -= 2)
+    {
+        *out++ = source[0] | static_cast<std::uint32_t>(source[-1]) << 16;
+    }
+    if (count != 0)
+    {
+        *reinterpret_cast<std::uint16_t*>(out) = *source;
+    }
+}
+
+// Copies every run of pixels that aren't `key`, stepping through the source backwards if TReverse
+template <bool TReverse>
+inline void copy_keyed_pixels(std::uint16_t* destination, const std::uint16_t* source, std::size_t count, std::uint16_t key)
+{
+    constexpr std::ptrdiff_t step{ TReverse ? -1 : 1 };
+    std::size_t x{ 0 };
+    while (x < count)
+    {
+        while (x < count && source[static_cast<std::ptrdiff_t>(x) * step] == key)
+        {
+            ++x;
+        }
+        const std::size_t run_start{ x };
+        while (x < count && source[static_cast<std::ptrdiff_t>(x) * step] != key)
+        {
+            ++x;
+        }
+        if constexpr (TReverse)
+        {
+            copy_pixels_reversed(destination + run_start, source - run_start, x - run_start);
+        }
+        else
+        {
+            copy_pixels(destination + run_start, source + run_start, x - run_start);
+        }
+    }
+}
+
+// Palette index of pixel `x` of an indexed row
+template <SpriteFormat TFormat>
+inline std::uint32_t get_index(const std::uint8_t* row, std::size_t x)
+{
+    if constexpr (TFormat == SpriteFormat::Indexed4)
+    {
+        return (row[x / 2u] >> ((x & 1u) != 0 ? 0u : 4u)) & 0x0Fu;
+    }
+    else
+    {
+        return row[x];
+    }
+}
+
+// Looks up `count` pixels of an indexed row starting at pixel `x`, stepping backwards if TReverse. Pairs of opaque
+//   pixels are written with one 32 bit store.
+template <SpriteFormat TFormat, bool TReverse>
+inline void expand_indexed_pixels(std::uint16_t* destination, const std::uint8_t* row, std::size_t x, std::size_t count,
+    const RGB565* palette, std::optional<std::uint16_t> transparent_index)
+{
+    constexpr std::ptrdiff_t step{ TReverse ? -1 : 1 };
+    const auto next_index{
+        [&]()
+        {
+            const std::uint32_t index{ get_index<TFormat>(row, x) };
+            x = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(x) + step);
+            return index;
+        }
+    };
+    if (!transparent_index.has_value())
+    {
+        if (count != 0 && (reinterpret_cast<std::uintptr_t>(destination) & 0b10u) != 0)
+        {
+            *destination++ = palette[next_index()].data;
+            --count;
+        }
+        pixel_pair_t* out{ reinterpret_cast<pixel_pair_t*>(destination) };
+        for (; count >= 2; count -= 2)
+        {
+            const std::uint32_t first{ palette[next_index()].data };
+            *out++ = first | static_cast<std::uint32_t>(palette[next_index()].data) << 16;
+        }
+        if (count != 0)
+        {
+            *reinterpret_cast<std::uint16_t*>(out) = palette[next_index()].data;
+        }
+        return;
+    }
+    const std::uint32_t key{ transparent_index.value() };
+    for (std::size_t i{ 0 }; i < count; ++i)
+    {
+        const std::uint32_t index{ next_index() };
+        if (index != key)
+        {
+            destination[i] = palette[index].data;
+        }
+    }
+}
+}
+
+// Draws `sprite` with its top left corner at x, y on any target with get_width(), get_row(y) and mark_dirty().
+// The source rect, flip and screen edges are resolved into one visible rect up front, so the per-row work is
+//   just a copy or palette lookup with no clipping.
+template <typename TTarget>
+PICONSOLE_FUNC void draw_sprite(TTarget& target, const Sprite& sprite, std::int32_t x, std::int32_t y,
+    const SpriteBlit& blit = {})
+{
+    const Rect source{
+        blit.source.empty()
+            ? Rect{ .width = static_cast<std::uint32_t>(sprite.get_width()), .height = static_cast<std::uint32_t>(sprite.get_height()) }
+            : blit.source.clipped(sprite.get_width(), sprite.get_height())
+    };
+    const std::span<const RGB565> palette{ blit.palette.empty() ? sprite.get_palette() : blit.palette };
+    if (source.empty()
+        || (sprite.get_format() == SpriteFormat::Indexed8 && palette.size() < 256u)
+        || (sprite.get_format() == SpriteFormat::Indexed4 && palette.size() < 16u))
+    {
+        return;
+    }
+    const std::int32_t target_width{ static_cast<std::int32_t>(target.get_width()) };
+    const std::int32_t target_height{ static_cast<std::int32_t>(target.get_height()) };
+    const std::int32_t start_x{ std::max(x, 0) };
+    const std::int32_t start_y{ std::max(y, 0) };
+    const std::int32_t end_x{ std::min(x + static_cast<std::int32_t>(source.width), target_width) };
+    const std::int32_t end_y{ std::min(y + static_cast<std::int32_t>(source.height), target_height) };
+    if (start_x >= end_x || start_y >= end_y)
+    {
+        return;
+    }
+    const std::size_t visible_width{ static_cast<std::size_t>(end_x - start_x) };
+    target.mark_dirty(start_x, start_y, visible_width, end_y - start_y);
+
+    const bool flip_horizontal{ (static_cast<std::uint8_t>(blit.flip) & static_cast<std::uint8_t>(Flip::Horizontal)) != 0 };
+    const bool flip_vertical{ (static_cast<std::uint8_t>(blit.flip) & static_cast<std::uint8_t>(Flip::Vertical)) != 0 };
+    // Sprite column drawn at start_x; with a horizontal flip columns are then read right to left
+    const std::size_t skipped_columns{ static_cast<std::size_t>(start_x - x) };
+    const std::size_t first_column{
+        flip_horizontal ? source.end_x() - 1u - skipped_columns : source.x + skipped_columns
+    };
+    const std::optional<std::uint16_t> color_key{ sprite.get_color_key() };
+    for (std::int32_t screen_y{ start_y }; screen_y < end_y; ++screen_y)
+    {
+        const std::span<RGB565> pixels{ target.get_row(static_cast<std::size_t>(screen_y)) };
+        if (pixels.empty())
+        {
+            continue;
+        }
+        std::uint16_t* const out{ reinterpret_cast<std::uint16_t*>(pixels.data() + start_x) };
+        const std::size_t drawn_row{ static_cast<std::size_t>(screen_y - y) };
+        const std::uint8_t* const row{
+            sprite.get_row(flip_vertical ? source.end_y() - 1u - drawn_row : source.y + drawn_row)
+        };
+        switch (sprite.get_format())
+        {
+        case SpriteFormat::RGB565:
+        {
+            const std::uint16_t* const in{ reinterpret_cast<const std::uint16_t*>(row) + first_column };
+            if (color_key.has_value())
+            {
+                if (flip_horizontal)
+                {
+                    detail::copy_keyed_pixels<true>(out, in, visible_width, color_key.value());
+                }
+                else
+                {
+                    detail::copy_keyed_pixels<false>(out, in, visible_width, color_key.value());
+                }
+            }
+            else if (flip_horizontal)
+            {
+                detail::copy_pixels_reversed(out, in, visible_width);
+            }
+            else
+            {
+                detail::copy_pixels(out, in, visible_width);
+            }
+            break;
+        }
+        case SpriteFormat::Indexed8:
+            if (flip_horizontal)
+            {
+                detail::expand_indexed_pixels<SpriteFormat::Indexed8, true>(out, row, first_column, visible_width, palette.data(), color_key);
+            }
+            else
+            {
+                detail::expand_indexed_pixels<SpriteFormat::Indexed8, false>(out, row, first_column, visible_width, palette.data(), color_key);
+            }
+            break;
+        case SpriteFormat::Indexed4:
+            if (flip_horizontal)
+            {
+                detail::expand_indexed_pixels<SpriteFormat::Indexed4, true>(out, row, first_column, visible_width, palette.data(), color_key);
+            }
+            else
+            {
+                detail::expand_indexed_pixels<SpriteFormat::Indexed4, false>(out, row, first_column, visible_width, palette.data(), color_key);
+            }
+            break;
+        }
+    }
+}
+}
@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "PICOnsole_defines.h"
+#include "debug.h"
+#include "gfx/sprite.h"
+#include "interfaces/SD.h"
+
+namespace gfx
+{
+// `TPageCount` buffers of `TPageSize` bytes holding pages of some larger store, such as a file on the SD card.
+// A miss refills the least recently used buffer, so a working set of up to TPageCount pages is read only once.
+template <std::size_t TPageSize, std::size_t TPageCount>
+class PageCache
+{
+public:
+    static_assert(TPageCount > 0);
+    constexpr static std::size_t page_size{ TPageSize };
+    constexpr static std::size_t page_count{ TPageCount };
+    constexpr static std::uint32_t no_page{ std::numeric_limits<std::uint32_t>::max() };
+
+    struct Stats
+    {
+        std::uint32_t hits{ 0u };
+        std::uint32_t misses{ 0u };
+        // Pages read by preload() rather than by a miss
+        std::uint32_t preloads{ 0u };
+        // Misses and preloads that had to throw away another page
+        std::uint32_t evictions{ 0u };
+    };
+
+    // Page `page`, calling `read(page, bytes)` to fill a buffer if it isn't cached. Empty if the read fails.
+    // The bytes stay valid until the page is evicted, which takes at least TPageCount - 1 other pages being loaded.
+    template <typename TRead>
+    std::span<const std::uint8_t> get(std::uint32_t page, TRead&& read)
+    {
+        if (Slot* const slot{ find(page) })
+        {
+            ++stats.hits;
+            slot->last_used = ++clock;
+            return slot->bytes;
+        }
+        ++stats.misses;
+        return load(page, read);
+    }
+    // Loads `page` ahead of it being needed; does nothing if it's already cached
+    template <typename TRead>
+    bool preload(std::uint32_t page, TRead&& read)
+    {
+        if (find(page) != nullptr)
+        {
+            return true;
+        }
+        ++stats.preloads;
+        return !load(page, read).empty();
+    }
+
+    GETTER bool contains(std::uint32_t page) const
+    {
+        return std::any_of(slots.begin(), slots.end(), [page](const Slot& slot) { return slot.page == page; });
+    }
+    void clear()
+    {
+        for (Slot& slot : slots)
+        {
+            slot.page = no_page;
+            slot.last_used = 0u;
+        }
+    }
+    GETTER const Stats& get_stats() const { return stats; }
+    void reset_stats() { stats = Stats{}; }
+
+private:
+    struct Slot
+    {
+        std::uint32_t page{ no_page };
+        std::uint32_t last_used{ 0u };
+        // Sprites are drawn straight out of the buffer a word at a time
+        alignas(4) std::array<std::uint8_t, TPageSize> bytes{};
+    };
+
+    Slot* find(std::uint32_t page)
+    {
+        const auto slot{ std::find_if(slots.begin(), slots.end(), [page](const Slot& slot) { return slot.page == page; }) };
+        return slot != slots.end() ? &*slot : nullptr;
+    }
+    template <typename TRead>
+    std::span<const std::uint8_t> load(std::uint32_t page, TRead& read)
+    {
+        // Empty slots have never been used, so they're always the least recently used
+        Slot& slot{ *std::min_element(slots.begin(), slots.end(),
+            [](const Slot& a, const Slot& b) { return a.last_used < b.last_used; }) };
+        if (slot.page != no_page)
+        {
+            ++stats.evictions;
+        }
+        slot.page = no_page;
+        if (!read(page, std::span<std::uint8_t>{ slot.bytes }))
+        {
+            slot.last_used = 0u;
+            return {};
+        }
+        slot.page = page;
+        slot.last_used = ++clock;
+        return slot.bytes;
+    }
+
+    std::array<Slot, TPageCount> slots{};
+    std::uint32_t clock{ 0u };
+    Stats stats{};
+};
+
+// Sprite frames streamed from an atlas file on the SD card through a PageCache in program RAM.
+// Atlases are written by tools/sprite_atlas.py: a header, the palette for indexed atlases, an index of every frame
+//   and then the frames' pixels, packed so no frame crosses a page boundary. The file stays open, so a frame that
+//   isn't cached costs one seek and one page sized read and never a whole-file read.
+template <std::size_t TPageSize = 4096, std::size_t TPageCount = 8>
+class SpriteAtlas
+{
+public:
+    using Cache = PageCache<TPageSize, TPageCount>;
+    using Stats = typename Cache::Stats;
+    constexpr static std::size_t page_size{ TPageSize };
+    constexpr static std::size_t page_count{ TPageCount };
+    constexpr static std::size_t max_prefetches{ 8 };
+
+    constexpr static std::string_view file_magic{ "PATL" };
+    constexpr static std::uint8_t file_version{ 1u };
+
+    struct Header
+    {
+        char magic[4];
+        std::uint8_t version;
+        SpriteFormat format;
+        std::uint16_t frame_count;
+        std::uint16_t palette_size;
+        // Pages are this many bytes of the file, which must fit in one of the cache's pages
+        std::uint16_t page_size;
+        // Where the first page starts
+        std::uint32_t data_offset;
+    };
+    static_assert(sizeof(Header) == 16);
+
+    struct Frame
+    {
+        // From the start of the first page
+        std::uint32_t offset;
+        std::uint32_t size;
+        std::uint16_t width;
+        std::uint16_t height;
+        // Transparent color or palette index if flags has has_color_key set
+        std::uint16_t color_key;
+        std::uint8_t flags;
+        std::uint8_t reserved;
+
+        constexpr static std::uint8_t has_color_key{ 0b1u };
+    };
+    static_assert(sizeof(Frame) == 16);
+
+    SpriteAtlas() = default;
+    explicit SpriteAtlas(const char* path) { open(path); }
+
+    // Opens an atlas, reading its header, palette and frame index into RAM
+    bool open(const char* path)
+    {
+        close();
+        reader.emplace(path);
+        if (!reader->is_valid() || !reader->read(header))
+        {
+            print("SpriteAtlas failed to read header: %s\n", path);
+            close();
+            return false;
+        }
+        // Indexed sprites need a palette entry for every possible index
+        const std::size_t min_palette_size{
+            header.format == SpriteFormat::Indexed8 ? 256u : header.format == SpriteFormat::Indexed4 ? 16u : 0u
+        };
+        if (std::string_view{ header.magic, sizeof(header.magic) } != file_magic || header.version != file_version
+            || header.format > SpriteFormat::Indexed4 || header.palette_size < min_palette_size
+            || header.page_size == 0u || header.page_size > TPageSize)
+        {
+            print("SpriteAtlas failed to open %s; bad header or its %u byte pages don't fit in %u bytes\n",
+                path, header.page_size, static_cast<unsigned>(TPageSize));
+            close();
+            return false;
+        }
+        palette.resize(header.palette_size);
+        frames.resize(header.frame_count);
+        if (!reader->read_bytes(std::span<std::uint8_t>{ reinterpret_cast<std::uint8_t*>(palette.data()), palette.size() * sizeof(RGB565) })
+            || !reader->read_bytes(std::span<std::uint8_t>{ reinterpret_cast<std::uint8_t*>(frames.data()), frames.size() * sizeof(Frame) }))
+        {
+            print("SpriteAtlas failed to read index: %s\n", path);
+            close();
+            return false;
+        }
+        const bool frames_fit{ std::all_of(frames.begin(), frames.end(),
+            [this](const Frame& frame)
+            {
+                return frame.size >= Sprite::get_stride(header.format, frame.width) * frame.height
+                    && frame.offset % header.page_size + frame.size <= header.page_size;
+            }) };
+        if (!frames_fit)
+        {
+            print("SpriteAtlas failed to open %s; a frame is too small or crosses a page boundary\n", path);
+            close();
+            return false;
+        }
+        return true;
+    }
+    void close()
+    {
+        reader.reset();
+        cache.clear();
+        frames.clear();
+        palette.clear();
+        prefetch_count = 0;
+    }
+    GETTER bool is_open() const { return reader.has_value() && reader->is_valid(); }
+
+    GETTER std::size_t get_frame_count() const { return frames.size(); }
+    GETTER std::span<const Frame> get_frames() const { return frames; }
+    GETTER std::span<const RGB565> get_palette() const { return palette; }
+
+    // Frame `index` as a sprite drawn straight out of the cache, reading its page from the SD card if it isn't
+    //   cached. The sprite is only valid until its page is evicted, so draw it before getting TPageCount more frames.
+    GETTER std::optional<Sprite> get(std::size_t index)
+    {
+        if (index >= frames.size() || !is_open())
+        {
+            return std::nullopt;
+        }
+        const Frame& frame{ frames[index] };
+        const std::span<const std::uint8_t> page{ cache.get(get_page(frame), make_reader()) };
+        if (page.empty())
+        {
+            return std::nullopt;
+        }
+        const std::span<const std::uint8_t> pixels{ page.subspan(frame.offset % header.page_size, frame.size) };
+        const bool has_color_key{ (frame.flags & Frame::has_color_key) != 0 };
+        if (header.format == SpriteFormat::RGB565)
+        {
+            return Sprite{
+                { reinterpret_cast<const RGB565*>(pixels.data()), pixels.size() / sizeof(RGB565) }, frame.width, frame.height,
+                has_color_key ? std::optional<RGB565>{ RGB565{ frame.color_key } } : std::nullopt
+            };
+        }
+        return Sprite{
+            header.format, pixels, frame.width, frame.height, palette,
+            has_color_key ? std::optional<std::uint8_t>{ static_cast<std::uint8_t>(frame.color_key) } : std::nullopt
+        };
+    }
+
+    // Hints that frame `index` will be drawn soon; load_prefetched() then reads it in at a convenient time
+    bool prefetch(std::size_t index)
+    {
+        if (index >= frames.size())
+        {
+            return false;
+        }
+        const std::uint32_t page{ get_page(frames[index]) };
+        const auto queued{ prefetches.begin() + prefetch_count };
+        if (cache.contains(page) || std::find(prefetches.begin(), queued, page) != queued)
+        {
+            return true;
+        }
+        if (prefetch_count == prefetches.size())
+        {
+            return false;
+        }
+        prefetches[prefetch_count++] = page;
+        return true;
+    }
+    // Reads up to `max_pages` prefetched pages, e.g. while the last frame is still being sent to the panel.
+    // Returns how many were read.
+    std::size_t load_prefetched(std::size_t max_pages = max_prefetches)
+    {
+        const std::size_t count{ std::min(max_pages, prefetch_count) };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            cache.preload(prefetches[i], make_reader());
+        }
+        std::copy(prefetches.begin() + count, prefetches.begin() + prefetch_count, prefetches.begin());
+        prefetch_count -= count;
+        return count;
+    }
+
+    GETTER const Stats& get_stats() const { return cache.get_stats(); }
+    void reset_stats() { cache.reset_stats(); }
+
+private:
+    GETTER std::uint32_t get_page(const Frame& frame) const { return frame.offset / header.page_size; }
+    auto make_reader()
+    {
+        return [this](std::uint32_t page, std::span<std::uint8_t> bytes)
+        {
+            reader->seek_absolute(header.data_offset + page * header.page_size);
+            return reader->read_bytes(bytes.first(header.page_size));
+        };
+    }
+
+    std::optional<SDCard::FileReader> reader{};
+    Header header{};
+    std::vector<RGB565> palette{};
+    std::vector<Frame> frames{};
+    Cache cache{};
+    std::array<std::uint32_t, max_prefetches> prefetches{};
+    std::size_t prefetch_count{ 0 };
+};
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/display_list.h"
+#include "gfx/region.h"
+#include "gfx/sprite.h"
+#include "gfx/text.h"
+#include "gfx/tilemap.h"
+
+namespace gfx
+{
+// Drawing target covering `row_count` full-width rows of the screen starting at `start_y`.
+// Everything is drawn in screen coordinates and clipped to the strip, so the same calls produce the same pixels
+//   as they would in a full framebuffer.
+template <typename TLCD>
+class StripTarget
+{
+public:
+    using ColorFormat = typename TLCD::ColorFormat;
+    using TextSettings = typename TLCD::TextSettings;
+    using TextLayout = typename TLCD::TextLayout;
+    constexpr static std::size_t width{ TLCD::width };
+    constexpr static std::size_t height{ TLCD::height };
+
+    StripTarget(std::span<ColorFormat> pixels, std::size_t start_y, std::size_t row_count)
+        : pixels{ pixels }, start_y{ start_y }, end_y{ start_y + row_count }
+    {}
+
+    GETTER std::size_t get_width() const { return width; }
+    GETTER std::size_t get_height() const { return height; }
+
+    void set_pixel(ColorFormat color, std::size_t x, std::size_t y)
+    {
+        if (x < width && y >= start_y && y < end_y)
+        {
+            pixels[x + (y - start_y) * width] = color;
+        }
+    }
+    std::span<ColorFormat> get_row(std::size_t y)
+    {
+        if (y < start_y || y >= end_y)
+        {
+            return {};
+        }
+        return pixels.subspan((y - start_y) * width, width);
+    }
+    void fill(ColorFormat color)
+    {
+        std::fill(pixels.begin(), pixels.end(), color);
+    }
+    void line_horizontal(ColorFormat color, std::size_t x, std::size_t y, std::size_t line_width)
+    {
+        if (x >= width || y < start_y || y >= end_y)
+        {
+            return;
+        }
+        const auto row{ pixels.begin() + (y - start_y) * width };
+        std::fill(row + x, row + std::min(x + line_width, width), color);
+    }
+    void line_vertical(ColorFormat color, std::size_t x, std::size_t y, std::size_t line_height)
+    {
+        if (x >= width)
+        {
+            return;
+        }
+        const std::size_t first_row{ std::max(y, start_y) };
+        const std::size_t last_row{ std::min(y + line_height, end_y) };
+        for (std::size_t row{ first_row }; row < last_row; ++row)
+        {
+            pixels[x + (row - start_y) * width] = color;
+        }
+    }
+    void rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        line_horizontal(color, x, y, rectangle_width);
+        if (rectangle_height <= 1)
+        {
+            return;
+        }
+        line_horizontal(color, x, y + rectangle_height - 1, rectangle_width);
+        if (rectangle_height <= 2)
+        {
+            return;
+        }
+        const std::size_t side_height{ rectangle_height - 2 };
+        line_vertical(color, x, y + 1, side_height);
+        if (rectangle_width > 1)
+        {
+            line_vertical(color, x + rectangle_width - 1, y + 1, side_height);
+        }
+    }
+    void filled_rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        const std::size_t first_row{ std::max(y, start_y) };
+        const std::size_t last_row{ std::min(y + rectangle_height, end_y) };
+        for (std::size_t row{ first_row }; row < last_row; ++row)
+        {
+            line_horizontal(color, x, row, rectangle_width);
+        }
+    }
+    void text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_text<StripTarget>(*this, string, settings);
+    }
+    void centered_text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_centered_text<StripTarget>(*this, string, settings);
+    }
+    void text(const TextLayout& layout)
+    {
+        layout.render(*this);
+    }
+    void blit(std::span<const ColorFormat> source, std::size_t x, std::size_t y, std::size_t source_width, std::size_t source_height)
+    {
+        if (x >= width)
+        {
+            return;
+        }
+        const std::size_t visible_width{ std::min(source_width, width - x) };
+        const std::size_t first_row{ std::max(y, start_y) };
+        const std::size_t last_row{ std::min(y + source_height, end_y) };
+        for (std::size_t row{ first_row }; row < last_row; ++row)
+        {
+            const auto source_row{ source.begin() + (row - y) * source_width };
+            std::copy(source_row, source_row + visible_width, pixels.begin() + x + (row - start_y) * width);
+        }
+    }
+    void sprite(const Sprite& sprite, std::int32_t x, std::int32_t y, const SpriteBlit& blit = {})
+    {
+        draw_sprite(*this, sprite, x, y, blit);
+    }
+    // Strips are sent whole, so there's nothing to track
+    void mark_dirty(std::size_t, std::size_t, std::size_t, std::size_t) {}
+
+private:
+    std::span<ColorFormat> pixels;
+    std::size_t start_y;
+    std::size_t end_y;
+};
+
+// Renders a DisplayList to the panel without a full framebuffer.
+// The screen is rasterized `TStripRows` rows at a time into one of two small strip buffers; while one strip is
+//   being sent over DMA the next is rasterized into the other.
+// The list is drawn in screen coordinates. On LCDs with hardware scrolling the panel is scrolled to the LCD's
+//   scroll offset first, and each row is rotated to match, so the panel's left edge shows column 0 of the list.
+template <typename TLCD, std::size_t TStripRows = 8>
+class StripRenderer
+{
+public:
+    using ColorFormat = typename TLCD::ColorFormat;
+    constexpr static std::size_t strip_rows{ TStripRows };
+    using strip_type = std::array<ColorFormat, TLCD::width * TStripRows>;
+
+    // Returns once the last strip has started sending; the LCD's wait_present() waits for it to finish
+    template <std::size_t TMaxCommands, std::size_t TMaxTexts, std::size_t TMaxSpriteBlits>
+    void render(TLCD& lcd, const DisplayList<TLCD, TMaxCommands, TMaxTexts, TMaxSpriteBlits>& display_list,
+        ColorFormat clear_color = color::black<ColorFormat>())
+    {
+        lcd.wait_present();
+        // Buffer column of the screen's left edge
+        std::size_t scroll_offset{ 0 };
+        if constexpr (hardware_scroll_t<TLCD>)
+        {
+            lcd.apply_scroll_offset();
+            scroll_offset = lcd.get_scroll_offset();
+        }
+        lcd.begin_write_window(Rect{ .width = TLCD::width, .height = TLCD::height });
+        std::size_t strip_index{ 0 };
+        for (std::size_t y{ 0 }; y < TLCD::height; y += strip_rows)
+        {
+            const std::size_t row_count{ std::min(strip_rows, TLCD::height - y) };
+            // Only the strip sent last can still be in flight, and that's always the other buffer
+            strip_type& strip{ strips[strip_index] };
+            strip_index = (strip_index + 1) % strips.size();
+            StripTarget<TLCD> target{ { strip.data(), row_count * TLCD::width }, y, row_count };
+            target.fill(clear_color);
+            display_list.render(target);
+            if (scroll_offset != 0)
+            {
+                // Screen column x goes to buffer column (x + scroll_offset) % width
+                for (std::size_t row{ 0 }; row < row_count; ++row)
+                {
+                    const auto row_start{ strip.begin() + row * TLCD::width };
+                    std::rotate(row_start, row_start + (TLCD::width - scroll_offset), row_start + TLCD::width);
+                }
+            }
+            lcd.write_data_async({
+                reinterpret_cast<const std::uint8_t*>(strip.data()),
+                row_count * TLCD::width * sizeof(ColorFormat)
+            });
+        }
+    }
+
+private:
+    std::array<strip_type, 2> strips;
+};
+}
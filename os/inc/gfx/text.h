@@ -1,9 +1,17 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <concepts>
+#include <limits>
 #include <optional>
+#include <span>
 #include <string_view>
 #include "gfx/color.h"
+#include "gfx/font.h"
+#include "gfx/fonts/ascii_5px.h"
+#include "gfx/glyph_blitter.h"
+#include "gfx/region.h"
 #include "gfx/typeface.h"
 
 namespace gfx::text
@@ -25,11 +33,14 @@ struct PrintSettings
     std::optional<std::uint32_t> padding_y{ std::nullopt };
     typename TLCD::ColorFormat color{ color::white<typename TLCD::ColorFormat>() };
     std::optional<typename TLCD::ColorFormat> background{ std::nullopt };
+    // Must outlive any TextLayout using these settings
+    const Font* font{ &get_ascii_font() };
 };
 
-template <typename TLCD, std::size_t TWidth>
-PICONSOLE_FUNC void print_character_row(TLCD& lcd, const std::bitset<TWidth>& character_row,
-    const PrintSettings<std::remove_cvref_t<TLCD>>& settings = {})
+// Print functions draw onto any target with a set_pixel(color, x, y) member; TLCD is only used for the settings type
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>, std::size_t TWidth>
+PICONSOLE_FUNC void print_character_row(TTarget& lcd, const std::bitset<TWidth>& character_row,
+    const PrintSettings<TLCD>& settings = {})
 {
     std::uint32_t x{ settings.x + settings.padding_x };
     for (std::size_t i{ 0 }, b{ TWidth - 1}; i < TWidth; ++i, --b)
@@ -53,9 +64,9 @@ PICONSOLE_FUNC void print_character_row(TLCD& lcd, const std::bitset<TWidth>& ch
     }
 }
 
-template <typename TLCD, std::size_t THeight, std::size_t TWidth = THeight>
-PICONSOLE_FUNC void print_character(TLCD& lcd, const TextCharacter<THeight, TWidth>& character,
-    PrintSettings<std::remove_cvref_t<TLCD>> settings = {})
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>, std::size_t THeight, std::size_t TWidth = THeight>
+PICONSOLE_FUNC void print_character(TTarget& lcd, const TextCharacter<THeight, TWidth>& character,
+    PrintSettings<TLCD> settings = {})
 {
     for (const auto& character_row : character)
     {
@@ -68,9 +79,9 @@ PICONSOLE_FUNC void print_character(TLCD& lcd, const TextCharacter<THeight, TWid
     }
 }
 
-template <typename TLCD, typeface_t TTypeface>
-PICONSOLE_FUNC void print_character(TLCD& lcd, char character, const TTypeface& typeface = get_ascii_typeface(),
-    const PrintSettings<std::remove_cvref_t<TLCD>>& settings = {})
+template <typename TTarget, fixed_typeface_t TTypeface, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_character(TTarget& lcd, char character, const TTypeface& typeface,
+    const PrintSettings<TLCD>& settings = {})
 {
     if (is_character_printable(character, typeface))
     {
@@ -78,9 +89,34 @@ PICONSOLE_FUNC void print_character(TLCD& lcd, char character, const TTypeface&
     }
 }
 
-template <typename TLCD, typeface_t TTypeface = std::remove_cvref_t<decltype(get_ascii_typeface())>>
-PICONSOLE_FUNC void print_string(TLCD& lcd, std::string_view string, const TTypeface& typeface = get_ascii_typeface(),
-    PrintSettings<std::remove_cvref_t<TLCD>> settings = {})
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_character(TTarget& lcd, char character, const Font& font, const PrintSettings<TLCD>& settings = {})
+{
+    const Glyph& glyph{ font.get_glyph(character) };
+    if (glyph.width == 0u)
+    {
+        return;
+    }
+    // Centered lines may start off the left edge, which wraps settings.x around
+    const std::int32_t x{ static_cast<std::int32_t>(settings.x + settings.padding_x + glyph.bearing) };
+    const std::int32_t end_x{ static_cast<std::int32_t>(settings.end_x - settings.padding_x) };
+    const std::uint32_t end_y{ settings.end_y - settings.padding_y.value_or(0u) * 2u };
+    for (std::uint32_t row{ 0u }; row < font.height && settings.y + row <= end_y; ++row)
+    {
+        const std::uint32_t glyph_row{ font.rows[glyph.row_offset + row] };
+        for (std::int32_t column{ std::max(-x, 0) }; column < glyph.width && x + column < end_x; ++column)
+        {
+            if ((glyph_row & (0x80u >> column)) != 0u)
+            {
+                lcd.set_pixel(settings.color, static_cast<std::uint32_t>(x + column), settings.y + row);
+            }
+        }
+    }
+}
+
+template <typename TTarget, fixed_typeface_t TTypeface, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_string(TTarget& lcd, std::string_view string, const TTypeface& typeface,
+    PrintSettings<TLCD> settings = {})
 {
     const std::uint32_t character_width{ get_typeface_character_width<TTypeface>() + 1u };
     const std::uint32_t character_height{ get_typeface_character_height<TTypeface>() + 1u };
@@ -107,4 +143,328 @@ PICONSOLE_FUNC void print_string(TLCD& lcd, std::string_view string, const TType
         }
     }
 }
+
+// Prints a string with settings.font one glyph at a time
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_string(TTarget& lcd, std::string_view string, PrintSettings<TLCD> settings = {})
+{
+    const Font& font{ *settings.font };
+    const std::uint32_t wrapped_line_width{ (settings.end_x - settings.padding_x) - (settings.wrap_x + settings.padding_x) };
+    for (char character : string)
+    {
+        if (character == '\n')
+        {
+            settings.x = settings.wrap_x;
+            settings.y += font.get_line_height();
+        }
+        else
+        {
+            print_character(lcd, character, font, settings);
+            settings.x += font.get_advance(character);
+        }
+        if (settings.wrap_mode == WrapMode::Wrap && settings.x > settings.end_x)
+        {
+            settings.x -= wrapped_line_width;
+        }
+    }
+}
+
+// Targets that hand out whole RGB565 rows get text drawn by the GlyphBlitter instead of pixel by pixel
+template <typename TTarget>
+concept row_target_t = requires (TTarget& target, std::size_t y) {
+    { target.get_row(y) } -> std::same_as<std::span<RGB565>>;
+};
+
+// Draws one row of a laid out line of text; rows past the font's height are its line spacing.
+// The line is `line_width` pixels wide starting at `line_x` and is clipped at `end_x`.
+// With an opaque blitter, `background_x` to `background_end_x` is filled around the glyphs and any part of the
+//   line outside that range is drawn transparently.
+template <row_target_t TTarget>
+inline void blit_text_row(TTarget& lcd, std::string_view line, const Font& font, std::int32_t line_x,
+    std::int32_t line_width, std::int32_t end_x, std::uint32_t y, std::uint32_t glyph_row, const GlyphBlitter& blitter,
+    std::uint32_t background_x = 0u, std::uint32_t background_end_x = 0u)
+{
+    const std::span<RGB565> pixels{ lcd.get_row(y + glyph_row) };
+    if (pixels.empty())
+    {
+        return;
+    }
+    const std::int32_t width{ static_cast<std::int32_t>(pixels.size()) };
+    const std::uint32_t start_x{ static_cast<std::uint32_t>(std::clamp(line_x, 0, width)) };
+    const std::uint32_t stop_x{ static_cast<std::uint32_t>(std::clamp(
+        std::min(line_x + line_width, end_x),
+        static_cast<std::int32_t>(start_x), width
+    )) };
+    // Draws the part of the line between from_x and to_x
+    const auto draw{
+        [&](const GlyphBlitter& part_blitter, std::uint32_t from_x, std::uint32_t to_x)
+        {
+            if (from_x < to_x)
+            {
+                part_blitter.draw_row(pixels.subspan(from_x, to_x - from_x), line, glyph_row, font,
+                    static_cast<std::size_t>(static_cast<std::int32_t>(from_x) - line_x));
+            }
+        }
+    };
+    background_end_x = std::min(background_end_x, static_cast<std::uint32_t>(width));
+    if (background_x >= background_end_x)
+    {
+        draw(blitter, start_x, stop_x);
+        return;
+    }
+    const GlyphBlitter transparent_blitter{ blitter.get_color() };
+    const std::uint32_t inside_x{ std::clamp(start_x, background_x, background_end_x) };
+    const std::uint32_t inside_end_x{ std::clamp(stop_x, background_x, background_end_x) };
+    if (background_x < inside_x)
+    {
+        blitter.fill(pixels.subspan(background_x, inside_x - background_x));
+    }
+    draw(transparent_blitter, start_x, std::min(stop_x, background_x));
+    draw(blitter, inside_x, inside_end_x);
+    draw(transparent_blitter, std::max(start_x, background_end_x), stop_x);
+    const std::uint32_t after_x{ std::max(inside_end_x, inside_x) };
+    if (after_x < background_end_x)
+    {
+        blitter.fill(pixels.subspan(after_x, background_end_x - after_x));
+    }
+}
+
+enum class Alignment
+{
+    Left,
+    Centered
+};
+
+// Enough lines to cover a screen `THeight` pixels tall with the built in font
+template <std::size_t THeight>
+consteval std::size_t get_max_text_lines()
+{
+    return THeight / fonts::ascii_5px.get_line_height() + 1u;
+}
+
+// A string measured and broken into lines against a set of PrintSettings once, so it can be drawn every frame
+//   without scanning the string again.
+// Left aligned lines start at settings.x, centered lines are centered on it. Like DisplayList, the string is
+//   referenced rather than copied, so it must outlive the layout.
+template <typename TLCD, std::size_t TMaxLines = get_max_text_lines<TLCD::height>()>
+class TextLayout
+{
+public:
+    using Settings = PrintSettings<TLCD>;
+    constexpr static std::size_t max_lines{ TMaxLines };
+
+    struct Line
+    {
+        std::uint16_t offset{ 0u };
+        std::uint16_t length{ 0u };
+        // Origin of the first glyph; centered lines may start off screen
+        std::int16_t x{ 0 };
+        std::uint16_t y{ 0u };
+        // Sum of the line's advances, including the blank columns after the last glyph
+        std::uint16_t width{ 0u };
+    };
+
+    TextLayout() = default;
+    TextLayout(std::string_view string, const Settings& settings, Alignment alignment = Alignment::Left)
+    {
+        layout(string, settings, alignment);
+    }
+
+    // Breaks `new_string` into lines in a single pass
+    void layout(std::string_view new_string, const Settings& new_settings, Alignment new_alignment = Alignment::Left)
+    {
+        string = new_string;
+        settings = new_settings;
+        alignment = new_alignment;
+        line_count = 0;
+        bounds = Rect{};
+        const Font& font{ *settings.font };
+        line_height = font.get_line_height();
+        const std::uint32_t padding_y{ settings.padding_y.value_or(settings.padding_x) };
+        const std::int32_t padding_x{ static_cast<std::int32_t>(settings.padding_x) };
+        const std::int32_t end_x{ static_cast<std::int32_t>(settings.end_x) };
+        std::int32_t x{ static_cast<std::int32_t>(settings.x) };
+        std::uint32_t y{ settings.y + padding_y };
+        std::int32_t min_x{ std::numeric_limits<std::int32_t>::max() };
+        std::int32_t max_end_x{ std::numeric_limits<std::int32_t>::min() };
+        std::size_t offset{ 0 };
+        while (offset < string.length() && line_count < max_lines && y + padding_y < settings.end_y)
+        {
+            const std::int32_t max_width{ std::max(
+                alignment == Alignment::Left ? (end_x - padding_x) - (x + padding_x) : (end_x - x) * 2,
+                0
+            ) };
+            std::size_t end{ offset };
+            std::int32_t line_width{ 0 };
+            while (end < string.length() && string[end] != '\n')
+            {
+                const std::int32_t advance{ static_cast<std::int32_t>(font.get_advance(string[end])) };
+                if (line_width + advance > max_width)
+                {
+                    break;
+                }
+                line_width += advance;
+                ++end;
+            }
+            const std::int32_t line_x{ (alignment == Alignment::Left ? x : x - line_width / 2) + padding_x };
+            lines[line_count++] = Line{
+                .offset = static_cast<std::uint16_t>(offset), .length = static_cast<std::uint16_t>(end - offset),
+                .x = static_cast<std::int16_t>(line_x), .y = static_cast<std::uint16_t>(y),
+                .width = static_cast<std::uint16_t>(line_width)
+            };
+            min_x = std::min(min_x, line_x);
+            max_end_x = std::max(max_end_x, line_x + line_width);
+            offset = end;
+            if (offset < string.length() && string[offset] == '\n')
+            {
+                ++offset;
+            }
+            else if (offset < string.length() && (settings.wrap_mode == WrapMode::Clip || line_width == 0))
+            {
+                // The rest of the line doesn't fit and isn't wrapped
+                const std::size_t newline_index{ string.find('\n', offset) };
+                if (newline_index == std::string_view::npos)
+                {
+                    break;
+                }
+                offset = newline_index + 1u;
+            }
+            y += line_height;
+            x = static_cast<std::int32_t>(settings.wrap_x);
+        }
+        if (line_count == 0)
+        {
+            return;
+        }
+        // Every line plus padding, without the last spacing column and the last line's spacing
+        const std::int32_t bounds_x{ std::max(min_x - padding_x, 0) };
+        const std::int32_t bounds_end_x{ max_end_x - (max_end_x > min_x ? 1 : 0) + padding_x };
+        const std::uint32_t bounds_end_y{ lines[line_count - 1].y + font.height + padding_y };
+        bounds = Rect{
+            .x = static_cast<std::uint32_t>(bounds_x), .y = settings.y,
+            .width = static_cast<std::uint32_t>(std::max(bounds_end_x - bounds_x, 0)),
+            .height = bounds_end_y - settings.y
+        };
+    }
+
+    // Draws the laid out text onto any target with the same drawing functions as ColorLCD; row targets draw the
+    //   background in the same pass as the glyphs rather than filling it first
+    template <typename TTarget>
+    void render(TTarget& target) const
+    {
+        for (const Line& line : get_lines())
+        {
+            const std::int32_t dirty_x{ std::max<std::int32_t>(line.x, 0) };
+            target.mark_dirty(dirty_x, line.y, std::max<std::int32_t>(line.x + line.width - dirty_x, 0), line_height);
+        }
+        if constexpr (row_target_t<TTarget>)
+        {
+            render_rows(target);
+        }
+        else
+        {
+            if (settings.background.has_value())
+            {
+                target.filled_rectangle(settings.background.value(), bounds.x, bounds.y, bounds.width, bounds.height);
+            }
+            for (const Line& line : get_lines())
+            {
+                Settings line_settings{ settings };
+                line_settings.wrap_mode = WrapMode::Clip;
+                line_settings.x = static_cast<std::uint32_t>(line.x - static_cast<std::int32_t>(settings.padding_x));
+                line_settings.y = line.y;
+                print_string(target, get_line_text(line), line_settings);
+            }
+        }
+    }
+
+    GETTER bool empty() const { return line_count == 0; }
+    GETTER std::span<const Line> get_lines() const { return { lines.data(), line_count }; }
+    GETTER std::string_view get_line_text(const Line& line) const { return string.substr(line.offset, line.length); }
+    GETTER const Settings& get_settings() const { return settings; }
+    GETTER Alignment get_alignment() const { return alignment; }
+    // Area covered by the background: every line plus the settings' padding
+    GETTER const Rect& get_bounds() const { return bounds; }
+
+private:
+    template <row_target_t TTarget>
+    void render_rows(TTarget& target) const
+    {
+        const bool has_background{ settings.background.has_value() };
+        const GlyphBlitter blitter{ settings.color, settings.background };
+        const GlyphBlitter transparent_blitter{ settings.color };
+        const Font& font{ *settings.font };
+        // Next background row that hasn't been drawn yet
+        std::uint32_t background_y{ bounds.y };
+        const auto fill_background_rows{
+            [&](std::uint32_t end_y)
+            {
+                for (end_y = std::min(end_y, bounds.end_y()); background_y < end_y; ++background_y)
+                {
+                    const std::span<RGB565> pixels{ target.get_row(background_y) };
+                    if (bounds.x < pixels.size())
+                    {
+                        const std::uint32_t end_x{ std::min<std::uint32_t>(bounds.end_x(), pixels.size()) };
+                        blitter.fill(pixels.subspan(bounds.x, end_x - bounds.x));
+                    }
+                }
+            }
+        };
+        if (has_background)
+        {
+            target.mark_dirty(bounds.x, bounds.y, bounds.width, bounds.height);
+        }
+        const std::int32_t end_x{ static_cast<std::int32_t>(settings.end_x - settings.padding_x) };
+        const std::uint32_t end_y{ settings.end_y - settings.padding_y.value_or(settings.padding_x) };
+        for (const Line& line : get_lines())
+        {
+            const std::string_view text{ get_line_text(line) };
+            if (has_background)
+            {
+                fill_background_rows(line.y);
+            }
+            for (std::uint32_t glyph_row{ 0u }; glyph_row < line_height && line.y + glyph_row < end_y; ++glyph_row)
+            {
+                const std::uint32_t y{ line.y + glyph_row };
+                if (has_background && y >= background_y && y < bounds.end_y())
+                {
+                    blit_text_row(target, text, font, line.x, line.width, end_x, line.y, glyph_row, blitter,
+                        bounds.x, bounds.end_x());
+                    background_y = y + 1u;
+                }
+                else if (glyph_row < font.height)
+                {
+                    blit_text_row(target, text, font, line.x, line.width, end_x, line.y, glyph_row, transparent_blitter);
+                }
+            }
+        }
+        if (has_background)
+        {
+            fill_background_rows(bounds.end_y());
+        }
+    }
+
+    std::string_view string{};
+    Settings settings{};
+    Alignment alignment{ Alignment::Left };
+    std::array<Line, TMaxLines> lines{};
+    std::size_t line_count{ 0 };
+    std::uint32_t line_height{ 0u };
+    Rect bounds{};
+};
+
+// Prints a block of text, clipping or wrapping each line to the settings' bounds.
+// Targets need set_pixel, filled_rectangle and mark_dirty members, or get_row for the GlyphBlitter.
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_text(TTarget& lcd, std::string_view string, PrintSettings<TLCD> settings = {})
+{
+    TextLayout<TLCD>{ string, settings }.render(lcd);
+}
+
+// Prints a block of text with each line centered on settings.x
+template <typename TTarget, typename TLCD = std::remove_cvref_t<TTarget>>
+PICONSOLE_FUNC void print_centered_text(TTarget& lcd, std::string_view string, PrintSettings<TLCD> settings = {})
+{
+    TextLayout<TLCD>{ string, settings, Alignment::Centered }.render(lcd);
+}
 }
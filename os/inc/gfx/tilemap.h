@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+#include "gfx/region.h"
+#include "gfx/sprite.h"
+
+namespace gfx
+{
+// One cell of a tilemap: a tile index and how that tile is flipped, packed into 16 bits so maps can be constexpr
+//   arrays in flash as easily as arrays in RAM
+struct Tile
+{
+    constexpr static std::uint16_t index_mask{ 0x3FFFu };
+    constexpr static std::uint32_t flip_shift{ 14u };
+
+    constexpr Tile() = default;
+    constexpr Tile(std::uint16_t index, Flip flip = Flip::None)
+        : value{ static_cast<std::uint16_t>((index & index_mask) | static_cast<std::uint32_t>(flip) << flip_shift) }
+    {}
+
+    GETTER constexpr std::uint16_t get_index() const { return value & index_mask; }
+    GETTER constexpr Flip get_flip() const { return static_cast<Flip>(value >> flip_shift); }
+
+    std::uint16_t value{ 0u };
+};
+static_assert(sizeof(Tile) == 2);
+
+// Grid of square RGB565 tiles that wraps around at its edges, so positions past the end of the map repeat it
+template <std::size_t TTileSize>
+class Tilemap
+{
+public:
+    static_assert(TTileSize == 8 || TTileSize == 16, "Tiles are 8x8 or 16x16 pixels");
+    constexpr static std::size_t tile_size{ TTileSize };
+    constexpr static std::size_t tile_pixels{ TTileSize * TTileSize };
+
+    constexpr Tilemap() = default;
+    // `tileset` holds tiles in the framebuffer's layout one after another, each tile_size x tile_size pixels.
+    // `tiles` is `width` x `height` cells, row by row. Both must outlive the map; a map in RAM can be changed at any
+    //   time, but what's already on screen is only updated once it's redrawn.
+    constexpr Tilemap(std::span<const RGB565> tileset, std::span<const Tile> tiles, std::size_t width, std::size_t height)
+        : tileset{ tileset }, tiles{ tiles }, width{ width }, height{ height }
+    {}
+
+    GETTER constexpr std::size_t get_width() const { return width; }
+    GETTER constexpr std::size_t get_height() const { return height; }
+    GETTER constexpr std::size_t get_pixel_width() const { return width * TTileSize; }
+    GETTER constexpr std::size_t get_pixel_height() const { return height * TTileSize; }
+    GETTER constexpr std::size_t get_tile_count() const { return tileset.size() / tile_pixels; }
+    GETTER constexpr bool empty() const { return width == 0u || height == 0u || tiles.size() < width * height; }
+    GETTER constexpr Tile get_tile(std::size_t x, std::size_t y) const { return tiles[x + y * width]; }
+
+    // Draws `area` of the map, in map pixels, with its top left corner at x, y on any target with get_row(y) and
+    //   mark_dirty(). The area may start anywhere and wraps around the map, but must fit on the target.
+    // Tiles are copied a row segment at a time, a word at a time; tiles past the end of the tileset are skipped.
+    template <typename TTarget>
+    PICONSOLE_FUNC void draw(TTarget& target, const Rect& area, std::size_t x, std::size_t y) const
+    {
+        if (area.empty() || empty())
+        {
+            return;
+        }
+        target.mark_dirty(x, y, area.width, area.height);
+        const std::size_t tile_count{ get_tile_count() };
+        const std::uint16_t* const tile_pixels_start{ reinterpret_cast<const std::uint16_t*>(tileset.data()) };
+        const std::size_t start_x{ area.x % get_pixel_width() };
+        std::size_t map_y{ area.y % get_pixel_height() };
+        for (std::size_t row{ 0 }; row < area.height; ++row)
+        {
+            const std::span<RGB565> pixels{ target.get_row(y + row) };
+            if (!pixels.empty())
+            {
+                const Tile* const map_row{ tiles.data() + map_y / TTileSize * width };
+                const std::size_t tile_row{ map_y % TTileSize };
+                std::uint16_t* out{ reinterpret_cast<std::uint16_t*>(pixels.data() + x) };
+                std::size_t tile_x{ start_x / TTileSize };
+                std::size_t column{ start_x % TTileSize };
+                std::size_t remaining{ area.width };
+                while (remaining != 0)
+                {
+                    const std::size_t count{ std::min(TTileSize - column, remaining) };
+                    const Tile tile{ map_row[tile_x] };
+                    if (tile.get_index() < tile_count)
+                    {
+                        const std::uint8_t flip{ static_cast<std::uint8_t>(tile.get_flip()) };
+                        const std::size_t source_row{
+                            (flip & static_cast<std::uint8_t>(Flip::Vertical)) != 0 ? TTileSize - 1u - tile_row : tile_row
+                        };
+                        const std::uint16_t* const source{ tile_pixels_start + tile.get_index() * tile_pixels + source_row * TTileSize };
+                        if ((flip & static_cast<std::uint8_t>(Flip::Horizontal)) != 0)
+                        {
+                            detail::copy_pixels_reversed(out, source + (TTileSize - 1u - column), count);
+                        }
+                        else
+                        {
+                            detail::copy_pixels(out, source + column, count);
+                        }
+                    }
+                    out += count;
+                    remaining -= count;
+                    column = 0;
+                    if (++tile_x == width)
+                    {
+                        tile_x = 0;
+                    }
+                }
+            }
+            if (++map_y == get_pixel_height())
+            {
+                map_y = 0;
+            }
+        }
+    }
+
+private:
+    std::span<const RGB565> tileset{};
+    std::span<const Tile> tiles{};
+    std::size_t width{ 0 };
+    std::size_t height{ 0 };
+};
+
+// LCDs whose panel can pan across the framebuffer along x, like PicoLCD_1_8
+template <typename TLCD>
+concept hardware_scroll_t = requires (TLCD& lcd, std::size_t offset) {
+    lcd.set_scroll_offset(offset);
+};
+
+// Keeps a Tilemap scrolled across the whole screen of an LCD, drawing and sending only what scrolling exposes.
+// With hardware scrolling the framebuffer is a ring along x that the panel pans across, so scrolling sideways
+//   redraws and sends just the newly exposed columns. Scrolling along y, or along x on LCDs without hardware
+//   scrolling, falls back to redrawing the map in software, which sends the whole screen.
+// Everything else on screen scrolls with the map too, so draw sprites through draw_sprite() and anything else at
+//   get_buffer_x(). After each scroll_to(), restore() the map where sprites were drawn into the current buffer;
+//   when double buffered that's where they were two frames ago.
+template <typename TLCD, std::size_t TTileSize>
+class TilemapScroller
+{
+public:
+    constexpr static bool hardware_scroll{ hardware_scroll_t<TLCD> };
+
+    TilemapScroller(TLCD& lcd, const Tilemap<TTileSize>& map) : lcd{ lcd }, map{ map } {}
+
+    GETTER std::int32_t get_x() const { return view_x; }
+    GETTER std::int32_t get_y() const { return view_y; }
+
+    // Moves the view's top left corner to x, y in map pixels and redraws what that exposes. Call it before drawing
+    //   the rest of the frame; the LCD scrolls with the next show()/present().
+    void scroll_to(std::int32_t x, std::int32_t y)
+    {
+        view_x = x;
+        view_y = y;
+        BufferState& state{ get_buffer_state() };
+        const std::int32_t distance{ x - state.x };
+        if (hardware_scroll && state.valid && state.y == y && std::abs(distance) < screen_width())
+        {
+            // Only the columns that weren't on screen the last time this buffer was drawn
+            if (distance > 0)
+            {
+                draw_view(Rect{
+                    .x = static_cast<std::uint32_t>(screen_width() - distance),
+                    .width = static_cast<std::uint32_t>(distance), .height = static_cast<std::uint32_t>(screen_height())
+                });
+            }
+            else if (distance < 0)
+            {
+                draw_view(Rect{ .width = static_cast<std::uint32_t>(-distance), .height = static_cast<std::uint32_t>(screen_height()) });
+            }
+        }
+        else if (!state.valid || distance != 0 || state.y != y)
+        {
+            draw_view(Rect{ .width = static_cast<std::uint32_t>(screen_width()), .height = static_cast<std::uint32_t>(screen_height()) });
+        }
+        state.x = x;
+        state.y = y;
+        state.valid = true;
+        if constexpr (hardware_scroll)
+        {
+            lcd.set_scroll_offset(wrap(x, screen_width()));
+        }
+    }
+    void scroll_by(std::int32_t x, std::int32_t y) { scroll_to(view_x + x, view_y + y); }
+    // Redraws the whole screen, e.g. after the map changed or something else drew over it
+    void redraw()
+    {
+        buffer_states = {};
+        scroll_to(view_x, view_y);
+    }
+    // Redraws the map under an area given in map pixels, e.g. where a sprite was drawn, if any of it is on screen
+    void restore(std::int32_t x, std::int32_t y, std::int32_t width, std::int32_t height)
+    {
+        const std::int32_t start_x{ std::max(x - view_x, 0) };
+        const std::int32_t start_y{ std::max(y - view_y, 0) };
+        const std::int32_t end_x{ std::min(x - view_x + width, screen_width()) };
+        const std::int32_t end_y{ std::min(y - view_y + height, screen_height()) };
+        if (start_x < end_x && start_y < end_y)
+        {
+            draw_view(Rect{
+                .x = static_cast<std::uint32_t>(start_x), .y = static_cast<std::uint32_t>(start_y),
+                .width = static_cast<std::uint32_t>(end_x - start_x), .height = static_cast<std::uint32_t>(end_y - start_y)
+            });
+        }
+    }
+
+    // Framebuffer column that screen column `x` is shown from
+    GETTER std::size_t get_buffer_x(std::int32_t x) const
+    {
+        return hardware_scroll ? wrap(view_x + x, screen_width()) : static_cast<std::size_t>(x);
+    }
+    // Draws a sprite at x, y on the screen, splitting it where the framebuffer wraps around
+    void draw_sprite(const Sprite& sprite, std::int32_t x, std::int32_t y, const SpriteBlit& blit = {})
+    {
+        if constexpr (!hardware_scroll)
+        {
+            gfx::draw_sprite(lcd, sprite, x, y, blit);
+        }
+        else
+        {
+            // Clip to the screen's sides first; off screen columns wrap around onto the other side of the ring
+            Rect source{
+                blit.source.empty()
+                    ? Rect{ .width = static_cast<std::uint32_t>(sprite.get_width()), .height = static_cast<std::uint32_t>(sprite.get_height()) }
+                    : blit.source.clipped(sprite.get_width(), sprite.get_height())
+            };
+            const std::int32_t start_x{ std::max(x, 0) };
+            const std::int32_t end_x{ std::min(x + static_cast<std::int32_t>(source.width), screen_width()) };
+            if (start_x >= end_x)
+            {
+                return;
+            }
+            const std::uint32_t skipped_left{ static_cast<std::uint32_t>(start_x - x) };
+            const std::uint32_t skipped_right{ source.width - skipped_left - static_cast<std::uint32_t>(end_x - start_x) };
+            const bool flip_horizontal{ (static_cast<std::uint8_t>(blit.flip) & static_cast<std::uint8_t>(Flip::Horizontal)) != 0 };
+            source.x += flip_horizontal ? skipped_right : skipped_left;
+            source.width = static_cast<std::uint32_t>(end_x - start_x);
+            const SpriteBlit clipped_blit{ .source = source, .flip = blit.flip, .palette = blit.palette };
+            const std::int32_t buffer_x{ static_cast<std::int32_t>(get_buffer_x(start_x)) };
+            gfx::draw_sprite(lcd, sprite, buffer_x, y, clipped_blit);
+            if (buffer_x + static_cast<std::int32_t>(source.width) > screen_width())
+            {
+                gfx::draw_sprite(lcd, sprite, buffer_x - screen_width(), y, clipped_blit);
+            }
+        }
+    }
+
+private:
+    // Where the view was the last time a framebuffer was drawn, so double buffered LCDs get each buffer caught up
+    struct BufferState
+    {
+        const RGB565* buffer{ nullptr };
+        std::int32_t x{ 0 };
+        std::int32_t y{ 0 };
+        bool valid{ false };
+    };
+
+    GETTER static std::size_t wrap(std::int32_t value, std::int32_t size)
+    {
+        const std::int32_t wrapped{ value % size };
+        return static_cast<std::size_t>(wrapped < 0 ? wrapped + size : wrapped);
+    }
+    GETTER std::int32_t screen_width() const { return static_cast<std::int32_t>(lcd.get_width()); }
+    GETTER std::int32_t screen_height() const { return static_cast<std::int32_t>(lcd.get_height()); }
+
+    BufferState& get_buffer_state()
+    {
+        const RGB565* const buffer{ lcd.get_row(0).data() };
+        for (BufferState& state : buffer_states)
+        {
+            if (state.buffer == buffer)
+            {
+                return state;
+            }
+        }
+        // A buffer we haven't drawn to yet, or double buffering changed; anything older can't be trusted
+        buffer_states[1] = buffer_states[0];
+        buffer_states[0] = BufferState{ .buffer = buffer };
+        return buffer_states[0];
+    }
+    // Draws the map under `area` of the screen at the view's current position
+    void draw_view(const Rect& area)
+    {
+        if (area.empty())
+        {
+            return;
+        }
+        const Rect map_area{
+            .x = static_cast<std::uint32_t>(wrap(view_x + static_cast<std::int32_t>(area.x), static_cast<std::int32_t>(map.get_pixel_width()))),
+            .y = static_cast<std::uint32_t>(wrap(view_y + static_cast<std::int32_t>(area.y), static_cast<std::int32_t>(map.get_pixel_height()))),
+            .width = area.width, .height = area.height
+        };
+        const std::size_t buffer_x{ get_buffer_x(static_cast<std::int32_t>(area.x)) };
+        const std::size_t first_width{ std::min<std::size_t>(area.width, lcd.get_width() - buffer_x) };
+        map.draw(lcd, Rect{ .x = map_area.x, .y = map_area.y, .width = static_cast<std::uint32_t>(first_width), .height = area.height },
+            buffer_x, area.y);
+        if (first_width < area.width)
+        {
+            // The rest wraps around to the start of the ring
+            map.draw(lcd, Rect{
+                .x = static_cast<std::uint32_t>(map_area.x + first_width), .y = map_area.y,
+                .width = static_cast<std::uint32_t>(area.width - first_width), .height = area.height
+            }, 0, area.y);
+        }
+    }
+
+    TLCD& lcd;
+    const Tilemap<TTileSize>& map;
+    std::int32_t view_x{ 0 };
+    std::int32_t view_y{ 0 };
+    std::array<BufferState, 2> buffer_states{};
+};
+}
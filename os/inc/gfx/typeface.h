@@ -4,6 +4,8 @@
 #include <bitset>
 #include <concepts>
 #include <cstdint>
+#include <string_view>
+#include "gfx/font.h"
 
 template<typename>
 struct bitset_size;
@@ -23,23 +25,27 @@ template <std::size_t THeight, std::size_t TWidth = THeight, std::size_t TCharac
 using Typeface = std::array<TextCharacter<THeight, TWidth>, TCharacterCount>;
 
 template <typename T>
-concept typeface_t = requires (T x) {
+concept fixed_typeface_t = requires (T x) {
     { Typeface(x) } -> std::same_as<std::remove_cvref_t<T>>;
 };
 
+// Either a fixed cell Typeface of bitsets or a packed, proportional gfx::Font
+template <typename T>
+concept typeface_t = fixed_typeface_t<T> || std::same_as<std::remove_cvref_t<T>, gfx::Font>;
+
 template <textcharacter_t TCharacter>
 [[nodiscard]] consteval std::uint32_t get_character_width() { return bitset_size<typename TCharacter::value_type>::value; }
 
 template <textcharacter_t TCharacter>
 [[nodiscard]] consteval std::uint32_t get_character_height() { return std::tuple_size<TCharacter>(); }
 
-template <typeface_t TTypeface>
+template <fixed_typeface_t TTypeface>
 [[nodiscard]] consteval std::uint32_t get_typeface_character_width() { return get_character_width<typename TTypeface::value_type>(); }
 
-template <typeface_t TTypeface>
+template <fixed_typeface_t TTypeface>
 [[nodiscard]] consteval std::uint32_t get_typeface_character_height() { return get_character_height<typename TTypeface::value_type>(); }
 
-template <typeface_t TTypeface>
+template <fixed_typeface_t TTypeface>
 [[nodiscard]] constexpr bool is_character_printable(char character, const TTypeface& typeface)
 {
     const std::size_t index{ static_cast<std::size_t>(character) };
@@ -55,10 +61,12 @@ template <typeface_t TTypeface>
         ) != end;
 }
 
-template <std::size_t THeight = 5, std::size_t TWidth = THeight>
-const Typeface<THeight, TWidth>& get_ascii_typeface();
+[[nodiscard]] constexpr bool is_character_printable(char character, const gfx::Font& font)
+{
+    return font.is_printable(character);
+}
 
-template <typeface_t TTypeface = std::remove_cvref_t<decltype(get_ascii_typeface())>>
+template <fixed_typeface_t TTypeface>
 [[nodiscard]] constexpr std::uint32_t get_string_width(std::string_view string)
 {
     std::size_t longest_line_length{ 0u };
@@ -85,13 +93,26 @@ template <typeface_t TTypeface = std::remove_cvref_t<decltype(get_ascii_typeface
         + (longest_line_length - 1); // Account for 1 pixel of padding after each character but the last
 }
 
-template <typeface_t TTypeface>
+template <fixed_typeface_t TTypeface>
 std::size_t get_string_width(std::string_view string, const TTypeface&)
 {
     return get_string_width<TTypeface>(string);
 }
 
-template <typeface_t TTypeface = std::remove_cvref_t<decltype(get_ascii_typeface())>>
+// Width of the widest line, not counting the spacing column after its last glyph
+[[nodiscard]] constexpr std::uint32_t get_string_width(std::string_view string, const gfx::Font& font)
+{
+    std::uint32_t widest{ 0u };
+    while (!string.empty())
+    {
+        const std::string_view line{ string.substr(0, string.find('\n')) };
+        widest = std::max(widest, font.get_string_width(line));
+        string.remove_prefix(std::min(line.length() + 1u, string.length()));
+    }
+    return widest > 0u ? widest - 1u : 0u;
+}
+
+template <fixed_typeface_t TTypeface>
 std::size_t get_string_height(std::string_view string)
 {
     const std::size_t line_count{
@@ -102,8 +123,15 @@ std::size_t get_string_height(std::string_view string)
     return line_count * (get_typeface_character_height<TTypeface>() + (line_count > 1u ? 1u : 0u));
 }
 
-template <typeface_t TTypeface>
+template <fixed_typeface_t TTypeface>
 std::size_t get_string_height(std::string_view string, const TTypeface&)
 {
     return get_string_height<TTypeface>(string);
 }
+
+// Height of every line, not counting the spacing after the last
+[[nodiscard]] constexpr std::size_t get_string_height(std::string_view string, const gfx::Font& font)
+{
+    const std::size_t line_count{ static_cast<std::size_t>(std::count(string.begin(), string.end(), '\n')) + 1u };
+    return line_count * font.get_line_height() - font.line_spacing;
+}
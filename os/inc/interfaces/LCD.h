@@ -2,15 +2,23 @@
 #include <algorithm>
 #include <concepts>
 #include <cstdint>
+#include <functional>
 #include <span>
 #include <string_view>
+#include <utility>
 #include "PICOnsole_defines.h"
 #include "hardware/dma.h"
 #include "hardware/pwm.h"
 #include "hardware/spi.h"
+#include "gfx/blend.h"
 #include "gfx/color.h"
+#include "gfx/indexed_framebuffer.h"
+#include "gfx/post_process.h"
+#include "gfx/region.h"
+#include "gfx/shapes.h"
+#include "gfx/sprite.h"
 #include "gfx/typeface.h"
-#include "gfx/typefaces/ascii_5px.h"
+#include "gfx/fonts/ascii_5px.h"
 #include "gfx/text.h"
 
 extern "C"
@@ -19,9 +27,9 @@ extern "C"
     extern std::uint8_t __piconsole_lcd_buffer[];
     extern void *__piconsole_lcd_buffer_end[];
 #elif _PICONSOLE_PROGRAM
-    // TODO: Find a way to link these in from the OS's ELF?
-    std::uint8_t *__piconsole_lcd_buffer { reinterpret_cast<std::uint8_t*>(0x20000468) };
-    void **__piconsole_lcd_buffer_end { (void**)0x2000a468 };
+    // Defined in OS.h, once the OS's size is known
+    extern std::uint8_t *__piconsole_lcd_buffer;
+    extern void **__piconsole_lcd_buffer_end;
 #endif
 }
 
@@ -41,6 +49,8 @@ public:
     PICONSOLE_MEMBER_FUNC void write_data(std::uint8_t byte);
     PICONSOLE_MEMBER_FUNC void write_data(std::span<const std::uint8_t> bytes);
     PICONSOLE_MEMBER_FUNC void write_data(std::initializer_list<std::uint8_t> bytes);
+    // Writes `row_count` rows of `row_size` bytes, each `stride` bytes apart, with a single chip select
+    PICONSOLE_MEMBER_FUNC void write_data_strided(const std::uint8_t* data, std::size_t row_size, std::size_t stride, std::size_t row_count);
     PICONSOLE_MEMBER_FUNC void write_command(std::uint8_t byte);
     PICONSOLE_MEMBER_FUNC void write_command(std::span<const std::uint8_t> bytes);
     PICONSOLE_MEMBER_FUNC void write_command(std::initializer_list<std::uint8_t> bytes);
@@ -49,6 +59,32 @@ public:
     
     PICONSOLE_MEMBER_FUNC void show() = 0;
 
+    // Called on core0 once a present() has fully gone out over SPI, from update_present() rather than the DMA IRQ
+    using present_callback_t = void(*)(SPILCD& lcd);
+    // Starts sending the framebuffer over DMA and returns immediately; the buffer must not be drawn to until
+    //   is_presenting() returns false
+    PICONSOLE_MEMBER_FUNC void present(present_callback_t callback = nullptr) = 0;
+    // Like present(), but sends an indexed framebuffer's dirty regions, expanding each row to RGB565 through its
+    //   palette just before it's needed. update_present() expands the next row on core0 while the last one goes out
+    //   over SPI, so the DMA IRQ only ever sends rows that are already expanded.
+    // The palette and regions are copied, so only the frame's pixels must be left alone until is_presenting()
+    //   returns false.
+    PICONSOLE_MEMBER_FUNC void present_indexed(const gfx::IndexedFrame& frame, present_callback_t callback = nullptr) = 0;
+    GETTER PICONSOLE_MEMBER_FUNC bool is_presenting() const { return presenting; }
+    // On core0 this carries the present on itself with update_present(); other cores wait for core0 to
+    PICONSOLE_MEMBER_FUNC void wait_present();
+    // The DMA IRQ only re-arms the data channel with the next row of the current write window. This prepares the row
+    //   after it and, once a window has gone out, finishes the transfer and opens the next window or ends the present,
+    //   all from thread context.
+    // Must be called on core0, where the IRQ runs, whenever it wakes; OS::update() does so.
+    PICONSOLE_MEMBER_FUNC void update_present();
+
+    // Sets the panel's address window and begins a memory write into it
+    PICONSOLE_MEMBER_FUNC void begin_write_window(const gfx::Rect& window) = 0;
+    // Streams raw pixel data into the current write window over DMA; tracked by is_presenting()/wait_present()
+    //   like present(), and `bytes` must stay valid until it's done
+    PICONSOLE_MEMBER_FUNC void write_data_async(std::span<const std::uint8_t> bytes, present_callback_t callback = nullptr);
+
     GETTER PICONSOLE_MEMBER_FUNC const uint& get_baudrate() const { return baudrate; }
     PICONSOLE_MEMBER_FUNC void set_backlight_strength(float strength);
 
@@ -56,9 +92,36 @@ public:
 
 protected:
     static spi_inst_t* get_spi();
+    // Asserts DC/CS and starts streaming `bytes` to the SPI TX FIFO on present_dma_channel
+    PICONSOLE_MEMBER_FUNC void start_data_dma(std::span<const std::uint8_t> bytes);
+    // Starts streaming more bytes into the transfer already under way, leaving DC/CS alone; safe from the DMA IRQ
+    PICONSOLE_MEMBER_FUNC void continue_data_dma(std::span<const std::uint8_t> bytes);
+    // Waits for the SPI to drain after a DMA transfer and releases CS
+    PICONSOLE_MEMBER_FUNC void finish_data_dma();
+    // Opens the next write window of an in-flight present() and starts sending it; returns false once there is
+    //   nothing left to send. Only called from thread context, as it writes commands.
+    PICONSOLE_MEMBER_FUNC bool present_next() = 0;
+    // Called from the DMA IRQ: re-arms the data channel with the next row of the current write window. Returns false
+    //   when the window is done, as anything else needs commands.
+    PICONSOLE_MEMBER_FUNC bool present_next_row() = 0;
+    // Called by update_present() while a transfer is under way, to get ready whatever present_next_row() sends next
+    PICONSOLE_MEMBER_FUNC void prepare_next_present_row() {}
+    PICONSOLE_MEMBER_FUNC void on_present_dma_complete();
+
     bool initialized{ false };
+    int present_dma_channel{ -1 };
+    // Core whose DMA IRQ handler sends the present; the one that called init()
+    uint present_core{ 0 };
+    volatile bool presenting{ false };
+    // Set by the DMA IRQ once a transfer has ended without it re-arming; update_present() takes over from there
+    volatile bool present_window_done{ false };
+    // Whether update_present() should ask present_next() for more transfers
+    bool present_chained{ false };
+    present_callback_t present_callback{ nullptr };
 
 private:
+    static void __isr __time_critical_func(present_dma_irq_handler)();
+
     uint baudrate{0};
 
     float backlight_strength{0.0f};
@@ -76,6 +139,12 @@ public:
     constexpr static std::size_t buffer_size{ width * height * sizeof(ColorFormat) };
     using buffer_type = std::array<ColorFormat, width * height>;
     using TextSettings = gfx::text::PrintSettings<ColorLCD<TColorFormat, TWidth, THeight>>;
+    using TextLayout = gfx::text::TextLayout<ColorLCD<TColorFormat, TWidth, THeight>, gfx::text::get_max_text_lines<THeight>()>;
+    constexpr static std::size_t max_dirty_regions{ 8 };
+    using DirtyRegions = gfx::DirtyRegions<max_dirty_regions>;
+    // Program owned framebuffers of palette indices for present_indexed()
+    using IndexedFramebuffer8 = gfx::IndexedFramebuffer<gfx::SpriteFormat::Indexed8, TWidth, THeight>;
+    using IndexedFramebuffer4 = gfx::IndexedFramebuffer<gfx::SpriteFormat::Indexed4, TWidth, THeight>;
 
     PICONSOLE_MEMBER_FUNC ~ColorLCD() {}
 
@@ -90,8 +159,27 @@ public:
     }
     PICONSOLE_MEMBER_FUNC void set_pixel(ColorFormat color, std::size_t x, std::size_t y)
     {
+        mark_dirty(x, y, 1, 1);
         this->get_buffer()[x + y * this->get_width()] = color;
     }
+    // Row `y` of the draw buffer for drawing whole spans at once; empty if off screen. Callers must mark_dirty themselves.
+    GETTER PICONSOLE_MEMBER_FUNC std::span<ColorFormat> get_row(std::size_t y)
+    {
+        if (y >= THeight)
+        {
+            return {};
+        }
+        return { this->get_buffer().data() + y * TWidth, TWidth };
+    }
+    // Row `y` of the buffer show()/present() last sent, before scrolling and post processing; empty if off screen
+    GETTER PICONSOLE_MEMBER_FUNC std::span<const ColorFormat> get_display_row(std::size_t y) const
+    {
+        if (y >= THeight)
+        {
+            return {};
+        }
+        return { this->get_display_buffer().data() + y * TWidth, TWidth };
+    }
     PICONSOLE_MEMBER_FUNC void fill(ColorFormat color) = 0;
     PICONSOLE_MEMBER_FUNC void line_horizontal(ColorFormat color, std::size_t x, std::size_t y, std::size_t width) = 0;
     PICONSOLE_MEMBER_FUNC void line_vertical(ColorFormat color, std::size_t x, std::size_t y, std::size_t height) = 0;
@@ -117,6 +205,8 @@ public:
     }
     PICONSOLE_MEMBER_FUNC void filled_rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
     {
+        // Mark the whole area up front so each row is already covered
+        mark_dirty(x, y, width, height);
         const std::size_t end_line{ y + height };
         while (y < end_line)
         {
@@ -126,13 +216,176 @@ public:
     }
     PICONSOLE_MEMBER_FUNC void text(std::string_view string, TextSettings settings = {}) = 0;
     PICONSOLE_MEMBER_FUNC void centered_text(std::string_view string, TextSettings settings = {}) = 0;
+    // Draws text laid out ahead of time, skipping all measuring and line breaking
+    PICONSOLE_MEMBER_FUNC void text(const TextLayout& layout)
+    {
+        layout.render(*this);
+    }
+    // Copies a row-major block of `width` x `height` pixels to x, y, clipped to the screen
+    PICONSOLE_MEMBER_FUNC void blit(std::span<const ColorFormat> pixels, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        if (x >= TWidth || y >= THeight)
+        {
+            return;
+        }
+        const std::size_t visible_width{ std::min(width, TWidth - x) };
+        const std::size_t visible_height{ std::min(height, THeight - y) };
+        mark_dirty(x, y, visible_width, visible_height);
+        for (std::size_t row{ 0 }; row < visible_height; ++row)
+        {
+            const auto source{ pixels.begin() + row * width };
+            std::copy(source, source + visible_width, this->get_buffer().begin() + x + (y + row) * TWidth);
+        }
+    }
+
+    // Draws a sprite with its top left corner at x, y, which may be off screen; see gfx::draw_sprite()
+    PICONSOLE_MEMBER_FUNC void sprite(const gfx::Sprite& sprite, std::int32_t x, std::int32_t y, const gfx::SpriteBlit& blit = {})
+    {
+        gfx::draw_sprite(*this, sprite, x, y, blit);
+    }
+
+    // Shapes; coordinates are signed and everything is clipped, so shapes may hang off any edge of the screen
+    PICONSOLE_MEMBER_FUNC void circle(ColorFormat color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        gfx::shapes::circle(*this, color, { x, y }, radius);
+    }
+    PICONSOLE_MEMBER_FUNC void filled_circle(ColorFormat color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        gfx::shapes::filled_circle(*this, color, { x, y }, radius);
+    }
+    PICONSOLE_MEMBER_FUNC void ellipse(ColorFormat color, std::int32_t x, std::int32_t y, std::int32_t radius_x, std::int32_t radius_y)
+    {
+        gfx::shapes::ellipse(*this, color, { x, y }, radius_x, radius_y);
+    }
+    PICONSOLE_MEMBER_FUNC void filled_ellipse(ColorFormat color, std::int32_t x, std::int32_t y, std::int32_t radius_x, std::int32_t radius_y)
+    {
+        gfx::shapes::filled_ellipse(*this, color, { x, y }, radius_x, radius_y);
+    }
+    PICONSOLE_MEMBER_FUNC void triangle(ColorFormat color, gfx::shapes::Point a, gfx::shapes::Point b, gfx::shapes::Point c)
+    {
+        gfx::shapes::triangle(*this, color, a, b, c);
+    }
+    PICONSOLE_MEMBER_FUNC void filled_triangle(ColorFormat color, gfx::shapes::Point a, gfx::shapes::Point b, gfx::shapes::Point c)
+    {
+        gfx::shapes::filled_triangle(*this, color, a, b, c);
+    }
+    PICONSOLE_MEMBER_FUNC void polygon(ColorFormat color, std::span<const gfx::shapes::Point> vertices)
+    {
+        gfx::shapes::polygon(*this, color, vertices);
+    }
+    // Vertices must describe a convex polygon
+    PICONSOLE_MEMBER_FUNC void filled_polygon(ColorFormat color, std::span<const gfx::shapes::Point> vertices)
+    {
+        gfx::shapes::filled_polygon(*this, color, vertices);
+    }
+
+    // Dirty region tracking; show() only needs to send the regions marked since the last show()
+    PICONSOLE_MEMBER_FUNC void mark_dirty(std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        dirty_regions.add(gfx::Rect{
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y),
+            .width = static_cast<std::uint32_t>(width), .height = static_cast<std::uint32_t>(height)
+        }.clipped(TWidth, THeight));
+    }
+    PICONSOLE_MEMBER_FUNC void mark_all_dirty() { mark_dirty(0, 0, TWidth, THeight); }
+    GETTER PICONSOLE_MEMBER_FUNC const DirtyRegions& get_dirty_regions() const { return dirty_regions; }
+
+    // Double buffering
+    // Passing a buffer owned by the program (see piconsole_program_lcd_back_buffer) makes drawing go to the back
+    //   buffer while flip() streams the front one; passing nullptr goes back to the single OS-owned buffer.
+    PICONSOLE_MEMBER_FUNC void set_back_buffer(buffer_type* back_buffer)
+    {
+        this->wait_present();
+        if (drawing_in_flight)
+        {
+            wait_for_drawing();
+        }
+        buffer_type* const primary_buffer{ &get_primary_buffer() };
+        if (back_buffer == nullptr)
+        {
+            if (display_buffer != primary_buffer)
+            {
+                std::copy(display_buffer->begin(), display_buffer->end(), primary_buffer->begin());
+            }
+            draw_buffer = primary_buffer;
+            display_buffer = primary_buffer;
+        }
+        else
+        {
+            std::copy(display_buffer->begin(), display_buffer->end(), back_buffer->begin());
+            draw_buffer = back_buffer;
+            display_buffer = primary_buffer;
+        }
+        previous_dirty_regions.clear();
+    }
+    GETTER PICONSOLE_MEMBER_FUNC bool is_double_buffered() const { return draw_buffer != display_buffer; }
+    // Double buffered: waits for the last flip to finish sending, swaps buffers and starts presenting the frame
+    //   that was just drawn without waiting for it. The new back buffer holds the frame from two flips ago.
+    // Single buffered: same as show()
+    PICONSOLE_MEMBER_FUNC void flip(SPILCD::present_callback_t callback = nullptr)
+    {
+        if (!is_double_buffered())
+        {
+            this->show();
+            if (callback != nullptr)
+            {
+                std::invoke(callback, *this);
+            }
+            return;
+        }
+        this->wait_present();
+        // The panel last received the other buffer, so it also needs whatever changed in that buffer's frame
+        const DirtyRegions drawn_regions{ dirty_regions };
+        for (const gfx::Rect& region : previous_dirty_regions.get_regions())
+        {
+            dirty_regions.add(region);
+        }
+        previous_dirty_regions = drawn_regions;
+        std::swap(draw_buffer, display_buffer);
+        this->present(callback);
+    }
 
 protected:
     #if _PICONSOLE_OS
-    static inline buffer_type &get_buffer() { return *reinterpret_cast<buffer_type*>(&__piconsole_lcd_buffer); }
+    static inline buffer_type &get_primary_buffer() { return *reinterpret_cast<buffer_type*>(&__piconsole_lcd_buffer); }
     #else
-    static buffer_type &get_buffer();
+    static inline buffer_type &get_primary_buffer() { return *reinterpret_cast<buffer_type*>(__piconsole_lcd_buffer); }
     #endif
+    // Waits for any asynchronous drawing (e.g. a DMA fill) into the buffers to finish
+    PICONSOLE_MEMBER_FUNC void wait_for_drawing() const {}
+    // Buffer that drawing functions write to
+    GETTER inline buffer_type &get_buffer()
+    {
+        if (drawing_in_flight)
+        {
+            wait_for_drawing();
+        }
+        return *draw_buffer;
+    }
+    GETTER inline const buffer_type &get_buffer() const
+    {
+        if (drawing_in_flight)
+        {
+            wait_for_drawing();
+        }
+        return *draw_buffer;
+    }
+    // Buffer that show()/present() send to the panel; the same as get_buffer() unless double buffered
+    GETTER inline const buffer_type &get_display_buffer() const
+    {
+        if (drawing_in_flight)
+        {
+            wait_for_drawing();
+        }
+        return *display_buffer;
+    }
+
+    DirtyRegions dirty_regions;
+    DirtyRegions previous_dirty_regions;
+    buffer_type* draw_buffer{ &get_primary_buffer() };
+    buffer_type* display_buffer{ &get_primary_buffer() };
+    // Set while asynchronous drawing may still be writing to the buffers
+    mutable bool drawing_in_flight{ false };
 };
 
 template <std::size_t TWidth, std::size_t THeight>
@@ -143,54 +396,101 @@ public:
     using buffer_type = super::buffer_type;
     using ColorFormat = super::ColorFormat;
     using TextSettings = super::TextSettings;
+    using TextLayout = super::TextLayout;
+    using super::text;
 
     PICONSOLE_MEMBER_FUNC ~ColorLCD_RGB565() {}
 
     // Drawing
+    // fill(), line_horizontal() and filled_rectangle() only start a DMA transfer; the buffer is waited on the next
+    //   time anything reads or writes it directly
     PICONSOLE_MEMBER_FUNC void fill(ColorFormat color) override
     {
-        if (dma_channel_is_busy(dma_channel))
+        if (fill_chained)
+        {
+            // Aborting a chained channel can retrigger the channel it chains to (RP2040-E13), so let it finish
+            wait_for_dma();
+        }
+        else if (dma_channel_is_busy(dma_channel))
         {
             dma_channel_abort(dma_channel); // We don't care about the last transfer when filling the whole screen
         }
-        static ColorFormat fill_source_color{};
-        fill_source_color = color;
-        dma_channel_config config{ dma_channel_get_default_config(dma_channel) };
-        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
-        channel_config_set_read_increment(&config, false);
-        channel_config_set_write_increment(&config, true);
-        wait_for_dma();
-        dma_channel_configure(
-            dma_channel,
-            &config,
-            this->get_buffer().data(),
-            &fill_source_color.data,
-            this->get_buffer().size(),
-            true
-        );
-        wait_for_dma();
+        this->mark_all_dirty();
+        start_span_fill(color, 0, TWidth * THeight);
     }
     PICONSOLE_MEMBER_FUNC void line_horizontal(ColorFormat color, std::size_t x, std::size_t y, std::size_t width) override
     {
-        static ColorFormat source_color{};
-        source_color = color;
+        this->mark_dirty(x, y, width, 1);
+        start_span_fill(color, x + y * this->get_width(), width);
+    }
+    // Sends the whole rectangle as one chain of DMA transfers, one per row, instead of setting up each row separately
+    PICONSOLE_MEMBER_FUNC void filled_rectangle(ColorFormat color, std::size_t x, std::size_t y, std::size_t width, std::size_t height) override
+    {
+        if (x >= TWidth || y >= THeight || width == 0 || height == 0)
+        {
+            return;
+        }
+        width = std::min(width, TWidth - x);
+        height = std::min(height, THeight - y);
+        this->mark_dirty(x, y, width, height);
+        if (width == TWidth || height == 1)
+        {
+            // Rows are contiguous in the buffer
+            start_span_fill(color, x + y * TWidth, width * height);
+            return;
+        }
+        wait_for_dma();
+        fill_source_color = color;
+        ColorFormat* const start{ this->get_buffer().data() + x + y * TWidth };
+        for (std::size_t row{ 0 }; row < height; ++row)
+        {
+            fill_blocks[row] = FillBlock{ .write_address = start + row * TWidth, .transfer_count = static_cast<std::uint32_t>(width) };
+        }
+        // Writing a zero transfer count is a null trigger, which ends the chain
+        fill_blocks[height] = FillBlock{};
+
+        // The fill channel retriggers the control channel after each row...
         dma_channel_config config{ dma_channel_get_default_config(dma_channel) };
         channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
         channel_config_set_read_increment(&config, false);
         channel_config_set_write_increment(&config, true);
-        const std::size_t start_offset{ x + y * this->get_width() };
-        wait_for_dma();
+        channel_config_set_chain_to(&config, fill_control_dma_channel);
+        dma_channel_configure(dma_channel, &config, nullptr, &fill_source_color.data, 0, false);
+        // ...which loads the next row's block into WRITE_ADDR and TRANS_COUNT_TRIG, starting the fill channel again
+        dma_channel_config control_config{ dma_channel_get_default_config(fill_control_dma_channel) };
+        channel_config_set_transfer_data_size(&control_config, DMA_SIZE_32);
+        channel_config_set_read_increment(&control_config, true);
+        channel_config_set_write_increment(&control_config, true);
+        channel_config_set_ring(&control_config, true, 3); // Wrap the write address after 8 bytes (2 registers)
+        fill_chained = true;
+        this->drawing_in_flight = true;
         dma_channel_configure(
-            dma_channel,
-            &config,
-            this->get_buffer().data() + start_offset,
-            &source_color.data,
-            width,
+            fill_control_dma_channel,
+            &control_config,
+            &dma_hw->ch[dma_channel].al1_write_addr,
+            fill_blocks.data(),
+            sizeof(FillBlock) / sizeof(std::uint32_t),
             true
         );
     }
+    // Draws `color` with `alpha` over the rectangle, e.g. for a translucent panel or a drop shadow; see gfx::blend
+    PICONSOLE_MEMBER_FUNC void blended_rectangle(ColorFormat color, std::uint8_t alpha, std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+    {
+        if (x >= TWidth || y >= THeight || width == 0 || height == 0)
+        {
+            return;
+        }
+        width = std::min(width, TWidth - x);
+        height = std::min(height, THeight - y);
+        this->mark_dirty(x, y, width, height);
+        for (std::size_t row{ y }; row < y + height; ++row)
+        {
+            gfx::blend::fill(this->get_row(row).subspan(x, width), color, alpha);
+        }
+    }
     PICONSOLE_MEMBER_FUNC void line_vertical(ColorFormat color, std::size_t x, std::size_t y, std::size_t height) override
     {
+        this->mark_dirty(x, y, 1, height);
         const std::size_t end_y{ y + height };
         while (y < end_y)
         {
@@ -200,90 +500,71 @@ public:
     }
     PICONSOLE_MEMBER_FUNC void line(ColorFormat color, std::size_t start_x, std::size_t start_y, std::size_t end_x, std::size_t end_y) override
     {
-        // TODO
+        gfx::shapes::line(*this, color,
+            { static_cast<std::int32_t>(start_x), static_cast<std::int32_t>(start_y) },
+            { static_cast<std::int32_t>(end_x), static_cast<std::int32_t>(end_y) });
     }
     PICONSOLE_MEMBER_FUNC void text(std::string_view string, TextSettings settings = {}) override
     {
-        if (settings.background.has_value())
-        {
-            this->filled_rectangle(settings.background.value(), settings.x, settings.y,
-                settings.padding_x * 2u + get_string_width(string),
-                settings.padding_y.value_or(settings.padding_x) * 2u + get_string_height(string));
-        }
-        const auto& typeface{ get_ascii_typeface() };
-        using Typeface = std::remove_cvref_t<decltype(typeface)>;
-        const std::uint32_t character_width{ get_typeface_character_width<Typeface>() + 1u };
-        const std::uint32_t character_height{ get_typeface_character_height<Typeface>() + 1u };
-        while (!string.empty()
-            && (settings.y + settings.padding_y.value_or(settings.padding_x))
-                < (settings.end_y - settings.padding_y.value_or(settings.padding_x))
-            )
-        {
-            const std::uint32_t max_line_width_px{ (settings.end_x - settings.padding_x) - (settings.x + settings.padding_x) };
-            const std::size_t newline_index{ string.find('\n') };
-            const std::uint32_t line_width_characters{
-                std::min<std::uint32_t>(
-                    std::min<std::uint32_t>(max_line_width_px / character_width, string.length()),
-                    newline_index
-                )
-            };
-            const bool has_newline{ newline_index != std::string_view::npos };
-            const std::uint32_t line_width_px{ std::min<std::uint32_t>(line_width_characters * character_width, max_line_width_px) };
-            std::string_view line{ string.substr(0, line_width_characters) };
-            gfx::text::print_string<super>(*this, line, typeface, settings);
-            if (settings.wrap_mode == gfx::text::WrapMode::Clip && !has_newline)
-            {
-                return;
-            }
-            string = string.substr(line_width_characters + (has_newline ? 1u : 0u));
-            settings.y += character_height;
-            settings.x = settings.wrap_x;
-        }
+        gfx::text::print_text<super>(*this, string, settings);
     }
     PICONSOLE_MEMBER_FUNC void centered_text(std::string_view string, TextSettings settings = {}) override
     {
-        // TODO: Add background based on widest line
-        const auto& typeface{ get_ascii_typeface() };
-        using Typeface = std::remove_cvref_t<decltype(typeface)>;
-        const std::uint32_t character_width{ get_typeface_character_width<Typeface>() + 1u };
-        const std::uint32_t character_height{ get_typeface_character_height<Typeface>() + 1u };
-        while (!string.empty() && settings.y < settings.end_y)
-        {
-            const std::uint32_t max_line_width_px{ (settings.end_x - settings.x) * 2u };
-            const std::size_t newline_index{ string.find('\n') };
-            const std::uint32_t line_width_characters{
-                std::min<std::uint32_t>(
-                    std::min<std::uint32_t>(max_line_width_px / character_width, string.length()),
-                    newline_index
-                )
-            };
-            const bool has_newline{ newline_index != std::string_view::npos };
-            const std::uint32_t line_width_px{ std::min<std::uint32_t>(line_width_characters * character_width, max_line_width_px) };
-            TextSettings line_settings{ settings };
-            line_settings.wrap_mode = gfx::text::WrapMode::Clip;
-            line_settings.x -= line_width_px / 2u;
-            std::string_view line{ string.substr(0, line_width_characters) };
-            gfx::text::print_string<super>(*this, line, typeface, line_settings);
-            if (settings.wrap_mode == gfx::text::WrapMode::Clip && !has_newline)
-            {
-                return;
-            }
-            string = string.substr(line_width_characters + (has_newline ? 1u : 0u));
-            settings.y += character_height;
-            settings.x = settings.wrap_x;
-        }
+        gfx::text::print_centered_text<super>(*this, string, settings);
     }
 
     PICONSOLE_MEMBER_FUNC void wait_for_dma() const
     {
-        if (dma_channel != -1)
+        if (dma_channel == -1)
         {
-            dma_channel_wait_for_finish_blocking(dma_channel);
+            return;
         }
+        // Between rows of a chained fill only the control channel is busy, so both need to be idle
+        while (dma_channel_is_busy(dma_channel)
+            || (fill_control_dma_channel != -1 && dma_channel_is_busy(fill_control_dma_channel)))
+        {
+            tight_loop_contents();
+        }
+        fill_chained = false;
+        this->drawing_in_flight = false;
     }
 
 protected:
+    // One row of a chained filled_rectangle(), laid out to match the fill channel's WRITE_ADDR and TRANS_COUNT_TRIG
+    struct FillBlock
+    {
+        ColorFormat* write_address{ nullptr };
+        std::uint32_t transfer_count{ 0u };
+    };
+
+    PICONSOLE_MEMBER_FUNC void wait_for_drawing() const override { wait_for_dma(); }
+    // Starts filling `count` pixels from `offset` in the buffer without waiting for it to finish
+    PICONSOLE_MEMBER_FUNC void start_span_fill(ColorFormat color, std::size_t offset, std::size_t count)
+    {
+        dma_channel_config config{ dma_channel_get_default_config(dma_channel) };
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        wait_for_dma();
+        // The previous transfer may still have been reading the old color until now
+        fill_source_color = color;
+        dma_channel_configure(
+            dma_channel,
+            &config,
+            this->get_buffer().data() + offset,
+            &fill_source_color.data,
+            count,
+            true
+        );
+        this->drawing_in_flight = true;
+    }
+
     int dma_channel{ -1 };
+    // Reprograms dma_channel from fill_blocks for each row of a filled_rectangle()
+    int fill_control_dma_channel{ -1 };
+    mutable bool fill_chained{ false };
+    ColorFormat fill_source_color{};
+    std::array<FillBlock, THeight + 1> fill_blocks{};
 };
 
 class PicoLCD_1_8 : public ColorLCD_RGB565<160, 128>
@@ -298,4 +579,66 @@ public:
     PICONSOLE_MEMBER_FUNC ~PicoLCD_1_8();
 
     PICONSOLE_MEMBER_FUNC void show() override;
+    PICONSOLE_MEMBER_FUNC void present(present_callback_t callback = nullptr) override;
+    PICONSOLE_MEMBER_FUNC void present_indexed(const gfx::IndexedFrame& frame, present_callback_t callback = nullptr) override;
+    PICONSOLE_MEMBER_FUNC void begin_write_window(const gfx::Rect& window) override;
+
+    // Hardware scrolling along x: the panel shows buffer column `offset` at the left edge of the screen, with the
+    //   columns after it wrapping around, so a sideways scroll only needs the newly exposed columns sent.
+    // Takes effect at the end of the next show()/present(), once the columns drawn for it have been sent.
+    PICONSOLE_MEMBER_FUNC void set_scroll_offset(std::size_t offset) { scroll_offset = offset % width; }
+    GETTER PICONSOLE_MEMBER_FUNC std::size_t get_scroll_offset() const { return scroll_offset; }
+    // Sends the set_scroll_offset() offset straight away, for callers that write the panel themselves rather than
+    //   through show()/present(), like StripRenderer. Only call it while nothing is being sent.
+    PICONSOLE_MEMBER_FUNC void apply_scroll_offset() { send_scroll_offset(scroll_offset); }
+
+    // Color adjustment, such as a fade or gamma curve, applied to pixels as they're sent without touching the
+    //   framebuffer. Waits for the current present() and marks the whole screen dirty so it's resent adjusted.
+    // While it isn't the identity, show() adjusts each row itself before sending it, and present() sends every row
+    //   through a bounce row that update_present() adjusts while the last one goes out; never in the DMA IRQ.
+    PICONSOLE_MEMBER_FUNC void set_post_process(const gfx::PostProcess& new_post_process);
+    GETTER PICONSOLE_MEMBER_FUNC const gfx::PostProcess& get_post_process() const { return post_process; }
+
+    // Panel RAM is offset from the visible area by this many pixels
+    constexpr static std::size_t column_offset{ 1 };
+    constexpr static std::size_t row_offset{ 2 };
+    // Lines of panel RAM along the x axis, which is the panel's own vertical (scrolling) axis in horizontal mode
+    constexpr static std::size_t ram_width{ 162 };
+
+protected:
+    PICONSOLE_MEMBER_FUNC bool present_next() override;
+    PICONSOLE_MEMBER_FUNC bool present_next_row() override;
+    PICONSOLE_MEMBER_FUNC void prepare_next_present_row() override;
+    // Sends the scroll start address if it changed; `offset` is a set_scroll_offset() offset
+    PICONSOLE_MEMBER_FUNC void send_scroll_offset(std::size_t offset);
+    // Starts a present that sends every row from present_rows, preparing the next row while the last is sent
+    PICONSOLE_MEMBER_FUNC void start_bounced_present();
+    PICONSOLE_MEMBER_FUNC bool present_next_bounced();
+    PICONSOLE_MEMBER_FUNC bool present_next_bounced_row();
+    // Expands and/or post processes the next row of a bounced present into present_rows[present_row_buffer]. Only
+    //   called from thread context; the DMA IRQ just sends rows once present_row_ready says they're there.
+    PICONSOLE_MEMBER_FUNC void prepare_present_row();
+
+    // Regions still to be sent by the current present()
+    DirtyRegions present_regions;
+    std::size_t present_region_index{ 0 };
+    // Next row of a region that's sent a row at a time; 0 once the next transfer needs a new write window
+    std::size_t present_row{ 0 };
+    // Scroll offset the current present() finishes with
+    std::size_t present_scroll_offset{ 0 };
+    std::size_t scroll_offset{ 0 };
+    // What the panel is currently scrolled to
+    std::size_t panel_scroll_offset{ 0 };
+    // The indexed frame being sent by present_indexed(), if any, with a copy of its palette
+    gfx::IndexedFrame present_frame{};
+    std::array<ColorFormat, 256> present_palette{};
+    // Set while the current present sends from present_rows: one row going out over DMA while the next is
+    //   prepared in the other
+    bool present_bounced{ false };
+    std::array<std::array<ColorFormat, width>, 2> present_rows{};
+    std::size_t present_row_buffer{ 0 };
+    // Whether present_rows[present_row_buffer] holds the next row. A row that isn't ready when the one before it has
+    //   gone out ends the write window early; present_next() opens a new one from that row.
+    volatile bool present_row_ready{ false };
+    gfx::PostProcess post_process{};
 };
@@ -74,6 +74,7 @@ public:
         }
 
         GETTER PICONSOLE_MEMBER_FUNC constexpr FSIZE_t get_current_offset() const { return current_offset; }
+        GETTER PICONSOLE_MEMBER_FUNC FSIZE_t get_size() const { return f_size(&file_handle); }
     
     protected:
         FIL file_handle;
@@ -148,6 +149,76 @@ public:
         }
     };
 
+    class FileWriter : public FileInterface
+    {
+    public:
+        FileWriter(const char* path)
+        {
+            const FRESULT open_result{ f_open(&file_handle, path, FA_WRITE | FA_CREATE_ALWAYS) };
+            last_result = open_result;
+            if (open_result != FR_OK)
+            {
+                print("FileWriter failed to f_open path: %s; Err: %d", path, open_result);
+                return;
+            }
+        }
+
+        // Allocates `size` bytes of clusters up front so later writes don't stop to extend the FAT chain a cluster
+        //   at a time, then seeks back to the start. FF_USE_EXPAND is off, so this seeks past the end of the file
+        //   rather than asking f_expand for a contiguous run.
+        bool preallocate(FSIZE_t size)
+        {
+            if (!is_valid())
+            {
+                return false;
+            }
+            const FRESULT seek_result{ f_lseek(&file_handle, size) };
+            if (seek_result != FR_OK || f_tell(&file_handle) != size)
+            {
+                last_result = seek_result != FR_OK ? seek_result : FR_DENIED;
+                print("FileWriter failed to preallocate %u bytes; Err: %d\n", static_cast<unsigned>(size), last_result);
+                return false;
+            }
+            seek_absolute(0);
+            return true;
+        }
+
+        template <byte_type TByte>
+        bool write_bytes(std::span<const TByte> memory)
+        {
+            if (!is_valid())
+            {
+                return false;
+            }
+            const std::size_t total_size{ memory.size() };
+            FSIZE_t written_bytes{ 0 };
+            while (total_size > written_bytes)
+            {
+                constexpr static unsigned int max_chunk_size{ std::numeric_limits<unsigned int>::max() };
+                const FSIZE_t remaining_bytes{ total_size - written_bytes };
+                const unsigned int chunk_size{ remaining_bytes > max_chunk_size ? max_chunk_size : static_cast<unsigned int>(remaining_bytes) };
+                unsigned int write_count;
+                const FRESULT write_result{ f_write(&file_handle, memory.data() + written_bytes, chunk_size, &write_count) };
+                if (write_result == FR_OK && write_count != chunk_size)
+                {
+                    // f_write only comes up short when the volume is full
+                    print("FileWriter f_write write_count (%u) differs from chunk_size (%u)\n", write_count, chunk_size);
+                    last_result = FR_DENIED;
+                    return false;
+                }
+                current_offset += write_count;
+                if (write_result != FR_OK)
+                {
+                    last_result = write_result;
+                    print("FileWriter failed to f_write; Err: %d\n", write_result);
+                    return false;
+                }
+                written_bytes += chunk_size;
+            }
+            return true;
+        }
+    };
+
     constexpr static std::size_t max_path_length{ 256 };
 
 private:
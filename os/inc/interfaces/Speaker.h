@@ -88,6 +88,9 @@ public:
     PICONSOLE_MEMBER_FUNC void uninit() {};
     PICONSOLE_MEMBER_FUNC void update() {};
     PICONSOLE_MEMBER_FUNC void set_audio_generator(audio_generator_callback_t callback) { generator_callback = callback; };
+    // Frames per second the generator's audio is played at; 0 until set, which leaves the hardware's default
+    PICONSOLE_MEMBER_FUNC void set_sample_rate(std::uint32_t rate) {};
+    GETTER PICONSOLE_MEMBER_FUNC std::uint32_t get_sample_rate() const { return 0u; };
 
 protected:
     audio_generator_callback_t generator_callback{ nullptr };
@@ -101,6 +104,8 @@ public:
     PICONSOLE_MEMBER_FUNC void init();
     PICONSOLE_MEMBER_FUNC void uninit();
     PICONSOLE_MEMBER_FUNC void update();
+    PICONSOLE_MEMBER_FUNC void set_sample_rate(std::uint32_t rate);
+    GETTER PICONSOLE_MEMBER_FUNC std::uint32_t get_sample_rate() const { return frequency; };
     PICONSOLE_MEMBER_FUNC void start_dma_transfer();
     PICONSOLE_MEMBER_FUNC void stop_dma_transfer();
 
@@ -108,6 +113,7 @@ private:
     static void __isr __time_critical_func(i2s_dma_irq_handler)();
     GETTER PICONSOLE_MEMBER_FUNC AudioBuffer& get_active_buffer() { return buffers[active_buffer]; }
     GETTER PICONSOLE_MEMBER_FUNC const AudioBuffer& get_active_buffer() const { return buffers[active_buffer]; }
+    PICONSOLE_MEMBER_FUNC void apply_sample_rate();
     PICONSOLE_MEMBER_FUNC void swap_active_buffer()
     {
         active_buffer = (active_buffer + 1) % buffers.size();
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "interfaces/SD.h"
+
+// Streaming decoder for the LZ4 block format, which tools/program_packer.py compresses program images with. A block
+//   is a run of sequences, each some literal bytes copied as they are followed by a match copying bytes already
+//   decoded; the last sequence has no match. Decoding is little more than copying, so it keeps up with the SD card.
+// Only the last history.size() decoded bytes are kept for matches to copy from, so the encoder mustn't reach further
+//   back than that. Standard LZ4 reaches back up to 64 KB; a smaller limit costs a little compression but lets the
+//   decoder run in a few KB of RAM.
+namespace lz4
+{
+// The token's literal count or match length runs on in extra bytes when its nibble holds this
+constexpr std::uint8_t run_on_length{ 15u };
+constexpr std::size_t min_match_length{ 4 };
+
+// Decodes one block in order, stopping after each span it's given and carrying on from there in the next, so it can
+//   be decoded straight into buffers of whatever size suits the destination.
+class StreamDecoder
+{
+public:
+    // `history` must be a power of two in size. `chunk` is what the block is read from the SD card into, at least two
+    //   bytes but ideally a whole sector or more. Both must outlive the decoder.
+    StreamDecoder(SDCard::FileReader& reader, std::span<std::uint8_t> history, std::span<std::uint8_t> chunk)
+        : reader{ reader }, history{ history }, chunk{ chunk }
+    {}
+
+    // Starts on a block of `packed_size` bytes at the reader's position
+    void start(std::uint32_t packed_size);
+    // Decodes the next destination.size() bytes of the block into `destination`
+    bool decode(std::span<std::uint8_t> destination);
+    // Whether the whole block has been read and everything it encodes decoded
+    GETTER bool is_finished() const
+    {
+        return literals_left == 0u && match_left == 0u && remaining_packed_bytes == 0u && chunk_position == chunk_end;
+    }
+
+private:
+    // Copies `count` decoded bytes to `out` and into the history
+    void emit(const std::uint8_t* bytes, std::size_t count, std::uint8_t*& out);
+    // Ensures at least `count` unread bytes are in the chunk, moving those left to its front and reading after them
+    bool refill(std::size_t count);
+    // Adds a length's run on bytes to it, each up to 255 with the last less than that
+    bool read_run_on(std::size_t& length);
+
+    SDCard::FileReader& reader;
+    std::span<std::uint8_t> history;
+    std::span<std::uint8_t> chunk;
+    std::uint32_t remaining_packed_bytes{ 0u };
+    std::size_t chunk_position{ 0 };
+    std::size_t chunk_end{ 0 };
+    // Bytes decoded so far; history holds each at this modulo its size
+    std::uint32_t position{ 0u };
+    std::uint8_t token{ 0u };
+    // The current sequence's literals have been copied, so its match comes next
+    bool match_next{ false };
+    std::size_t literals_left{ 0 };
+    std::size_t match_left{ 0 };
+    std::uint32_t match_offset{ 0u };
+};
+}
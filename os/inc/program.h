@@ -1,38 +1,124 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include "hardware/flash.h"
-#include "hardware/regs/addressmap.h"
+#include <cstdlib>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "program_layout.h"
+
+class OS;
 
 typedef void program_reset_fn(void);
 typedef int program_init_fn(OS&);
 typedef void program_update_fn(OS&);
 
 enum FIFOCodes : std::uint32_t {
+    // Pushed on launch by programs that don't report finishing their updates, such as ones built before
+    //   program_updated existed; the OS sends them one update per tick whether or not they're done with the last
     program_launch_success = 1,
     os_updated = 2,
+    // Pushed by the program after each update it was sent, so the OS knows it's free for the next
+    program_updated = 3,
+    // Pushed on launch instead of program_launch_success by programs that push program_updated, as every program
+    //   started through run_program() does
+    program_launch_acknowledges_updates = 4,
 
     error_generic = 100,
     error_crash = 101,
 };
 
-class OS;
+// The program's side of running on core1: reports the launch, runs `init` once, then `update` for each os_updated
+//   the OS sends, pushing program_updated after each. Never returns; programs call it through piconsole_program_main.
+[[noreturn]] PICONSOLE_FUNC void run_program(program_init_fn& init, program_update_fn& update);
 
 #undef piconsole_program_init
 #undef piconsole_program_update
+#undef piconsole_program_main
+#undef piconsole_program_lcd_back_buffer
 #if _PICONSOLE_OS || _PICONSOLE_PROGRAM
 #define piconsole_program_init int __attribute__((section(".piconsole.program.init"))) _piconsole_program_init(OS& os)
 #define piconsole_program_update void __attribute__((section(".piconsole.program.update"))) _piconsole_program_update(OS& os)
+// Defines the program's entry point, which hands its init and update to run_program(); goes after both
+#define piconsole_program_main int __attribute__((section(".piconsole.program.main"))) main() { run_program(_piconsole_program_init, _piconsole_program_update); }
+// Reserves a second LCD buffer in program RAM; pass &_piconsole_program_lcd_back_buffer to
+//   LCD_MODEL::set_back_buffer to enable double buffering
+#define piconsole_program_lcd_back_buffer LCD_MODEL::buffer_type __attribute__((section(".piconsole.program.lcd_back_buffer"))) _piconsole_program_lcd_back_buffer
 #endif
 
-constexpr std::size_t piconsole_program_flash_offset{ 0x00080000 };
-constexpr std::size_t piconsole_program_flash_start{ XIP_BASE + piconsole_program_flash_offset };
-constexpr std::size_t piconsole_program_flash_end{ XIP_BASE + 0x00200000 };
-constexpr std::size_t piconsole_program_flash_size{ piconsole_program_flash_end - piconsole_program_flash_start };
-static_assert(piconsole_program_flash_size % FLASH_SECTOR_SIZE == 0);
-constexpr std::size_t piconsole_program_ram_offset{ 0x00018000 };
-constexpr std::size_t piconsole_program_ram_start{ SRAM_BASE + piconsole_program_ram_offset };
-constexpr std::size_t piconsole_program_ram_end{ SRAM_BASE + 0x0003E000 };
-constexpr std::size_t piconsole_program_ram_size{ piconsole_program_ram_end - piconsole_program_ram_start - 1 };
+// 32 bit FNV-1a; continue a hash over several ranges by passing the last result back in
+GETTER constexpr std::uint32_t hash_bytes(std::span<const std::uint8_t> bytes, std::uint32_t hash = 0x811C9DC5u)
+{
+    for (const std::uint8_t byte : bytes)
+    {
+        hash = (hash ^ byte) * 0x01000193u;
+    }
+    return hash;
+}
+
+// Programs kept resident in program flash between loads, so launching one that's still there only loads its RAM
+//   segments. Each slot is a run of whole sectors holding one program's flash image. Programs are linked to run from
+//   piconsole_program_flash_start and moved to their slot by the loader, which adds the slot's offset to every
+//   address the linker left in the image pointing into it (see piconsole_program_memmap.ld).
+struct ProgramSlot
+{
+    // Identifies the ELF: its path, and its size and modification time as FatFS reports them
+    std::uint32_t path_hash;
+    std::uint32_t file_size;
+    std::uint16_t file_date;
+    std::uint16_t file_time;
+    // hash_bytes() over the whole slot, as it was left after the program was written into it
+    std::uint32_t flash_hash;
+    // Offset of the slot from piconsole_program_flash_start and its size, both whole sectors; unused if the size is 0
+    std::uint32_t flash_offset;
+    std::uint32_t flash_size;
+    // ProgramSlotIndex::launch_count as of the program's last launch; the lowest is replaced first
+    std::uint32_t last_launch;
+    std::uint32_t reserved;
+
+    GETTER constexpr bool is_used() const { return flash_size != 0u; }
+    GETTER constexpr bool is_same_image(const ProgramSlot& other) const
+    {
+        return path_hash == other.path_hash && file_size == other.file_size && file_date == other.file_date
+            && file_time == other.file_time;
+    }
+    GETTER constexpr std::size_t get_start() const { return piconsole_program_flash_start + flash_offset; }
+    GETTER constexpr std::size_t get_end() const { return get_start() + flash_size; }
+};
+static_assert(sizeof(ProgramSlot) == 32);
+
+// Which program is in which slot, kept at piconsole_loader_flash_start
+struct ProgramSlotIndex
+{
+    constexpr static std::uint32_t expected_magic{ 0x544C5350u }; // "PSLT"
+    constexpr static std::uint32_t current_version{ 1u };
+    constexpr static std::size_t max_slots{ 16 };
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    // Launches so far, for ordering the slots by when they were last used
+    std::uint32_t launch_count;
+    std::uint32_t reserved;
+    ProgramSlot slots[max_slots];
+
+    GETTER constexpr bool is_valid() const { return magic == expected_magic && version == current_version; }
+    // The slot holding the same ELF as `identity`, if any
+    GETTER constexpr ProgramSlot* find(const ProgramSlot& identity)
+    {
+        for (ProgramSlot& slot : slots)
+        {
+            if (slot.is_used() && slot.is_same_image(identity))
+            {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+    GETTER constexpr const ProgramSlot* find(const ProgramSlot& identity) const
+    {
+        return const_cast<ProgramSlotIndex*>(this)->find(identity);
+    }
+};
+static_assert(sizeof(ProgramSlotIndex) <= piconsole_loader_flash_size);
 
 struct ELFHeader
 {
@@ -92,7 +178,9 @@ struct SegmentHeader
         SharedLibrary = 5, // Should never be used
         ProgramHeader = 6,
         ThreadLocalStorage = 7,
-        Count
+        Count,
+        // In the OS specific range; marks a packed ELF (see PackedSegmentTable)
+        PackedSegments = 0x6050434Bu
     } type;
     std::size_t content_offset;
     std::size_t virtual_address;
@@ -113,6 +201,33 @@ struct SegmentHeader
     std::uint32_t alignment;
 };
 
+// Contents of the SegmentHeader::Type::PackedSegments segment tools/program_packer.py adds to an ELF when it LZ4
+//   compresses its loadable segments (see lz4.h). Their content_offset points at the compressed bytes instead, while
+//   segment_size is still what they unpack to, so the rest of the ELF reads as it did. The table is followed by a
+//   std::uint32_t per program header, in the same order, giving the size of that segment's compressed bytes, or 0 for
+//   one stored as it is.
+struct PackedSegmentTable
+{
+    constexpr static std::uint32_t expected_magic{ 0x4B415050u }; // "PPAK"
+    constexpr static std::uint8_t lz4_codec{ 1u };
+    // Range of history the loader sets aside RAM for
+    constexpr static std::uint8_t min_history_bits{ 8u };
+    constexpr static std::uint8_t max_history_bits{ 14u };
+
+    std::uint32_t magic;
+    std::uint8_t codec;
+    // Matches reach back at most 1 << history_bits bytes
+    std::uint8_t history_bits;
+    std::uint16_t segment_count;
+
+    GETTER constexpr bool is_valid() const
+    {
+        return magic == expected_magic && codec == lz4_codec && history_bits >= min_history_bits
+            && history_bits <= max_history_bits;
+    }
+};
+static_assert(sizeof(PackedSegmentTable) == 8);
+
 struct SectionHeader
 {
     std::uint32_t string_table_name_index;
@@ -148,6 +263,132 @@ struct SectionHeader
 };
 static_assert(sizeof(SectionHeader) == 40);
 
+// Entry of a SectionHeader::Type::Relocation section; ARM uses these rather than the kind with an explicit addend
+struct RelocationEntry
+{
+    // Only the types that can hold an address of data, absolute or PC relative. Branches never need moving: they can't
+    //   reach between flash and RAM without a veneer, so they always land in the same region as they're in. The
+    //   veneers themselves aren't relocated, so a program with any from RAM into flash isn't moved at all.
+    enum class Type : std::uint8_t
+    {
+        Absolute32 = 2,
+        Relative32 = 3,
+        // Treated as Absolute32 by GNU ld; used for .init_array and friends
+        Target1 = 38,
+        // 31 bit PC relative offset, used by .ARM.exidx
+        Relative31 = 42
+    };
+
+    // Address of the bytes to relocate, as the program sees them when running
+    std::size_t offset;
+    // Symbol index << 8 | Type
+    std::uint32_t info;
+
+    GETTER constexpr Type get_type() const { return static_cast<Type>(info & 0xFFu); }
+};
+static_assert(sizeof(RelocationEntry) == 8);
+
+// Entry of a SectionHeader::Type::SymbolTable section
+struct SymbolEntry
+{
+    // Offset of the name in the linked string table
+    std::uint32_t name_index;
+    std::size_t value;
+    std::uint32_t size;
+    // Binding << 4 | Type
+    std::uint8_t info;
+    std::uint8_t other;
+    std::uint16_t section_index;
+
+    GETTER constexpr bool is_function() const { return (info & 0xFu) == 2u; }
+};
+static_assert(sizeof(SymbolEntry) == 16);
+
+// A place in a program's flash image that changes when the program is moved, found from the ELF's relocations.
+//   Packed into a word to fit as many as possible in the RAM the loader borrows for them: flash_offset in the low 24
+//   bits, then kind and range.
+struct RelocationSite
+{
+    enum class Kind : std::uint32_t
+    {
+        Absolute,
+        Relative32,
+        Relative31
+    };
+
+    // Where the bytes are in the flash image as linked, from piconsole_program_flash_start
+    std::uint32_t flash_offset : 24;
+    Kind kind : 2;
+    // The LoadManifest range holding them, for where they are when the program runs
+    std::uint32_t range : 6;
+
+    GETTER constexpr std::size_t get_load_address() const { return piconsole_program_flash_start + flash_offset; }
+};
+static_assert(sizeof(RelocationSite) == 4);
+static_assert(piconsole_program_flash_size <= 1u << 24);
+
+// One step of loading a program; see LoadManifest
+struct LoadRange
+{
+    enum class Type : std::uint32_t
+    {
+        // Bytes from the ELF written into program flash, moved along with the program into its slot
+        Flash,
+        // Bytes from the ELF copied straight into program RAM; never packed
+        RAM,
+        // Bytes already written into program flash copied on into program RAM, such as initialized data
+        FlashToRAM,
+        // Program RAM cleared, such as the part of a segment beyond its bytes in the ELF
+        Zero
+    } type;
+    // Where the bytes go: in program flash as linked, or in program RAM
+    std::uint32_t address;
+    std::uint32_t size;
+    // Where they come from: an offset into the ELF for Flash and RAM, or for FlashToRAM an address in program flash
+    //   as linked
+    std::uint32_t source;
+    // How many bytes the ELF holds for a Flash range if they're packed (see lz4.h), 0 if they're as they are
+    std::uint32_t packed_size;
+    // Where a Flash range's bytes are when the program runs, for moving its relocations: in RAM if they're copied there
+    std::uint32_t run_address;
+};
+static_assert(sizeof(LoadRange) == 24);
+
+// Everything OS::load_program needs to load a program, worked out from its ELF ahead of time by
+//   tools/program_packer.py and stored straight after the ELF header, so a launch parses nothing: one read for the
+//   manifest, one for the relocation sites if the program is moved, and then the ranges' bytes. Flash ranges are
+//   written first, then the rest in order. The loader works one out for itself for an ELF without one.
+struct LoadManifest
+{
+    constexpr static std::uint32_t expected_magic{ 0x4D444C50u }; // "PLDM"
+    constexpr static std::uint16_t current_version{ 1u };
+    constexpr static std::size_t max_ranges{ 16 };
+    static_assert(max_ranges <= 1u << 6, "RelocationSite::range has to be able to refer to every range");
+
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint16_t range_count;
+    // hash_bytes() over the manifest as stored, with this 0
+    std::uint32_t hash;
+    // Where the program starts running, as linked
+    std::uint32_t entry_point;
+    // End of the program's flash image as linked; its slot, and so what's erased for it, is this in whole sectors
+    std::uint32_t image_end;
+    // Matches in packed ranges reach back at most 1 << history_bits bytes; 0 if none are packed
+    std::uint8_t history_bits;
+    std::uint8_t reserved[3];
+    // Where in the ELF the RelocationSites moving the program from where it was linked are, sorted by flash_offset;
+    //   0 if it can't be moved
+    std::uint32_t relocation_sites_offset;
+    std::uint32_t relocation_site_count;
+    // Only range_count are stored
+    LoadRange ranges[max_ranges];
+
+    GETTER constexpr std::size_t get_stored_size() const { return offsetof(LoadManifest, ranges) + range_count * sizeof(LoadRange); }
+    GETTER constexpr bool is_movable() const { return relocation_sites_offset != 0u; }
+};
+static_assert(offsetof(LoadManifest, ranges) == 32);
+
 struct SymbolTableEntry
 {
     std::uint32_t string_table_name_index;
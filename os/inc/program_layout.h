@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+
+// Where programs live in flash and RAM; see piconsole_program_memmap.ld
+constexpr std::size_t piconsole_program_flash_offset{ 0x00080000 };
+constexpr std::size_t piconsole_program_flash_start{ XIP_BASE + piconsole_program_flash_offset };
+// The last sector of flash is kept back from programs for the loader's own records (see ProgramSlotIndex)
+constexpr std::size_t piconsole_loader_flash_size{ FLASH_SECTOR_SIZE };
+constexpr std::size_t piconsole_program_flash_end{ XIP_BASE + 0x00200000 - piconsole_loader_flash_size };
+constexpr std::size_t piconsole_program_flash_size{ piconsole_program_flash_end - piconsole_program_flash_start };
+static_assert(piconsole_program_flash_size % FLASH_SECTOR_SIZE == 0);
+constexpr std::size_t piconsole_loader_flash_start{ piconsole_program_flash_end };
+constexpr std::size_t piconsole_loader_flash_end{ piconsole_loader_flash_start + piconsole_loader_flash_size };
+constexpr std::size_t piconsole_program_ram_offset{ 0x00018000 };
+constexpr std::size_t piconsole_program_ram_start{ SRAM_BASE + piconsole_program_ram_offset };
+constexpr std::size_t piconsole_program_ram_end{ SRAM_BASE + 0x0003E000 };
+constexpr std::size_t piconsole_program_ram_size{ piconsole_program_ram_end - piconsole_program_ram_start - 1 };
+// OS RAM starts with the RAM vector table, then the OS object, then the LCD's framebuffer 4 byte aligned after it;
+//   piconsole_os_memmap.ld asserts as much. Programs aren't linked against the OS's ELF, so they find both from here
+//   and sizeof(OS) rather than from its symbols.
+constexpr std::size_t piconsole_os_address{ SRAM_BASE + 48u * 4u };
+constexpr std::size_t piconsole_lcd_buffer_address(std::size_t os_size)
+{
+    return (piconsole_os_address + os_size + 3u) & ~std::size_t{ 3u };
+}
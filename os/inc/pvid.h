@@ -0,0 +1,155 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include "PICOnsole_defines.h"
+#include "gfx/color.h"
+
+// PVID videos, as written by tools/video_encoder.py and played by VideoPlayer.
+// A PVID file is a sector sized header followed by one chunk per video frame. Each chunk holds a little audio
+//   followed by the frame: a keyframe run length encodes every pixel and a delta frame only the pixels that changed
+//   since the last frame, skipping the rest. Each chunk's header gives the size of the next one, so every frame
+//   costs exactly one SD read.
+namespace pvid
+{
+constexpr std::array<char, 4> file_magic{ 'P', 'V', 'I', 'D' };
+constexpr std::uint8_t file_version{ 1u };
+
+struct FileHeader
+{
+    std::array<char, 4> magic;
+    std::uint8_t version;
+    // 0 for a silent video, 1 for mono or 2 for stereo 16 bit samples
+    std::uint8_t audio_channels;
+    std::uint16_t width;
+    std::uint16_t height;
+    std::uint16_t frame_rate;
+    std::uint32_t frame_count;
+    std::uint32_t sample_rate;
+    // Largest chunk in the file, which is what the chunk buffer is allocated for
+    std::uint32_t max_chunk_size;
+    std::uint32_t first_chunk_size;
+    // Where the first chunk starts
+    std::uint32_t data_offset;
+};
+static_assert(sizeof(FileHeader) == 32);
+
+enum class FrameType : std::uint8_t
+{
+    Key,
+    Delta
+};
+
+struct ChunkHeader
+{
+    // 0 after the last frame
+    std::uint32_t next_chunk_size;
+    FrameType type;
+    std::uint8_t reserved;
+    // Audio frames (one sample per channel) following this header
+    std::uint16_t audio_frames;
+    // Bytes of video operations following the audio
+    std::uint32_t video_size;
+};
+static_assert(sizeof(ChunkHeader) == 12);
+
+// Video is a sequence of operations on the frame's pixels in reading order. Each starts with a byte holding the
+//   operation in its top two bits and a pixel count of 1 to 63 in the rest; a count of 0 means the real count
+//   follows as a little endian 16 bit value.
+enum class Operation : std::uint8_t
+{
+    // Leave pixels as they were in the last frame
+    Skip = 0b00u,
+    // Pixels follow, two bytes each in the framebuffer's RGB565 layout
+    Literal = 0b01u,
+    // One pixel follows, repeated for the whole count
+    Fill = 0b10u
+};
+constexpr std::uint8_t operation_shift{ 6 };
+constexpr std::uint8_t count_mask{ 0x3Fu };
+
+// Runs one frame's video operations on a `width` x `height` frame drawn at x, y on `target`, which needs get_row()
+//   and mark_dirty() like ColorLCD, and marks the rows that changed dirty. False if the operations are malformed or
+//   run past the end of the frame, leaving whatever was decoded before that in place.
+template <typename TTarget>
+bool decode_frame(TTarget& target, std::size_t x, std::size_t y, std::size_t width, std::size_t height,
+    std::span<const std::uint8_t> operations)
+{
+    const std::size_t pixel_count{ width * height };
+    const std::uint8_t* in{ operations.data() };
+    const std::uint8_t* const end{ in + operations.size() };
+    std::size_t pixel{ 0 };
+    // Rows that changed, to only mark those dirty
+    std::size_t first_row{ height };
+    std::size_t last_row{ 0 };
+    while (in != end)
+    {
+        const std::uint8_t tag{ *in++ };
+        const Operation operation{ static_cast<Operation>(tag >> operation_shift) };
+        std::size_t count{ static_cast<std::size_t>(tag & count_mask) };
+        if (count == 0u)
+        {
+            if (end - in < 2)
+            {
+                return false;
+            }
+            count = static_cast<std::size_t>(in[0]) | static_cast<std::size_t>(in[1]) << 8;
+            in += 2;
+        }
+        if (count > pixel_count - pixel)
+        {
+            return false;
+        }
+        if (operation == Operation::Skip)
+        {
+            pixel += count;
+            continue;
+        }
+        const bool literal{ operation == Operation::Literal };
+        if (!literal && operation != Operation::Fill)
+        {
+            return false;
+        }
+        const std::size_t source_size{ literal ? count * sizeof(RGB565) : sizeof(RGB565) };
+        if (static_cast<std::size_t>(end - in) < source_size)
+        {
+            return false;
+        }
+        first_row = std::min(first_row, pixel / width);
+        // Operations run on across rows; each row of the framebuffer gets its share
+        while (count != 0u)
+        {
+            const std::size_t row{ pixel / width };
+            const std::size_t column{ pixel % width };
+            const std::size_t run{ std::min(count, width - column) };
+            RGB565* const destination{ target.get_row(y + row).data() + x + column };
+            if (literal)
+            {
+                std::memcpy(destination, in, run * sizeof(RGB565));
+                in += run * sizeof(RGB565);
+            }
+            else
+            {
+                std::uint16_t color;
+                std::memcpy(&color, in, sizeof(color));
+                std::fill_n(reinterpret_cast<std::uint16_t*>(destination), run, color);
+            }
+            pixel += run;
+            count -= run;
+        }
+        if (!literal)
+        {
+            in += sizeof(RGB565);
+        }
+        last_row = (pixel - 1u) / width;
+    }
+    if (first_row <= last_row)
+    {
+        target.mark_dirty(x, y + first_row, width, last_row - first_row + 1u);
+    }
+    return true;
+}
+}
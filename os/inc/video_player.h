@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "PICOnsole_defines.h"
+#include "interfaces/SD.h"
+#include "interfaces/Speaker.h"
+#include "pvid.h"
+
+// Plays PVID videos (see pvid.h) from the SD card into the framebuffer with their sound going to the speaker.
+// Timing comes from the microsecond timer: update() decodes every frame that's due and presents the last one, so a
+//   slow SD read drops frames rather than letting the picture fall behind the sound. The next chunk is read while
+//   the panel is still being sent the frame just decoded.
+// Delta frames build on what's already in the framebuffer, so the LCD must not be double buffered while playing.
+class VideoPlayer
+{
+public:
+    using FileHeader = pvid::FileHeader;
+    using FrameType = pvid::FrameType;
+    using ChunkHeader = pvid::ChunkHeader;
+    using Operation = pvid::Operation;
+    constexpr static std::array<char, 4> file_magic{ pvid::file_magic };
+    constexpr static std::uint8_t file_version{ pvid::file_version };
+    // Frames of audio buffered between decoding and the speaker; several video frames' worth at common rates
+    constexpr static std::size_t audio_ring_size{ 4096 };
+
+    struct Stats
+    {
+        std::uint32_t frames_decoded{ 0u };
+        std::uint32_t frames_presented{ 0u };
+        // Frames decoded but never shown because a later frame was already due
+        std::uint32_t frames_dropped{ 0u };
+        // Times the speaker asked for audio the player didn't have yet
+        std::uint32_t audio_underruns{ 0u };
+        // Audio frames thrown away because the speaker wasn't taking them fast enough
+        std::uint32_t audio_frames_dropped{ 0u };
+        // Microseconds spent reading chunks and decoding frames: last, maximum and in total
+        std::uint32_t read_time_us{ 0u };
+        std::uint32_t max_read_time_us{ 0u };
+        std::uint64_t total_read_time_us{ 0u };
+        std::uint32_t decode_time_us{ 0u };
+        std::uint32_t max_decode_time_us{ 0u };
+        std::uint64_t total_decode_time_us{ 0u };
+
+        // Frame rate the SD card and decoder could sustain on average, not counting the panel transfer, which
+        //   overlaps the next read
+        GETTER float get_achievable_frame_rate() const
+        {
+            const std::uint64_t total_time_us{ total_read_time_us + total_decode_time_us };
+            return total_time_us == 0u ? 0.0f : static_cast<float>(frames_decoded) * 1'000'000.0f / static_cast<float>(total_time_us);
+        }
+    };
+
+    VideoPlayer() = default;
+    VideoPlayer(const VideoPlayer&) = delete;
+    VideoPlayer& operator=(const VideoPlayer&) = delete;
+    ~VideoPlayer() { close(); }
+
+    // Opens `path` and reads its first chunk, ready to start playing on the first update(). The video is centered
+    //   on screen; it mustn't be bigger than the screen.
+    bool open(const char* path);
+    // Stops playing, handing the speaker back
+    void close();
+    // Decodes and presents whatever is due; returns false once the video has finished or failed
+    bool update();
+
+    GETTER bool is_playing() const { return playing; }
+    GETTER const FileHeader& get_header() const { return header; }
+    // Frames decoded so far
+    GETTER std::uint32_t get_current_frame() const { return next_frame; }
+    GETTER const Stats& get_stats() const { return stats; }
+
+private:
+    // Reads the chunk of `size` bytes at the reader's position into chunk_buffer
+    bool read_chunk(std::uint32_t size);
+    // Decodes the chunk in chunk_buffer into the framebuffer and the audio ring
+    bool decode_chunk();
+    void queue_audio(std::span<const std::uint8_t> samples, std::uint32_t frame_count);
+    // Speaker generator; takes from the audio ring of whichever player is playing
+    static void generate_audio(AudioBuffer& buffer);
+
+    std::optional<SDCard::FileReader> reader{};
+    FileHeader header{};
+    std::vector<std::uint8_t> chunk_buffer{};
+    // Size of the chunk in chunk_buffer, 0 once the last one has been decoded
+    std::uint32_t chunk_size{ 0u };
+    std::uint32_t next_frame{ 0u };
+    std::uint64_t start_time_us{ 0u };
+    bool started{ false };
+    bool playing{ false };
+    // Where the video's top left corner is on screen
+    std::size_t screen_x{ 0 };
+    std::size_t screen_y{ 0 };
+    Stats stats{};
+
+    // Written only by the decoding core and read by the speaker's, or the other way round for audio_read
+    std::array<AudioFrame, audio_ring_size> audio_ring{};
+    std::atomic<std::uint32_t> audio_written{ 0u };
+    std::atomic<std::uint32_t> audio_read{ 0u };
+
+    static VideoPlayer* audio_player;
+};
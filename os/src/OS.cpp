@@ -7,8 +7,13 @@
 #include "hardware/structs/xip_ctrl.h"
 #include "pico/bootrom.h"
 #include "debug.h"
+#include "gfx/screenshot.h"
 #include "gfx/typeface.h"
+#include "lz4.h"
 #include "program.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
 #include <optional>
 
 #include "RP2040.h"
@@ -20,6 +25,10 @@
 
 constexpr uint LED_PIN{ 25u };
 
+// Screenshots are converted and written this many rows at a time; 8 rows of 160 pixels is 5 whole SD sectors
+constexpr std::size_t screenshot_chunk_rows{ 8u };
+alignas(4) static std::array<LCD_MODEL::ColorFormat, LCD_MODEL::width * screenshot_chunk_rows> screenshot_chunk;
+
 bool OS::init()
 {
     if (initialized)
@@ -131,11 +140,18 @@ void OS::show_color_test()
 
 void OS::update()
 {
+    const std::uint64_t wake_time{ time_us_64() };
+    while (multicore_fifo_rvalid())
     {
-        std::uint32_t program_status;
-        multicore_fifo_pop_timeout_us(100, &program_status);
+        const std::uint32_t program_status{ multicore_fifo_pop_blocking() };
         switch (static_cast<FIFOCodes>(program_status))
         {
+        case FIFOCodes::program_updated:
+            if (program_running && frame_pacer.on_program_updated(time_us_64()))
+            {
+                send_program_update();
+            }
+            break;
         case FIFOCodes::error_generic:
             show_program_error("Program has pushed a generic error signal during the last update.");
             break;
@@ -144,16 +160,91 @@ void OS::update()
             break;
         }
     }
+    // The LCD's DMA IRQ leaves opening each write window of a present() to us
+    lcd.update_present();
     vibrator.update();
     speaker.update();
+    if (frame_pacer.poll(time_us_64(), program_running))
+    {
+        send_program_update();
+    }
+    else if (!program_running)
+    {
+        input.update();
+        check_screenshot_chord();
+    }
+    const std::uint64_t sleep_time{ time_us_64() };
+    frame_pacer.add_os_time(static_cast<std::uint32_t>(sleep_time - wake_time));
+    // Until the next tick, unless the program pushes to the FIFO (which signals an event) or an interrupt such as
+    //   the speaker's or the LCD's DMA wakes us first
+    best_effort_wfe_or_timeout(from_us_since_boot(frame_pacer.get_wake_time(sleep_time)));
+}
+
+void OS::send_program_update()
+{
     input.update();
+    // A program that acknowledges updates has finished its last one and is waiting for this, so it isn't drawing
+    //   over the frame being captured or using FatFS on core1. Any other could be doing either, so it's left alone.
+    if (program_acknowledges_updates)
+    {
+        check_screenshot_chord();
+    }
     gpio_put(LED_PIN, !gpio_get(LED_PIN));
-    if (program_running)
+    multicore_fifo_push_timeout_us(FIFOCodes::os_updated, 8'000);
+}
+
+void OS::check_screenshot_chord()
+{
+    const bool chord_held{ input.get_button_state(Button::Start) && input.get_button_state(Button::Y) };
+    if (!chord_held || screenshot_chord_held)
+    {
+        screenshot_chord_held = chord_held;
+        return;
+    }
+    screenshot_chord_held = true;
+    const FRESULT mkdir_result{ f_mkdir(screenshot_directory) };
+    if (mkdir_result != FR_OK && mkdir_result != FR_EXIST)
     {
-        multicore_fifo_push_timeout_us(FIFOCodes::os_updated, 8'000);
+        print("OS failed to f_mkdir screenshot directory %s; Err: %d\n", screenshot_directory, mkdir_result);
+        return;
+    }
+    // Skip numbers already taken, including by screenshots from before the last reset
+    char path[SDCard::max_path_length + 1];
+    FILINFO file_info;
+    do
+    {
+        std::snprintf(path, sizeof(path), "%s/shot_%04u.bmp", screenshot_directory,
+            static_cast<unsigned>(next_screenshot_number++));
+    } while (f_stat(path, &file_info) == FR_OK);
+    if (capture_screenshot(path))
+    {
+        vibrator.start(0.5f, 50);
     }
 }
 
+bool OS::capture_screenshot(const char* path)
+{
+    if (!sd.is_valid())
+    {
+        print("OS can't capture a screenshot without an SD card\n");
+        return false;
+    }
+    const std::uint64_t start_time{ time_us_64() };
+    bool written{ false };
+    {
+        SDCard::FileWriter writer{ path };
+        written = gfx::write_screenshot(writer, lcd, std::span{ screenshot_chunk });
+    }
+    if (!written)
+    {
+        print("OS failed to capture screenshot to %s\n", path);
+        f_unlink(path);
+        return false;
+    }
+    print("Captured screenshot to %s in %llu us\n", path, time_us_64() - start_time);
+    return true;
+}
+
 // Taken directly from flash_ssi_dma example
 static void __no_inline_not_in_flash_func(flash_bulk_read)(uint32_t memory_address, uint32_t word_count, uint32_t flash_offset, uint dma_channel) {
     // SSI must be disabled to set transfer size. If software is executing
@@ -192,25 +283,6 @@ static void __no_inline_not_in_flash_func(flash_bulk_read)(uint32_t memory_addre
     ssi_hw->ssienr = 1;
 }
 
-struct DeferredCopy
-{
-    std::size_t segment_size;
-    std::size_t memory_size;
-    std::size_t virtual_address;
-    union
-    {
-        FSIZE_t file_offset;
-        std::size_t physical_address;
-    };
-    
-    enum class Source
-    {
-        Nothing,
-        ELF,
-        Flash,
-    } source;
-};
-
 #ifdef CALL_WITH_INTERUPTS_DISABLED
 #undef CALL_WITH_INTERUPTS_DISABLED
 #endif
@@ -221,8 +293,915 @@ struct DeferredCopy
         restore_interrupts(interupts); \
     }
 
+static bool is_in_program_flash(const SegmentHeader& segment_header)
+{
+    return segment_header.physical_address >= piconsole_program_flash_start
+        && segment_header.physical_address < piconsole_program_flash_end;
+}
+
+// Hash of what flash currently holds in `slot`, to compare with ProgramSlot::flash_hash
+static std::uint32_t hash_slot(const ProgramSlot& slot)
+{
+    return hash_bytes({ reinterpret_cast<const std::uint8_t*>(slot.get_start()), slot.flash_size });
+}
+
+// Fills in what identifies the ELF at `path` in the slot index; false if FatFS can't say, leaving only the path
+static bool get_program_identity(const char* path, ProgramSlot& identity)
+{
+    identity = ProgramSlot{};
+    identity.path_hash = hash_bytes({ reinterpret_cast<const std::uint8_t*>(path), std::strlen(path) });
+    FILINFO file_info;
+    if (f_stat(path, &file_info) != FR_OK)
+    {
+        return false;
+    }
+    identity.file_size = static_cast<std::uint32_t>(file_info.fsize);
+    identity.file_date = file_info.fdate;
+    identity.file_time = file_info.ftime;
+    return true;
+}
+
+// Moves a program linked to run from piconsole_program_flash_start into a slot further on. Programs are linked with
+//   --emit-relocs, so every address the linker filled in is still listed in the ELF; those pointing into the
+//   program's flash image get the slot's offset added, and PC relative ones change if only one end moves.
+class ProgramRelocator
+{
+public:
+    ProgramRelocator(std::span<const LoadRange> ranges, std::size_t image_end)
+        : ranges{ ranges }, image_end{ image_end }
+    {}
+
+    // Finds the ELF's relocation sections; false if there are none, as the program wasn't linked with its relocations
+    bool read_sections(SDCard::FileReader& reader, const ELFHeader& elf_header)
+    {
+        relocation_sections.clear();
+        if (elf_header.section_header_entry_size != sizeof(SectionHeader))
+        {
+            return false;
+        }
+        std::vector<SectionHeader> section_headers(elf_header.section_header_count);
+        reader.seek_absolute(elf_header.section_header_offset);
+        for (SectionHeader& section_header : section_headers)
+        {
+            if (!reader.read<SectionHeader>(section_header))
+            {
+                return false;
+            }
+        }
+        for (const SectionHeader& section_header : section_headers)
+        {
+            // Relocations of debug info and the like don't matter, only those of sections that are loaded
+            if (section_header.type == SectionHeader::Type::Relocation && section_header.info < section_headers.size()
+                && (static_cast<std::uint32_t>(section_headers[section_header.info].flags)
+                    & static_cast<std::uint32_t>(SectionHeader::Flags::Allocate)) != 0u)
+            {
+                relocation_sections.push_back(section_header);
+            }
+        }
+        if (relocation_sections.empty())
+        {
+            return false;
+        }
+        if (has_flash_veneers(reader, section_headers))
+        {
+            print("Program calls into flash from RAM through veneers, so it can't be moved from where it was linked\n");
+            relocation_sections.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Reads the relocations that matter into `storage`, sorted by address. False if the program can't be moved after
+    //   all: there are more than `storage` holds, or some are in a segment loaded straight from the ELF into RAM,
+    //   which the loader doesn't relocate.
+    bool read_sites(SDCard::FileReader& reader, std::span<RelocationSite> storage)
+    {
+        const std::span<std::uint8_t> storage_bytes{ reinterpret_cast<std::uint8_t*>(storage.data()), storage.size_bytes() };
+        std::size_t site_count{ 0 };
+        for (const SectionHeader& section_header : relocation_sections)
+        {
+            reader.seek_absolute(section_header.offset);
+            std::size_t remaining{ section_header.size / sizeof(RelocationEntry) };
+            while (remaining != 0u)
+            {
+                // Entries are read into the free end of the storage, each making way for its site, if it has one,
+                //   which is half its size
+                const std::span<std::uint8_t> free_bytes{ storage_bytes.subspan(site_count * sizeof(RelocationSite)) };
+                const std::size_t count{ std::min(remaining, free_bytes.size() / sizeof(RelocationEntry)) };
+                if (count == 0u)
+                {
+                    print("Program has more relocations than the loader has room for\n");
+                    return false;
+                }
+                if (!reader.read_bytes(free_bytes.first(count * sizeof(RelocationEntry))))
+                {
+                    return false;
+                }
+                remaining -= count;
+                for (std::size_t i{ 0 }; i < count; ++i)
+                {
+                    RelocationEntry entry;
+                    std::memcpy(&entry, free_bytes.data() + i * sizeof(RelocationEntry), sizeof(entry));
+                    RelocationSite::Kind kind;
+                    switch (entry.get_type())
+                    {
+                        case RelocationEntry::Type::Absolute32:
+                        case RelocationEntry::Type::Target1:
+                            kind = RelocationSite::Kind::Absolute;
+                            break;
+                        case RelocationEntry::Type::Relative32:
+                            kind = RelocationSite::Kind::Relative32;
+                            break;
+                        case RelocationEntry::Type::Relative31:
+                            kind = RelocationSite::Kind::Relative31;
+                            break;
+                        default:
+                            continue;
+                    }
+                    const auto range{ std::find_if(ranges.begin(), ranges.end(),
+                        [&](const LoadRange& range)
+                        {
+                            const std::uint32_t run_address{ range.type == LoadRange::Type::Flash ? range.run_address : range.address };
+                            return (range.type == LoadRange::Type::Flash || range.type == LoadRange::Type::RAM)
+                                && entry.offset >= run_address && entry.offset - run_address < range.size;
+                        }) };
+                    if (range == ranges.end())
+                    {
+                        continue;
+                    }
+                    if (range->type != LoadRange::Type::Flash)
+                    {
+                        print("Program has relocations in a segment loaded straight into RAM (0x%08lx)\n", entry.offset);
+                        return false;
+                    }
+                    storage[site_count++] = RelocationSite{
+                        .flash_offset = static_cast<std::uint32_t>(entry.offset - range->run_address + range->address - piconsole_program_flash_start),
+                        .kind = kind,
+                        .range = static_cast<std::uint32_t>(range - ranges.begin())
+                    };
+                }
+            }
+        }
+        sites = storage.first(site_count);
+        std::sort(sites.begin(), sites.end(),
+            [](const RelocationSite& a, const RelocationSite& b) { return a.flash_offset < b.flash_offset; });
+        return true;
+    }
+
+    // Reads the sites `manifest` lists, already sorted, into `storage` with one read. False if there are more than
+    //   `storage` holds or they aren't what the manifest says, leaving the program where it was linked.
+    bool read_manifest_sites(SDCard::FileReader& reader, const LoadManifest& manifest, std::span<RelocationSite> storage)
+    {
+        if (manifest.relocation_site_count > storage.size())
+        {
+            print("Program has more relocations than the loader has room for\n");
+            return false;
+        }
+        sites = storage.first(manifest.relocation_site_count);
+        reader.seek_absolute(manifest.relocation_sites_offset);
+        if (!reader.read_bytes(std::span<std::uint8_t>{ reinterpret_cast<std::uint8_t*>(sites.data()), sites.size_bytes() }))
+        {
+            sites = {};
+            return false;
+        }
+        std::uint32_t last_offset{ 0u };
+        for (const RelocationSite& site : sites)
+        {
+            const bool in_range{ site.range < ranges.size() && ranges[site.range].type == LoadRange::Type::Flash
+                && site.get_load_address() >= ranges[site.range].address
+                && site.get_load_address() + sizeof(std::uint32_t) <= ranges[site.range].address + ranges[site.range].size };
+            if (!in_range || site.flash_offset < last_offset)
+            {
+                print("Program's manifest lists a relocation outside its flash ranges or out of order\n");
+                sites = {};
+                return false;
+            }
+            last_offset = site.flash_offset;
+        }
+        return true;
+    }
+
+    // Moves `bytes`, which hold the flash image as linked from `load_address` on, `offset` bytes further into flash.
+    //   Relocations straddling either end are completed from `before` and `after`, the bytes either side of them as
+    //   read from the ELF. Returns how many addresses changed.
+    std::uint32_t apply(std::span<std::uint8_t> bytes, std::size_t load_address, std::uint32_t offset,
+        std::span<const std::uint8_t> before, std::span<const std::uint8_t> after) const
+    {
+        std::uint32_t applied{ 0u };
+        const std::size_t load_end{ load_address + bytes.size() };
+        auto site{ std::lower_bound(sites.begin(), sites.end(), load_address - sizeof(std::uint32_t) + 1u,
+            [](const RelocationSite& site, std::size_t address) { return site.get_load_address() < address; }) };
+        for (; site != sites.end() && site->get_load_address() < load_end; ++site)
+        {
+            const std::size_t site_address{ site->get_load_address() };
+            const LoadRange& range{ ranges[site->range] };
+            std::uint32_t value;
+            if (site_address >= load_address && site_address + sizeof(value) <= load_end)
+            {
+                std::memcpy(&value, bytes.data() + (site_address - load_address), sizeof(value));
+            }
+            else
+            {
+                std::array<std::uint8_t, sizeof(value)> value_bytes;
+                std::size_t found{ 0 };
+                for (; found < value_bytes.size(); ++found)
+                {
+                    const std::size_t byte_address{ site_address + found };
+                    if (byte_address < load_address && load_address - byte_address <= before.size())
+                    {
+                        value_bytes[found] = before[before.size() - (load_address - byte_address)];
+                    }
+                    else if (byte_address >= load_address && byte_address < load_end)
+                    {
+                        value_bytes[found] = bytes[byte_address - load_address];
+                    }
+                    else if (byte_address >= load_end && byte_address - load_end < after.size())
+                    {
+                        value_bytes[found] = after[byte_address - load_end];
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+                if (found != value_bytes.size())
+                {
+                    continue;
+                }
+                std::memcpy(&value, value_bytes.data(), sizeof(value));
+            }
+            const std::uint32_t address{ static_cast<std::uint32_t>(site_address - range.address + range.run_address) };
+            // Offsets between two things in flash, or two in RAM, stay the same
+            const auto relative_change{ [&](std::uint32_t target)
+            {
+                return (moves(target) ? offset : 0u) - (moves(address) ? offset : 0u);
+            } };
+            std::uint32_t relocated{ value };
+            switch (site->kind)
+            {
+                case RelocationSite::Kind::Absolute:
+                    relocated += moves(value) ? offset : 0u;
+                    break;
+                case RelocationSite::Kind::Relative32:
+                    relocated += relative_change(address + value);
+                    break;
+                case RelocationSite::Kind::Relative31:
+                {
+                    const std::uint32_t relative{ static_cast<std::uint32_t>(static_cast<std::int32_t>(value << 1) >> 1) };
+                    relocated = (value & 0x80000000u) | ((relative + relative_change(address + relative)) & 0x7FFFFFFFu);
+                    break;
+                }
+            }
+            if (relocated == value)
+            {
+                continue;
+            }
+            const std::size_t first{ std::max(site_address, load_address) };
+            const std::size_t last{ std::min(site_address + sizeof(relocated), load_end) };
+            std::memcpy(bytes.data() + (first - load_address),
+                reinterpret_cast<const std::uint8_t*>(&relocated) + (first - site_address), last - first);
+            // A relocation straddling two windows counts for the first
+            if (site_address >= load_address)
+            {
+                ++applied;
+            }
+        }
+        return applied;
+    }
+
+private:
+    // Whether code in program RAM calls into flash through a veneer. The linker names each one __<callee>_veneer, and
+    //   the flash address it holds has no relocation, so it would still point into the slot the program was linked
+    //   for. True if the symbols can't be read either.
+    static bool has_flash_veneers(SDCard::FileReader& reader, std::span<const SectionHeader> section_headers)
+    {
+        constexpr std::string_view suffix{ "_veneer" };
+        for (const SectionHeader& symbol_table : section_headers)
+        {
+            if (symbol_table.type != SectionHeader::Type::SymbolTable || symbol_table.linked_section_index >= section_headers.size())
+            {
+                continue;
+            }
+            const SectionHeader& names{ section_headers[symbol_table.linked_section_index] };
+            for (std::size_t i{ 0 }; i < symbol_table.size / sizeof(SymbolEntry); ++i)
+            {
+                SymbolEntry symbol;
+                reader.seek_absolute(symbol_table.offset + i * sizeof(SymbolEntry));
+                if (!reader.read<SymbolEntry>(symbol))
+                {
+                    return true;
+                }
+                if (!symbol.is_function() || symbol.value < piconsole_program_ram_start
+                    || symbol.value >= piconsole_program_ram_end || symbol.name_index >= names.size)
+                {
+                    continue;
+                }
+                // Names are read a chunk at a time, carrying the end of the last chunk over in case it ends there
+                reader.seek_absolute(names.offset + symbol.name_index);
+                std::array<char, 32u + suffix.size()> buffer;
+                std::size_t carried{ 0 };
+                std::size_t remaining{ names.size - symbol.name_index };
+                while (remaining != 0u)
+                {
+                    const std::size_t count{ std::min<std::size_t>(remaining, buffer.size() - carried) };
+                    if (!reader.read_bytes(std::span{ reinterpret_cast<std::uint8_t*>(buffer.data()) + carried, count }))
+                    {
+                        return true;
+                    }
+                    remaining -= count;
+                    const std::string_view chunk{ buffer.data(), carried + count };
+                    const std::size_t terminator{ chunk.find('\0') };
+                    if (terminator != std::string_view::npos)
+                    {
+                        if (chunk.substr(0, terminator).ends_with(suffix))
+                        {
+                            return true;
+                        }
+                        break;
+                    }
+                    carried = std::min(chunk.size(), suffix.size());
+                    std::copy(chunk.end() - carried, chunk.end(), buffer.begin());
+                }
+            }
+        }
+        return false;
+    }
+
+    // Whether `address` is in the program's flash image, so moves with it. The end counts for end of image symbols.
+    GETTER bool moves(std::uint32_t address) const
+    {
+        return address >= piconsole_program_flash_start && address <= image_end;
+    }
+
+    std::span<const LoadRange> ranges;
+    std::size_t image_end;
+    std::vector<SectionHeader> relocation_sections{};
+    std::span<RelocationSite> sites{};
+};
+
+// Where a program goes in program flash, and what has to go to make room for it
+struct SlotPlacement
+{
+    // Entry of the slot index it takes
+    std::size_t slot;
+    // Offset from piconsole_program_flash_start
+    std::uint32_t flash_offset;
+    // Bit per slot index entry whose program is dropped
+    std::uint32_t evicted_slots;
+};
+
+// Picks a place for a program image of `size` bytes: where an older build of the same program was, else the first
+//   gap it fits in, evicting the least recently launched programs until one opens up. A program that can't be moved
+//   only goes at the start of program flash, evicting whatever's in the way.
+static SlotPlacement place_program(const ProgramSlotIndex& index, const ProgramSlot& identity, std::size_t size, bool movable)
+{
+    static_assert(ProgramSlotIndex::max_slots <= 32);
+    // Older builds of the same program always go
+    std::uint32_t stale_slots{ 0u };
+    std::optional<std::uint32_t> preferred_offset{};
+    for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+    {
+        // Rebuilding a program mostly leaves it the same, so rewriting it in place changes the fewest sectors
+        if (index.slots[i].is_used() && index.slots[i].path_hash == identity.path_hash)
+        {
+            stale_slots |= 1u << i;
+            preferred_offset = preferred_offset.value_or(index.slots[i].flash_offset);
+        }
+    }
+    std::uint32_t evicted_slots{ stale_slots };
+    const auto is_kept{ [&](std::size_t i) { return index.slots[i].is_used() && (evicted_slots & 1u << i) == 0u; } };
+    const auto overlaps{ [&](std::size_t i, std::uint32_t offset)
+    {
+        return offset < index.slots[i].flash_offset + index.slots[i].flash_size && index.slots[i].flash_offset < offset + size;
+    } };
+    const auto fits{ [&](std::uint32_t offset)
+    {
+        if (offset + size > piconsole_program_flash_size)
+        {
+            return false;
+        }
+        for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+        {
+            if (is_kept(i) && overlaps(i, offset))
+            {
+                return false;
+            }
+        }
+        return true;
+    } };
+    while (true)
+    {
+        std::optional<std::uint32_t> offset{};
+        if (!movable || (preferred_offset.has_value() && fits(*preferred_offset)))
+        {
+            const std::uint32_t candidate{ movable ? *preferred_offset : 0u };
+            if (fits(candidate))
+            {
+                offset = candidate;
+            }
+        }
+        else
+        {
+            // Gaps start at the start of program flash or right after a slot
+            offset = fits(0u) ? std::optional<std::uint32_t>{ 0u } : std::nullopt;
+            for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+            {
+                const std::uint32_t candidate{ index.slots[i].flash_offset + index.slots[i].flash_size };
+                if (is_kept(i) && (!offset.has_value() || candidate < *offset) && fits(candidate))
+                {
+                    offset = candidate;
+                }
+            }
+        }
+        std::optional<std::size_t> slot{};
+        for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots && !slot.has_value(); ++i)
+        {
+            if (!is_kept(i))
+            {
+                slot = i;
+            }
+        }
+        if (offset.has_value() && slot.has_value())
+        {
+            // Programs evicted on the way that aren't in the way after all can stay, unless one's entry is needed
+            std::uint32_t in_the_way{ stale_slots };
+            for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+            {
+                if ((evicted_slots & 1u << i) != 0u && overlaps(i, *offset))
+                {
+                    in_the_way |= 1u << i;
+                }
+            }
+            for (std::size_t i{ ProgramSlotIndex::max_slots }; i-- != 0u;)
+            {
+                if (!index.slots[i].is_used() || (in_the_way & 1u << i) != 0u)
+                {
+                    slot = i;
+                }
+            }
+            const std::uint32_t slot_bit{ index.slots[*slot].is_used() ? 1u << *slot : 0u };
+            return SlotPlacement{ .slot = *slot, .flash_offset = *offset, .evicted_slots = in_the_way | slot_bit };
+        }
+        // Evict the least recently launched program, out of those in the way if the program can't go anywhere else
+        std::optional<std::size_t> victim{};
+        for (const bool only_in_the_way : { !movable, false })
+        {
+            for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+            {
+                if (is_kept(i) && (!only_in_the_way || overlaps(i, 0u))
+                    && (!victim.has_value() || index.slots[i].last_launch < index.slots[*victim].last_launch))
+                {
+                    victim = i;
+                }
+            }
+            if (victim.has_value())
+            {
+                break;
+            }
+        }
+        // The image was checked to fit in program flash, so once everything's gone there's room
+        evicted_slots |= 1u << *victim;
+    }
+}
+
+// Flash is rewritten a window at a time. Windows line up with the flash chip's 64 KB erase blocks, so a window whose
+//   sectors all changed is erased with one block erase, several times faster than sixteen sector erases.
+constexpr std::size_t flash_window_size{ 0x10000u };
+static_assert(flash_window_size % FLASH_SECTOR_SIZE == 0);
+
+// Erases the sectors from `run_start` to `run_end`, which `window` (starting at flash address `window_start`) holds the
+//   new contents of, then programs their non-blank pages, a stretch of consecutive pages per call
+static void rewrite_flash_run(std::size_t run_start, std::size_t run_end, std::span<const std::uint8_t> window,
+    std::size_t window_start, OS::LoadStats& stats)
+{
+    CALL_WITH_INTERUPTS_DISABLED(flash_range_erase(run_start - XIP_BASE, run_end - run_start));
+    stats.sectors_erased += (run_end - run_start) / FLASH_SECTOR_SIZE;
+    for (std::size_t sector{ run_start }; sector < run_end; sector += FLASH_SECTOR_SIZE)
+    {
+        bool programmed{ false };
+        std::size_t page{ sector };
+        while (page < sector + FLASH_SECTOR_SIZE)
+        {
+            // Erased flash reads back as 0xFF already
+            const auto is_blank{ [&](std::size_t address)
+            {
+                const std::span<const std::uint8_t> page_data{ window.subspan(address - window_start, FLASH_PAGE_SIZE) };
+                return std::all_of(page_data.begin(), page_data.end(), [](std::uint8_t byte) { return byte == 0xFFu; });
+            } };
+            if (is_blank(page))
+            {
+                page += FLASH_PAGE_SIZE;
+                continue;
+            }
+            std::size_t stretch_end{ page + FLASH_PAGE_SIZE };
+            while (stretch_end < sector + FLASH_SECTOR_SIZE && !is_blank(stretch_end))
+            {
+                stretch_end += FLASH_PAGE_SIZE;
+            }
+            CALL_WITH_INTERUPTS_DISABLED(flash_range_program(page - XIP_BASE, window.data() + (page - window_start), stretch_end - page));
+            programmed = true;
+            page = stretch_end;
+        }
+        if (programmed)
+        {
+            ++stats.sectors_programmed;
+        }
+    }
+}
+
+// Packed segments are read from the SD card four sectors at a time, so each read is a multiple block one
+constexpr std::size_t unpack_chunk_size{ 2048 };
+
+// Reads a segment's bytes from the ELF in order, unpacking them on the way if the ELF is packed (see
+//   PackedSegmentTable)
+class SegmentReader
+{
+public:
+    SegmentReader(SDCard::FileReader& reader, std::optional<lz4::StreamDecoder>& decoder)
+        : reader{ reader }, decoder{ decoder }
+    {}
+
+    // Starts on the `size` bytes of a segment held at `file_offset`, in `packed_size` bytes if they're packed or as
+    //   they are if that's 0
+    bool start(FSIZE_t file_offset, std::uint32_t size, std::uint32_t packed_size)
+    {
+        if (packed_size != 0u && !decoder.has_value())
+        {
+            return false;
+        }
+        reader.seek_absolute(file_offset);
+        start_offset = file_offset;
+        segment_size = size;
+        remaining = size;
+        packed = packed_size != 0u;
+        if (packed)
+        {
+            decoder->start(packed_size);
+        }
+        return true;
+    }
+    // Reads the segment's next bytes.size() bytes
+    bool read(std::span<std::uint8_t> bytes)
+    {
+        if (bytes.size() > remaining)
+        {
+            return false;
+        }
+        remaining -= static_cast<std::uint32_t>(bytes.size());
+        return packed ? decoder->decode(bytes) : reader.read_bytes(bytes);
+    }
+    // Checks the whole segment was read, and its packed bytes ended with it, adding what it took to `stats`
+    bool finish(OS::LoadStats& stats)
+    {
+        stats.segment_bytes_read += static_cast<std::uint32_t>(reader.get_current_offset() - start_offset);
+        stats.segment_bytes_loaded += segment_size - remaining;
+        if (remaining != 0u || (packed && !decoder->is_finished()))
+        {
+            print("Segment at ELF offset 0x%08lx didn't end where its header says\n", static_cast<std::uint32_t>(start_offset));
+            return false;
+        }
+        return true;
+    }
+
+private:
+    SDCard::FileReader& reader;
+    std::optional<lz4::StreamDecoder>& decoder;
+    FSIZE_t start_offset{ 0 };
+    std::uint32_t segment_size{ 0u };
+    std::uint32_t remaining{ 0u };
+    bool packed{ false };
+};
+
+// Reads a packed ELF's table (see PackedSegmentTable) into `table` and `packed_sizes`, checking every packed segment
+//   lies within the file
+static bool read_packed_table(SDCard::FileReader& reader, const SegmentHeader& table_header,
+    std::span<const SegmentHeader> segment_headers, PackedSegmentTable& table, std::vector<std::uint32_t>& packed_sizes)
+{
+    reader.seek_absolute(table_header.content_offset);
+    if (table_header.segment_size < sizeof(table) + segment_headers.size() * sizeof(std::uint32_t)
+        || !reader.read<PackedSegmentTable>(table) || !table.is_valid() || table.segment_count != segment_headers.size())
+    {
+        print("Packed ELF's table is invalid or for another version of the loader\n");
+        return false;
+    }
+    packed_sizes.resize(segment_headers.size());
+    for (std::size_t i{ 0 }; i < segment_headers.size(); ++i)
+    {
+        if (!reader.read<std::uint32_t>(packed_sizes[i]))
+        {
+            return false;
+        }
+        if (packed_sizes[i] != 0u && (segment_headers[i].type != SegmentHeader::Type::Load
+            || segment_headers[i].content_offset + packed_sizes[i] > reader.get_size()))
+        {
+            print("Packed segment %u isn't loadable or runs past the end of the ELF\n", static_cast<unsigned>(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+// The manifest of the program being loaded, read from its ELF or worked out from its headers
+static LoadManifest load_manifest;
+
+// Reads the LoadManifest tools/program_packer.py stores straight after the ELF header. False if there isn't one, or
+//   it's damaged or for another version of the loader, leaving the ELF's headers to be read instead.
+static bool read_load_manifest(SDCard::FileReader& reader, LoadManifest& manifest)
+{
+    std::uint8_t* const manifest_bytes{ reinterpret_cast<std::uint8_t*>(&manifest) };
+    reader.seek_absolute(sizeof(ELFHeader));
+    if (!reader.read_bytes(std::span<std::uint8_t>{ manifest_bytes, offsetof(LoadManifest, ranges) }) || manifest.magic != LoadManifest::expected_magic)
+    {
+        return false;
+    }
+    if (manifest.version != LoadManifest::current_version || manifest.range_count > LoadManifest::max_ranges
+        || !reader.read_bytes(std::span<std::uint8_t>{ reinterpret_cast<std::uint8_t*>(manifest.ranges), manifest.range_count * sizeof(LoadRange) }))
+    {
+        print("Program's load manifest is for another version of the loader; reading its ELF headers instead\n");
+        return false;
+    }
+    const std::uint32_t stored_hash{ manifest.hash };
+    manifest.hash = 0u;
+    if (hash_bytes({ manifest_bytes, manifest.get_stored_size() }) != stored_hash)
+    {
+        print("Program's load manifest is damaged; reading its ELF headers instead\n");
+        return false;
+    }
+    manifest.hash = stored_hash;
+    return true;
+}
+
+// Works out the manifest for an ELF that doesn't have one from its program headers and, if it's packed, their
+//   packed sizes
+static bool build_load_manifest(std::span<const SegmentHeader> segment_headers, std::span<const std::uint32_t> packed_sizes,
+    std::uint8_t history_bits, LoadManifest& manifest)
+{
+    manifest = LoadManifest{
+        .magic = LoadManifest::expected_magic,
+        .version = LoadManifest::current_version,
+        .entry_point = piconsole_program_flash_start,
+        .image_end = piconsole_program_flash_start,
+        .history_bits = history_bits
+    };
+    const auto add_range{ [&](const LoadRange& range)
+    {
+        if (manifest.range_count == LoadManifest::max_ranges)
+        {
+            print("Program has more segments than the loader has room for\n");
+            return false;
+        }
+        manifest.ranges[manifest.range_count++] = range;
+        return true;
+    } };
+    // Other segments, like .ARM.exidx's, only describe part of a loadable one; a packed ELF doesn't even hold their
+    //   bytes where they say
+    const auto is_loadable{ [](const SegmentHeader& segment_header) { return segment_header.type == SegmentHeader::Type::Load; } };
+    for (std::size_t i{ 0 }; i < segment_headers.size(); ++i)
+    {
+        const SegmentHeader& segment_header{ segment_headers[i] };
+        if (!is_loadable(segment_header) || !is_in_program_flash(segment_header))
+        {
+            continue;
+        }
+        if (!add_range({
+            .type = LoadRange::Type::Flash,
+            .address = segment_header.physical_address,
+            .size = segment_header.segment_size,
+            .source = segment_header.content_offset,
+            .packed_size = packed_sizes[i],
+            .run_address = segment_header.virtual_address }))
+        {
+            return false;
+        }
+        manifest.image_end = std::max<std::uint32_t>(manifest.image_end, segment_header.physical_address + segment_header.segment_size);
+    }
+    for (std::size_t i{ 0 }; i < segment_headers.size(); ++i)
+    {
+        const SegmentHeader& segment_header{ segment_headers[i] };
+        if (!is_loadable(segment_header) || segment_header.memory_size < segment_header.segment_size)
+        {
+            continue;
+        }
+        if (is_in_program_flash(segment_header))
+        {
+            if (segment_header.virtual_address == segment_header.physical_address)
+            {
+                continue;
+            }
+            // Copying from flash to RAM (preinitialized data)
+            if (!add_range({
+                .type = LoadRange::Type::FlashToRAM,
+                .address = segment_header.virtual_address,
+                .size = segment_header.segment_size,
+                .source = segment_header.physical_address }))
+            {
+                return false;
+            }
+        }
+        else if (segment_header.physical_address >= piconsole_program_ram_start
+            && segment_header.physical_address < piconsole_program_ram_end)
+        {
+            // The decoder's history is in the RAM this would be unpacked into
+            if (packed_sizes[i] != 0u)
+            {
+                print("Program has a packed segment loaded straight into RAM; pack it again with tools/program_packer.py\n");
+                return false;
+            }
+            if (!add_range({
+                .type = LoadRange::Type::RAM,
+                .address = segment_header.virtual_address,
+                .size = segment_header.segment_size,
+                .source = segment_header.content_offset }))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            continue;
+        }
+        if (segment_header.memory_size != segment_header.segment_size && !add_range({
+            .type = LoadRange::Type::Zero,
+            .address = segment_header.virtual_address + segment_header.segment_size,
+            .size = segment_header.memory_size - segment_header.segment_size }))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether `size` bytes from `address` are all within [start, end)
+static bool is_within(std::uint32_t address, std::uint32_t size, std::size_t start, std::size_t end)
+{
+    return address >= start && address <= end && size <= end - address;
+}
+
+// Checks every range of `manifest` stays within program flash or RAM and the ELF, whether it came from the ELF or
+//   was worked out from it, so loading can't write anywhere else
+static bool validate_load_manifest(const LoadManifest& manifest, FSIZE_t file_size)
+{
+    if (manifest.image_end <= piconsole_program_flash_start || manifest.image_end > piconsole_program_flash_end)
+    {
+        print("Program has nothing to put in program flash, or more than fits\n");
+        return false;
+    }
+    if (manifest.entry_point < piconsole_program_flash_start || manifest.entry_point >= manifest.image_end)
+    {
+        print("Program's entry point 0x%08lx isn't in its flash image\n", manifest.entry_point);
+        return false;
+    }
+    if (manifest.history_bits != 0u && (manifest.history_bits < PackedSegmentTable::min_history_bits
+        || manifest.history_bits > PackedSegmentTable::max_history_bits))
+    {
+        print("Program is packed with %u bits of history, which the loader doesn't set aside RAM for\n", manifest.history_bits);
+        return false;
+    }
+    for (std::size_t i{ 0 }; i < manifest.range_count; ++i)
+    {
+        const LoadRange& range{ manifest.ranges[i] };
+        const std::uint32_t stored_size{ range.packed_size != 0u ? range.packed_size : range.size };
+        const bool is_from_file{ range.source <= file_size && stored_size <= file_size - range.source };
+        bool is_valid{ false };
+        switch (range.type)
+        {
+            case LoadRange::Type::Flash:
+                is_valid = is_within(range.address, range.size, piconsole_program_flash_start, manifest.image_end)
+                    && is_from_file && (range.packed_size == 0u || manifest.history_bits != 0u);
+                break;
+            case LoadRange::Type::RAM:
+                is_valid = is_within(range.address, range.size, piconsole_program_ram_start, piconsole_program_ram_end)
+                    && is_from_file && range.packed_size == 0u;
+                break;
+            case LoadRange::Type::FlashToRAM:
+                is_valid = is_within(range.address, range.size, piconsole_program_ram_start, piconsole_program_ram_end)
+                    && is_within(range.source, range.size, piconsole_program_flash_start, manifest.image_end);
+                break;
+            case LoadRange::Type::Zero:
+                is_valid = is_within(range.address, range.size, piconsole_program_ram_start, piconsole_program_ram_end);
+                break;
+        }
+        if (!is_valid)
+        {
+            print("Program's load range %u (type %lu, 0x%08lx, 0x%05lx bytes) is outside program memory or the ELF\n",
+                static_cast<unsigned>(i), static_cast<std::uint32_t>(range.type), range.address, range.size);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Streams one Flash range from `segment_reader` into flash a window at a time, with one SD read per window whatever
+//   its size, or a chunk at a time if it's packed, moving it `slot_offset` bytes on from where it was linked. Sectors
+//   that already hold the range's bytes are left alone; runs of changed sectors are erased together, keeping whatever
+//   else shared them with the range, and only their non-blank pages programmed.
+static bool program_flash_segment(SegmentReader& segment_reader, const LoadRange& range, std::uint32_t slot_offset,
+    const ProgramRelocator& relocator, std::span<std::uint8_t, flash_window_size> window, OS::LoadStats& stats)
+{
+    const std::size_t segment_start{ range.address + slot_offset };
+    const std::size_t segment_end{ segment_start + range.size };
+    if (!segment_reader.start(range.source, range.size, range.packed_size))
+    {
+        return false;
+    }
+    // The segment is only ever read forwards, which is all a packed one allows, so relocations straddling two windows
+    //   are completed from the bytes either side of the window, kept as they were read
+    constexpr std::size_t straddle_size{ sizeof(std::uint32_t) - 1u };
+    std::array<std::uint8_t, straddle_size> previous_tail{};
+    std::array<std::uint8_t, straddle_size> next_head{};
+    std::size_t previous_tail_size{ 0 };
+    std::size_t next_head_size{ 0 };
+    for (std::size_t window_start{ segment_start - segment_start % flash_window_size }; window_start < segment_end;
+        window_start += flash_window_size)
+    {
+        const std::size_t data_start{ std::max(segment_start, window_start) };
+        const std::size_t data_end{ std::min(segment_end, window_start + flash_window_size) };
+        const std::span<std::uint8_t> data{ window.subspan(data_start - window_start, data_end - data_start) };
+        std::memcpy(data.data(), next_head.data(), next_head_size);
+        if (!segment_reader.read(data.subspan(next_head_size)))
+        {
+            return false;
+        }
+        if (slot_offset != 0u)
+        {
+            next_head_size = std::min(straddle_size, segment_end - data_end);
+            if (!segment_reader.read(std::span<std::uint8_t>{ next_head }.first(next_head_size)))
+            {
+                return false;
+            }
+            std::array<std::uint8_t, straddle_size> tail;
+            const std::size_t tail_size{ std::min(straddle_size, data.size()) };
+            std::memcpy(tail.data(), data.data() + (data.size() - tail_size), tail_size);
+            stats.relocations_applied += relocator.apply(data, data_start - slot_offset, slot_offset,
+                std::span<const std::uint8_t>{ previous_tail }.first(previous_tail_size),
+                std::span<const std::uint8_t>{ next_head }.first(next_head_size));
+            previous_tail = tail;
+            previous_tail_size = tail_size;
+        }
+        std::size_t run_start{ 0 };
+        bool in_run{ false };
+        const std::size_t first_sector{ data_start - data_start % FLASH_SECTOR_SIZE };
+        for (std::size_t sector{ first_sector }; sector < data_end; sector += FLASH_SECTOR_SIZE)
+        {
+            const std::size_t sector_end{ sector + FLASH_SECTOR_SIZE };
+            const std::size_t sector_data_start{ std::max(data_start, sector) };
+            const std::size_t sector_data_end{ std::min(data_end, sector_end) };
+            std::uint8_t* const sector_buffer{ window.data() + (sector - window_start) };
+            if (std::memcmp(sector_buffer + (sector_data_start - sector), reinterpret_cast<const void*>(sector_data_start),
+                sector_data_end - sector_data_start) == 0)
+            {
+                ++stats.sectors_skipped;
+                if (in_run)
+                {
+                    rewrite_flash_run(run_start, sector, window, window_start, stats);
+                    in_run = false;
+                }
+                continue;
+            }
+            // Whatever shares the sector with this segment has to survive the erase
+            std::memcpy(sector_buffer, reinterpret_cast<const void*>(sector), sector_data_start - sector);
+            std::memcpy(sector_buffer + (sector_data_end - sector), reinterpret_cast<const void*>(sector_data_end), sector_end - sector_data_end);
+            if (!in_run)
+            {
+                run_start = sector;
+                in_run = true;
+            }
+        }
+        if (in_run)
+        {
+            const std::size_t run_end{ data_end + (FLASH_SECTOR_SIZE - data_end % FLASH_SECTOR_SIZE) % FLASH_SECTOR_SIZE };
+            rewrite_flash_run(run_start, run_end, window, window_start, stats);
+        }
+    }
+    return segment_reader.finish(stats);
+}
+
+// The slot index is written as whole pages, the rest of its sector left erased
+constexpr std::size_t slot_index_flash_size{ (sizeof(ProgramSlotIndex) + FLASH_PAGE_SIZE - 1u) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE };
+
+// The slot index as it is in flash, or an empty one if flash doesn't hold one yet
+static void read_slot_index(ProgramSlotIndex& index)
+{
+    std::memcpy(&index, reinterpret_cast<const void*>(piconsole_loader_flash_start), sizeof(index));
+    if (!index.is_valid())
+    {
+        index = ProgramSlotIndex{ .magic = ProgramSlotIndex::expected_magic, .version = ProgramSlotIndex::current_version };
+    }
+}
+
+static void write_slot_index(const ProgramSlotIndex& index, std::span<std::uint8_t, flash_window_size> window)
+{
+    const std::span<std::uint8_t> pages{ window.first(slot_index_flash_size) };
+    std::fill(pages.begin(), pages.end(), 0xFFu);
+    std::memcpy(pages.data(), &index, sizeof(index));
+    const std::uint32_t flash_offset{ piconsole_loader_flash_start - XIP_BASE };
+    CALL_WITH_INTERUPTS_DISABLED(flash_range_erase(flash_offset, FLASH_SECTOR_SIZE));
+    CALL_WITH_INTERUPTS_DISABLED(flash_range_program(flash_offset, pages.data(), pages.size()));
+}
+
 bool OS::load_program(std::string_view path)
 {
+    const std::uint64_t load_start_time{ time_us_64() };
     if (path.size() > SDCard::max_path_length)
     {
         show_os_error((std::stringstream{} << "Can't load program from path as it exceeds the max path length (" << path.size() << ", " << SDCard::max_path_length << ")").str());
@@ -269,216 +1248,224 @@ bool OS::load_program(std::string_view path)
     print("Program/Segment elf_header offset: 0x%08lx\n", elf_header.segment_header_offset);
     print("Section elf_header offset: 0x%08lx\n", elf_header.section_header_offset);
 
-    reader.seek_absolute(elf_header.segment_header_offset);
-    print("Loading %d segments...\n", elf_header.segment_header_count);
-    print("             idx: Type Offset     VirtAddr   PhysAddr   FileSize MemSize Flags (Raw)    Alignment\n");
-    std::vector<DeferredCopy> deferred_copies;
+    // A packed ELF's loadable segments are unpacked as they're read
+    const bool from_manifest{ read_load_manifest(reader, load_manifest) };
     std::vector<SegmentHeader> segment_headers;
-    segment_headers.resize(elf_header.segment_header_count);
-    for (std::size_t i{ 0 }; i < elf_header.segment_header_count; ++i)
+    if (from_manifest)
+    {
+        print("Loading from the ELF's manifest: %u ranges, %lu relocations\n", load_manifest.range_count,
+            load_manifest.relocation_site_count);
+    }
+    else
     {
-        if (!reader.read<SegmentHeader>(segment_headers[i]))
+        reader.seek_absolute(elf_header.segment_header_offset);
+        print("Loading %d segments...\n", elf_header.segment_header_count);
+        print("             idx: Type Offset     VirtAddr   PhysAddr   FileSize MemSize Flags (Raw)    Alignment\n");
+        segment_headers.resize(elf_header.segment_header_count);
+        for (std::size_t i{ 0 }; i < elf_header.segment_header_count; ++i)
         {
-            show_os_error("OS::load_program failed to read segment header from program ELF");
-            std::memset(current_program_path, 0, count_of(current_program_path));
-            return false;
+            if (!reader.read<SegmentHeader>(segment_headers[i]))
+            {
+                show_os_error("OS::load_program failed to read segment header from program ELF");
+                std::memset(current_program_path, 0, count_of(current_program_path));
+                return false;
+            }
+            print(" %3d:", i);
+            if (segment_headers[i].type < SegmentHeader::Type::Count)
+            {
+                print(" %.4d", segment_headers[i].type);
+            }
+            else
+            {
+                print(" ????");
+            }
+            print(" 0x%08lx 0x%08lx 0x%08lx",
+                segment_headers[i].content_offset, segment_headers[i].virtual_address, segment_headers[i].physical_address);
+            print(" 0x%05x  0x%05x",
+                segment_headers[i].segment_size, segment_headers[i].memory_size);
+            constexpr static auto has_flag{
+                [](SegmentHeader::Flags flags, SegmentHeader::Flags mask)
+                {
+                    const std::uint32_t masked{ static_cast<std::uint32_t>(flags) & static_cast<std::uint32_t>(mask) };
+                    return masked == static_cast<std::uint32_t>(mask);
+                }
+            };
+            print(" %c%c%c",
+                has_flag(segment_headers[i].flags, SegmentHeader::Flags::R) ? 'R' : ' ',
+                has_flag(segment_headers[i].flags, SegmentHeader::Flags::W) ? 'W' : ' ',
+                has_flag(segment_headers[i].flags, SegmentHeader::Flags::X) ? 'X' : ' ');
+            print("   (0x%04x) 0x%04x\n", segment_headers[i].flags, segment_headers[i].alignment);
         }
-        print(" %3d:", i);
-        if (segment_headers[i].type < SegmentHeader::Type::Count)
+        std::vector<std::uint32_t> packed_sizes(segment_headers.size(), 0u);
+        PackedSegmentTable packed_table{};
+        const auto packed_table_header{ std::find_if(segment_headers.begin(), segment_headers.end(),
+            [](const SegmentHeader& segment_header) { return segment_header.type == SegmentHeader::Type::PackedSegments; }) };
+        if (packed_table_header != segment_headers.end()
+            && !read_packed_table(reader, *packed_table_header, segment_headers, packed_table, packed_sizes))
         {
-            print(" %.4d", segment_headers[i].type);
+            show_os_error("OS::load_program couldn't read the packed ELF's table");
+            std::memset(current_program_path, 0, count_of(current_program_path));
+            return false;
         }
-        else
+        if (!build_load_manifest(segment_headers, packed_sizes, packed_table.history_bits, load_manifest))
         {
-            print(" ????");
+            show_os_error("OS::load_program can't load the program's segments");
+            std::memset(current_program_path, 0, count_of(current_program_path));
+            return false;
         }
-        print(" 0x%08lx 0x%08lx 0x%08lx",
-            segment_headers[i].content_offset, segment_headers[i].virtual_address, segment_headers[i].physical_address);
-        print(" 0x%05x  0x%05x",
-            segment_headers[i].segment_size, segment_headers[i].memory_size);
-        constexpr static auto has_flag{
-            [](SegmentHeader::Flags flags, SegmentHeader::Flags mask)
-            {
-                const std::uint32_t masked{ static_cast<std::uint32_t>(flags) & static_cast<std::uint32_t>(mask) };
-                return masked == static_cast<std::uint32_t>(mask);
-            }
-        };
-        print(" %c%c%c",
-            has_flag(segment_headers[i].flags, SegmentHeader::Flags::R) ? 'R' : ' ',
-            has_flag(segment_headers[i].flags, SegmentHeader::Flags::W) ? 'W' : ' ',
-            has_flag(segment_headers[i].flags, SegmentHeader::Flags::X) ? 'X' : ' ');
-        print("   (0x%04x) 0x%04x\n", segment_headers[i].flags, segment_headers[i].alignment);
     }
-    // Erase existing flash
-    for (const SegmentHeader& segment_header : segment_headers)
+    if (!validate_load_manifest(load_manifest, reader.get_size()))
+    {
+        show_os_error("OS::load_program found the program's segments outside program memory or its ELF");
+        std::memset(current_program_path, 0, count_of(current_program_path));
+        return false;
+    }
+    const std::span<const LoadRange> load_ranges{ load_manifest.ranges, load_manifest.range_count };
+    // The program's flash image is moved into its slot as a whole
+    const std::size_t image_size{ (load_manifest.image_end - piconsole_program_flash_start + FLASH_SECTOR_SIZE - 1u) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE };
+    // The running program executes from the flash and RAM about to be rewritten
+    stop_program();
+    LoadStats load_stats{ .from_manifest = from_manifest };
+    // Temporarily borrowing program RAM to build flash windows in, for a working copy of the slot index, for the
+    //   decoder's history and chunk if the ELF is packed and for the program's relocations; whatever was there won't
+    //   matter anymore anyway
+    const std::span<std::uint8_t, flash_window_size> flash_window{ reinterpret_cast<std::uint8_t*>(piconsole_program_ram_start), flash_window_size };
+    ProgramSlotIndex& slot_index{ *reinterpret_cast<ProgramSlotIndex*>(piconsole_program_ram_start + flash_window_size) };
+    std::size_t relocation_sites_start{ piconsole_program_ram_start + flash_window_size + slot_index_flash_size };
+    std::optional<lz4::StreamDecoder> decoder;
+    if (load_manifest.history_bits != 0u)
+    {
+        const std::size_t history_size{ std::size_t{ 1u } << load_manifest.history_bits };
+        std::uint8_t* const history{ reinterpret_cast<std::uint8_t*>(relocation_sites_start) };
+        decoder.emplace(reader, std::span<std::uint8_t>{ history, history_size },
+            std::span<std::uint8_t>{ history + history_size, unpack_chunk_size });
+        relocation_sites_start += history_size + unpack_chunk_size;
+        print("ELF is packed, with %lu bytes of history\n", static_cast<std::uint32_t>(history_size));
+    }
+    const std::span<RelocationSite> relocation_sites{ reinterpret_cast<RelocationSite*>(relocation_sites_start),
+        (piconsole_program_ram_end - relocation_sites_start) / sizeof(RelocationSite) };
+    static_assert(flash_window_size + slot_index_flash_size + (std::size_t{ 1u } << PackedSegmentTable::max_history_bits)
+        + unpack_chunk_size < piconsole_program_ram_size);
+    SegmentReader segment_reader{ reader, decoder };
+    read_slot_index(slot_index);
+    // Relaunching an ELF that's still in its slot, with flash untouched since, needs no SD reads or flash writes at all
+    ProgramSlot identity;
+    const bool has_file_info{ get_program_identity(current_program_path, identity) };
+    ProgramSlot* slot{ has_file_info ? slot_index.find(identity) : nullptr };
+    load_stats.was_resident = slot != nullptr && hash_slot(*slot) == slot->flash_hash;
+    ProgramRelocator relocator{ load_ranges, load_manifest.image_end };
+    if (load_stats.was_resident)
     {
-        if (segment_header.physical_address < piconsole_program_flash_start
-            || segment_header.physical_address >= piconsole_program_flash_end)
+        print("%s is still resident at 0x%08lx; skipping flash segments\n", current_program_path, slot->get_start());
+        load_stats.sectors_skipped = slot->flash_size / FLASH_SECTOR_SIZE;
+    }
+    else
+    {
+        // Only a program linked with its relocations can go anywhere but the start of program flash
+        const bool is_movable{ from_manifest ? load_manifest.is_movable() : relocator.read_sections(reader, elf_header) };
+        SlotPlacement placement{ place_program(slot_index, identity, image_size, is_movable) };
+        if (placement.flash_offset != 0u && !(from_manifest
+            ? relocator.read_manifest_sites(reader, load_manifest, relocation_sites)
+            : relocator.read_sites(reader, relocation_sites)))
         {
-            // Segment not in flash, nothing to erase
-            continue;
+            print("%s can't be moved from where it was linked\n", current_program_path);
+            placement = place_program(slot_index, identity, image_size, false);
         }
-        const std::uint32_t unaligned_flash_offset{ segment_header.physical_address - XIP_BASE };
-        const std::uint32_t sector_alignment_error_of_segment_start{ unaligned_flash_offset % FLASH_SECTOR_SIZE };
-        const std::uint32_t flash_offset{
-            unaligned_flash_offset - (sector_alignment_error_of_segment_start > 0u ? 1u : 0u)
-        };
-        const std::uint32_t sector_alignment_error_of_segment_size{ segment_header.segment_size % FLASH_SECTOR_SIZE };
-        // Erase 1 extra segment if division results in truncation
-        const std::uint32_t sector_count{
-            segment_header.segment_size / FLASH_SECTOR_SIZE
-            + (sector_alignment_error_of_segment_size > 0u ? 1u : 0u) 
-            + (sector_alignment_error_of_segment_start > 0u ? 1u : 0u)
-        };
-        print("Erasing %lu sectors on existing flash starting at 0x%.08x...\n", sector_count, segment_header.physical_address);
-        CALL_WITH_INTERUPTS_DISABLED(flash_range_erase(flash_offset, sector_count * FLASH_SECTOR_SIZE));
-    }
-    // Program flash with new data
-    for (const SegmentHeader& segment_header : segment_headers)
-    {
-        // Temporarily borrowing program RAM; whatever was there won't matter anymore anyway
-        // TODO: Chunk this in case the segment_size is > 192KB
-        if (segment_header.physical_address >= piconsole_program_flash_start)
-        {
-            if (segment_header.physical_address < piconsole_program_flash_end)
-            {
-                // Copy directly to flash
-                // Flash writes need to be page aligned, so first we need to copy the bytes
-                //   from the beginning of the page we're programming to ram...
-                const std::size_t leading_byte_count{ segment_header.physical_address % 0x100 };
-                std::span<std::uint8_t> leading_flash{reinterpret_cast<std::uint8_t*>(segment_header.physical_address - leading_byte_count), leading_byte_count};
-                std::span<std::uint8_t> leading_RAM{reinterpret_cast<std::uint8_t*>(piconsole_program_ram_start), leading_byte_count};
-                //std::memcpy(leading_RAM.data(), leading_flash.data(), leading_byte_count);
-                std::memset(leading_RAM.data(), 0xA5, leading_byte_count);
-                // ...then we can read the data we want to program from the SD card...
-                std::span<std::uint8_t> segment_data{reinterpret_cast<std::uint8_t*>(piconsole_program_ram_start + leading_byte_count), segment_header.segment_size};
-                reader.seek_absolute(segment_header.content_offset);
-                if (!reader.read_bytes(segment_data))
-                {
-                    show_os_error("Failed to read segment data while OS was loading program from ELF file");
-                    return false;
-                }
-                // ...then we can write the whole thing back to flash.
-                //   See flash programming example
-                print("\tCopying directly from RAM to flash...\n");
-                // ...then we need to end with the trailing bytes of the last written page...
-                const std::size_t trailing_offset{ leading_byte_count + segment_data.size() };
-                const std::size_t alignment_error{ trailing_offset % 0x100 };
-                const std::size_t trailing_byte_count{ alignment_error == 0 ? 0 : 0x100 - alignment_error };
-                std::span<std::uint8_t> trailing_flash{reinterpret_cast<std::uint8_t*>(segment_header.physical_address + trailing_offset), trailing_byte_count};
-                std::span<std::uint8_t> trailing_RAM{reinterpret_cast<std::uint8_t*>(piconsole_program_ram_start + trailing_offset), trailing_byte_count};
-                std::memcpy(trailing_RAM.data(), trailing_flash.data(), trailing_byte_count);
-                // ..and finally we can write everything back to flash.
-                const std::size_t total_byte_count{ leading_byte_count + segment_data.size() + trailing_byte_count };
-                hard_assert(total_byte_count % 0x100 == 0);
-                const std::size_t flash_offset{ reinterpret_cast<std::size_t>(leading_flash.data()) - XIP_BASE };
-                //flash_range_program(flash_offset, leading_RAM.data(), total_byte_count);
-                CALL_WITH_INTERUPTS_DISABLED(flash_range_program(flash_offset, leading_RAM.data(), total_byte_count));
-                print("\t0x%.08x == 0x%.08x\n", *(std::uint32_t*)(segment_data.data()), *(std::uint32_t*)(segment_header.physical_address));
-                print("\tDone.\n");
-            }
-            else if (segment_header.physical_address >= piconsole_program_ram_start
-                && segment_header.physical_address < piconsole_program_ram_end)
-            {
-                // Defer segment copy into RAM to the end
-                const DeferredCopy copy{
-                    .segment_size = segment_header.segment_size,
-                    .memory_size = segment_header.memory_size,
-                    .virtual_address = segment_header.virtual_address,
-                    .file_offset = segment_header.content_offset,
-                    .source = DeferredCopy::Source::ELF
-                };
-                print("\tDeferring copy from ELF (0x%04x) to RAM (0x%08lx)!\n",
-                    copy.file_offset, copy.virtual_address);
-                deferred_copies.emplace_back(std::move(copy));
-            }
-            if (segment_header.virtual_address != segment_header.physical_address)
-            {
-                // May be copying from flash to RAM (preinitialized data)
-                if (segment_header.virtual_address < piconsole_program_ram_start
-                    || segment_header.virtual_address >= piconsole_program_ram_end)
-                {
-                    show_os_error("Invalid segment initialization! virtual_address != physical_address, but virtual_address isn't in program RAM");
-                    return false;
-                }
-                else if (segment_header.physical_address < piconsole_program_flash_start
-                        || segment_header.physical_address >= piconsole_program_flash_end)
+        for (std::size_t i{ 0 }; i < ProgramSlotIndex::max_slots; ++i)
+        {
+            if ((placement.evicted_slots & 1u << i) != 0u)
+            {
+                if (slot_index.slots[i].path_hash != identity.path_hash)
                 {
-                    show_os_error("Invalid segment initialization! virtual_address != physical_address, but physical_address isn't in program Flash");
-                    return false;
+                    ++load_stats.slots_evicted;
                 }
-                // Defer segment copy into RAM to the end
-                const DeferredCopy copy{
-                    .segment_size = segment_header.segment_size,
-                    .memory_size = segment_header.memory_size,
-                    .virtual_address = segment_header.virtual_address,
-                    .physical_address = segment_header.physical_address,
-                    .source = DeferredCopy::Source::Flash
-                };
-                print("\tDeferring copy from flash (0x%08lx) to RAM (0x%08lx)!\n", copy.physical_address, copy.virtual_address);
-                deferred_copies.emplace_back(std::move(copy));
+                slot_index.slots[i] = ProgramSlot{};
             }
         }
+        slot = &slot_index.slots[placement.slot];
+        *slot = identity;
+        slot->flash_offset = placement.flash_offset;
+        slot->flash_size = image_size;
+        print("Placing %s at 0x%08lx, evicting %lu other programs\n", current_program_path, slot->get_start(),
+            load_stats.slots_evicted);
     }
-    print("\tInitial copies to flash done; doing any deferred copies...\n");
-    const int dma_channel{ dma_claim_unused_channel(false) };
-    for (const DeferredCopy& copy : deferred_copies)
+    const std::uint32_t slot_offset{ slot->flash_offset };
+    // Program flash with new data
+    if (!load_stats.was_resident)
     {
-        if (copy.virtual_address < piconsole_program_ram_start || copy.virtual_address >= piconsole_program_ram_end)
+        for (const LoadRange& range : load_ranges)
         {
-            show_os_error("OS::load_program attempted deferred copy into non-program RAM");
-            return false;
+            if (range.type == LoadRange::Type::Flash
+                && !program_flash_segment(segment_reader, range, slot_offset, relocator, flash_window, load_stats))
+            {
+                show_os_error("Failed to read segment data while OS was loading program from ELF file");
+                return false;
+            }
         }
-        switch (copy.source)
+        slot->flash_hash = hash_slot(*slot);
+    }
+    // The index is only rewritten when the order of the slots changes or a program was written
+    if (slot->last_launch != slot_index.launch_count || slot_index.launch_count == 0u)
+    {
+        slot->last_launch = ++slot_index.launch_count;
+    }
+    if (std::memcmp(&slot_index, reinterpret_cast<const void*>(piconsole_loader_flash_start), sizeof(slot_index)) != 0)
+    {
+        write_slot_index(slot_index, flash_window);
+    }
+    load_stats.slot_address = slot->get_start();
+    print("Flash sectors: %lu skipped, %lu erased, %lu programmed; %lu relocations applied\n",
+        load_stats.sectors_skipped, load_stats.sectors_erased, load_stats.sectors_programmed, load_stats.relocations_applied);
+    // The rest go into program RAM, over what was borrowed
+    print("\tInitial copies to flash done; doing RAM copies...\n");
+    const int dma_channel{ dma_claim_unused_channel(false) };
+    for (const LoadRange& range : load_ranges)
+    {
+        switch (range.type)
         {
-            case DeferredCopy::Source::Nothing:
+            case LoadRange::Type::Flash:
+                break;
+            case LoadRange::Type::Zero:
             {
                 print("\tClearing memory region: 0x%08lx-0x%08lx (size: 0x%08lx)\n",
-                    copy.virtual_address, copy.virtual_address + copy.memory_size, copy.memory_size);
-                std::memset(reinterpret_cast<void*>(copy.virtual_address), 0, copy.memory_size);
+                    range.address, range.address + range.size, range.size);
+                std::memset(reinterpret_cast<void*>(range.address), 0, range.size);
                 break;
             }
-            case DeferredCopy::Source::ELF:
+            case LoadRange::Type::RAM:
             {
                 print("\tCopying memory from ELF offset 0x%04x to RAM address 0x%08lx (size: 0x%08lx)\n",
-                    copy.file_offset, copy.virtual_address + copy.memory_size, copy.memory_size);
-                std::span<std::uint8_t> segment_data{reinterpret_cast<std::uint8_t*>(copy.virtual_address), copy.segment_size};
-                reader.seek_absolute(copy.file_offset);
-                if (!reader.read_bytes(segment_data))
+                    range.source, range.address, range.size);
+                const std::span<std::uint8_t> segment_data{ reinterpret_cast<std::uint8_t*>(range.address), range.size };
+                if (!segment_reader.start(range.source, range.size, 0u) || !segment_reader.read(segment_data)
+                    || !segment_reader.finish(load_stats))
                 {
-                    show_os_error("OS::load_program failed to read segment data in deferred_copy");
+                    show_os_error("OS::load_program failed to read segment data into RAM");
                     return false;
                 }
-                const std::size_t remaining_bytes{ copy.memory_size - copy.segment_size };
-                if (remaining_bytes > 0)
-                {
-                    std::memset(reinterpret_cast<void*>(copy.virtual_address + remaining_bytes), 0, remaining_bytes);
-                }
                 break;
             }
-            case DeferredCopy::Source::Flash:
+            case LoadRange::Type::FlashToRAM:
             {
-                const std::size_t flash_offset{ copy.physical_address - XIP_BASE };
+                const std::uint32_t source{ range.source + slot_offset };
+                const std::uint32_t flash_offset{ source - XIP_BASE };
                 print("\tCopying memory from flash address 0x%08lx (offset: 0x%08lx) to RAM address 0x%08lx (size: 0x%08lx)\n",
-                    copy.physical_address, flash_offset,
-                    copy.virtual_address + copy.memory_size, copy.memory_size);
-                if (dma_channel != -1)
+                    source, flash_offset, range.address, range.size);
+                // DMA moves whole words, so any bytes after the last are copied the slow way
+                std::size_t copied{ 0 };
+                const std::size_t word_count{ range.size / 4u };
+                if (dma_channel != -1 && word_count != 0u)
                 {
-                    const bool memory_size_is_aligned{ copy.memory_size % 4 == 0 };
-                    const std::size_t word_count{ copy.memory_size / 4 + (memory_size_is_aligned ? 0 : 1) };
                     print("\tStarting DMA of 0x%08lx words...\n", word_count);
-                    CALL_WITH_INTERUPTS_DISABLED(flash_bulk_read(copy.virtual_address, word_count, flash_offset, dma_channel));
+                    CALL_WITH_INTERUPTS_DISABLED(flash_bulk_read(range.address, word_count, flash_offset, dma_channel));
+                    copied = word_count * 4u;
                 }
-                else
+                else if (dma_channel == -1)
                 {
                     print("\tNo DMA available for flash->RAM copy; copying the slow way\n");
-                    std::memcpy(reinterpret_cast<void*>(copy.virtual_address), reinterpret_cast<const void*>(flash_offset), copy.segment_size);
-                    const std::size_t remaining_bytes{ copy.memory_size - copy.segment_size };
-                    if (remaining_bytes > 0)
-                    {
-                        std::memset(reinterpret_cast<void*>(copy.virtual_address + remaining_bytes), 0, remaining_bytes);
-                    }
                 }
+                std::memcpy(reinterpret_cast<void*>(range.address + copied), reinterpret_cast<const void*>(source + copied),
+                    range.size - copied);
                 break;
             }
         }
@@ -505,14 +1492,23 @@ bool OS::load_program(std::string_view path)
     );
     // Should never return
 #endif
+    load_stats.load_time_us = time_us_64() - load_start_time;
+    last_load_stats = load_stats;
+    print("Loaded %s in %llu us, reading %lu bytes of segments for %lu loaded\n", current_program_path,
+        load_stats.load_time_us, load_stats.segment_bytes_read, load_stats.segment_bytes_loaded);
     typedef void program_entrypoint_t(void);
-    const program_entrypoint_t* program_entrypoint{ reinterpret_cast<program_entrypoint_t*>(0x10080001) };
+    // Programs start with their main, in Thumb mode, moved into the slot along with the rest of the flash image
+    const std::uint32_t entry_address{ load_stats.slot_address + (load_manifest.entry_point - piconsole_program_flash_start) };
+    const program_entrypoint_t* program_entrypoint{ reinterpret_cast<program_entrypoint_t*>(entry_address | 1u) };
     stop_program();
     print("Launching program on core1...\n");
     multicore_launch_core1(program_entrypoint);
     std::uint32_t launch_result{ ~0u };
     multicore_fifo_pop_timeout_us(500'000, &launch_result);
-    program_running = launch_result == FIFOCodes::program_launch_success;
+    const bool acknowledges_updates{ launch_result == FIFOCodes::program_launch_acknowledges_updates };
+    program_running = acknowledges_updates || launch_result == FIFOCodes::program_launch_success;
+    program_acknowledges_updates = acknowledges_updates;
+    frame_pacer.start(time_us_64(), acknowledges_updates);
     if (!program_running)
     {
         print("Failed to launch program; the program_launch_success constant was not pushed to the fifo.\n");
@@ -520,10 +1516,26 @@ bool OS::load_program(std::string_view path)
     else
     {
         print("Program started successfully!\n");
+        if (!acknowledges_updates)
+        {
+            print("Program doesn't report finishing updates; sending it one every tick, without screenshots\n");
+        }
     }
     return program_running;
 }
 
+bool OS::is_program_resident(const char* path) const
+{
+    ProgramSlot identity;
+    if (!get_program_identity(path, identity))
+    {
+        return false;
+    }
+    const ProgramSlotIndex& slot_index{ *reinterpret_cast<const ProgramSlotIndex*>(piconsole_loader_flash_start) };
+    const ProgramSlot* const slot{ slot_index.is_valid() ? slot_index.find(identity) : nullptr };
+    return slot != nullptr && hash_slot(*slot) == slot->flash_hash;
+}
+
 bool OS::stop_program()
 {
     if (!program_running)
@@ -532,6 +1544,14 @@ bool OS::stop_program()
     }
     print("Stopping current program...\n");
     multicore_reset_core1();
+    // The back buffer lived in program RAM, which the next program is free to reuse
+    lcd.set_back_buffer(nullptr);
+    // The OS draws in screen coordinates, so undo any hardware scroll the program left behind
+    lcd.set_scroll_offset(0);
+    // Fades and lookup tables belong to the program, and a color table may point into its flash
+    lcd.set_post_process({});
+    // So does the audio generator, which is code in its flash
+    speaker.set_audio_generator(nullptr);
     program_running = false;
     return true;
 }
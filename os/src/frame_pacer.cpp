@@ -0,0 +1,133 @@
+#include "frame_pacer.h"
+#include <algorithm>
+
+namespace
+{
+// Running average over roughly the last 8 samples
+std::uint32_t update_average(std::uint32_t average, std::uint32_t sample)
+{
+    return average == 0u ? sample : average - average / 8u + sample / 8u;
+}
+}
+
+void FramePacer::set_target_frame_rate(std::uint32_t frames_per_second)
+{
+    frame_rate = frames_per_second;
+    frame_time_us = frames_per_second == 0u ? 0u : 1'000'000u / frames_per_second;
+    restart_ticks = true;
+}
+
+void FramePacer::start(std::uint64_t now_us, bool acknowledges_updates)
+{
+    next_tick_us = now_us;
+    restart_ticks = false;
+    update_in_flight = false;
+    program_acknowledges_updates = acknowledges_updates;
+    queued_ticks = 0u;
+    os_busy_us = 0u;
+    stats = Stats{};
+}
+
+bool FramePacer::poll(std::uint64_t now_us, bool program_running)
+{
+    if (frame_time_us == 0u)
+    {
+        // Uncapped: the next update goes out as soon as the last one is done
+        if (!program_running || update_in_flight)
+        {
+            return false;
+        }
+        // Nothing says when a program that doesn't acknowledge updates is free, so rather than one every time the OS
+        //   wakes it gets one every max_sleep_us
+        if (!program_acknowledges_updates)
+        {
+            if (now_us < next_tick_us)
+            {
+                return false;
+            }
+            next_tick_us = now_us + max_sleep_us;
+        }
+        send_update(now_us);
+        return true;
+    }
+    if (restart_ticks)
+    {
+        next_tick_us = now_us;
+        restart_ticks = false;
+    }
+    if (now_us < next_tick_us)
+    {
+        return false;
+    }
+    // Ticks the OS slept or worked through, e.g. while loading from the SD card, all count as due
+    const std::uint32_t due_ticks{ 1u + static_cast<std::uint32_t>((now_us - next_tick_us) / frame_time_us) };
+    next_tick_us += static_cast<std::uint64_t>(due_ticks) * frame_time_us;
+    stats.ticks += due_ticks;
+    stats.os_time_us = os_busy_us;
+    stats.average_os_time_us = update_average(stats.average_os_time_us, os_busy_us);
+    stats.max_os_time_us = std::max(stats.max_os_time_us, os_busy_us);
+    os_busy_us = 0u;
+    if (!program_running)
+    {
+        return false;
+    }
+    if (update_in_flight)
+    {
+        stats.missed_deadlines += due_ticks;
+        queue_missed(due_ticks);
+        return false;
+    }
+    if (due_ticks > 1u)
+    {
+        stats.missed_deadlines += due_ticks - 1u;
+        queue_missed(due_ticks - 1u);
+    }
+    send_update(now_us);
+    return true;
+}
+
+bool FramePacer::on_program_updated(std::uint64_t now_us)
+{
+    if (!update_in_flight)
+    {
+        return false;
+    }
+    update_in_flight = false;
+    const std::uint32_t program_time{ static_cast<std::uint32_t>(now_us - update_sent_us) };
+    ++stats.updates;
+    stats.program_time_us = program_time;
+    stats.average_program_time_us = update_average(stats.average_program_time_us, program_time);
+    stats.max_program_time_us = std::max(stats.max_program_time_us, program_time);
+    if (frame_time_us == 0u || queued_ticks != 0u)
+    {
+        queued_ticks -= std::min(queued_ticks, 1u);
+        send_update(now_us);
+        return true;
+    }
+    return false;
+}
+
+std::uint64_t FramePacer::get_wake_time(std::uint64_t now_us) const
+{
+    if (frame_time_us == 0u)
+    {
+        return !program_acknowledges_updates && next_tick_us > now_us ? next_tick_us : now_us + max_sleep_us;
+    }
+    return std::max(next_tick_us, now_us);
+}
+
+void FramePacer::send_update(std::uint64_t now_us)
+{
+    // Without acknowledgements the next update goes out on the next tick regardless
+    update_in_flight = program_acknowledges_updates;
+    update_sent_us = now_us;
+}
+
+void FramePacer::queue_missed(std::uint32_t ticks)
+{
+    // Catch-up runs as each update is acknowledged, so there's none without acknowledgements
+    const std::uint32_t limit{ program_acknowledges_updates ? max_catch_up : 0u };
+    const std::uint32_t queued{ std::min(ticks, limit - std::min(queued_ticks, limit)) };
+    queued_ticks += queued;
+    stats.dropped_ticks += ticks - queued;
+}
@@ -0,0 +1,3 @@
+#include "gfx/fonts/ascii_5px.h"
+
+const gfx::Font& gfx::get_ascii_font() { return gfx::fonts::ascii_5px; }
@@ -0,0 +1,110 @@
+#include "gfx/sprite.h"
+#include <array>
+#include "debug.h"
+#include "gfx/qoi.h"
+#include "interfaces/SD.h"
+#include "program_layout.h"
+
+namespace
+{
+// Most pixels a sprite loaded from the SD card may have, taking up half of program RAM
+constexpr std::uint64_t max_loaded_pixels{ piconsole_program_ram_size / 2u / sizeof(RGB565) };
+
+// Worked out in 64 bits: a corrupt header's width times height can wrap a 32 bit size_t into a small allocation that
+//   the pixels are then written far past
+bool fits_in_program_ram(std::uint32_t width, std::uint32_t height)
+{
+    return static_cast<std::uint64_t>(width) * height <= max_loaded_pixels;
+}
+
+std::uint32_t read_big_endian(std::span<const std::uint8_t> bytes)
+{
+    std::uint32_t value{ 0u };
+    for (std::uint8_t byte : bytes)
+    {
+        value = value << 8 | byte;
+    }
+    return value;
+}
+}
+
+bool gfx::Sprite::load(const char* path)
+{
+    SDCard::FileReader reader{ path };
+    // Magic, transparency mode ('O'paque or 'T'ransparent), color key, height and width
+    std::array<std::uint8_t, file_magic.size() + 1u + 2u + 4u + 4u> header;
+    if (!reader.read_bytes(std::span<std::uint8_t>{ header }))
+    {
+        print("Sprite failed to read header: %s\n", path);
+        return false;
+    }
+    if (std::string_view{ reinterpret_cast<const char*>(header.data()), file_magic.size() } != file_magic)
+    {
+        print("Sprite failed to load (bad header): %s\n", path);
+        return false;
+    }
+    const std::span<const std::uint8_t> fields{ std::span{ header }.subspan(file_magic.size()) };
+    const char transparency{ static_cast<char>(fields[0]) };
+    if (transparency != 'O' && transparency != 'T')
+    {
+        print("Sprite failed to load (bad transparency byte): %s\n", path);
+        return false;
+    }
+    const std::uint32_t new_height{ read_big_endian(fields.subspan(3, 4)) };
+    const std::uint32_t new_width{ read_big_endian(fields.subspan(7, 4)) };
+    if (new_width > UINT16_MAX || new_height > UINT16_MAX || !fits_in_program_ram(new_width, new_height))
+    {
+        print("Sprite failed to load (%lu x %lu is too big): %s\n", new_width, new_height, path);
+        return false;
+    }
+    std::vector<std::uint8_t> pixels(new_width * new_height * sizeof(RGB565));
+    if (!reader.read_bytes(std::span<std::uint8_t>{ pixels }))
+    {
+        print("Sprite failed to read pixels: %s\n", path);
+        return false;
+    }
+    // Pixels are stored in the order they're sent to the panel, which is the framebuffer's layout too
+    storage = std::move(pixels);
+    data = nullptr;
+    width = static_cast<std::uint16_t>(new_width);
+    height = static_cast<std::uint16_t>(new_height);
+    format = SpriteFormat::RGB565;
+    has_color_key = transparency == 'T';
+    color_key = static_cast<std::uint16_t>(read_big_endian(fields.subspan(1, 2)));
+    palette = {};
+    return true;
+}
+
+bool gfx::Sprite::load_qoi(const char* path, std::optional<RGB565> new_color_key /* = std::nullopt */)
+{
+    SDCard::FileReader reader{ path };
+    qoi::StreamDecoder decoder{ reader };
+    if (!decoder.read_header())
+    {
+        print("Sprite failed to read QOI header: %s\n", path);
+        return false;
+    }
+    const qoi::Header& header{ decoder.get_header() };
+    if (header.width > UINT16_MAX || header.height > UINT16_MAX || !fits_in_program_ram(header.width, header.height))
+    {
+        print("Sprite failed to load (%lu x %lu is too big): %s\n", header.width, header.height, path);
+        return false;
+    }
+    decoder.set_transparent_color(new_color_key);
+    // Decoded straight into the sprite's own pixels
+    std::vector<std::uint8_t> pixels(header.width * header.height * sizeof(RGB565));
+    if (!decoder.decode({ reinterpret_cast<RGB565*>(pixels.data()), header.width * header.height }))
+    {
+        print("Sprite failed to decode QOI pixels: %s\n", path);
+        return false;
+    }
+    storage = std::move(pixels);
+    data = nullptr;
+    width = static_cast<std::uint16_t>(header.width);
+    height = static_cast<std::uint16_t>(header.height);
+    format = SpriteFormat::RGB565;
+    has_color_key = new_color_key.has_value();
+    color_key = new_color_key.value_or(RGB565{}).data;
+    palette = {};
+    return true;
+}
@@ -1,4 +0,0 @@
-#include "gfx/typefaces/ascii_5px.h"
-
-template <>
-const Typeface<5>& get_ascii_typeface<5>() { return typeface_ascii_5px; }
@@ -1,4 +1,6 @@
 #include "interfaces/LCD.h"
+#include "OS.h"
+#include "hardware/irq.h"
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "pico/binary_info.h"
@@ -43,6 +45,19 @@ bool SPILCD::init(bool final_step /* = true */)
     gpio_init(LCD_DC);
     gpio_set_dir(LCD_DC, GPIO_OUT);
     reset();
+
+    present_dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config present_config{ dma_channel_get_default_config(present_dma_channel) };
+    channel_config_set_transfer_data_size(&present_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&present_config, true);
+    channel_config_set_write_increment(&present_config, false);
+    channel_config_set_dreq(&present_config, spi_get_dreq(get_spi(), true));
+    dma_channel_configure(present_dma_channel, &present_config, &spi_get_hw(get_spi())->dr, nullptr, 0, false);
+    present_core = get_core_num();
+    // DMA_IRQ_0 is already shared by the SD card and speaker
+    irq_add_shared_handler(DMA_IRQ_1, present_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(present_dma_channel, true);
+    irq_set_enabled(DMA_IRQ_1, true);
     if (final_step)
     {
         initialized = true;
@@ -56,6 +71,11 @@ bool SPILCD::uninit()
     {
         return false;
     }
+    wait_present();
+    dma_channel_set_irq1_enabled(present_dma_channel, false);
+    irq_remove_handler(DMA_IRQ_1, present_dma_irq_handler);
+    dma_channel_unclaim(present_dma_channel);
+    present_dma_channel = -1;
     spi_deinit(get_spi());
     gpio_deinit(LCD_BACKLIGHT);
     gpio_deinit(LCD_CS);
@@ -91,6 +111,18 @@ void __debug_noinline SPILCD::write_data(std::initializer_list<std::uint8_t> byt
     write_data(std::span{bytes.begin(), bytes.end()});
 }
 
+void __debug_noinline SPILCD::write_data_strided(const std::uint8_t* data, std::size_t row_size, std::size_t stride, std::size_t row_count)
+{
+    gpio_put(LCD_DC, 1);
+    gpio_put(LCD_CS, LCD_CS_ACTIVE_POLARITY);
+    for (std::size_t row{ 0 }; row < row_count; ++row)
+    {
+        spi_write_blocking(get_spi(), data, row_size);
+        data += stride;
+    }
+    gpio_put(LCD_CS, !LCD_CS_ACTIVE_POLARITY);
+}
+
 void __debug_noinline SPILCD::write_command(std::uint8_t byte)
 {
     gpio_put(LCD_DC, 0);
@@ -112,6 +144,107 @@ void __debug_noinline SPILCD::write_command(std::initializer_list<std::uint8_t>
     write_command(std::span{bytes.begin(), bytes.end()});
 }
 
+void SPILCD::wait_present()
+{
+    while (presenting)
+    {
+        if (get_core_num() == present_core)
+        {
+            update_present();
+        }
+        else
+        {
+            tight_loop_contents();
+        }
+    }
+}
+
+void SPILCD::update_present()
+{
+    if (!presenting)
+    {
+        return;
+    }
+    if (!present_window_done)
+    {
+        if (present_chained)
+        {
+            prepare_next_present_row();
+        }
+        return;
+    }
+    // The IRQ has nothing left to send, so it won't run again until a transfer is started here
+    present_window_done = false;
+    finish_data_dma();
+    if (present_chained && present_next())
+    {
+        return;
+    }
+    presenting = false;
+    if (present_callback != nullptr)
+    {
+        std::invoke(present_callback, *this);
+    }
+}
+
+void __debug_noinline SPILCD::start_data_dma(std::span<const std::uint8_t> bytes)
+{
+    gpio_put(LCD_DC, 1);
+    gpio_put(LCD_CS, LCD_CS_ACTIVE_POLARITY);
+    dma_channel_transfer_from_buffer_now(present_dma_channel, bytes.data(), bytes.size());
+}
+
+void SPILCD::continue_data_dma(std::span<const std::uint8_t> bytes)
+{
+    dma_channel_transfer_from_buffer_now(present_dma_channel, bytes.data(), bytes.size());
+}
+
+void __debug_noinline SPILCD::finish_data_dma()
+{
+    // The DMA finishes as soon as the last byte is in the TX FIFO, so wait for it to actually leave
+    while (spi_is_busy(get_spi()))
+    {
+        tight_loop_contents();
+    }
+    // Nothing reads the RX FIFO during the transfer; drain it and clear the overrun like spi_write_blocking does
+    while (spi_is_readable(get_spi()))
+    {
+        (void)spi_get_hw(get_spi())->dr;
+    }
+    spi_get_hw(get_spi())->icr = SPI_SSPICR_RORIC_BITS;
+    gpio_put(LCD_CS, !LCD_CS_ACTIVE_POLARITY);
+}
+
+void SPILCD::write_data_async(std::span<const std::uint8_t> bytes, present_callback_t callback /* = nullptr */)
+{
+    wait_present();
+    present_chained = false;
+    present_callback = callback;
+    presenting = true;
+    start_data_dma(bytes);
+}
+
+void SPILCD::on_present_dma_complete()
+{
+    if (present_chained && present_next_row())
+    {
+        return;
+    }
+    present_window_done = true;
+    // Wakes core0 from its wait for the next tick so it can carry on with update_present()
+    __sev();
+}
+
+void __isr __time_critical_func(SPILCD::present_dma_irq_handler)()
+{
+    SPILCD& lcd{ OS::get().get_lcd() };
+    if (lcd.present_dma_channel != -1 && dma_channel_get_irq1_status(lcd.present_dma_channel))
+    {
+        dma_channel_acknowledge_irq1(lcd.present_dma_channel);
+        lcd.on_present_dma_complete();
+    }
+}
+
 void SPILCD::reset()
 {
     gpio_put(LCD_CS, !LCD_CS_ACTIVE_POLARITY);
@@ -141,6 +274,18 @@ bool PicoLCD_1_8::init(bool final_step /* = true */)
     // Horizontal mode
     write_data(0x70);
     //write_data(0x00); // Vertical mode
+
+    // Vertical scroll definition; in horizontal mode the panel scrolls along x. Only the visible columns scroll, the
+    //   RAM lines either side of them stay fixed.
+    write_command(0x33);
+    write_data({
+        0x00, static_cast<std::uint8_t>(column_offset),
+        0x00, static_cast<std::uint8_t>(width),
+        0x00, static_cast<std::uint8_t>(ram_width - width - column_offset)
+    });
+    scroll_offset = 0;
+    panel_scroll_offset = width; // Never a valid offset, so the start address is always sent
+    send_scroll_offset(0);
     
     // ???
     write_command(0x3A);
@@ -209,6 +354,7 @@ bool PicoLCD_1_8::init(bool final_step /* = true */)
     write_command(0x29);
     
     dma_channel = dma_claim_unused_channel(true);
+    fill_control_dma_channel = dma_claim_unused_channel(true);
     fill(color::black<ColorFormat>());
     show();
     if (final_step)
@@ -226,6 +372,8 @@ bool PicoLCD_1_8::uninit()
     }
     fill(color::black<ColorFormat>());
     show();
+    dma_channel_unclaim(fill_control_dma_channel);
+    fill_control_dma_channel = -1;
     dma_channel_unclaim(dma_channel);
     return SPILCD::uninit();
 }
@@ -235,24 +383,338 @@ PicoLCD_1_8::~PicoLCD_1_8()
     uninit();
 }
 
-void PicoLCD_1_8::show()
+void PicoLCD_1_8::begin_write_window(const gfx::Rect& window)
 {
-    // ???
+    const std::uint32_t start_x{ window.x + column_offset };
+    const std::uint32_t end_x{ window.end_x() - 1u + column_offset };
+    const std::uint32_t start_y{ window.y + row_offset };
+    const std::uint32_t end_y{ window.end_y() - 1u + row_offset };
+    // Column address set
     write_command(0x2A);
-    write_data({0x00, 0x01, 0x00, 0xA0});
-    
-    // ???
+    write_data({
+        static_cast<std::uint8_t>(start_x >> 8), static_cast<std::uint8_t>(start_x),
+        static_cast<std::uint8_t>(end_x >> 8), static_cast<std::uint8_t>(end_x)
+    });
+    // Row address set
     write_command(0x2B);
-    write_data({ 0x00, 0x02, 0x00, 0x81 });
-    
-    // ???
-    // - Maybe tell the LCD it's about to get pixel data?
+    write_data({
+        static_cast<std::uint8_t>(start_y >> 8), static_cast<std::uint8_t>(start_y),
+        static_cast<std::uint8_t>(end_y >> 8), static_cast<std::uint8_t>(end_y)
+    });
+    // Memory write; following data is streamed into the window
     write_command(0x2C);
-    
-    dma_channel_wait_for_finish_blocking(dma_channel);
-    buffer_type &buf{ get_buffer() };
-    write_data(std::span<std::uint8_t>{
-        reinterpret_cast<std::uint8_t*>(buf.data()),
-        get_buffer().size() * get_bytes_per_pixel()
-        });
+}
+
+void PicoLCD_1_8::send_scroll_offset(std::size_t offset)
+{
+    if (offset == panel_scroll_offset)
+    {
+        return;
+    }
+    panel_scroll_offset = offset;
+    const std::uint32_t start{ column_offset + offset };
+    // Vertical scroll start address
+    write_command(0x37);
+    write_data({ static_cast<std::uint8_t>(start >> 8), static_cast<std::uint8_t>(start) });
+}
+
+void PicoLCD_1_8::show()
+{
+    if (is_double_buffered())
+    {
+        // Whatever was just drawn is in the back buffer
+        flip();
+        wait_present();
+        return;
+    }
+    wait_present();
+    if (dirty_regions.empty())
+    {
+        send_scroll_offset(scroll_offset);
+        return;
+    }
+    wait_for_dma();
+    const buffer_type &buf{ get_display_buffer() };
+    if (!post_process.is_identity())
+    {
+        // Each row is adjusted here, before it's sent, so none of it runs in the DMA IRQ
+        for (const gfx::Rect& region : dirty_regions.get_regions())
+        {
+            begin_write_window(region);
+            for (std::size_t y{ region.y }; y < region.y + region.height; ++y)
+            {
+                const std::span<ColorFormat> out{ present_rows[0].data(), region.width };
+                post_process.apply(out, { buf.data() + y * width + region.x, region.width });
+                write_data(std::span<const std::uint8_t>{ reinterpret_cast<const std::uint8_t*>(out.data()), out.size_bytes() });
+            }
+        }
+        dirty_regions.clear();
+        send_scroll_offset(scroll_offset);
+        return;
+    }
+    const std::uint8_t* const bytes{ reinterpret_cast<const std::uint8_t*>(buf.data()) };
+    constexpr std::size_t row_stride{ width * sizeof(ColorFormat) };
+    // Once most of the screen is dirty, a single window is cheaper than several smaller ones
+    if (dirty_regions.get_total_area() * 4u >= width * height * 3u)
+    {
+        begin_write_window(gfx::Rect{ .width = width, .height = height });
+        write_data(std::span<const std::uint8_t>{ bytes, buf.size() * sizeof(ColorFormat) });
+        dirty_regions.clear();
+        send_scroll_offset(scroll_offset);
+        return;
+    }
+    for (const gfx::Rect& region : dirty_regions.get_regions())
+    {
+        begin_write_window(region);
+        const std::uint8_t* const region_start{ bytes + region.y * row_stride + region.x * sizeof(ColorFormat) };
+        if (region.width == width)
+        {
+            // Full width rows are contiguous in the buffer
+            write_data(std::span<const std::uint8_t>{ region_start, region.height * row_stride });
+        }
+        else
+        {
+            write_data_strided(region_start, region.width * sizeof(ColorFormat), row_stride, region.height);
+        }
+    }
+    dirty_regions.clear();
+    send_scroll_offset(scroll_offset);
+}
+
+void PicoLCD_1_8::present(present_callback_t callback /* = nullptr */)
+{
+    wait_present();
+    if (dirty_regions.empty())
+    {
+        send_scroll_offset(scroll_offset);
+        if (callback != nullptr)
+        {
+            std::invoke(callback, *this);
+        }
+        return;
+    }
+    wait_for_dma();
+    present_regions.clear();
+    if (!post_process.is_identity())
+    {
+        // Every row is adjusted into a bounce row, so regions are sent as they are
+        for (const gfx::Rect& region : dirty_regions.get_regions())
+        {
+            present_regions.add(region);
+        }
+        dirty_regions.clear();
+        present_callback = callback;
+        start_bounced_present();
+        return;
+    }
+    for (const gfx::Rect& region : dirty_regions.get_regions())
+    {
+        // Narrow regions, like the columns exposed by a hardware scroll, are sent a row at a time. Wider ones are
+        //   widened to full rows so each is contiguous in the buffer and needs only one DMA transfer.
+        if (region.width * 2u < width)
+        {
+            present_regions.add(region);
+        }
+        else
+        {
+            present_regions.add(gfx::Rect{ .x = 0, .y = region.y, .width = width, .height = region.height });
+        }
+    }
+    dirty_regions.clear();
+    present_region_index = 0;
+    present_row = 0;
+    present_scroll_offset = scroll_offset;
+    present_chained = true;
+    present_callback = callback;
+    presenting = true;
+    present_next();
+}
+
+void PicoLCD_1_8::present_indexed(const gfx::IndexedFrame& frame, present_callback_t callback /* = nullptr */)
+{
+    wait_present();
+    if (frame.pixels == nullptr || frame.regions.empty())
+    {
+        send_scroll_offset(scroll_offset);
+        if (callback != nullptr)
+        {
+            std::invoke(callback, *this);
+        }
+        return;
+    }
+    // Every row is sent on its own, so unlike present() there's nothing to gain from widening regions
+    present_regions.clear();
+    for (const gfx::Rect& region : frame.regions)
+    {
+        present_regions.add(region.clipped(width, height));
+    }
+    std::copy_n(frame.palette.begin(), std::min(frame.palette.size(), present_palette.size()), present_palette.begin());
+    present_frame = frame;
+    present_frame.regions = {};
+    present_frame.palette = present_palette;
+    present_callback = callback;
+    start_bounced_present();
+}
+
+void PicoLCD_1_8::set_post_process(const gfx::PostProcess& new_post_process)
+{
+    wait_present();
+    post_process = new_post_process;
+    mark_all_dirty();
+}
+
+void PicoLCD_1_8::start_bounced_present()
+{
+    present_region_index = 0;
+    present_row = 0;
+    present_row_buffer = 0;
+    present_scroll_offset = scroll_offset;
+    present_bounced = true;
+    present_row_ready = false;
+    present_chained = true;
+    presenting = true;
+    present_next();
+}
+
+// Moves on to the next row of a region sent a row at a time
+static void advance_present_row(const gfx::Rect& region, std::size_t& row, std::size_t& region_index)
+{
+    if (++row == region.height)
+    {
+        row = 0;
+        ++region_index;
+    }
+}
+
+void PicoLCD_1_8::prepare_present_row()
+{
+    const std::span<const gfx::Rect> regions{ present_regions.get_regions() };
+    if (present_region_index >= regions.size())
+    {
+        return;
+    }
+    const gfx::Rect& region{ regions[present_region_index] };
+    const std::span<ColorFormat> out{ present_rows[present_row_buffer].data(), region.width };
+    if (present_frame.pixels == nullptr)
+    {
+        const ColorFormat* const row{ get_display_buffer().data() + (region.y + present_row) * width + region.x };
+        post_process.apply(out, { row, region.width });
+        return;
+    }
+    const std::uint8_t* const row{ present_frame.pixels + (region.y + present_row) * present_frame.stride };
+    std::uint16_t* const pixels{ reinterpret_cast<std::uint16_t*>(out.data()) };
+    if (present_frame.format == gfx::SpriteFormat::Indexed4)
+    {
+        gfx::detail::expand_indexed_pixels<gfx::SpriteFormat::Indexed4, false>(pixels, row, region.x, region.width, present_palette.data(), std::nullopt);
+    }
+    else
+    {
+        gfx::detail::expand_indexed_pixels<gfx::SpriteFormat::Indexed8, false>(pixels, row, region.x, region.width, present_palette.data(), std::nullopt);
+    }
+    if (!post_process.is_identity())
+    {
+        post_process.apply(out, out);
+    }
+}
+
+void PicoLCD_1_8::prepare_next_present_row()
+{
+    if (!present_bounced || present_row_ready)
+    {
+        return;
+    }
+    // The DMA IRQ leaves the row and its position alone until present_row_ready is set
+    prepare_present_row();
+    __compiler_memory_barrier();
+    present_row_ready = true;
+}
+
+bool PicoLCD_1_8::present_next_bounced()
+{
+    const std::span<const gfx::Rect> regions{ present_regions.get_regions() };
+    if (present_region_index >= regions.size())
+    {
+        present_frame = gfx::IndexedFrame{};
+        present_bounced = false;
+        send_scroll_offset(present_scroll_offset);
+        return false;
+    }
+    prepare_next_present_row();
+    const gfx::Rect& region{ regions[present_region_index] };
+    // present_row is past 0 when the last window ended early on a row that wasn't ready
+    begin_write_window(gfx::Rect{ .x = region.x, .y = region.y + present_row, .width = region.width,
+        .height = region.height - present_row });
+    const std::span<const std::uint8_t> row{ reinterpret_cast<const std::uint8_t*>(present_rows[present_row_buffer].data()),
+        region.width * sizeof(ColorFormat) };
+    present_row_buffer ^= 1u;
+    advance_present_row(region, present_row, present_region_index);
+    present_row_ready = false;
+    start_data_dma(row);
+    prepare_next_present_row();
+    return true;
+}
+
+bool PicoLCD_1_8::present_next_bounced_row()
+{
+    // A new region needs a new write window, and a row that isn't prepared yet can't be sent; update_present() picks
+    //   up both from thread context
+    if (present_row == 0 || !present_row_ready)
+    {
+        return false;
+    }
+    const gfx::Rect& region{ present_regions.get_regions()[present_region_index] };
+    continue_data_dma({ reinterpret_cast<const std::uint8_t*>(present_rows[present_row_buffer].data()), region.width * sizeof(ColorFormat) });
+    present_row_buffer ^= 1u;
+    advance_present_row(region, present_row, present_region_index);
+    present_row_ready = false;
+    // Wakes core0 to prepare the row after this one
+    __sev();
+    return true;
+}
+
+bool PicoLCD_1_8::present_next()
+{
+    if (present_bounced)
+    {
+        return present_next_bounced();
+    }
+    const std::span<const gfx::Rect> regions{ present_regions.get_regions() };
+    if (present_region_index >= regions.size())
+    {
+        // Scrolling only once the exposed columns are in panel RAM means they never show stale pixels
+        send_scroll_offset(present_scroll_offset);
+        return false;
+    }
+    const gfx::Rect& region{ regions[present_region_index] };
+    const std::uint8_t* const bytes{ reinterpret_cast<const std::uint8_t*>(get_display_buffer().data()) };
+    constexpr std::size_t row_stride{ width * sizeof(ColorFormat) };
+    begin_write_window(region);
+    if (region.width == width)
+    {
+        ++present_region_index;
+        start_data_dma({ bytes + region.y * row_stride, region.height * row_stride });
+        return true;
+    }
+    start_data_dma({ bytes + region.y * row_stride + region.x * sizeof(ColorFormat), region.width * sizeof(ColorFormat) });
+    advance_present_row(region, present_row, present_region_index);
+    return true;
+}
+
+bool PicoLCD_1_8::present_next_row()
+{
+    if (present_bounced)
+    {
+        return present_next_bounced_row();
+    }
+    if (present_row == 0)
+    {
+        return false;
+    }
+    const gfx::Rect& region{ present_regions.get_regions()[present_region_index] };
+    const std::uint8_t* const bytes{ reinterpret_cast<const std::uint8_t*>(get_display_buffer().data()) };
+    constexpr std::size_t row_stride{ width * sizeof(ColorFormat) };
+    // The memory write carries on from row to row until the next command
+    continue_data_dma({ bytes + (region.y + present_row) * row_stride + region.x * sizeof(ColorFormat), region.width * sizeof(ColorFormat) });
+    advance_present_row(region, present_row, present_region_index);
+    return true;
 }
@@ -1,5 +1,6 @@
 #include "interfaces/Speaker.h"
 #include "OS.h"
+#include "hardware/clocks.h"
 #include "hardware/dma.h"
 #include "i2s.pio.h"
 
@@ -34,6 +35,7 @@ void I2SSpeaker::init()
     const std::uint32_t offset{ pio_add_program(pio0, &i2s_program) };
 
     i2s_program_init(pio0, pio_state_machine, offset, I2S_DATA, I2S_CLK);
+    apply_sample_rate();
 
     dma_channel = dma_claim_unused_channel(dma_channel);
     dma_channel_config dma_config{ dma_channel_get_default_config(dma_channel) };
@@ -81,6 +83,26 @@ void I2SSpeaker::update()
     }
 }
 
+void I2SSpeaker::set_sample_rate(std::uint32_t rate)
+{
+    frequency = rate;
+    if (active)
+    {
+        apply_sample_rate();
+    }
+}
+
+void I2SSpeaker::apply_sample_rate()
+{
+    if (frequency == 0u)
+    {
+        return;
+    }
+    // The program takes two cycles per bit, and a frame is two 16 bit samples
+    constexpr static float cycles_per_frame{ 2.0f * 32.0f };
+    pio_sm_set_clkdiv(pio0, pio_state_machine, static_cast<float>(clock_get_hz(clk_sys)) / (static_cast<float>(frequency) * cycles_per_frame));
+}
+
 void I2SSpeaker::start_dma_transfer()
 {
     if (dma_active)
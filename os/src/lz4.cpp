@@ -0,0 +1,143 @@
+#include "lz4.h"
+#include <algorithm>
+#include <cstring>
+#include "debug.h"
+
+namespace lz4
+{
+void StreamDecoder::start(std::uint32_t packed_size)
+{
+    remaining_packed_bytes = packed_size;
+    chunk_position = 0;
+    chunk_end = 0;
+    position = 0u;
+    match_next = false;
+    literals_left = 0;
+    match_left = 0;
+}
+
+bool StreamDecoder::decode(std::span<std::uint8_t> destination)
+{
+    std::uint8_t* out{ destination.data() };
+    std::uint8_t* const end{ out + destination.size() };
+    const std::uint32_t history_mask{ static_cast<std::uint32_t>(history.size()) - 1u };
+    while (out != end)
+    {
+        if (literals_left != 0u)
+        {
+            if (chunk_position == chunk_end && !refill(1u))
+            {
+                return false;
+            }
+            const std::size_t count{ std::min({ literals_left, static_cast<std::size_t>(end - out), chunk_end - chunk_position }) };
+            emit(chunk.data() + chunk_position, count, out);
+            chunk_position += count;
+            literals_left -= count;
+            continue;
+        }
+        if (match_left != 0u)
+        {
+            // Byte by byte, as a match may overlap what it's copying
+            const std::size_t count{ std::min(match_left, static_cast<std::size_t>(end - out)) };
+            for (std::size_t i{ 0 }; i < count; ++i)
+            {
+                const std::uint8_t byte{ history[(position - match_offset) & history_mask] };
+                history[position & history_mask] = byte;
+                *out++ = byte;
+                ++position;
+            }
+            match_left -= count;
+            continue;
+        }
+        if (match_next)
+        {
+            if (!refill(2u))
+            {
+                return false;
+            }
+            match_offset = static_cast<std::uint32_t>(chunk[chunk_position]) | static_cast<std::uint32_t>(chunk[chunk_position + 1u]) << 8;
+            chunk_position += 2u;
+            match_left = token & 0x0Fu;
+            if (match_left == run_on_length && !read_run_on(match_left))
+            {
+                return false;
+            }
+            match_left += min_match_length;
+            if (match_offset == 0u || match_offset > history.size() || match_offset > position)
+            {
+                print("lz4::StreamDecoder match reaches back %lu bytes, past what's kept\n", match_offset);
+                return false;
+            }
+            match_next = false;
+            continue;
+        }
+        if (!refill(1u))
+        {
+            return false;
+        }
+        token = chunk[chunk_position++];
+        literals_left = token >> 4;
+        if (literals_left == run_on_length && !read_run_on(literals_left))
+        {
+            return false;
+        }
+        match_next = true;
+    }
+    return true;
+}
+
+void StreamDecoder::emit(const std::uint8_t* bytes, std::size_t count, std::uint8_t*& out)
+{
+    std::memcpy(out, bytes, count);
+    out += count;
+    position += static_cast<std::uint32_t>(count);
+    // Only the end of a run longer than the history stays in it
+    const std::size_t kept{ std::min(count, history.size()) };
+    const std::uint8_t* const kept_bytes{ bytes + (count - kept) };
+    const std::size_t start{ (position - kept) & (history.size() - 1u) };
+    const std::size_t first{ std::min(kept, history.size() - start) };
+    std::memcpy(history.data() + start, kept_bytes, first);
+    std::memcpy(history.data(), kept_bytes + first, kept - first);
+}
+
+bool StreamDecoder::refill(std::size_t count)
+{
+    if (chunk_end - chunk_position >= count)
+    {
+        return true;
+    }
+    const std::size_t kept{ chunk_end - chunk_position };
+    std::memmove(chunk.data(), chunk.data() + chunk_position, kept);
+    chunk_position = 0;
+    chunk_end = kept;
+    const std::size_t read_count{ std::min<std::size_t>(chunk.size() - kept, remaining_packed_bytes) };
+    if (kept + read_count < count)
+    {
+        print("lz4::StreamDecoder ran out of data\n");
+        return false;
+    }
+    if (!reader.read_bytes(chunk.subspan(kept, read_count)))
+    {
+        print("lz4::StreamDecoder failed to read %u bytes\n", static_cast<unsigned>(read_count));
+        return false;
+    }
+    remaining_packed_bytes -= static_cast<std::uint32_t>(read_count);
+    chunk_end += read_count;
+    return true;
+}
+
+bool StreamDecoder::read_run_on(std::size_t& length)
+{
+    std::uint8_t byte;
+    do
+    {
+        if (!refill(1u))
+        {
+            return false;
+        }
+        byte = chunk[chunk_position++];
+        length += byte;
+    } while (byte == 0xFFu);
+    return true;
+}
+}
@@ -10,7 +10,7 @@
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
 #include "pico/binary_info.h"
-#include "gfx/typefaces/ascii_5px.h"
+#include "gfx/fonts/ascii_5px.h"
 
 #include <functional>
 
@@ -0,0 +1,21 @@
+#include "PICOnsole.h"
+#include "pico/multicore.h"
+
+void run_program(program_init_fn& init, program_update_fn& update)
+{
+    multicore_fifo_push_blocking(FIFOCodes::program_launch_acknowledges_updates);
+    OS& os{ OS::get() };
+    if (!os.is_initialized())
+    {
+        os.init();
+    }
+    init(os);
+    while (true)
+    {
+        if (multicore_fifo_pop_blocking() == FIFOCodes::os_updated)
+        {
+            update(os);
+            multicore_fifo_push_blocking(FIFOCodes::program_updated);
+        }
+    }
+}
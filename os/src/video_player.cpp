@@ -0,0 +1,254 @@
+#include "video_player.h"
+#include <algorithm>
+#include <cstring>
+#include "debug.h"
+#include "OS.h"
+#include "pico/time.h"
+
+VideoPlayer* VideoPlayer::audio_player{ nullptr };
+
+bool VideoPlayer::open(const char* path)
+{
+    close();
+    LCD_MODEL& lcd{ OS::get().get_lcd() };
+    if (lcd.is_double_buffered())
+    {
+        print("VideoPlayer can't play %s while the LCD is double buffered\n", path);
+        return false;
+    }
+    reader.emplace(path);
+    if (!reader->is_valid() || !reader->read(header))
+    {
+        print("VideoPlayer failed to read header: %s\n", path);
+        reader.reset();
+        return false;
+    }
+    if (header.magic != file_magic || header.version != file_version)
+    {
+        print("VideoPlayer failed to open (bad header): %s\n", path);
+        reader.reset();
+        return false;
+    }
+    if (header.width == 0u || header.height == 0u || header.width > lcd.get_width() || header.height > lcd.get_height()
+        || header.frame_rate == 0u || header.audio_channels > 2u)
+    {
+        print("VideoPlayer failed to open (%ux%u at %u fps, %u channels won't play): %s\n", header.width, header.height,
+            header.frame_rate, header.audio_channels, path);
+        reader.reset();
+        return false;
+    }
+    if (header.first_chunk_size > header.max_chunk_size)
+    {
+        print("VideoPlayer failed to open (first chunk is bigger than the largest): %s\n", path);
+        reader.reset();
+        return false;
+    }
+    chunk_buffer.resize(header.max_chunk_size);
+    screen_x = (lcd.get_width() - header.width) / 2u;
+    screen_y = (lcd.get_height() - header.height) / 2u;
+    reader->seek_absolute(header.data_offset);
+    stats = Stats{};
+    next_frame = 0u;
+    started = false;
+    audio_written.store(0u, std::memory_order_relaxed);
+    audio_read.store(0u, std::memory_order_relaxed);
+    if (header.frame_count == 0u || !read_chunk(header.first_chunk_size))
+    {
+        close();
+        return false;
+    }
+    playing = true;
+    return true;
+}
+
+void VideoPlayer::close()
+{
+    if (audio_player == this)
+    {
+        OS::get().get_speaker().set_audio_generator(nullptr);
+        audio_player = nullptr;
+    }
+    playing = false;
+    chunk_size = 0u;
+    reader.reset();
+    chunk_buffer = {};
+}
+
+bool VideoPlayer::update()
+{
+    if (!playing)
+    {
+        return false;
+    }
+    LCD_MODEL& lcd{ OS::get().get_lcd() };
+    const std::uint64_t now{ time_us_64() };
+    if (!started)
+    {
+        // The sound starts with the clock, so both count from the same moment
+        start_time_us = now;
+        started = true;
+        if (header.audio_channels != 0u)
+        {
+            audio_player = this;
+            Speaker& speaker{ OS::get().get_speaker() };
+            speaker.set_sample_rate(header.sample_rate);
+            speaker.set_audio_generator(generate_audio);
+        }
+    }
+    const std::uint64_t due_frame{ (now - start_time_us) * header.frame_rate / 1'000'000u };
+    if (next_frame > due_frame)
+    {
+        return true;
+    }
+    // Every due frame is decoded, since delta frames build on the last, but only the newest is worth sending
+    bool decoded{ false };
+    while (next_frame <= due_frame && chunk_size != 0u)
+    {
+        if (decoded)
+        {
+            ++stats.frames_dropped;
+        }
+        // The panel may still be reading the rows this frame overwrites
+        lcd.wait_present();
+        if (!decode_chunk())
+        {
+            close();
+            return false;
+        }
+        decoded = true;
+        const std::uint32_t next_chunk_size{ reinterpret_cast<const ChunkHeader*>(chunk_buffer.data())->next_chunk_size };
+        ++next_frame;
+        if (next_chunk_size == 0u || next_frame >= header.frame_count)
+        {
+            chunk_size = 0u;
+            break;
+        }
+        if (next_frame <= due_frame)
+        {
+            // Already behind, so there's no present to hide the read behind
+            if (!read_chunk(next_chunk_size))
+            {
+                close();
+                return false;
+            }
+            continue;
+        }
+        // Send the frame, then read the next chunk from the SD card while the panel's DMA runs
+        lcd.present();
+        ++stats.frames_presented;
+        if (!read_chunk(next_chunk_size))
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+    if (decoded)
+    {
+        lcd.present();
+        ++stats.frames_presented;
+    }
+    if (chunk_size == 0u)
+    {
+        // Let the last of the sound play out before handing the speaker back
+        if (audio_player == this && OS::get().get_speaker().is_active()
+            && audio_written.load(std::memory_order_relaxed) != audio_read.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool VideoPlayer::read_chunk(std::uint32_t size)
+{
+    if (size < sizeof(ChunkHeader) || size > chunk_buffer.size()
+        || reader->get_current_offset() + size > reader->get_size())
+    {
+        print("VideoPlayer chunk %lu has a bad size (%lu)\n", next_frame, size);
+        return false;
+    }
+    const std::uint64_t start{ time_us_64() };
+    if (!reader->read_bytes(std::span<std::uint8_t>{ chunk_buffer.data(), size }))
+    {
+        print("VideoPlayer failed to read chunk %lu\n", next_frame);
+        return false;
+    }
+    chunk_size = size;
+    stats.read_time_us = static_cast<std::uint32_t>(time_us_64() - start);
+    stats.max_read_time_us = std::max(stats.max_read_time_us, stats.read_time_us);
+    stats.total_read_time_us += stats.read_time_us;
+    return true;
+}
+
+bool VideoPlayer::decode_chunk()
+{
+    const std::uint64_t start{ time_us_64() };
+    const ChunkHeader& chunk{ *reinterpret_cast<const ChunkHeader*>(chunk_buffer.data()) };
+    const std::size_t audio_size{ static_cast<std::size_t>(chunk.audio_frames) * header.audio_channels * sizeof(AudioSample) };
+    if (sizeof(ChunkHeader) + audio_size + chunk.video_size > chunk_size)
+    {
+        print("VideoPlayer chunk %lu overflows its size\n", next_frame);
+        return false;
+    }
+    const std::span<const std::uint8_t> payload{ chunk_buffer.data() + sizeof(ChunkHeader), chunk_size - sizeof(ChunkHeader) };
+    if (audio_size != 0u)
+    {
+        queue_audio(payload.first(audio_size), chunk.audio_frames);
+    }
+    if (!pvid::decode_frame(OS::get().get_lcd(), screen_x, screen_y, header.width, header.height,
+        payload.subspan(audio_size, chunk.video_size)))
+    {
+        print("VideoPlayer failed to decode frame %lu\n", next_frame);
+        return false;
+    }
+    ++stats.frames_decoded;
+    stats.decode_time_us = static_cast<std::uint32_t>(time_us_64() - start);
+    stats.max_decode_time_us = std::max(stats.max_decode_time_us, stats.decode_time_us);
+    stats.total_decode_time_us += stats.decode_time_us;
+    return true;
+}
+
+void VideoPlayer::queue_audio(std::span<const std::uint8_t> samples, std::uint32_t frame_count)
+{
+    const std::uint32_t written{ audio_written.load(std::memory_order_relaxed) };
+    const std::uint32_t free{ static_cast<std::uint32_t>(audio_ring.size()) - (written - audio_read.load(std::memory_order_acquire)) };
+    const std::uint32_t queued{ std::min(frame_count, free) };
+    stats.audio_frames_dropped += frame_count - queued;
+    for (std::uint32_t i{ 0 }; i < queued; ++i)
+    {
+        AudioFrame& frame{ audio_ring[(written + i) % audio_ring.size()] };
+        if (header.audio_channels == 1u)
+        {
+            std::memcpy(&frame.left, samples.data() + i * sizeof(AudioSample), sizeof(AudioSample));
+            frame.right = frame.left;
+        }
+        else
+        {
+            std::memcpy(&frame, samples.data() + i * sizeof(AudioFrame), sizeof(AudioFrame));
+        }
+    }
+    audio_written.store(written + queued, std::memory_order_release);
+}
+
+void VideoPlayer::generate_audio(AudioBuffer& buffer)
+{
+    VideoPlayer* const player{ audio_player };
+    if (player == nullptr)
+    {
+        return;
+    }
+    std::uint32_t read{ player->audio_read.load(std::memory_order_relaxed) };
+    const std::uint32_t written{ player->audio_written.load(std::memory_order_acquire) };
+    if (read == written && player->playing)
+    {
+        ++player->stats.audio_underruns;
+    }
+    for (; read != written && !buffer.full(); ++read)
+    {
+        buffer.push_back(player->audio_ring[read % player->audio_ring.size()]);
+    }
+    player->audio_read.store(read, std::memory_order_release);
+}
@@ -0,0 +1,50 @@
+#include <array>
+#include <cstdio>
+#include "PICOnsole.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "shapes_benchmark.h"
+
+// Draws each of gfx::shapes' primitives onto the LCD for a second, then lists pixels per second for each; the same
+//   shapes as tests/shapes_benchmark.cpp draws on the host
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void isr_hardfault()
+{
+   multicore_fifo_push_blocking(FIFOCodes::error_crash);
+}
+
+piconsole_program_init
+{
+    LCD_MODEL &lcd{ os.get_lcd() };
+    lcd.fill(color::black<RGB565>());
+    std::array<char, 32> lines[shapes_benchmark::primitive_count];
+    std::size_t line_count{ 0 };
+    shapes_benchmark::run(lcd, color::yellow<RGB565>(), time_us_64, 1'000'000u,
+        [&](const char* name, double pixels_per_second)
+        {
+            print("%-16s %8.2f Mpixels/s\n", name, pixels_per_second / 1e6);
+            std::snprintf(lines[line_count].data(), lines[line_count].size(), "%s %.2f Mpx/s", name, pixels_per_second / 1e6);
+            ++line_count;
+        });
+    lcd.fill(color::black<RGB565>());
+    for (std::size_t i{ 0 }; i < line_count; ++i)
+    {
+        lcd.text(lines[i].data(), { .x = 4, .y = static_cast<std::uint32_t>(4 + i * 12), .color = color::white<RGB565>() });
+    }
+    lcd.show();
+    return 0;
+}
+
+piconsole_program_update
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+piconsole_program_main
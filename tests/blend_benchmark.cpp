@@ -0,0 +1,116 @@
+// Host Mpixels per second for the packed blend row kernels, against blending the same 160x128 frame a pixel at a time
+//   with the scalar reference blends they match
+#include <cstdio>
+#include <span>
+#include <vector>
+#include "gfx/blend.h"
+#include "test.h"
+
+namespace
+{
+namespace blend = gfx::blend;
+
+constexpr std::size_t frame_size{ 160u * 128u };
+constexpr RGB565 tint_color{ 0xFFu, 0xFFu, 0xFFu };
+
+struct Kernel
+{
+    const char* name;
+    void (*reference)(std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha);
+    void (*packed)(std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha);
+};
+
+constexpr Kernel kernels[]{
+    {
+        "mix",
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha)
+        {
+            for (std::size_t i{ 0 }; i < destination.size(); ++i)
+            {
+                destination[i] = blend::mix(destination[i], source[i], alpha);
+            }
+        },
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha)
+        {
+            blend::mix(destination, source, alpha);
+        },
+    },
+    {
+        "add",
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t)
+        {
+            for (std::size_t i{ 0 }; i < destination.size(); ++i)
+            {
+                destination[i] = blend::add(destination[i], source[i]);
+            }
+        },
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t)
+        {
+            blend::add(destination, source);
+        },
+    },
+    {
+        "tint",
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha)
+        {
+            for (std::size_t i{ 0 }; i < destination.size(); ++i)
+            {
+                destination[i] = blend::mix(source[i], tint_color, alpha);
+            }
+        },
+        [](std::span<RGB565> destination, std::span<const RGB565> source, std::uint8_t alpha)
+        {
+            blend::tint(destination, source, tint_color, alpha);
+        },
+    },
+    {
+        "fill",
+        [](std::span<RGB565> destination, std::span<const RGB565>, std::uint8_t alpha)
+        {
+            for (RGB565& pixel : destination)
+            {
+                pixel = blend::mix(pixel, tint_color, alpha);
+            }
+        },
+        [](std::span<RGB565> destination, std::span<const RGB565>, std::uint8_t alpha)
+        {
+            blend::fill(destination, tint_color, alpha);
+        },
+    },
+};
+}
+
+int main()
+{
+    test::Random random{ 14u };
+    std::vector<RGB565> source(frame_size);
+    std::vector<RGB565> frame(frame_size);
+    for (std::size_t i{ 0 }; i < frame_size; ++i)
+    {
+        source[i] = RGB565{ static_cast<std::uint16_t>(random.next()) };
+        frame[i] = RGB565{ static_cast<std::uint16_t>(random.next()) };
+    }
+    // Read through a volatile so the alpha can't be folded into the kernels
+    volatile std::uint8_t alpha{ 100u };
+    std::printf("%-16s %14s %14s\n", "Mpixels/s", "per pixel", "packed");
+    for (const Kernel& kernel : kernels)
+    {
+        // Both give the same frame, or the comparison means nothing
+        std::vector<RGB565> reference{ frame };
+        std::vector<RGB565> packed{ frame };
+        kernel.reference(reference, source, alpha);
+        kernel.packed(packed, source, alpha);
+        for (std::size_t i{ 0 }; i < frame_size; ++i)
+        {
+            if (reference[i].data != packed[i].data)
+            {
+                std::printf("%s: the packed kernel differs from the reference at pixel %zu\n", kernel.name, i);
+                return 1;
+            }
+        }
+        const double per_pixel{ test::calls_per_second([&]() { kernel.reference(reference, source, alpha); }) };
+        const double packed_rate{ test::calls_per_second([&]() { kernel.packed(packed, source, alpha); }) };
+        std::printf("%-16s %14.1f %14.1f\n", kernel.name, per_pixel * frame_size / 1e6, packed_rate * frame_size / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Checks the packed blend kernels bit for bit against the scalar reference blends: mix_pair, add_pair and mix_pixel
+//   for every RGB565 value and weight, then the row kernels at every alignment of destination and source
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+#include "gfx/blend.h"
+#include "test.h"
+
+namespace
+{
+namespace blend = gfx::blend;
+
+// Stored (byte swapped) pixels to and from the standard RGB565 the pair kernels work on
+std::uint16_t swap_bytes(std::uint16_t value)
+{
+    return static_cast<std::uint16_t>(value >> 8 | (value & 0xFFu) << 8);
+}
+std::uint32_t make_pair(RGB565 first, RGB565 second)
+{
+    return swap_bytes(first.data) | static_cast<std::uint32_t>(swap_bytes(second.data)) << 16;
+}
+
+// An alpha rounding to each weight, 0 and 255 included
+std::uint8_t alpha_for_weight(std::uint32_t weight)
+{
+    return static_cast<std::uint8_t>(std::min(weight * 8u, 255u));
+}
+
+void check_weights()
+{
+    CHECK(blend::to_weight(0u) == 0u && blend::to_weight(255u) == blend::max_weight);
+    for (std::uint32_t weight{ 0u }; weight <= blend::max_weight; ++weight)
+    {
+        CHECK(blend::to_weight(alpha_for_weight(weight)) == weight);
+    }
+    test::Random random{ 3u };
+    for (std::size_t i{ 0 }; i < 10'000u; ++i)
+    {
+        const RGB565 under{ static_cast<std::uint16_t>(random.next()) };
+        const RGB565 over{ static_cast<std::uint16_t>(random.next()) };
+        CHECK(blend::mix(under, over, 0u).data == under.data);
+        CHECK(blend::mix(under, over, 255u).data == over.data);
+    }
+}
+
+// Every RGB565 value as each pixel of the pair, against random partners, at every weight
+void check_pairs()
+{
+    test::Random random{ 14u };
+    std::size_t wrong{ 0 };
+    for (std::uint32_t value{ 0u }; value <= 0xFFFFu; ++value)
+    {
+        const RGB565 pixel{ static_cast<std::uint16_t>(value) };
+        const RGB565 partner{ static_cast<std::uint16_t>(random.next()) };
+        const RGB565 other{ static_cast<std::uint16_t>(random.next()) };
+        const RGB565 under[]{ pixel, other };
+        const RGB565 over[]{ partner, pixel };
+        for (std::uint32_t weight{ 0u }; weight <= blend::max_weight; ++weight)
+        {
+            const std::uint8_t alpha{ alpha_for_weight(weight) };
+            const std::uint32_t mixed{ blend::detail::mix_pair(make_pair(under[0], under[1]), make_pair(over[0], over[1]), weight) };
+            const std::uint32_t expected{ make_pair(blend::mix(under[0], over[0], alpha), blend::mix(under[1], over[1], alpha)) };
+            if (mixed != expected && wrong++ < 5u)
+            {
+                std::printf("mix_pair(%04X:%04X, %04X:%04X, %u) is %08X, not %08X\n", under[1].data, under[0].data,
+                    over[1].data, over[0].data, weight, mixed, expected);
+            }
+            const std::uint16_t single{ blend::detail::mix_pixel(pixel.data, partner.data, weight) };
+            if (single != blend::mix(pixel, partner, alpha).data && wrong++ < 5u)
+            {
+                std::printf("mix_pixel(%04X, %04X, %u) is %04X\n", pixel.data, partner.data, weight, single);
+            }
+        }
+        const std::uint32_t added{ blend::detail::add_pair(make_pair(under[0], under[1]), make_pair(over[0], over[1])) };
+        const std::uint32_t expected{ make_pair(blend::add(under[0], over[0]), blend::add(under[1], over[1])) };
+        if (added != expected && wrong++ < 5u)
+        {
+            std::printf("add_pair(%04X:%04X, %04X:%04X) is %08X, not %08X\n", under[1].data, under[0].data,
+                over[1].data, over[0].data, added, expected);
+        }
+        // Saturating against white and against itself
+        const std::uint32_t white{ make_pair(RGB565{ std::uint16_t{ 0xFFFFu } }, RGB565{ std::uint16_t{ 0xFFFFu } }) };
+        if (blend::detail::add_pair(make_pair(pixel, pixel), white) != white
+            || blend::detail::add_pair(make_pair(pixel, pixel), make_pair(pixel, pixel))
+                != make_pair(blend::add(pixel, pixel), blend::add(pixel, pixel)))
+        {
+            if (wrong++ < 5u)
+            {
+                std::printf("add_pair doesn't saturate %04X\n", pixel.data);
+            }
+        }
+    }
+    CHECK(wrong == 0u);
+}
+
+enum class Kernel
+{
+    Mix,
+    Add,
+    Multiply,
+    Tint,
+    Fill,
+    MixMasked,
+};
+
+// Each row kernel at every alignment and odd or even length, against its scalar blend a pixel at a time
+void check_kernels()
+{
+    constexpr Kernel kernels[]{ Kernel::Mix, Kernel::Add, Kernel::Multiply, Kernel::Tint, Kernel::Fill, Kernel::MixMasked };
+    test::Random random{ 42u };
+    std::vector<RGB565> destination(300);
+    std::vector<RGB565> source(300);
+    std::vector<std::uint8_t> alphas(160);
+    std::size_t wrong{ 0 };
+    for (std::size_t iteration{ 0 }; iteration < 30'000u; ++iteration)
+    {
+        for (RGB565& pixel : destination)
+        {
+            pixel = RGB565{ static_cast<std::uint16_t>(random.next()) };
+        }
+        for (RGB565& pixel : source)
+        {
+            pixel = RGB565{ static_cast<std::uint16_t>(random.next()) };
+        }
+        for (std::uint8_t& alpha : alphas)
+        {
+            alpha = static_cast<std::uint8_t>(random.next());
+        }
+        const Kernel kernel{ kernels[iteration % std::size(kernels)] };
+        const std::size_t destination_offset{ static_cast<std::size_t>(random.range(0, 3)) };
+        const std::size_t source_offset{ static_cast<std::size_t>(random.range(0, 3)) };
+        const std::size_t count{ static_cast<std::size_t>(random.range(0, 200)) };
+        const std::size_t first_alpha{ static_cast<std::size_t>(random.range(0, 4)) };
+        const std::uint8_t alpha{ static_cast<std::uint8_t>(random.next()) };
+        const RGB565 color{ static_cast<std::uint16_t>(random.next()) };
+
+        std::vector<RGB565> expected{ destination };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            RGB565& under{ expected[destination_offset + i] };
+            const RGB565 over{ source[source_offset + i] };
+            switch (kernel)
+            {
+            case Kernel::Mix:
+                under = blend::mix(under, over, alpha);
+                break;
+            case Kernel::Add:
+                under = blend::add(under, over);
+                break;
+            case Kernel::Multiply:
+                under = blend::multiply(under, over);
+                break;
+            case Kernel::Tint:
+                under = blend::mix(over, color, alpha);
+                break;
+            case Kernel::Fill:
+                under = blend::mix(under, color, alpha);
+                break;
+            case Kernel::MixMasked:
+            {
+                const std::size_t index{ first_alpha + i };
+                const std::uint32_t mask_alpha{ (alphas[index / 2u] >> ((index & 1u) != 0u ? 0u : 4u)) & 0x0Fu };
+                // The 4 bit alpha's weight, applied per channel
+                const std::uint32_t weight{ blend::alpha4_weights[mask_alpha] };
+                const blend::detail::Channels a{ blend::detail::unpack(under) };
+                const blend::detail::Channels b{ blend::detail::unpack(over) };
+                const auto channel{ [weight](std::uint32_t x, std::uint32_t y) { return (y * weight + x * (32u - weight)) >> 5; } };
+                under = blend::detail::pack({ .r = channel(a.r, b.r), .g = channel(a.g, b.g), .b = channel(a.b, b.b) });
+                break;
+            }
+            }
+        }
+
+        const std::span<RGB565> out{ destination.data() + destination_offset, count };
+        const std::span<const RGB565> in{ source.data() + source_offset, count };
+        switch (kernel)
+        {
+        case Kernel::Mix:
+            blend::mix(out, in, alpha);
+            break;
+        case Kernel::Add:
+            blend::add(out, in);
+            break;
+        case Kernel::Multiply:
+            blend::multiply(out, in);
+            break;
+        case Kernel::Tint:
+            blend::tint(out, in, color, alpha);
+            break;
+        case Kernel::Fill:
+            blend::fill(out, color, alpha);
+            break;
+        case Kernel::MixMasked:
+            blend::mix_masked(out, in, alphas, first_alpha);
+            break;
+        }
+        for (std::size_t i{ 0 }; i < destination.size(); ++i)
+        {
+            if (destination[i].data != expected[i].data)
+            {
+                if (wrong++ < 5u)
+                {
+                    std::printf("kernel %d, %zu pixels at offsets %zu and %zu: pixel %zu is %04X, not %04X\n",
+                        static_cast<int>(kernel), count, destination_offset, source_offset, i, destination[i].data,
+                        expected[i].data);
+                }
+                break;
+            }
+        }
+    }
+    CHECK(wrong == 0u);
+}
+}
+
+int main()
+{
+    check_weights();
+    check_pairs();
+    check_kernels();
+    return test::finish("blend_test");
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "frame_pacer.h"
+#include "test.h"
+
+namespace
+{
+struct Run
+{
+    FramePacer::Stats stats;
+    // When each update was sent
+    std::vector<std::uint64_t> sends;
+};
+
+// Plays out one simulated second of OS::update(): the OS wakes at the pacer's wake time or when the program finishes,
+//   and the program takes `durations` in turn for its updates. One that doesn't acknowledge them, like a program
+//   built before program_updated, never reports finishing.
+Run simulate(std::uint32_t frame_rate, std::uint32_t max_catch_up, bool acknowledges_updates,
+    const std::vector<std::uint64_t>& durations)
+{
+    constexpr std::uint64_t never{ std::numeric_limits<std::uint64_t>::max() };
+    constexpr std::uint64_t os_busy_us{ 20u };
+    FramePacer pacer;
+    pacer.set_target_frame_rate(frame_rate);
+    pacer.set_max_catch_up(max_catch_up);
+    pacer.start(0u, acknowledges_updates);
+    Run run;
+    std::uint64_t now{ 0u };
+    std::uint64_t done_at{ never };
+    std::size_t next_duration{ 0 };
+    const auto send{ [&]()
+        {
+            run.sends.push_back(now);
+            const std::uint64_t duration{ durations[next_duration++ % durations.size()] };
+            done_at = acknowledges_updates ? now + duration : never;
+        } };
+    while (now < 1'000'000u)
+    {
+        if (done_at <= now)
+        {
+            done_at = never;
+            if (pacer.on_program_updated(now))
+            {
+                send();
+            }
+        }
+        if (pacer.poll(now, true))
+        {
+            send();
+        }
+        pacer.add_os_time(os_busy_us);
+        now = std::min(pacer.get_wake_time(now + os_busy_us), std::max(done_at, now + 1u));
+    }
+    run.stats = pacer.get_stats();
+    return run;
+}
+
+// Ticks in the simulated second at 60 Hz, counting the one at its start
+constexpr std::uint32_t ticks_at_60_hz{ 1'000'000u / (1'000'000u / 60u) + 1u };
+
+void check_acknowledged()
+{
+    // Quick updates go out once a tick, on the tick
+    const Run quick{ simulate(60u, 0u, true, { 5'000u }) };
+    CHECK(quick.stats.ticks == ticks_at_60_hz);
+    CHECK(quick.stats.updates == 60u);
+    CHECK(quick.stats.missed_deadlines == 0u);
+    CHECK(quick.sends.size() == ticks_at_60_hz);
+    for (std::size_t i{ 1 }; i < quick.sends.size(); ++i)
+    {
+        CHECK(quick.sends[i] - quick.sends[i - 1] == 16'666u);
+    }
+    CHECK(quick.stats.max_program_time_us == 5'000u);
+
+    // A slow update every third frame misses two ticks each time, which are dropped without catch-up...
+    const Run slow{ simulate(60u, 0u, true, { 5'000u, 5'000u, 40'000u }) };
+    CHECK(slow.stats.missed_deadlines != 0u);
+    CHECK(slow.stats.dropped_ticks == slow.stats.missed_deadlines);
+    CHECK(slow.stats.updates + slow.stats.dropped_ticks == slow.stats.ticks
+        || slow.stats.updates + slow.stats.dropped_ticks + 1u == slow.stats.ticks);
+    // ...and run late with it
+    const Run caught_up{ simulate(60u, 3u, true, { 5'000u, 5'000u, 40'000u }) };
+    CHECK(caught_up.stats.missed_deadlines != 0u);
+    CHECK(caught_up.stats.dropped_ticks == 0u);
+    CHECK(caught_up.sends.size() + 1u >= caught_up.stats.ticks);
+
+    // Uncapped sends each update as the last one finishes
+    const Run uncapped{ simulate(0u, 0u, true, { 5'000u }) };
+    CHECK(uncapped.sends.size() == 200u);
+    CHECK(uncapped.stats.missed_deadlines == 0u);
+}
+
+void check_unacknowledged()
+{
+    // Never acknowledging doesn't stall the program after its first update: it gets one every tick
+    const Run paced{ simulate(60u, 3u, false, { 5'000u }) };
+    CHECK(paced.stats.ticks == ticks_at_60_hz);
+    CHECK(paced.sends.size() == ticks_at_60_hz);
+    CHECK(paced.stats.missed_deadlines == 0u);
+    CHECK(paced.stats.dropped_ticks == 0u);
+    CHECK(paced.stats.updates == 0u);
+    for (std::size_t i{ 1 }; i < paced.sends.size(); ++i)
+    {
+        CHECK(paced.sends[i] - paced.sends[i - 1] == 16'666u);
+    }
+
+    // And one every max_sleep_us when uncapped
+    const Run uncapped{ simulate(0u, 0u, false, { 5'000u }) };
+    CHECK(uncapped.sends.size() == 1'000'000u / FramePacer::max_sleep_us + 1u);
+    CHECK(uncapped.stats.missed_deadlines == 0u);
+
+    // However often something else wakes the OS in between
+    FramePacer woken;
+    woken.set_target_frame_rate(0u);
+    woken.start(0u, false);
+    std::vector<std::uint64_t> sends;
+    for (std::uint64_t now{ 0u }; now < 1'000'000u; now += 100u)
+    {
+        if (woken.poll(now, true))
+        {
+            CHECK(sends.empty() || now - sends.back() >= FramePacer::max_sleep_us);
+            CHECK(woken.get_wake_time(now) == now + FramePacer::max_sleep_us);
+            sends.push_back(now);
+        }
+    }
+    CHECK(sends.size() >= 1'000'000u / (FramePacer::max_sleep_us + 100u));
+
+    // A program reporting its updates after all is ignored, rather than getting extra ones
+    FramePacer pacer;
+    pacer.start(0u, false);
+    CHECK(pacer.poll(0u, true));
+    CHECK(!pacer.on_program_updated(1'000u));
+    CHECK(!pacer.poll(2'000u, true));
+    CHECK(pacer.poll(pacer.get_frame_time_us(), true));
+}
+}
+
+int main()
+{
+    check_acknowledged();
+    check_unacknowledged();
+    return test::finish("frame_pacer_test");
+}
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Writes LZ4 blocks compressed by tools/program_packer.py, for lz4_test to check the OS's decoder against.
+
+Each input is compressed at every history size the loader supports. The cases file lists one block per line: the raw
+file, the packed file and its history bits, all in the output directory.
+
+Example:
+    lz4_cases.py build/tests/lz4_cases
+"""
+import random
+import sys
+from pathlib import Path
+
+# Run from the build, so leave no bytecode behind in the source tree
+sys.dont_write_bytecode = True
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "tools"))
+import program_packer  # noqa: E402
+
+
+def make_inputs():
+    rng = random.Random(24)
+    # Something like Thumb code: common instruction sequences, each with a word changed now and then, and the odd
+    #   literal pool of addresses
+    words = [rng.getrandbits(16).to_bytes(2, "little") for _ in range(300)]
+    sequences = [[rng.choice(words) for _ in range(rng.randrange(3, 20))] for _ in range(60)]
+    code = bytearray()
+    while len(code) < 40_000:
+        if rng.random() < 0.05:
+            code += b"".join((0x10080000 + rng.randrange(0x10000)).to_bytes(4, "little") for _ in range(rng.randrange(1, 6)))
+        else:
+            sequence = list(rng.choice(sequences))
+            sequence[rng.randrange(len(sequence))] = rng.choice(words)
+            code += b"".join(sequence)
+    # Repeats that reach anywhere from a few bytes to 20 KB back, so every history size cuts some of them off
+    echoes = bytearray(rng.randbytes(512))
+    while len(echoes) < 40_000:
+        distance = rng.choice([3, 17, 200, 255, 256, 257, 1000, 4096, 8000, 16384, 20000])
+        start = max(len(echoes) - distance, 0)
+        echoes += echoes[start:start + rng.randrange(4, 300)] + rng.randbytes(rng.randrange(0, 40))
+    return {
+        "code": bytes(code),
+        "echoes": bytes(echoes),
+        # Long runs need run on bytes for both literal counts and match lengths
+        "runs": bytes(4000) + rng.randbytes(1000) + b"\xAB" * 70_000 + rng.randbytes(300),
+        "random": rng.randbytes(5000),
+        "text": (Path(program_packer.__file__).read_bytes() * 2)[:50_000],
+        # Shorter than the end rules leave room for a match in
+        "tiny": b"abcabcabca",
+    }
+
+
+def main():
+    out_dir = Path(sys.argv[1])
+    out_dir.mkdir(parents=True, exist_ok=True)
+    lines = []
+    for name, data in make_inputs().items():
+        raw_path = out_dir / f"{name}.raw"
+        raw_path.write_bytes(data)
+        for bits in range(program_packer.MIN_HISTORY_BITS, program_packer.MAX_HISTORY_BITS + 1):
+            packed = program_packer.compress(data, 1 << bits)
+            # The packer's own check, so a failure in lz4_test is the decoder's
+            if program_packer.decompress(packed, len(data), 1 << bits) != data:
+                sys.exit(f"{name} doesn't round trip through the packer at {bits} history bits")
+            packed_path = out_dir / f"{name}.{bits}.lz4"
+            packed_path.write_bytes(packed)
+            lines.append(f"{raw_path} {packed_path} {bits}\n")
+    (out_dir / "cases.txt").write_text("".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,147 @@
+// Decodes LZ4 blocks compressed by tools/program_packer.py (see lz4_cases.py) from the SD card the way the loader
+//   does, through every chunk size from 2 B to 2 KB and every history size from 256 B to 16 KB, in spans of random
+//   sizes, and checks the bytes match the packer's input exactly
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "lz4.h"
+#include "ram_disk.h"
+#include "test.h"
+
+namespace
+{
+constexpr const char* block_path{ "block.lz4" };
+// Bytes ahead of the block in its file, as a segment sits somewhere in the middle of an ELF
+constexpr std::size_t block_offset{ 37 };
+constexpr std::size_t chunk_sizes[]{ 2, 3, 17, 512, 2048 };
+
+struct Case
+{
+    std::string name;
+    std::vector<std::uint8_t> raw;
+    std::vector<std::uint8_t> packed;
+    std::uint32_t history_bits;
+};
+
+std::vector<std::uint8_t> read_host_file(const std::string& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    return { std::istreambuf_iterator<char>{ file }, {} };
+}
+
+std::vector<Case> read_cases(const char* path)
+{
+    std::vector<Case> cases;
+    std::ifstream list{ path };
+    std::string raw_path;
+    std::string packed_path;
+    std::uint32_t history_bits;
+    while (list >> raw_path >> packed_path >> history_bits)
+    {
+        cases.push_back({ packed_path.substr(packed_path.find_last_of('/') + 1), read_host_file(raw_path),
+            read_host_file(packed_path), history_bits });
+    }
+    return cases;
+}
+
+// Decodes `packed_size` bytes of the block on the RAM disk into `size` bytes, in spans of up to 5000 bytes; false if
+//   the decoder failed along the way. `finished` is whether it then says it's done and won't decode any further.
+bool decode(std::uint32_t packed_size, std::size_t size, std::size_t history_size, std::size_t chunk_size,
+    test::Random& random, std::vector<std::uint8_t>& out, bool& finished)
+{
+    SDCard::FileReader reader{ block_path };
+    reader.seek_absolute(block_offset);
+    std::vector<std::uint8_t> history(history_size);
+    std::vector<std::uint8_t> chunk(chunk_size);
+    lz4::StreamDecoder decoder{ reader, history, chunk };
+    decoder.start(packed_size);
+    out.assign(size, 0u);
+    for (std::size_t at{ 0 }; at < size;)
+    {
+        const std::size_t count{ std::min<std::size_t>(size - at, static_cast<std::size_t>(random.range(0, 5000))) };
+        if (!decoder.decode({ out.data() + at, count }))
+        {
+            return false;
+        }
+        at += count;
+    }
+    std::uint8_t extra;
+    finished = decoder.is_finished() && !decoder.decode({ &extra, 1u });
+    return true;
+}
+
+void check_case(const Case& test_case, test::Random& random)
+{
+    std::vector<std::uint8_t> file(block_offset, 0xEEu);
+    file.insert(file.end(), test_case.packed.begin(), test_case.packed.end());
+    CHECK(test::write_file(block_path, file));
+    const std::uint32_t packed_size{ static_cast<std::uint32_t>(test_case.packed.size()) };
+    std::vector<std::uint8_t> out;
+    bool finished{ false };
+    // The history it was packed for, and more than it needs
+    for (const std::uint32_t history_bits : { test_case.history_bits, 14u })
+    {
+        for (const std::size_t chunk_size : chunk_sizes)
+        {
+            const bool decoded{ decode(packed_size, test_case.raw.size(), std::size_t{ 1 } << history_bits, chunk_size,
+                random, out, finished) };
+            if (!decoded || out != test_case.raw || !finished)
+            {
+                std::printf("%s: decoding with %zu B chunks and %u history bits went wrong\n", test_case.name.c_str(),
+                    chunk_size, history_bits);
+                CHECK(decoded && out == test_case.raw && finished);
+            }
+        }
+    }
+    // A block cut short runs out of data rather than decoding what isn't there
+    for (const std::uint32_t cut : { 1u, 2u, 5u, packed_size / 2u, packed_size })
+    {
+        for (const std::size_t chunk_size : { std::size_t{ 2 }, std::size_t{ 512 } })
+        {
+            if (cut <= packed_size && decode(packed_size - cut, test_case.raw.size(),
+                std::size_t{ 1 } << test_case.history_bits, chunk_size, random, out, finished))
+            {
+                std::printf("%s: decoded %u bytes short with %zu B chunks\n", test_case.name.c_str(), cut, chunk_size);
+                CHECK(false);
+            }
+        }
+    }
+}
+}
+
+int main()
+{
+    const std::vector<Case> cases{ read_cases(LZ4_CASES_FILE) };
+    CHECK(cases.size() >= 6u * 7u);
+    if (!test::mount_ram_disk())
+    {
+        std::printf("lz4_test: couldn't mount the RAM disk\n");
+        return 1;
+    }
+    test::Random random{ 24u };
+    for (const Case& test_case : cases)
+    {
+        check_case(test_case, random);
+    }
+
+    // Matches reaching back past the history the decoder has are refused, not read from whatever's there
+    const auto echoes{ std::find_if(cases.begin(), cases.end(), [](const Case& test_case)
+        {
+            return test_case.name == "echoes.14.lz4";
+        }) };
+    CHECK(echoes != cases.end());
+    if (echoes != cases.end())
+    {
+        std::vector<std::uint8_t> file(block_offset, 0xEEu);
+        file.insert(file.end(), echoes->packed.begin(), echoes->packed.end());
+        CHECK(test::write_file(block_path, file));
+        std::vector<std::uint8_t> out;
+        bool finished{ false };
+        CHECK(!decode(static_cast<std::uint32_t>(echoes->packed.size()), echoes->raw.size(), 256u, 512u, random, out,
+            finished));
+    }
+    return test::finish("lz4_test");
+}
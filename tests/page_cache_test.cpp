@@ -0,0 +1,204 @@
+// Replays page access traces through gfx::PageCache and a plain list-based LRU side by side, checking every hit, miss,
+//   eviction and read against the reference, and that each page handed out holds that page's bytes
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <span>
+#include <vector>
+#include "gfx/sprite_atlas.h"
+#include "test.h"
+
+namespace
+{
+constexpr std::size_t page_size{ 64 };
+
+// Each page is filled with bytes derived from its number, so a page served from the wrong buffer shows up
+std::uint8_t page_byte(std::uint32_t page, std::size_t i)
+{
+    return static_cast<std::uint8_t>(page * 31u + i);
+}
+
+// Least recently used at the front; preloading a page that's already cached doesn't count as using it
+class ReferenceLRU
+{
+public:
+    explicit ReferenceLRU(std::size_t capacity) : capacity{ capacity } {}
+
+    // Whether `page` was cached, moving it to the back if so
+    bool use(std::uint32_t page)
+    {
+        const auto cached{ std::find(pages.begin(), pages.end(), page) };
+        if (cached == pages.end())
+        {
+            return false;
+        }
+        pages.splice(pages.end(), pages, cached);
+        return true;
+    }
+    bool contains(std::uint32_t page) const { return std::find(pages.begin(), pages.end(), page) != pages.end(); }
+    // Makes room for a page being read, returning whether another page had to go
+    bool evict_for_load()
+    {
+        if (pages.size() < capacity)
+        {
+            return false;
+        }
+        pages.pop_front();
+        return true;
+    }
+    void insert(std::uint32_t page) { pages.push_back(page); }
+
+    std::size_t capacity;
+    std::list<std::uint32_t> pages;
+    gfx::PageCache<page_size, 1>::Stats stats;
+};
+
+struct Access
+{
+    std::uint32_t page;
+    bool preload;
+    // Whether reading the page fails, if it comes to that
+    bool read_fails;
+};
+
+template <std::size_t TPageCount>
+void replay(const char* name, const std::vector<Access>& trace)
+{
+    gfx::PageCache<page_size, TPageCount> cache;
+    ReferenceLRU reference{ TPageCount };
+    std::size_t wrong{ 0 };
+    const auto report{ [&](std::size_t step, const char* what)
+        {
+            if (wrong++ == 0u)
+            {
+                std::printf("%s, %zu pages: %s at access %zu (page %u)\n", name, TPageCount, what, step,
+                    trace[step].page);
+            }
+        } };
+    for (std::size_t step{ 0 }; step < trace.size(); ++step)
+    {
+        const Access& access{ trace[step] };
+        std::vector<std::uint32_t> reads;
+        const auto read{ [&](std::uint32_t page, std::span<std::uint8_t> bytes)
+            {
+                reads.push_back(page);
+                for (std::size_t i{ 0 }; i < bytes.size(); ++i)
+                {
+                    bytes[i] = page_byte(page, i);
+                }
+                return !access.read_fails;
+            } };
+
+        // What the reference says should happen
+        bool expect_read{ false };
+        if (access.preload ? !reference.contains(access.page) : !reference.use(access.page))
+        {
+            expect_read = true;
+            ++(access.preload ? reference.stats.preloads : reference.stats.misses);
+            reference.stats.evictions += reference.evict_for_load() ? 1u : 0u;
+            if (!access.read_fails)
+            {
+                reference.insert(access.page);
+            }
+        }
+        else if (!access.preload)
+        {
+            ++reference.stats.hits;
+        }
+
+        if (access.preload)
+        {
+            if (cache.preload(access.page, read) != (!expect_read || !access.read_fails))
+            {
+                report(step, "preload returned the wrong result");
+            }
+        }
+        else
+        {
+            const std::span<const std::uint8_t> bytes{ cache.get(access.page, read) };
+            const bool should_fail{ expect_read && access.read_fails };
+            if (bytes.empty() != should_fail)
+            {
+                report(step, "get returned the wrong result");
+            }
+            for (std::size_t i{ 0 }; i < bytes.size(); ++i)
+            {
+                if (bytes[i] != page_byte(access.page, i))
+                {
+                    report(step, "get returned another page's bytes");
+                    break;
+                }
+            }
+        }
+        if (reads != (expect_read ? std::vector<std::uint32_t>{ access.page } : std::vector<std::uint32_t>{}))
+        {
+            report(step, "the wrong pages were read");
+        }
+        const auto& stats{ cache.get_stats() };
+        if (stats.hits != reference.stats.hits || stats.misses != reference.stats.misses
+            || stats.preloads != reference.stats.preloads || stats.evictions != reference.stats.evictions)
+        {
+            report(step, "stats differ");
+        }
+        for (std::uint32_t page{ 0 }; page < 64u; ++page)
+        {
+            if (cache.contains(page) != reference.contains(page))
+            {
+                report(step, "cached pages differ");
+                break;
+            }
+        }
+    }
+    CHECK(wrong == 0u);
+}
+
+template <std::size_t TPageCount>
+void replay_all()
+{
+    test::Random random{ static_cast<std::uint32_t>(11u + TPageCount) };
+    std::vector<Access> trace;
+
+    // Cycling through a working set that fits misses once per page and then always hits
+    for (std::size_t i{ 0 }; i < TPageCount * 20u; ++i)
+    {
+        trace.push_back({ static_cast<std::uint32_t>(i % TPageCount), false, false });
+    }
+    replay<TPageCount>("fitting loop", trace);
+
+    // One page more than fits makes LRU miss every time
+    trace.clear();
+    for (std::size_t i{ 0 }; i < (TPageCount + 1u) * 20u; ++i)
+    {
+        trace.push_back({ static_cast<std::uint32_t>(i % (TPageCount + 1u)), false, false });
+    }
+    replay<TPageCount>("overflowing loop", trace);
+
+    // Mostly a few hot pages, now and then one of many cold ones
+    trace.clear();
+    for (std::size_t i{ 0 }; i < 20'000u; ++i)
+    {
+        const bool hot{ random.range(0, 9) < 8 };
+        trace.push_back({ static_cast<std::uint32_t>(hot ? random.range(0, static_cast<std::int32_t>(TPageCount) / 2)
+            : random.range(0, 63)), false, false });
+    }
+    replay<TPageCount>("hot and cold", trace);
+
+    // Preloads ahead of use, the way SpriteAtlas::load_prefetched() runs them, and reads that fail
+    trace.clear();
+    for (std::size_t i{ 0 }; i < 20'000u; ++i)
+    {
+        const std::uint32_t page{ static_cast<std::uint32_t>(random.range(0, static_cast<std::int32_t>(TPageCount) * 2)) };
+        trace.push_back({ page, random.range(0, 3) == 0, random.range(0, 19) == 0 });
+    }
+    replay<TPageCount>("preloads and failures", trace);
+}
+}
+
+int main()
+{
+    replay_all<1>();
+    replay_all<4>();
+    replay_all<8>();
+    return test::finish("page_cache_test");
+}
@@ -0,0 +1,241 @@
+// Host full screen images per second for gfx::qoi::draw() decoding a 160x128 QOI file from the SD card straight into
+//   the framebuffer, against reading the same image stored raw in the framebuffer's RGB565 layout. Both go through
+//   FatFS on a RAM disk, which reads far faster than a real SD card, so the raw reads here are close to free; the bytes
+//   each reads are printed alongside, since on the device those are what the raw path waits for.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <vector>
+#include "gfx/color.h"
+#include "gfx/convert.h"
+#include "gfx/qoi.h"
+#include "canvas.h"
+#include "ram_disk.h"
+#include "test.h"
+
+namespace
+{
+constexpr std::size_t screen_width{ 160 };
+constexpr std::size_t screen_height{ 128 };
+
+// Packed as r | g << 8 | b << 16, all opaque
+using Image = std::vector<std::uint32_t>;
+
+constexpr std::uint32_t rgb(std::uint32_t r, std::uint32_t g, std::uint32_t b)
+{
+    return r | g << 8 | b << 16;
+}
+
+// An RGB QOI file of a screen sized `image`, encoded as the spec's reference encoder does
+std::vector<std::uint8_t> encode_qoi(const Image& image)
+{
+    std::vector<std::uint8_t> bytes{ 'q', 'o', 'i', 'f' };
+    for (const std::size_t size : { screen_width, screen_height })
+    {
+        for (std::size_t i{ 4 }; i-- > 0;)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(size >> (i * 8u)));
+        }
+    }
+    bytes.push_back(3u);
+    bytes.push_back(0u);
+    std::uint32_t index[64]{};
+    std::uint32_t previous{ 0u };
+    std::uint8_t run{ 0u };
+    for (std::size_t i{ 0 }; i < image.size(); ++i)
+    {
+        const std::uint32_t pixel{ image[i] };
+        if (pixel == previous)
+        {
+            if (++run == 62u || i + 1u == image.size())
+            {
+                bytes.push_back(static_cast<std::uint8_t>(gfx::qoi::detail::op_run | (run - 1u)));
+                run = 0u;
+            }
+            continue;
+        }
+        if (run != 0u)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(gfx::qoi::detail::op_run | (run - 1u)));
+            run = 0u;
+        }
+        const std::uint8_t r{ static_cast<std::uint8_t>(pixel) };
+        const std::uint8_t g{ static_cast<std::uint8_t>(pixel >> 8) };
+        const std::uint8_t b{ static_cast<std::uint8_t>(pixel >> 16) };
+        // Every pixel is opaque, so alpha is always 255 in the hash
+        const std::uint8_t hash{ static_cast<std::uint8_t>((r * 3u + g * 5u + b * 7u + 255u * 11u) % 64u) };
+        if (index[hash] == pixel)
+        {
+            bytes.push_back(hash);
+            previous = pixel;
+            continue;
+        }
+        index[hash] = pixel;
+        const int dr{ static_cast<std::int8_t>(r - static_cast<std::uint8_t>(previous)) };
+        const int dg{ static_cast<std::int8_t>(g - static_cast<std::uint8_t>(previous >> 8)) };
+        const int db{ static_cast<std::int8_t>(b - static_cast<std::uint8_t>(previous >> 16)) };
+        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(gfx::qoi::detail::op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+        }
+        else if (dg >= -32 && dg <= 31 && dr - dg >= -8 && dr - dg <= 7 && db - dg >= -8 && db - dg <= 7)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(gfx::qoi::detail::op_luma | (dg + 32)));
+            bytes.push_back(static_cast<std::uint8_t>((dr - dg + 8) << 4 | (db - dg + 8)));
+        }
+        else
+        {
+            bytes.insert(bytes.end(), { gfx::qoi::detail::op_rgb, r, g, b });
+        }
+        previous = pixel;
+    }
+    bytes.insert(bytes.end(), { 0u, 0u, 0u, 0u, 0u, 0u, 0u, 1u });
+    return bytes;
+}
+
+// The image as the framebuffer holds it
+std::vector<std::uint8_t> encode_raw(const Image& image)
+{
+    std::vector<std::uint8_t> bytes(image.size() * sizeof(RGB565));
+    for (std::size_t i{ 0 }; i < image.size(); ++i)
+    {
+        const std::uint16_t stored{ static_cast<std::uint16_t>(
+            gfx::convert::detail::to_stored(image[i] & 0xFFu, image[i] >> 8 & 0xFFu, image[i] >> 16 & 0xFFu)) };
+        std::memcpy(bytes.data() + i * sizeof(RGB565), &stored, sizeof(stored));
+    }
+    return bytes;
+}
+
+// A smooth two way gradient: mostly QOI_OP_DIFF and QOI_OP_LUMA
+Image make_gradient()
+{
+    Image image;
+    for (std::size_t y{ 0 }; y < screen_height; ++y)
+    {
+        for (std::size_t x{ 0 }; x < screen_width; ++x)
+        {
+            image.push_back(rgb(static_cast<std::uint32_t>(y * 255u / screen_height),
+                static_cast<std::uint32_t>(x * 255u / screen_width),
+                static_cast<std::uint32_t>(255u - (x + y) * 255u / (screen_width + screen_height))));
+        }
+    }
+    return image;
+}
+
+// Like a title screen: banded sky, a brick floor, a few round sprites and some blocky text. Mostly runs and indexes
+Image make_title_art()
+{
+    Image image(screen_width * screen_height);
+    for (std::size_t y{ 0 }; y < screen_height; ++y)
+    {
+        for (std::size_t x{ 0 }; x < screen_width; ++x)
+        {
+            std::uint32_t color{ y < 80u ? rgb(40u + static_cast<std::uint32_t>(y / 8u * 8u),
+                90u + static_cast<std::uint32_t>(y / 8u * 6u), 200u)
+                : (x / 8u + y / 8u) % 2u != 0u ? rgb(150u, 70u, 40u) : rgb(130u, 60u, 30u) };
+            if (y >= 80u && (x % 8u == 0u || y % 8u == 0u))
+            {
+                color = rgb(90u, 40u, 20u);
+            }
+            image[y * screen_width + x] = color;
+        }
+    }
+    test::Random random{ 19u };
+    constexpr std::uint32_t palette[]{ rgb(255u, 220u, 180u), rgb(200u, 30u, 30u), rgb(20u, 20u, 20u), rgb(60u, 60u, 220u) };
+    for (std::size_t sprite{ 0 }; sprite < 6u; ++sprite)
+    {
+        const std::size_t sprite_x{ static_cast<std::size_t>(random.range(0, 140)) };
+        const std::size_t sprite_y{ static_cast<std::size_t>(random.range(0, 60)) };
+        for (std::size_t y{ 0 }; y < 16u; ++y)
+        {
+            for (std::size_t x{ 0 }; x < 16u; ++x)
+            {
+                const std::int32_t dx{ static_cast<std::int32_t>(x) - 8 };
+                const std::int32_t dy{ static_cast<std::int32_t>(y) - 8 };
+                if (dx * dx + dy * dy < 50)
+                {
+                    image[(sprite_y + y) * screen_width + sprite_x + x] = palette[(x / 4u + y / 8u * 2u + sprite) % 4u];
+                }
+            }
+        }
+    }
+    for (std::size_t y{ 20 }; y < 27u; ++y)
+    {
+        for (std::size_t x{ 30 }; x < 130u; ++x)
+        {
+            if ((random.next() & 1u) != 0u)
+            {
+                image[y * screen_width + x] = rgb(255u, 255u, 255u);
+            }
+        }
+    }
+    return image;
+}
+
+// Nothing for QOI to find, so every pixel is a 4 byte QOI_OP_RGB: the worst case
+Image make_noise()
+{
+    test::Random random{ 9u };
+    Image image(screen_width * screen_height);
+    for (std::uint32_t& pixel : image)
+    {
+        pixel = random.next() & 0xFFFFFFu;
+    }
+    return image;
+}
+
+// The raw image is the whole framebuffer, so it's one read
+bool read_raw(test::Canvas<RGB565>& canvas, const char* path)
+{
+    SDCard::FileReader reader{ path };
+    return reader.read_bytes(std::span<std::uint8_t>{ reinterpret_cast<std::uint8_t*>(canvas.pixels.data()),
+        canvas.pixels.size() * sizeof(RGB565) });
+}
+
+struct Case
+{
+    const char* name;
+    Image (*make)();
+};
+
+constexpr Case cases[]{
+    { "gradient", make_gradient },
+    { "title art", make_title_art },
+    { "noise", make_noise },
+};
+}
+
+int main()
+{
+    if (!test::mount_ram_disk())
+    {
+        std::printf("Couldn't mount the RAM disk\n");
+        return 1;
+    }
+    std::printf("%-12s %10s %10s %14s %14s\n", "image", "QOI KB", "raw KB", "QOI draws/s", "raw reads/s");
+    for (const Case& image_case : cases)
+    {
+        const Image image{ image_case.make() };
+        const std::vector<std::uint8_t> qoi_file{ encode_qoi(image) };
+        const std::vector<std::uint8_t> raw_file{ encode_raw(image) };
+        if (!test::write_file("image.qoi", qoi_file) || !test::write_file("image.raw", raw_file))
+        {
+            std::printf("%s: couldn't write the image files\n", image_case.name);
+            return 1;
+        }
+        // Both give the same framebuffer, or the comparison means nothing
+        test::Canvas<RGB565> decoded{ screen_width, screen_height };
+        test::Canvas<RGB565> read{ screen_width, screen_height };
+        if (!gfx::qoi::draw(decoded, "image.qoi") || !read_raw(read, "image.raw") || !(decoded == read))
+        {
+            std::printf("%s: the decoded image differs from the raw one\n", image_case.name);
+            return 1;
+        }
+        const double draws_per_second{ test::calls_per_second([&]() { gfx::qoi::draw(decoded, "image.qoi"); }) };
+        const double reads_per_second{ test::calls_per_second([&]() { read_raw(read, "image.raw"); }) };
+        std::printf("%-12s %10.1f %10.1f %14.0f %14.0f\n", image_case.name, static_cast<double>(qoi_file.size()) / 1024.0,
+            static_cast<double>(raw_file.size()) / 1024.0, draws_per_second, reads_per_second);
+    }
+    return 0;
+}
@@ -0,0 +1,357 @@
+// Draws random frames through a host LCD with ColorLCD's drawing calls (fills, lines, rectangles, text, blits, sprites
+//   and shapes), which mark what they draw just as ColorLCD's do, and checks the merged DirtyRegions against a diff of
+//   the frames before and after: resending just the regions must turn the old frame into the new one, while the
+//   regions stay apart, on screen and within the set's capacity
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "gfx/color.h"
+#include "gfx/region.h"
+#include "gfx/shapes.h"
+#include "gfx/sprite.h"
+#include "gfx/text.h"
+#include "canvas.h"
+#include "test.h"
+
+namespace
+{
+using gfx::Rect;
+
+// A 160x128 framebuffer with ColorLCD_RGB565's drawing calls, built the same way and marking dirty exactly what they
+//   mark, including through the gfx code they hand off to. Only the DMA fills are plain loops here.
+class DirtyTrackingLCD
+{
+public:
+    using ColorFormat = RGB565;
+    constexpr static std::size_t width{ 160 };
+    constexpr static std::size_t height{ 128 };
+    using TextSettings = gfx::text::PrintSettings<DirtyTrackingLCD>;
+    // As many as the LCD keeps
+    using DirtyRegions = gfx::DirtyRegions<8>;
+
+    std::size_t get_width() const { return width; }
+    std::size_t get_height() const { return height; }
+    // Empty if off screen; callers must mark_dirty themselves
+    std::span<RGB565> get_row(std::size_t y) { return y < height ? canvas.get_row(y) : std::span<RGB565>{}; }
+    void set_pixel(RGB565 color, std::size_t x, std::size_t y)
+    {
+        mark_dirty(x, y, 1, 1);
+        canvas.set_pixel(color, x, y);
+    }
+    void fill(RGB565 color)
+    {
+        mark_all_dirty();
+        canvas.fill(color);
+    }
+    void line_horizontal(RGB565 color, std::size_t x, std::size_t y, std::size_t line_width)
+    {
+        mark_dirty(x, y, line_width, 1);
+        canvas.line_horizontal(color, x, y, line_width);
+    }
+    void line_vertical(RGB565 color, std::size_t x, std::size_t y, std::size_t line_height)
+    {
+        mark_dirty(x, y, 1, line_height);
+        for (std::size_t row{ y }; row < y + line_height; ++row)
+        {
+            set_pixel(color, x, row);
+        }
+    }
+    void line(RGB565 color, std::size_t start_x, std::size_t start_y, std::size_t end_x, std::size_t end_y)
+    {
+        gfx::shapes::line(*this, color,
+            { static_cast<std::int32_t>(start_x), static_cast<std::int32_t>(start_y) },
+            { static_cast<std::int32_t>(end_x), static_cast<std::int32_t>(end_y) });
+    }
+    void rectangle(RGB565 color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        line_horizontal(color, x, y, rectangle_width);
+        if (rectangle_height <= 1)
+        {
+            return;
+        }
+        line_horizontal(color, x, y + rectangle_height - 1, rectangle_width);
+        if (rectangle_height <= 2)
+        {
+            return;
+        }
+        line_vertical(color, x, y + 1, rectangle_height - 2);
+        if (rectangle_width > 1)
+        {
+            line_vertical(color, x + rectangle_width - 1, y + 1, rectangle_height - 2);
+        }
+    }
+    void filled_rectangle(RGB565 color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        if (x >= width || y >= height || rectangle_width == 0 || rectangle_height == 0)
+        {
+            return;
+        }
+        rectangle_width = std::min(rectangle_width, width - x);
+        rectangle_height = std::min(rectangle_height, height - y);
+        mark_dirty(x, y, rectangle_width, rectangle_height);
+        for (std::size_t row{ y }; row < y + rectangle_height; ++row)
+        {
+            canvas.line_horizontal(color, x, row, rectangle_width);
+        }
+    }
+    void text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_text<DirtyTrackingLCD>(*this, string, settings);
+    }
+    void centered_text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_centered_text<DirtyTrackingLCD>(*this, string, settings);
+    }
+    void blit(std::span<const RGB565> pixels, std::size_t x, std::size_t y, std::size_t blit_width, std::size_t blit_height)
+    {
+        if (x >= width || y >= height)
+        {
+            return;
+        }
+        const std::size_t visible_width{ std::min(blit_width, width - x) };
+        const std::size_t visible_height{ std::min(blit_height, height - y) };
+        mark_dirty(x, y, visible_width, visible_height);
+        for (std::size_t row{ 0 }; row < visible_height; ++row)
+        {
+            std::copy_n(pixels.begin() + row * blit_width, visible_width, get_row(y + row).begin() + x);
+        }
+    }
+    void sprite(const gfx::Sprite& sprite, std::int32_t x, std::int32_t y, const gfx::SpriteBlit& blit = {})
+    {
+        gfx::draw_sprite(*this, sprite, x, y, blit);
+    }
+    void circle(RGB565 color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        gfx::shapes::circle(*this, color, { x, y }, radius);
+    }
+    void filled_circle(RGB565 color, std::int32_t x, std::int32_t y, std::int32_t radius)
+    {
+        gfx::shapes::filled_circle(*this, color, { x, y }, radius);
+    }
+    void filled_triangle(RGB565 color, gfx::shapes::Point a, gfx::shapes::Point b, gfx::shapes::Point c)
+    {
+        gfx::shapes::filled_triangle(*this, color, a, b, c);
+    }
+
+    void mark_dirty(std::size_t x, std::size_t y, std::size_t dirty_width, std::size_t dirty_height)
+    {
+        dirty_regions.add(Rect{
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y),
+            .width = static_cast<std::uint32_t>(dirty_width), .height = static_cast<std::uint32_t>(dirty_height)
+        }.clipped(width, height));
+    }
+    void mark_all_dirty() { mark_dirty(0, 0, width, height); }
+
+    test::Canvas<RGB565> canvas{ width, height };
+    DirtyRegions dirty_regions;
+};
+
+using DirtyRegions = DirtyTrackingLCD::DirtyRegions;
+constexpr std::size_t screen_width{ DirtyTrackingLCD::width };
+constexpr std::size_t screen_height{ DirtyTrackingLCD::height };
+
+// Images for blit() and sprite()
+struct Images
+{
+    Images()
+    {
+        for (std::size_t i{ 0 }; i < pixels.size(); ++i)
+        {
+            pixels[i] = RGB565{ static_cast<std::uint16_t>(i * 0x0731u + 1u) };
+        }
+        for (std::size_t i{ 0 }; i < indices.size(); ++i)
+        {
+            indices[i] = static_cast<std::uint8_t>((i * 7u) % 16u);
+        }
+    }
+
+    std::vector<RGB565> pixels = std::vector<RGB565>(24u * 20u);
+    std::vector<std::uint8_t> indices = std::vector<std::uint8_t>(16u * 16u);
+    gfx::Sprite sprite{ gfx::SpriteFormat::Indexed8, indices, 16u, 16u,
+        std::span<const RGB565>{ pixels.data(), 256u }, std::optional<std::uint8_t>{ 3u } };
+};
+
+std::int32_t random_x(test::Random& random) { return random.range(0, screen_width - 1); }
+std::int32_t random_y(test::Random& random) { return random.range(0, screen_height - 1); }
+
+// One drawing call of the kind a frame makes: mostly small, now and then a line or something large, and sometimes
+//   hanging off the edges where the call clips. Calls that don't clip on the LCD are kept on screen.
+void draw_random_call(DirtyTrackingLCD& lcd, const Images& images, test::Random& random)
+{
+    const RGB565 color{ static_cast<std::uint16_t>(random.next()) };
+    const std::size_t x{ static_cast<std::size_t>(random_x(random)) };
+    const std::size_t y{ static_cast<std::size_t>(random_y(random)) };
+    switch (random.range(0, 12))
+    {
+    case 0:
+        lcd.set_pixel(color, x, y);
+        break;
+    case 1:
+        lcd.line_horizontal(color, x, y, static_cast<std::size_t>(random.range(1, screen_width - x)));
+        break;
+    case 2:
+        lcd.line_vertical(color, x, y, static_cast<std::size_t>(random.range(1, screen_height - y)));
+        break;
+    case 3:
+        lcd.line(color, x, y, static_cast<std::size_t>(random.range(0, screen_width + 40)),
+            static_cast<std::size_t>(random.range(0, screen_height + 40)));
+        break;
+    case 4:
+        lcd.rectangle(color, x, y, static_cast<std::size_t>(random.range(1, screen_width - x)),
+            static_cast<std::size_t>(random.range(1, screen_height - y)));
+        break;
+    case 5:
+        lcd.filled_rectangle(color, x, y, static_cast<std::size_t>(random.range(1, 100)), static_cast<std::size_t>(random.range(1, 100)));
+        break;
+    case 6:
+        lcd.text("Dirty text\non two lines", { .wrap_mode = random.range(0, 1) == 0 ? gfx::text::WrapMode::Clip : gfx::text::WrapMode::Wrap,
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y), .padding_x = 1u, .color = color,
+            .background = random.range(0, 1) == 0 ? std::nullopt : std::optional<RGB565>{ RGB565{ static_cast<std::uint16_t>(~color.data) } } });
+        break;
+    case 7:
+        lcd.centered_text("Centered", { .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y), .color = color });
+        break;
+    case 8:
+        lcd.blit(images.pixels, x, y, 24u, 20u);
+        break;
+    case 9:
+        lcd.sprite(images.sprite, random.range(-20, screen_width + 4), random.range(-20, screen_height + 4));
+        break;
+    case 10:
+        lcd.circle(color, random.range(-20, screen_width + 20), random.range(-20, screen_height + 20), random.range(0, 40));
+        break;
+    case 11:
+        lcd.filled_circle(color, random.range(-20, screen_width + 20), random.range(-20, screen_height + 20), random.range(0, 40));
+        break;
+    default:
+        lcd.filled_triangle(color, { random.range(-20, screen_width + 20), random.range(-20, screen_height + 20) },
+            { random.range(-20, screen_width + 20), random.range(-20, screen_height + 20) },
+            { random.range(-20, screen_width + 20), random.range(-20, screen_height + 20) });
+        break;
+    }
+}
+
+void check_against_diff(const test::Canvas<RGB565>& previous, const DirtyTrackingLCD& lcd)
+{
+    const std::span<const Rect> regions{ lcd.dirty_regions.get_regions() };
+    CHECK(regions.size() <= DirtyRegions::max_regions);
+    std::uint32_t total_area{ 0u };
+    for (std::size_t i{ 0 }; i < regions.size(); ++i)
+    {
+        CHECK(!regions[i].empty());
+        CHECK(regions[i].end_x() <= screen_width && regions[i].end_y() <= screen_height);
+        total_area += regions[i].area();
+        for (std::size_t j{ i + 1u }; j < regions.size(); ++j)
+        {
+            CHECK(!regions[i].touches(regions[j]));
+        }
+    }
+    CHECK(lcd.dirty_regions.get_total_area() == total_area);
+
+    // Sending only the regions reproduces the new frame wherever the reference diff says it changed
+    test::Canvas<RGB565> sent{ previous };
+    for (const Rect& region : regions)
+    {
+        for (std::uint32_t y{ region.y }; y < region.end_y(); ++y)
+        {
+            std::copy_n(lcd.canvas.pixels.begin() + y * screen_width + region.x, region.width,
+                sent.pixels.begin() + y * screen_width + region.x);
+        }
+    }
+    std::size_t missed{ 0 };
+    for (std::size_t i{ 0 }; i < sent.pixels.size(); ++i)
+    {
+        if (sent.pixels[i].data != lcd.canvas.pixels[i].data && missed++ == 0u)
+        {
+            std::printf("pixel %zu, %zu changed outside every dirty region\n", i % screen_width, i / screen_width);
+        }
+    }
+    CHECK(missed == 0u);
+}
+
+void check_random_frames()
+{
+    test::Random random{ 1u };
+    const Images images;
+    DirtyTrackingLCD lcd;
+    for (RGB565& pixel : lcd.canvas.pixels)
+    {
+        pixel = RGB565{ static_cast<std::uint16_t>(random.next()) };
+    }
+    for (std::size_t frame{ 0 }; frame < 3000u; ++frame)
+    {
+        const test::Canvas<RGB565> previous{ lcd.canvas };
+        lcd.dirty_regions.clear();
+        // From nothing to far more than the set holds, with a whole screen fill now and then
+        const std::size_t count{ static_cast<std::size_t>(frame % 4u == 0u ? random.range(0, 4) : random.range(0, 40)) };
+        for (std::size_t i{ 0 }; i < count; ++i)
+        {
+            if (random.range(0, 199) == 0)
+            {
+                lcd.fill(RGB565{ static_cast<std::uint16_t>(random.next()) });
+            }
+            draw_random_call(lcd, images, random);
+        }
+        check_against_diff(previous, lcd);
+    }
+}
+
+// Filled rectangles that don't touch each other, and fit, are kept exactly as drawn
+void check_apart_rectangles()
+{
+    DirtyTrackingLCD lcd;
+    const Rect rects[]{ { 2u, 3u, 10u, 4u }, { 40u, 3u, 1u, 1u }, { 100u, 50u, 30u, 60u }, { 150u, 120u, 10u, 8u } };
+    for (const Rect& rect : rects)
+    {
+        lcd.filled_rectangle(color::white<RGB565>(), rect.x, rect.y, rect.width, rect.height);
+    }
+    // Off the bottom right corner, it's clipped to what's on screen
+    lcd.filled_rectangle(color::white<RGB565>(), 60u, 120u, 20u, 20u);
+    const std::span<const Rect> regions{ lcd.dirty_regions.get_regions() };
+    CHECK(regions.size() == std::size(rects) + 1u);
+    for (const Rect& rect : rects)
+    {
+        CHECK(std::find(regions.begin(), regions.end(), rect) != regions.end());
+    }
+    CHECK(std::find(regions.begin(), regions.end(), Rect{ 60u, 120u, 20u, 8u }) != regions.end());
+}
+
+void check_merges()
+{
+    DirtyRegions dirty;
+    dirty.add({ 10u, 10u, 20u, 20u });
+    // Inside an existing region, or empty: nothing changes
+    dirty.add({ 15u, 15u, 5u, 5u });
+    dirty.add({ 50u, 50u, 0u, 10u });
+    CHECK(dirty.size() == 1u && dirty.get_regions()[0] == (Rect{ 10u, 10u, 20u, 20u }));
+    // Sharing an edge merges, and so does a rect that grows to touch another once merged
+    dirty.add({ 60u, 10u, 10u, 10u });
+    dirty.add({ 30u, 10u, 5u, 5u });
+    CHECK(dirty.size() == 2u);
+    dirty.add({ 35u, 12u, 25u, 2u });
+    CHECK(dirty.size() == 1u && dirty.get_regions()[0] == (Rect{ 10u, 10u, 60u, 20u }));
+
+    // Once full, a new rect joins the region it grows the least
+    dirty.clear();
+    for (std::uint32_t i{ 0 }; i < DirtyRegions::max_regions; ++i)
+    {
+        dirty.add({ i * 20u, 0u, 10u, 10u });
+    }
+    dirty.add({ 42u, 12u, 4u, 4u });
+    CHECK(dirty.size() == DirtyRegions::max_regions);
+    CHECK(std::find(dirty.get_regions().begin(), dirty.get_regions().end(), Rect{ 40u, 0u, 10u, 16u })
+        != dirty.get_regions().end());
+}
+}
+
+int main()
+{
+    check_merges();
+    check_apart_rectangles();
+    check_random_frames();
+    return test::finish("region_test");
+}
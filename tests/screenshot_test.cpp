@@ -0,0 +1,156 @@
+// Writes screenshots of a stand-in LCD to the RAM disk with gfx::write_screenshot(), as OS::capture_screenshot() does,
+//   then reads each BMP back and checks it pixel for pixel against the display buffer as the panel would show it
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+#include "gfx/color.h"
+#include "gfx/post_process.h"
+#include "gfx/screenshot.h"
+#include "ram_disk.h"
+#include "test.h"
+
+namespace
+{
+constexpr const char* screenshot_path{ "shot.bmp" };
+
+// Just what write_screenshot() reads of an LCD, with the 1.8" panel's size
+struct FakeLCD
+{
+    using ColorFormat = RGB565;
+    constexpr static std::size_t width{ 160 };
+    constexpr static std::size_t height{ 128 };
+
+    std::vector<RGB565> display_buffer = std::vector<RGB565>(width * height);
+    std::size_t scroll_offset{ 0 };
+    gfx::PostProcess post_process;
+
+    std::span<const RGB565> get_display_row(std::size_t y) const { return { display_buffer.data() + y * width, width }; }
+    std::size_t get_scroll_offset() const { return scroll_offset; }
+    const gfx::PostProcess& get_post_process() const { return post_process; }
+};
+
+// The same chunk OS.cpp uses: 8 rows
+alignas(4) std::array<RGB565, FakeLCD::width * 8u> chunk;
+
+std::uint32_t get_u16(const std::vector<std::uint8_t>& bytes, std::size_t at)
+{
+    return static_cast<std::uint32_t>(bytes[at] | bytes[at + 1u] << 8);
+}
+std::uint32_t get_u32(const std::vector<std::uint8_t>& bytes, std::size_t at)
+{
+    return get_u16(bytes, at) | get_u16(bytes, at + 2u) << 16;
+}
+
+// Standard RGB565, as the BMP holds it, from a pixel in the framebuffer's stored layout
+std::uint32_t to_standard(RGB565 color)
+{
+    return static_cast<std::uint32_t>(color.data >> 8 | (color.data & 0xFFu) << 8);
+}
+
+// The screenshot of `lcd`, checked for a well formed 16 bit top-down BITFIELDS header; empty if it isn't one
+std::vector<std::uint8_t> capture(const FakeLCD& lcd)
+{
+    bool written{ false };
+    {
+        SDCard::FileWriter writer{ screenshot_path };
+        written = gfx::write_screenshot(writer, lcd, std::span{ chunk });
+    }
+    CHECK(written);
+    const std::vector<std::uint8_t> file{ test::read_file(screenshot_path) };
+    const std::size_t expected_size{ gfx::bmp::pixel_data_offset + FakeLCD::width * FakeLCD::height * 2u };
+    CHECK(file.size() == expected_size);
+    if (file.size() != expected_size)
+    {
+        return {};
+    }
+    CHECK(file[0] == 'B' && file[1] == 'M');
+    CHECK(get_u32(file, 2u) == expected_size);
+    CHECK(get_u32(file, 10u) == gfx::bmp::pixel_data_offset);
+    CHECK(get_u32(file, 14u) == 40u);
+    CHECK(get_u32(file, 18u) == FakeLCD::width);
+    CHECK(static_cast<std::int32_t>(get_u32(file, 22u)) == -static_cast<std::int32_t>(FakeLCD::height));
+    CHECK(get_u16(file, 26u) == 1u && get_u16(file, 28u) == 16u);
+    CHECK(get_u32(file, 30u) == 3u);
+    CHECK(get_u32(file, 54u) == 0xF800u && get_u32(file, 58u) == 0x07E0u && get_u32(file, 62u) == 0x001Fu);
+    return file;
+}
+
+// Checks every pixel of `file` is `expected` of the display buffer pixel the panel shows there
+template <typename TExpected>
+void check_pixels(const char* name, const FakeLCD& lcd, const std::vector<std::uint8_t>& file, TExpected&& expected)
+{
+    if (file.empty())
+    {
+        return;
+    }
+    std::size_t wrong{ 0 };
+    for (std::size_t y{ 0 }; y < FakeLCD::height; ++y)
+    {
+        for (std::size_t x{ 0 }; x < FakeLCD::width; ++x)
+        {
+            const RGB565 shown{ lcd.get_display_row(y)[(x + lcd.scroll_offset) % FakeLCD::width] };
+            const std::uint32_t pixel{ get_u16(file, gfx::bmp::pixel_data_offset + (y * FakeLCD::width + x) * 2u) };
+            if (pixel != expected(shown) && wrong++ == 0u)
+            {
+                std::printf("%s: pixel %zu, %zu is %04X, not %04X\n", name, x, y, static_cast<unsigned>(pixel),
+                    static_cast<unsigned>(expected(shown)));
+            }
+        }
+    }
+    CHECK(wrong == 0u);
+}
+}
+
+int main()
+{
+    if (!test::mount_ram_disk())
+    {
+        std::printf("screenshot_test: couldn't mount the RAM disk\n");
+        return 1;
+    }
+    FakeLCD lcd;
+    test::Random random{ 18u };
+    for (RGB565& pixel : lcd.display_buffer)
+    {
+        pixel = RGB565{ static_cast<std::uint16_t>(random.next()) };
+    }
+
+    check_pixels("plain", lcd, capture(lcd), to_standard);
+
+    // Every column that wraps, including the last
+    for (const std::size_t scroll_offset : { std::size_t{ 1 }, std::size_t{ 37 }, FakeLCD::width - 1u })
+    {
+        lcd.scroll_offset = scroll_offset;
+        check_pixels("scrolled", lcd, capture(lcd), to_standard);
+    }
+
+    // Curves that invert each channel map every standard RGB565 pixel to its complement
+    std::array<std::uint8_t, 256> invert;
+    for (std::size_t i{ 0 }; i < invert.size(); ++i)
+    {
+        invert[i] = static_cast<std::uint8_t>(0xFFu - i);
+    }
+    lcd.post_process.set_channel_curves(invert, invert, invert);
+    check_pixels("inverted", lcd, capture(lcd), [](RGB565 shown)
+        {
+            return ~to_standard(shown) & 0xFFFFu;
+        });
+    lcd.post_process.clear_lut();
+
+    // A fade, scrolled too, comes out as the panel gets it
+    lcd.post_process.set_fade(RGB565{ 255u, 128u, 0u }, 100u);
+    check_pixels("faded", lcd, capture(lcd), [&](RGB565 shown)
+        {
+            RGB565 faded;
+            lcd.post_process.apply(std::span{ &faded, 1u }, std::span<const RGB565>{ &shown, 1u });
+            return to_standard(faded);
+        });
+    lcd.post_process.set_brightness(0u);
+    check_pixels("black", lcd, capture(lcd), [](RGB565)
+        {
+            return 0u;
+        });
+    return test::finish("screenshot_test");
+}
@@ -0,0 +1,19 @@
+// Host pixels per second for gfx::shapes, drawing into a plain 160x128 RGB565 framebuffer; see the
+//   shapes_benchmark program for the same shapes on the device's LCD
+#include <cstdio>
+#include "gfx/color.h"
+#include "canvas.h"
+#include "shapes_benchmark.h"
+#include "test.h"
+
+int main()
+{
+    test::Canvas<RGB565> canvas{ 160, 128 };
+    std::printf("%-16s %14s\n", "primitive", "Mpixels/s");
+    shapes_benchmark::run(canvas, RGB565{ 0xFFu, 0x80u, 0x00u }, test::now_us, 300'000u,
+        [](const char* name, double pixels_per_second)
+        {
+            std::printf("%-16s %14.1f\n", name, pixels_per_second / 1e6);
+        });
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "gfx/shapes.h"
+
+// Pixels per second for each of gfx::shapes' primitives, shared by the host benchmark and the shapes_benchmark
+//   program so both draw exactly the same shapes
+namespace shapes_benchmark
+{
+using gfx::shapes::Point;
+
+// Counts the pixels a primitive covers without drawing them, so timing on the real target isn't skewed by counting
+class PixelCounter
+{
+public:
+    PixelCounter(std::size_t width, std::size_t height) : width{ width }, height{ height } {}
+
+    std::size_t get_width() const { return width; }
+    std::size_t get_height() const { return height; }
+    template <typename TColor>
+    void set_pixel(TColor, std::size_t, std::size_t) { ++pixels; }
+    template <typename TColor>
+    void line_horizontal(TColor, std::size_t, std::size_t, std::size_t length) { pixels += length; }
+
+    std::uint64_t pixels{ 0u };
+
+private:
+    std::size_t width;
+    std::size_t height;
+};
+
+// The same pseudo-random shapes on every run and every platform
+class Shapes
+{
+public:
+    explicit Shapes(std::size_t width, std::size_t height) : width{ static_cast<std::int32_t>(width) }, height{ static_cast<std::int32_t>(height) } {}
+
+    Point point()
+    {
+        return { static_cast<std::int32_t>(next() % static_cast<std::uint32_t>(width)),
+            static_cast<std::int32_t>(next() % static_cast<std::uint32_t>(height)) };
+    }
+    std::int32_t radius() { return 4 + static_cast<std::int32_t>(next() % 40u); }
+
+private:
+    std::uint32_t next()
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    std::int32_t width;
+    std::int32_t height;
+    std::uint32_t state{ 1u };
+};
+
+constexpr std::size_t shapes_per_run{ 200 };
+
+// Draws shapes_per_run of one primitive
+template <typename TTarget, typename TColor>
+void draw(TTarget& target, TColor color, std::size_t primitive)
+{
+    Shapes shapes{ target.get_width(), target.get_height() };
+    for (std::size_t i{ 0 }; i < shapes_per_run; ++i)
+    {
+        const Point a{ shapes.point() };
+        const Point b{ shapes.point() };
+        const Point c{ shapes.point() };
+        const std::int32_t radius_x{ shapes.radius() };
+        const std::int32_t radius_y{ shapes.radius() };
+        const Point pentagon[]{ { a.x, a.y - radius_y }, { a.x + radius_x, a.y - radius_y / 3 },
+            { a.x + radius_x / 2, a.y + radius_y }, { a.x - radius_x / 2, a.y + radius_y }, { a.x - radius_x, a.y - radius_y / 3 } };
+        switch (primitive)
+        {
+            case 0: gfx::shapes::line(target, color, a, b); break;
+            case 1: gfx::shapes::circle(target, color, a, radius_x); break;
+            case 2: gfx::shapes::filled_circle(target, color, a, radius_x); break;
+            case 3: gfx::shapes::ellipse(target, color, a, radius_x, radius_y); break;
+            case 4: gfx::shapes::filled_ellipse(target, color, a, radius_x, radius_y); break;
+            case 5: gfx::shapes::triangle(target, color, a, b, c); break;
+            case 6: gfx::shapes::filled_triangle(target, color, a, b, c); break;
+            case 7: gfx::shapes::polygon(target, color, pentagon); break;
+            default: gfx::shapes::filled_polygon(target, color, pentagon); break;
+        }
+    }
+}
+
+constexpr const char* primitive_names[]{
+    "line", "circle", "filled_circle", "ellipse", "filled_ellipse", "triangle", "filled_triangle", "polygon",
+    "filled_polygon"
+};
+constexpr std::size_t primitive_count{ sizeof(primitive_names) / sizeof(primitive_names[0]) };
+
+// Draws each primitive onto `target` for at least `min_us` by `now_us()`, calling
+//   `report(name, pixels_per_second)` for each
+template <typename TTarget, typename TColor, typename TClock, typename TReport>
+void run(TTarget& target, TColor color, TClock&& now_us, std::uint64_t min_us, TReport&& report)
+{
+    for (std::size_t primitive{ 0 }; primitive < primitive_count; ++primitive)
+    {
+        PixelCounter counter{ target.get_width(), target.get_height() };
+        draw(counter, color, primitive);
+        std::uint64_t runs{ 0u };
+        const std::uint64_t start{ now_us() };
+        std::uint64_t elapsed{ 0u };
+        while (elapsed < min_us)
+        {
+            draw(target, color, primitive);
+            ++runs;
+            elapsed = now_us() - start;
+        }
+        report(primitive_names[primitive], static_cast<double>(counter.pixels * runs) * 1e6 / static_cast<double>(elapsed));
+    }
+}
+}
@@ -0,0 +1,242 @@
+// Checks gfx::shapes' outlines and fills cover exactly the rows they should, as single spans, with outlines joined up
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "gfx/shapes.h"
+#include "canvas.h"
+#include "test.h"
+
+using gfx::shapes::Point;
+using Canvas = test::Canvas<std::uint8_t>;
+
+namespace
+{
+constexpr std::int32_t size{ 240 };
+constexpr Point center{ size / 2, size / 2 };
+
+// Columns [first, last] set on row y, or first > last if none
+struct RowSpan
+{
+    std::int32_t first{ size };
+    std::int32_t last{ -1 };
+    std::int32_t count{ 0 };
+};
+
+RowSpan get_row_span(const Canvas& canvas, std::int32_t y)
+{
+    RowSpan row;
+    for (std::int32_t x{ 0 }; x < size; ++x)
+    {
+        if (canvas.get_pixel(x, y) != 0u)
+        {
+            row.first = std::min(row.first, x);
+            row.last = x;
+            ++row.count;
+        }
+    }
+    return row;
+}
+
+// Whether every set pixel can be reached from `start` through 8-neighbours
+bool is_connected(const Canvas& canvas, Point start)
+{
+    const std::int32_t width{ static_cast<std::int32_t>(canvas.width) };
+    const std::int32_t height{ static_cast<std::int32_t>(canvas.height) };
+    std::vector<bool> seen(canvas.pixels.size(), false);
+    std::vector<Point> pending{ start };
+    seen[start.y * width + start.x] = true;
+    std::size_t reached{ 0 };
+    while (!pending.empty())
+    {
+        const Point point{ pending.back() };
+        pending.pop_back();
+        ++reached;
+        for (std::int32_t dy{ -1 }; dy <= 1; ++dy)
+        {
+            for (std::int32_t dx{ -1 }; dx <= 1; ++dx)
+            {
+                const Point next{ point.x + dx, point.y + dy };
+                if (next.x >= 0 && next.y >= 0 && next.x < width && next.y < height && canvas.get_pixel(next.x, next.y) != 0u
+                    && !seen[next.y * width + next.x])
+                {
+                    seen[next.y * width + next.x] = true;
+                    pending.push_back(next);
+                }
+            }
+        }
+    }
+    return reached == static_cast<std::size_t>(std::count_if(canvas.pixels.begin(), canvas.pixels.end(),
+        [](std::uint8_t pixel) { return pixel != 0u; }));
+}
+
+// Rows within `radius_y` of the center, and only those, are covered by both outline and fill; the fill is one span
+//   per row, no narrower than the row further from the center, and the outline lies within it and is joined up
+void check_round_shape(const Canvas& outline, const Canvas& filled, std::int32_t radius_x, std::int32_t radius_y,
+    const char* shape)
+{
+    bool ok{ true };
+    std::int32_t previous_width{ 0 };
+    for (std::int32_t y{ 0 }; y < size; ++y)
+    {
+        const std::int32_t distance{ std::abs(y - center.y) };
+        const bool inside{ distance <= radius_y };
+        const RowSpan outline_row{ get_row_span(outline, y) };
+        const RowSpan filled_row{ get_row_span(filled, y) };
+        ok &= (outline_row.count != 0) == inside && (filled_row.count != 0) == inside;
+        if (filled_row.count != 0)
+        {
+            ok &= filled_row.count == filled_row.last - filled_row.first + 1;
+            ok &= filled_row.first - center.x == center.x - filled_row.last;
+            ok &= filled_row.last - center.x <= radius_x;
+        }
+        if (y >= center.y && inside)
+        {
+            const std::int32_t width{ filled_row.last - filled_row.first };
+            ok &= y == center.y || width <= previous_width;
+            previous_width = width;
+        }
+    }
+    for (std::size_t i{ 0 }; i < outline.pixels.size(); ++i)
+    {
+        ok &= outline.pixels[i] == 0u || filled.pixels[i] != 0u;
+    }
+    ok &= outline.get_pixel(center.x + radius_x, center.y) != 0u && outline.get_pixel(center.x, center.y + radius_y) != 0u;
+    ok &= is_connected(outline, { center.x + radius_x, center.y });
+    if (!ok)
+    {
+        std::printf("%s with radii %d, %d is wrong\n", shape, radius_x, radius_y);
+    }
+    CHECK(ok);
+}
+
+void check_ellipses()
+{
+    for (std::int32_t radius_x{ 0 }; radius_x < size / 2; ++radius_x)
+    {
+        for (std::int32_t radius_y{ 0 }; radius_y < size / 2; radius_y += radius_x < 8 ? 1 : 3)
+        {
+            Canvas outline{ size, size };
+            Canvas filled{ size, size };
+            gfx::shapes::ellipse(outline, std::uint8_t{ 1 }, center, radius_x, radius_y);
+            gfx::shapes::filled_ellipse(filled, std::uint8_t{ 1 }, center, radius_x, radius_y);
+            check_round_shape(outline, filled, radius_x, radius_y, "ellipse");
+        }
+    }
+}
+
+void check_circles()
+{
+    for (std::int32_t radius{ 0 }; radius < size / 2; ++radius)
+    {
+        Canvas outline{ size, size };
+        Canvas filled{ size, size };
+        gfx::shapes::circle(outline, std::uint8_t{ 1 }, center, radius);
+        gfx::shapes::filled_circle(filled, std::uint8_t{ 1 }, center, radius);
+        check_round_shape(outline, filled, radius, radius, "circle");
+    }
+}
+
+// Ellipses too big for any screen still trace their quadrant within a pixel of the true curve, with each row a single
+//   span that touches the next
+void check_large_ellipses()
+{
+    constexpr std::int32_t radii[][2]{ { 800, 600 }, { 1500, 1500 }, { 3000, 200 }, { 200, 3000 }, { 6000, 4500 } };
+    for (const auto& [radius_x, radius_y] : radii)
+    {
+        bool on_curve{ true };
+        std::vector<RowSpan> rows(static_cast<std::size_t>(radius_y) + 1u, RowSpan{ radius_x + 1, -1, 0 });
+        gfx::shapes::detail::walk_ellipse(radius_x, radius_y,
+            [&](std::int32_t x, std::int32_t y, bool)
+            {
+                const double distance{ std::hypot(static_cast<double>(x) / radius_x, static_cast<double>(y) / radius_y) };
+                on_curve &= std::abs(distance - 1.0) * std::min(radius_x, radius_y) <= 1.0;
+                if (y >= 0 && y <= radius_y)
+                {
+                    RowSpan& row{ rows[static_cast<std::size_t>(y)] };
+                    row.first = std::min(row.first, x);
+                    row.last = std::max(row.last, x);
+                    ++row.count;
+                }
+            });
+        CHECK(on_curve);
+        bool joined{ rows.front().last == radius_x && rows.back().first == 0 };
+        for (std::size_t y{ 0 }; y < rows.size(); ++y)
+        {
+            joined &= rows[y].count == rows[y].last - rows[y].first + 1;
+            joined &= y == 0u || rows[y].last + 1 >= rows[y - 1u].first;
+        }
+        CHECK(joined);
+    }
+}
+
+// Lines hanging off every edge light exactly the pixels of the same lines drawn whole on a canvas big enough for them
+void check_clipped_lines()
+{
+    constexpr Point offset{ 120, 140 };
+    test::Random random{ 11 };
+    Canvas canvas{ 160, 128 };
+    Canvas whole{ 401, 401 };
+    for (int i{ 0 }; i < 20000; ++i)
+    {
+        const auto point{ [&] { return Point{ random.range(-120, 280), random.range(-140, 260) }; } };
+        const Point start{ point() };
+        const Point end{ point() };
+        canvas.fill(0u);
+        whole.fill(0u);
+        gfx::shapes::line(canvas, std::uint8_t{ 1 }, start, end);
+        gfx::shapes::line(whole, std::uint8_t{ 1 }, Point{ start.x + offset.x, start.y + offset.y },
+            Point{ end.x + offset.x, end.y + offset.y });
+        bool same{ true };
+        for (std::size_t y{ 0 }; y < canvas.height; ++y)
+        {
+            const std::span<std::uint8_t> row{ canvas.get_row(y) };
+            same &= std::equal(row.begin(), row.end(), whole.get_row(y + offset.y).begin() + offset.x);
+        }
+        CHECK(same);
+        // Whole, it's one pixel per step along its longer axis, from end to end
+        const std::int32_t length{ std::max(std::abs(end.x - start.x), std::abs(end.y - start.y)) + 1 };
+        CHECK(static_cast<std::int32_t>(std::count(whole.pixels.begin(), whole.pixels.end(), 1u)) == length);
+        CHECK(whole.get_pixel(start.x + offset.x, start.y + offset.y) == 1u);
+        CHECK(whole.get_pixel(end.x + offset.x, end.y + offset.y) == 1u);
+        CHECK(is_connected(whole, Point{ start.x + offset.x, start.y + offset.y }));
+    }
+}
+
+// Triangles hanging off every edge stay on the canvas and fill as one span per row
+void check_triangles()
+{
+    test::Random random{ 5 };
+    Canvas canvas{ 160, 128 };
+    for (int i{ 0 }; i < 20000; ++i)
+    {
+        const auto point{ [&] { return Point{ random.range(-120, 280), random.range(-140, 260) }; } };
+        const Point a{ point() };
+        const Point b{ point() };
+        const Point c{ point() };
+        canvas.fill(0u);
+        gfx::shapes::filled_triangle(canvas, std::uint8_t{ 1 }, a, b, c);
+        bool single_spans{ true };
+        for (std::size_t y{ 0 }; y < canvas.height; ++y)
+        {
+            const std::span<std::uint8_t> row{ canvas.get_row(y) };
+            const auto first{ std::find(row.begin(), row.end(), 1u) };
+            const auto last{ std::find(row.rbegin(), row.rend(), 1u) };
+            single_spans &= first == row.end() || std::find(first, last.base(), 0u) == last.base();
+        }
+        CHECK(single_spans);
+        gfx::shapes::triangle(canvas, std::uint8_t{ 2 }, a, b, c);
+        gfx::shapes::line(canvas, std::uint8_t{ 3 }, a, b);
+    }
+}
+}
+
+int main()
+{
+    check_ellipses();
+    check_circles();
+    check_large_ellipses();
+    check_clipped_lines();
+    check_triangles();
+    return test::finish("shapes_test");
+}
@@ -0,0 +1,147 @@
+// Host sprites per 60 Hz frame for gfx::draw_sprite at 16x16 and 32x32, against drawing the same sprite a pixel at a
+//   time, onto a plain 160x128 RGB565 framebuffer. Sprites have a transparent column band down each side when keyed,
+//   and every other draw is flipped.
+#include <cstdio>
+#include <optional>
+#include <vector>
+#include "gfx/color.h"
+#include "gfx/sprite.h"
+#include "canvas.h"
+#include "test.h"
+
+namespace
+{
+constexpr std::size_t screen_width{ 160 };
+constexpr std::size_t screen_height{ 128 };
+
+// What draw_sprite() replaced: one lookup, key test and store per pixel
+void draw_sprite_per_pixel(test::Canvas<RGB565>& target, const gfx::Sprite& sprite, std::int32_t x, std::int32_t y,
+    gfx::Flip flip)
+{
+    const bool flip_x{ (static_cast<std::uint8_t>(flip) & static_cast<std::uint8_t>(gfx::Flip::Horizontal)) != 0u };
+    const bool flip_y{ (static_cast<std::uint8_t>(flip) & static_cast<std::uint8_t>(gfx::Flip::Vertical)) != 0u };
+    const std::optional<std::uint16_t> color_key{ sprite.get_color_key() };
+    const std::span<const RGB565> palette{ sprite.get_palette() };
+    const std::int32_t width{ static_cast<std::int32_t>(sprite.get_width()) };
+    const std::int32_t height{ static_cast<std::int32_t>(sprite.get_height()) };
+    for (std::int32_t row{ 0 }; row < height; ++row)
+    {
+        const std::uint8_t* source{ sprite.get_row(static_cast<std::size_t>(flip_y ? height - 1 - row : row)) };
+        for (std::int32_t column{ 0 }; column < width; ++column)
+        {
+            const std::int32_t screen_x{ x + column };
+            const std::int32_t screen_y{ y + row };
+            if (screen_x < 0 || screen_y < 0 || screen_x >= static_cast<std::int32_t>(target.get_width())
+                || screen_y >= static_cast<std::int32_t>(target.get_height()))
+            {
+                continue;
+            }
+            const std::size_t source_x{ static_cast<std::size_t>(flip_x ? width - 1 - column : column) };
+            std::uint16_t value;
+            switch (sprite.get_format())
+            {
+            case gfx::SpriteFormat::RGB565:
+                value = reinterpret_cast<const std::uint16_t*>(source)[source_x];
+                break;
+            case gfx::SpriteFormat::Indexed8:
+                value = source[source_x];
+                break;
+            default:
+                value = source[source_x / 2u] >> (source_x % 2u == 0u ? 4u : 0u) & 0x0Fu;
+                break;
+            }
+            if (color_key == value)
+            {
+                continue;
+            }
+            target.set_pixel(sprite.is_indexed() ? palette[value] : RGB565{ value },
+                static_cast<std::size_t>(screen_x), static_cast<std::size_t>(screen_y));
+        }
+    }
+}
+
+struct Case
+{
+    const char* name;
+    gfx::SpriteFormat format;
+    bool keyed;
+};
+
+constexpr Case cases[]{
+    { "rgb565 opaque", gfx::SpriteFormat::RGB565, false },
+    { "rgb565 keyed", gfx::SpriteFormat::RGB565, true },
+    { "indexed8 opaque", gfx::SpriteFormat::Indexed8, false },
+    { "indexed8 keyed", gfx::SpriteFormat::Indexed8, true },
+    { "indexed4 opaque", gfx::SpriteFormat::Indexed4, false },
+    { "indexed4 keyed", gfx::SpriteFormat::Indexed4, true },
+};
+}
+
+int main()
+{
+    std::vector<RGB565> palette(256);
+    test::Random random{ 1u };
+    for (RGB565& color : palette)
+    {
+        color = RGB565{ static_cast<std::uint16_t>(random.next()) };
+    }
+    std::printf("%-22s %12s %12s\n", "sprites per frame", "per pixel", "draw_sprite");
+    for (const std::size_t size : { 16u, 32u })
+    {
+        // 0 is transparent when keyed: an eighth of the width down each side
+        std::vector<std::uint16_t> pixels(size * size);
+        std::vector<std::uint8_t> indices(size * size);
+        for (std::size_t i{ 0 }; i < pixels.size(); ++i)
+        {
+            const bool hole{ i % size < size / 8u || i % size >= size - size / 8u };
+            pixels[i] = hole ? 0u : static_cast<std::uint16_t>(0x1234u + i);
+            indices[i] = hole ? 0u : static_cast<std::uint8_t>(1u + i % 15u);
+        }
+        for (const Case& test_case : cases)
+        {
+            const gfx::Sprite sprite{ test_case.format == gfx::SpriteFormat::RGB565
+                ? gfx::Sprite{ { reinterpret_cast<const RGB565*>(pixels.data()), pixels.size() }, size, size,
+                    test_case.keyed ? std::optional<RGB565>{ RGB565{ std::uint16_t{ 0u } } } : std::nullopt }
+                : gfx::Sprite{ test_case.format, indices, size, size,
+                    std::span<const RGB565>{ palette }.first(test_case.format == gfx::SpriteFormat::Indexed4 ? 16u : 256u),
+                    test_case.keyed ? std::optional<std::uint8_t>{ 0u } : std::nullopt } };
+            test::Canvas<RGB565> fast{ screen_width, screen_height };
+            test::Canvas<RGB565> slow{ screen_width, screen_height };
+            std::size_t draw{ 0 };
+            const auto position{ [&](std::size_t i)
+                {
+                    return std::pair{ static_cast<std::int32_t>(i * 7u % (screen_width - size)),
+                        static_cast<std::int32_t>(i * 13u % (screen_height - size)) };
+                } };
+            // Both draw the same frames, or the comparison means nothing
+            for (std::size_t i{ 0 }; i < 64u; ++i)
+            {
+                const auto [x, y]{ position(i) };
+                const gfx::Flip flip{ (i & 1u) != 0u ? gfx::Flip::Horizontal : gfx::Flip::None };
+                draw_sprite_per_pixel(slow, sprite, x, y, flip);
+                gfx::draw_sprite(fast, sprite, x, y, { .flip = flip });
+            }
+            if (!(fast == slow))
+            {
+                std::printf("%zux%zu %s: draw_sprite differs from drawing per pixel\n", size, size, test_case.name);
+                return 1;
+            }
+            const double per_pixel{ test::calls_per_second([&]()
+                {
+                    const auto [x, y]{ position(draw) };
+                    draw_sprite_per_pixel(slow, sprite, x, y, (draw++ & 1u) != 0u ? gfx::Flip::Horizontal : gfx::Flip::None);
+                }) };
+            draw = 0;
+            const double blitted{ test::calls_per_second([&]()
+                {
+                    const auto [x, y]{ position(draw) };
+                    gfx::draw_sprite(fast, sprite, x, y,
+                        { .flip = (draw++ & 1u) != 0u ? gfx::Flip::Horizontal : gfx::Flip::None });
+                }) };
+            char name[32];
+            std::snprintf(name, sizeof(name), "%zux%zu %s", size, size, test_case.name);
+            std::printf("%-22s %12.0f %12.0f\n", name, per_pixel / 60.0, blitted / 60.0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "canvas.h"
+#include "program_layout.h"
+#include "ram_disk.h"
+#include "test.h"
+#include "gfx/sprite.h"
+
+namespace
+{
+using gfx::Sprite;
+
+// What a sprite loaded from SD may hold, as sprite.cpp works it out
+constexpr std::uint64_t max_pixels{ piconsole_program_ram_size / 2u / sizeof(RGB565) };
+
+void append_big_endian(std::vector<std::uint8_t>& bytes, std::uint32_t value, std::size_t size)
+{
+    for (std::size_t i{ size }; i-- > 0;)
+    {
+        bytes.push_back(static_cast<std::uint8_t>(value >> (i * 8u)));
+    }
+}
+
+// A PICOSPRITE file claiming to be width x height, holding `pixel_count` pixels of i * 0x0101
+std::vector<std::uint8_t> make_sprite_file(std::uint32_t width, std::uint32_t height, std::size_t pixel_count)
+{
+    std::vector<std::uint8_t> bytes{ Sprite::file_magic.begin(), Sprite::file_magic.end() };
+    bytes.push_back('O');
+    append_big_endian(bytes, 0u, 2u);
+    append_big_endian(bytes, height, 4u);
+    append_big_endian(bytes, width, 4u);
+    for (std::size_t i{ 0 }; i < pixel_count; ++i)
+    {
+        const std::uint16_t pixel{ static_cast<std::uint16_t>(i * 0x0101u) };
+        bytes.insert(bytes.end(), reinterpret_cast<const std::uint8_t*>(&pixel),
+            reinterpret_cast<const std::uint8_t*>(&pixel) + sizeof(pixel));
+    }
+    return bytes;
+}
+
+// A QOI file claiming to be width x height, holding `pixel_count` pixels of r = i, g = 2i, b = 3i as QOI_OP_RGB
+std::vector<std::uint8_t> make_qoi_file(std::uint32_t width, std::uint32_t height, std::size_t pixel_count)
+{
+    std::vector<std::uint8_t> bytes{ 'q', 'o', 'i', 'f' };
+    append_big_endian(bytes, width, 4u);
+    append_big_endian(bytes, height, 4u);
+    bytes.push_back(3u);
+    bytes.push_back(0u);
+    for (std::size_t i{ 0 }; i < pixel_count; ++i)
+    {
+        bytes.insert(bytes.end(), { 0xFEu, static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i * 2u),
+            static_cast<std::uint8_t>(i * 3u) });
+    }
+    bytes.insert(bytes.end(), { 0u, 0u, 0u, 0u, 0u, 0u, 0u, 1u });
+    return bytes;
+}
+
+void check_loads()
+{
+    CHECK(test::write_file("sprite.bin", make_sprite_file(5u, 3u, 15u)));
+    Sprite sprite;
+    CHECK(sprite.load("sprite.bin"));
+    CHECK(sprite.get_width() == 5u && sprite.get_height() == 3u);
+    test::Canvas<RGB565> canvas{ 8u, 8u };
+    gfx::draw_sprite(canvas, sprite, 1, 2);
+    for (std::size_t i{ 0 }; i < 15u; ++i)
+    {
+        CHECK(canvas.get_pixel(1u + i % 5u, 2u + i / 5u).data == static_cast<std::uint16_t>(i * 0x0101u));
+    }
+
+    CHECK(test::write_file("sprite.qoi", make_qoi_file(4u, 2u, 8u)));
+    Sprite qoi_sprite;
+    CHECK(qoi_sprite.load_qoi("sprite.qoi"));
+    CHECK(qoi_sprite.get_width() == 4u && qoi_sprite.get_height() == 2u);
+    canvas.fill(RGB565{});
+    gfx::draw_sprite(canvas, qoi_sprite, 0, 0);
+    for (std::size_t i{ 0 }; i < 8u; ++i)
+    {
+        const RGB565 expected{ static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i * 2u), static_cast<std::uint8_t>(i * 3u) };
+        CHECK(canvas.get_pixel(i % 4u, i / 4u).data == expected.data);
+    }
+
+    // As big as the limit allows, however it's split
+    const std::uint32_t limit_width{ 256u };
+    const std::uint32_t limit_height{ static_cast<std::uint32_t>(max_pixels / limit_width) };
+    CHECK(test::write_file("limit.bin", make_sprite_file(limit_width, limit_height, limit_width * limit_height)));
+    Sprite limit_sprite;
+    CHECK(limit_sprite.load("limit.bin"));
+    CHECK(limit_sprite.get_width() == limit_width && limit_sprite.get_height() == limit_height);
+}
+
+// Sizes whose pixels wouldn't fit in program RAM, some of which wrap a 32 bit size_t once multiplied out; loading
+//   one fails before allocating, and leaves the sprite as it was
+void check_rejects_oversized()
+{
+    const std::uint32_t sizes[][2]{
+        // 46341² pixels are 0x1'0000'D362 bytes, which wraps to 53 KB
+        { 46'341u, 46'341u },
+        { UINT16_MAX, UINT16_MAX },
+        { 32'768u, 32'768u },
+        { 1u, static_cast<std::uint32_t>(max_pixels + 1u) },
+        { 256u, static_cast<std::uint32_t>(max_pixels / 256u + 1u) },
+        // Too wide for a sprite at all
+        { 65'536u, 1u },
+    };
+    for (const auto& [width, height] : sizes)
+    {
+        Sprite sprite;
+        CHECK(test::write_file("sprite.bin", make_sprite_file(5u, 3u, 15u)));
+        CHECK(sprite.load("sprite.bin"));
+
+        // Enough pixels after the header for a wrapped allocation to be filled and then read past
+        CHECK(test::write_file("huge.bin", make_sprite_file(width, height, 30'000u)));
+        CHECK(!sprite.load("huge.bin"));
+        CHECK(sprite.get_width() == 5u && sprite.get_height() == 3u);
+
+        CHECK(test::write_file("huge.qoi", make_qoi_file(width, height, 30'000u)));
+        CHECK(!sprite.load_qoi("huge.qoi"));
+        CHECK(sprite.get_width() == 5u && sprite.get_height() == 3u);
+    }
+}
+}
+
+int main()
+{
+    if (!test::mount_ram_disk())
+    {
+        std::printf("sprite_test: couldn't mount the RAM disk\n");
+        return 1;
+    }
+    check_loads();
+    check_rejects_oversized();
+    return test::finish("sprite_test");
+}
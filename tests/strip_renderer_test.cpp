@@ -0,0 +1,257 @@
+// Renders the same DisplayLists through a StripRenderer, strip by strip, and straight into a full framebuffer the way
+//   ColorLCD draws them, and checks the bytes sent to the panel match the framebuffer exactly
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "gfx/color.h"
+#include "gfx/display_list.h"
+#include "gfx/strip_renderer.h"
+#include "gfx/text.h"
+#include "canvas.h"
+#include "test.h"
+
+namespace
+{
+// A 160x128 framebuffer with ColorLCD's drawing calls, built the same way on top of its lines and rows, and the part
+//   of the LCD a StripRenderer sends through, which keeps every byte written to the panel and scrolls like
+//   PicoLCD_1_8
+class FramebufferLCD
+{
+public:
+    using ColorFormat = RGB565;
+    constexpr static std::size_t width{ 160 };
+    constexpr static std::size_t height{ 128 };
+    using TextSettings = gfx::text::PrintSettings<FramebufferLCD>;
+    using TextLayout = gfx::text::TextLayout<FramebufferLCD, gfx::text::get_max_text_lines<height>()>;
+
+    std::size_t get_width() const { return width; }
+    std::size_t get_height() const { return height; }
+    std::span<RGB565> get_row(std::size_t y) { return canvas.get_row(y); }
+    void set_pixel(RGB565 color, std::size_t x, std::size_t y) { canvas.set_pixel(color, x, y); }
+    void line_horizontal(RGB565 color, std::size_t x, std::size_t y, std::size_t line_width)
+    {
+        canvas.line_horizontal(color, x, y, line_width);
+    }
+    void fill(RGB565 color) { canvas.fill(color); }
+    void mark_dirty(std::size_t, std::size_t, std::size_t, std::size_t) {}
+
+    // As ColorLCD draws them
+    void line_vertical(RGB565 color, std::size_t x, std::size_t y, std::size_t line_height)
+    {
+        for (std::size_t row{ y }; row < y + line_height; ++row)
+        {
+            set_pixel(color, x, row);
+        }
+    }
+    void rectangle(RGB565 color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        line_horizontal(color, x, y, rectangle_width);
+        if (rectangle_height <= 1)
+        {
+            return;
+        }
+        line_horizontal(color, x, y + rectangle_height - 1, rectangle_width);
+        if (rectangle_height <= 2)
+        {
+            return;
+        }
+        line_vertical(color, x, y + 1, rectangle_height - 2);
+        if (rectangle_width > 1)
+        {
+            line_vertical(color, x + rectangle_width - 1, y + 1, rectangle_height - 2);
+        }
+    }
+    void filled_rectangle(RGB565 color, std::size_t x, std::size_t y, std::size_t rectangle_width, std::size_t rectangle_height)
+    {
+        if (x >= width || y >= height)
+        {
+            return;
+        }
+        for (std::size_t row{ y }; row < std::min(y + rectangle_height, height); ++row)
+        {
+            line_horizontal(color, x, row, std::min(rectangle_width, width - x));
+        }
+    }
+    void text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_text<FramebufferLCD>(*this, string, settings);
+    }
+    void centered_text(std::string_view string, TextSettings settings = {})
+    {
+        gfx::text::print_centered_text<FramebufferLCD>(*this, string, settings);
+    }
+    void text(const TextLayout& layout)
+    {
+        layout.render(*this);
+    }
+    void blit(std::span<const RGB565> source, std::size_t x, std::size_t y, std::size_t source_width, std::size_t source_height)
+    {
+        if (x >= width || y >= height)
+        {
+            return;
+        }
+        for (std::size_t row{ 0 }; row < std::min(source_height, height - y); ++row)
+        {
+            std::copy_n(source.begin() + row * source_width, std::min(source_width, width - x), get_row(y + row).begin() + x);
+        }
+    }
+    void sprite(const gfx::Sprite& sprite, std::int32_t x, std::int32_t y, const gfx::SpriteBlit& blit = {})
+    {
+        gfx::draw_sprite(*this, sprite, x, y, blit);
+    }
+
+    // What StripRenderer drives
+    void wait_present() const {}
+    void begin_write_window(const gfx::Rect& window)
+    {
+        CHECK(window == (gfx::Rect{ .width = width, .height = height }));
+        sent.clear();
+    }
+    void write_data_async(std::span<const std::uint8_t> data)
+    {
+        sent.insert(sent.end(), data.begin(), data.end());
+    }
+    void set_scroll_offset(std::size_t offset) { scroll_offset = offset % width; }
+    std::size_t get_scroll_offset() const { return scroll_offset; }
+    void apply_scroll_offset() { panel_scroll_offset = scroll_offset; }
+
+    test::Canvas<RGB565> canvas{ width, height };
+    std::vector<std::uint8_t> sent;
+    std::size_t scroll_offset{ 0 };
+    std::size_t panel_scroll_offset{ 0 };
+};
+
+using DisplayList = gfx::DisplayList<FramebufferLCD>;
+
+// With the panel scrolled, what it shows from the left edge starts at buffer column `scroll_offset`
+template <std::size_t TStripRows>
+void check_strips_match(const char* name, const DisplayList& display_list, std::size_t scroll_offset)
+{
+    FramebufferLCD lcd;
+    // The strip renderer clears each strip first, which the framebuffer has to be told to do
+    lcd.fill(color::black<RGB565>());
+    display_list.render(lcd);
+    lcd.set_scroll_offset(scroll_offset);
+    gfx::StripRenderer<FramebufferLCD, TStripRows> renderer;
+    renderer.render(lcd, display_list);
+    CHECK(lcd.panel_scroll_offset == scroll_offset);
+    CHECK(lcd.sent.size() == lcd.canvas.pixels.size() * sizeof(RGB565));
+    if (lcd.sent.size() != lcd.canvas.pixels.size() * sizeof(RGB565))
+    {
+        return;
+    }
+    for (std::size_t y{ 0 }; y < FramebufferLCD::height; ++y)
+    {
+        for (std::size_t x{ 0 }; x < FramebufferLCD::width; ++x)
+        {
+            const std::size_t buffer_x{ (x + scroll_offset) % FramebufferLCD::width };
+            RGB565 shown;
+            std::memcpy(&shown, lcd.sent.data() + (y * FramebufferLCD::width + buffer_x) * sizeof(RGB565), sizeof(shown));
+            if (shown.data != lcd.canvas.get_pixel(x, y).data)
+            {
+                std::printf("%s with %zu row strips scrolled by %zu: pixel %zu, %zu differs from the framebuffer\n", name,
+                    TStripRows, scroll_offset, x, y);
+                CHECK(false);
+                return;
+            }
+        }
+    }
+}
+
+// Through strips that divide the screen's height evenly, and ones that leave a short strip at the bottom
+void check(const char* name, const DisplayList& display_list)
+{
+    check_strips_match<8>(name, display_list, 0);
+    check_strips_match<1>(name, display_list, 0);
+    check_strips_match<7>(name, display_list, 0);
+    check_strips_match<FramebufferLCD::height>(name, display_list, 0);
+    check_strips_match<8>(name, display_list, 37);
+    check_strips_match<7>(name, display_list, FramebufferLCD::width - 1);
+}
+
+// Text settings and non-default sprite blits each come from a pool of their own; once one runs out, commands that need
+//   it are refused without using up a command
+void check_pools()
+{
+    const std::vector<std::uint8_t> indices(4u, 0u);
+    const std::vector<RGB565> palette(256u);
+    const gfx::Sprite sprite{ gfx::SpriteFormat::Indexed8, indices, 2u, 2u, palette };
+    gfx::DisplayList<FramebufferLCD, 8, 2, 1> display_list;
+    CHECK(display_list.text("a") && display_list.centered_text("b"));
+    CHECK(!display_list.text("c"));
+    CHECK(display_list.sprite(sprite, 0, 0, { .flip = gfx::Flip::Horizontal }));
+    CHECK(!display_list.sprite(sprite, 0, 0, { .flip = gfx::Flip::Vertical }));
+    CHECK(display_list.sprite(sprite, 0, 0));
+    CHECK(display_list.size() == 4u);
+    CHECK(display_list.get_sprite_blit(display_list.get_commands()[2]).flip == gfx::Flip::Horizontal);
+    display_list.clear();
+    CHECK(display_list.text("d"));
+}
+}
+
+int main()
+{
+    std::vector<RGB565> pixels(24u * 20u);
+    for (std::size_t i{ 0 }; i < pixels.size(); ++i)
+    {
+        pixels[i] = RGB565{ static_cast<std::uint16_t>(i * 0x0731u) };
+    }
+    std::vector<std::uint8_t> indices(16u * 16u);
+    for (std::size_t i{ 0 }; i < indices.size(); ++i)
+    {
+        indices[i] = static_cast<std::uint8_t>((i * 7u) % 16u);
+    }
+    const std::vector<RGB565> palette(pixels.begin(), pixels.begin() + 16);
+    const gfx::Sprite sprite{ gfx::SpriteFormat::Indexed8, indices, 16u, 16u, palette, std::optional<std::uint8_t>{ 3u } };
+
+    DisplayList empty;
+    check("empty", empty);
+
+    // Shapes crossing strip boundaries, and ones entirely inside a strip
+    DisplayList shapes;
+    shapes.fill(color::dark_grey<RGB565>());
+    shapes.filled_rectangle(color::red<RGB565>(), 10, 5, 50, 37);
+    shapes.filled_rectangle(color::blue<RGB565>(), 100, 9, 3, 3);
+    shapes.rectangle(color::green<RGB565>(), 3, 60, 80, 30);
+    shapes.rectangle(color::white<RGB565>(), 0, 0, 160, 128);
+    shapes.rectangle(color::yellow<RGB565>(), 150, 70, 1, 1);
+    check("shapes", shapes);
+
+    // Text through the GlyphBlitter, wrapped, clipped and centered, with and without a background
+    DisplayList text;
+    text.filled_rectangle(color::blue<RGB565>(), 0, 20, 160, 50);
+    text.text("Hello strips\nwrapping along and along and along the screen", {
+        .wrap_mode = gfx::text::WrapMode::Wrap, .x = 4, .y = 30, .padding_x = 3,
+        .color = color::white<RGB565>(), .background = color::black<RGB565>() });
+    text.text("Clipped off the right edge of the screen", { .x = 90, .y = 3, .color = color::yellow<RGB565>() });
+    text.centered_text("Centered\non two lines", { .x = 80, .y = 100, .color = color::green<RGB565>() });
+    const FramebufferLCD::TextLayout layout{ "Laid out ahead", { .x = 20, .y = 118, .color = color::red<RGB565>() } };
+    text.text(layout);
+    check("text", text);
+
+    // Blits and sprites, hanging off the right and bottom edges too
+    DisplayList images;
+    images.fill(color::white<RGB565>());
+    images.blit(pixels, 30, 4, 24, 20);
+    images.blit(pixels, 140, 120, 24, 20);
+    images.sprite(sprite, 60, 50);
+    images.sprite(sprite, -5, 121, { .flip = gfx::Flip::Horizontal });
+    images.sprite(sprite, 150, -6, { .flip = gfx::Flip::Vertical });
+    check("images", images);
+
+    // Everything at once, in the order it was recorded
+    DisplayList mixed;
+    mixed.fill(color::dark_grey<RGB565>());
+    mixed.blit(pixels, 70, 60, 24, 20);
+    mixed.filled_rectangle(color::red<RGB565>(), 75, 65, 30, 30);
+    mixed.sprite(sprite, 80, 70);
+    mixed.text("On top", { .x = 78, .y = 72, .color = color::white<RGB565>() });
+    mixed.rectangle(color::green<RGB565>(), 69, 59, 40, 40);
+    check("mixed", mixed);
+    check_pools();
+    return test::finish("strip_renderer_test");
+}
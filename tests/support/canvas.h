@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace test
+{
+// Plain framebuffer in host memory, with the drawing calls gfx's templates expect of a target
+template <typename TColor>
+class Canvas
+{
+public:
+    Canvas(std::size_t width, std::size_t height, TColor background = {})
+        : width{ width }, height{ height }, pixels(width * height, background)
+    {}
+
+    std::size_t get_width() const { return width; }
+    std::size_t get_height() const { return height; }
+    void set_pixel(TColor color, std::size_t x, std::size_t y) { pixels[y * width + x] = color; }
+    void line_horizontal(TColor color, std::size_t x, std::size_t y, std::size_t length)
+    {
+        std::fill_n(pixels.begin() + static_cast<std::ptrdiff_t>(y * width + x), length, color);
+    }
+    std::span<TColor> get_row(std::size_t y) { return { pixels.data() + y * width, width }; }
+    TColor get_pixel(std::size_t x, std::size_t y) const { return pixels[y * width + x]; }
+    void fill(TColor color) { std::fill(pixels.begin(), pixels.end(), color); }
+    // Nothing to track: the whole canvas is always there to compare
+    void mark_dirty(std::size_t, std::size_t, std::size_t, std::size_t) {}
+
+    // Byte for byte, so it works for colors without an operator== of their own
+    bool operator==(const Canvas& other) const
+    {
+        return width == other.width && height == other.height
+            && std::memcmp(pixels.data(), other.pixels.data(), pixels.size() * sizeof(TColor)) == 0;
+    }
+
+    std::size_t width;
+    std::size_t height;
+    std::vector<TColor> pixels;
+};
+}
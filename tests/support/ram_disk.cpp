@@ -0,0 +1,107 @@
+#include "ram_disk.h"
+#include <cstring>
+#include "ff.h"
+#include "diskio.h"
+
+namespace
+{
+constexpr std::size_t sector_size{ FF_MAX_SS };
+
+std::vector<std::uint8_t> sectors;
+FATFS file_system;
+}
+
+extern "C"
+{
+DSTATUS disk_initialize(BYTE)
+{
+    return sectors.empty() ? STA_NOINIT : 0;
+}
+
+DSTATUS disk_status(BYTE)
+{
+    return sectors.empty() ? STA_NOINIT : 0;
+}
+
+DRESULT disk_read(BYTE, BYTE* buff, LBA_t sector, UINT count)
+{
+    if ((sector + count) * sector_size > sectors.size())
+    {
+        return RES_PARERR;
+    }
+    std::memcpy(buff, sectors.data() + sector * sector_size, count * sector_size);
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE, const BYTE* buff, LBA_t sector, UINT count)
+{
+    if ((sector + count) * sector_size > sectors.size())
+    {
+        return RES_PARERR;
+    }
+    std::memcpy(sectors.data() + sector * sector_size, buff, count * sector_size);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE, BYTE cmd, void* buff)
+{
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *static_cast<LBA_t*>(buff) = sectors.size() / sector_size;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *static_cast<DWORD*>(buff) = 1u;
+        return RES_OK;
+    }
+    return RES_PARERR;
+}
+
+DWORD get_fattime()
+{
+    // 2022-01-01 00:00:00, like FF_NORTC_YEAR
+    return static_cast<DWORD>(2022 - 1980) << 25 | 1u << 21 | 1u << 16;
+}
+}
+
+bool test::mount_ram_disk(std::uint32_t megabytes)
+{
+    f_mount(nullptr, "", 0);
+    sectors.assign(static_cast<std::size_t>(megabytes) << 20, 0u);
+    std::vector<std::uint8_t> work(FF_MAX_SS * 4);
+    const MKFS_PARM format{ .fmt = FM_ANY | FM_SFD };
+    return f_mkfs("", &format, work.data(), static_cast<UINT>(work.size())) == FR_OK
+        && f_mount(&file_system, "", 1) == FR_OK;
+}
+
+bool test::write_file(const char* path, std::span<const std::uint8_t> bytes)
+{
+    FIL file;
+    if (f_open(&file, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+    {
+        return false;
+    }
+    UINT written{ 0u };
+    const bool wrote{ f_write(&file, bytes.data(), static_cast<UINT>(bytes.size()), &written) == FR_OK
+        && written == bytes.size() };
+    return f_close(&file) == FR_OK && wrote;
+}
+
+std::vector<std::uint8_t> test::read_file(const char* path)
+{
+    FIL file;
+    if (f_open(&file, path, FA_READ) != FR_OK)
+    {
+        return {};
+    }
+    std::vector<std::uint8_t> bytes(f_size(&file));
+    UINT read{ 0u };
+    if (f_read(&file, bytes.data(), static_cast<UINT>(bytes.size()), &read) != FR_OK || read != bytes.size())
+    {
+        bytes.clear();
+    }
+    f_close(&file);
+    return bytes;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// FatFS itself, formatted onto a disk in host memory, so code reading and writing the SD card through ff.h runs
+//   unchanged in the host tests
+namespace test
+{
+// Formats a fresh `megabytes` disk and mounts it as the default drive, dropping whatever the last one held
+bool mount_ram_disk(std::uint32_t megabytes = 16u);
+// Writes `bytes` to `path`, replacing any file already there
+bool write_file(const char* path, std::span<const std::uint8_t> bytes);
+// The whole of the file at `path`, empty if it can't be read
+std::vector<std::uint8_t> read_file(const char* path);
+}
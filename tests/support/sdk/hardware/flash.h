@@ -0,0 +1,5 @@
+#pragma once
+// Stand-in for the Pico SDK's hardware/flash.h in the host tests: the RP2040's flash geometry, without the functions
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define FLASH_BLOCK_SIZE (1u << 16)
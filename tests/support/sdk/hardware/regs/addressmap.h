@@ -0,0 +1,4 @@
+#pragma once
+// Stand-in for the Pico SDK's hardware/regs/addressmap.h in the host tests: the RP2040's memory map
+#define XIP_BASE 0x10000000u
+#define SRAM_BASE 0x20000000u
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Just enough for the host tests: CHECK records a failure and carries on, so one run reports everything wrong, and
+//   main() returns finish() for CTest
+namespace test
+{
+inline int failures{ 0 };
+
+inline int finish(const char* name)
+{
+    if (failures != 0)
+    {
+        std::printf("%s: %d checks failed\n", name, failures);
+        return 1;
+    }
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// Small, fast and the same on every host, so failures reproduce
+class Random
+{
+public:
+    explicit Random(std::uint32_t seed) : state{ seed } {}
+
+    std::uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    // In [low, high]
+    std::int32_t range(std::int32_t low, std::int32_t high)
+    {
+        return low + static_cast<std::int32_t>(next() % static_cast<std::uint32_t>(high - low + 1));
+    }
+
+private:
+    std::uint32_t state;
+};
+
+// Microseconds on a monotonic clock, for benchmarks
+inline std::uint64_t now_us()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Calls `body` in batches until at least `min_us` have passed; returns calls per second
+template <typename TBody>
+double calls_per_second(TBody&& body, std::uint64_t min_us = 200'000)
+{
+    std::uint64_t calls{ 0 };
+    const std::uint64_t start{ now_us() };
+    std::uint64_t elapsed{ 0 };
+    for (std::uint64_t batch{ 1 }; elapsed < min_us; batch *= 2)
+    {
+        for (std::uint64_t i{ 0 }; i < batch; ++i)
+        {
+            body();
+        }
+        calls += batch;
+        elapsed = now_us() - start;
+    }
+    return static_cast<double>(calls) * 1e6 / static_cast<double>(elapsed);
+}
+}
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++test::failures; \
+        } \
+    } while (false)
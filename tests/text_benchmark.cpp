@@ -0,0 +1,235 @@
+// Host characters per second for print_text() through the GlyphBlitter, against print_text() as it was before the
+//   blitter: a bitset typeface drawn a pixel at a time through set_pixel(). Both draw the same text into a plain
+//   160x128 RGB565 framebuffer behind the same virtual drawing calls ColorLCD has.
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include "gfx/color.h"
+#include "gfx/region.h"
+#include "gfx/text.h"
+#include "gfx/typeface.h"
+#include "canvas.h"
+#include "test.h"
+
+namespace
+{
+// Only set_pixel() and filled_rectangle(), so text is drawn a pixel at a time. Both mark what they draw dirty the way
+//   ColorLCD does, which for set_pixel() means once a pixel.
+class PixelTarget
+{
+public:
+    using ColorFormat = RGB565;
+    constexpr static std::size_t width{ 160 };
+    constexpr static std::size_t height{ 128 };
+    using TextSettings = gfx::text::PrintSettings<PixelTarget>;
+
+    virtual ~PixelTarget() = default;
+
+    std::size_t get_width() const { return width; }
+    std::size_t get_height() const { return height; }
+    PICONSOLE_MEMBER_FUNC void set_pixel(RGB565 color, std::size_t x, std::size_t y)
+    {
+        mark_dirty(x, y, 1, 1);
+        canvas.set_pixel(color, x, y);
+    }
+    PICONSOLE_MEMBER_FUNC void filled_rectangle(RGB565 color, std::size_t x, std::size_t y, std::size_t rectangle_width,
+        std::size_t rectangle_height)
+    {
+        mark_dirty(x, y, rectangle_width, rectangle_height);
+        for (std::size_t row{ y }; row < std::min(y + rectangle_height, height); ++row)
+        {
+            canvas.line_horizontal(color, x, row, std::min(rectangle_width, width - x));
+        }
+    }
+    PICONSOLE_MEMBER_FUNC void mark_dirty(std::size_t x, std::size_t y, std::size_t rectangle_width,
+        std::size_t rectangle_height)
+    {
+        dirty_regions.add(gfx::Rect{
+            .x = static_cast<std::uint32_t>(x), .y = static_cast<std::uint32_t>(y),
+            .width = static_cast<std::uint32_t>(rectangle_width), .height = static_cast<std::uint32_t>(rectangle_height)
+        }.clipped(width, height));
+    }
+
+    test::Canvas<RGB565> canvas{ width, height };
+    gfx::DirtyRegions<8> dirty_regions;
+};
+
+// Hands out whole rows, so text goes through the GlyphBlitter
+class RowTarget : public PixelTarget
+{
+public:
+    using TextSettings = gfx::text::PrintSettings<RowTarget>;
+
+    GETTER PICONSOLE_MEMBER_FUNC std::span<RGB565> get_row(std::size_t y)
+    {
+        return y < height ? canvas.get_row(y) : std::span<RGB565>{};
+    }
+};
+
+// print_text() as it was before the GlyphBlitter, drawing the built in font as the bitset typeface it was stored as
+namespace before_blitter
+{
+using AsciiTypeface = Typeface<5>;
+
+const AsciiTypeface& get_ascii_typeface()
+{
+    static const AsciiTypeface typeface{
+        []()
+        {
+            const gfx::Font& font{ gfx::get_ascii_font() };
+            AsciiTypeface built{};
+            for (std::size_t character{ 0 }; character < built.size(); ++character)
+            {
+                const gfx::Glyph& glyph{ font.get_glyph(static_cast<char>(character)) };
+                for (std::size_t row{ 0 }; row < font.height; ++row)
+                {
+                    // Cells were 5 pixels wide with the spacing column left out
+                    built[character][row] = std::bitset<5>{ font.get_cell_row(glyph, row) >> 1u };
+                }
+            }
+            return built;
+        }()
+    };
+    return typeface;
+}
+
+template <typename TTarget>
+void print_text(TTarget& lcd, std::string_view string, gfx::text::PrintSettings<TTarget> settings)
+{
+    const AsciiTypeface& typeface{ get_ascii_typeface() };
+    const std::uint32_t character_width{ get_typeface_character_width<AsciiTypeface>() + 1u };
+    const std::uint32_t character_height{ get_typeface_character_height<AsciiTypeface>() + 1u };
+    if (settings.background.has_value())
+    {
+        std::size_t line_count{ 1 };
+        std::size_t longest_line_length{ 0 };
+        for (std::size_t line_length{ 0 }; const char character : string)
+        {
+            line_length = character == '\n' ? 0 : line_length + 1;
+            line_count += character == '\n' ? 1 : 0;
+            longest_line_length = std::max(longest_line_length, line_length);
+        }
+        lcd.filled_rectangle(settings.background.value(), settings.x, settings.y,
+            settings.padding_x * 2u + longest_line_length * character_width - 1u,
+            settings.padding_y.value_or(settings.padding_x) * 2u
+                + line_count * (character_height - 1u + (line_count > 1u ? 1u : 0u)));
+    }
+    while (!string.empty()
+        && (settings.y + settings.padding_y.value_or(settings.padding_x))
+            < (settings.end_y - settings.padding_y.value_or(settings.padding_x))
+        )
+    {
+        const std::uint32_t max_line_width_px{ (settings.end_x - settings.padding_x) - (settings.x + settings.padding_x) };
+        const std::size_t newline_index{ string.find('\n') };
+        const std::uint32_t line_width_characters{
+            std::min<std::uint32_t>(
+                std::min<std::uint32_t>(max_line_width_px / character_width, string.length()),
+                newline_index
+            )
+        };
+        const bool has_newline{ newline_index != std::string_view::npos };
+        const std::uint32_t line_width_px{ std::min<std::uint32_t>(line_width_characters * character_width, max_line_width_px) };
+        const std::string_view line{ string.substr(0, line_width_characters) };
+        lcd.mark_dirty(settings.x + settings.padding_x, settings.y, line_width_px, character_height);
+        gfx::text::print_string<TTarget>(lcd, line, typeface, settings);
+        if (settings.wrap_mode == gfx::text::WrapMode::Clip && !has_newline)
+        {
+            return;
+        }
+        string = string.substr(line_width_characters + (has_newline ? 1u : 0u));
+        settings.y += character_height;
+        settings.x = settings.wrap_x;
+    }
+}
+}
+
+// Every line fits on screen: before the blitter, text running past the edge was carried on to the next line one
+//   character short, even when clipping, so only text that fits draws the same both ways
+constexpr std::string_view sample{
+    "The quick brown fox\n"
+    "jumps over the lazy dog\n"
+    "0123456789 PACK MY BOX\n"
+    "WITH FIVE DOZEN liquor\n"
+    "jugs! ()[]{}<>?\tend"
+};
+
+struct Case
+{
+    const char* name;
+    bool opaque;
+    std::uint32_t x;
+};
+
+constexpr Case cases[]{
+    { "transparent", false, 3u },
+    { "opaque", true, 3u },
+    // Glyphs starting on odd pixels, so the blitter's pairs straddle words
+    { "transparent odd x", false, 4u },
+    { "opaque odd x", true, 4u },
+};
+
+constexpr RGB565 background_color{ 0x10u, 0x20u, 0x60u };
+
+// No vertical padding: before the blitter, text ignored it and always started at settings.y
+template <typename TTarget>
+typename TTarget::TextSettings get_settings(const Case& test_case)
+{
+    return { .x = test_case.x, .y = 5u, .wrap_x = 3u, .padding_x = 1u,
+        .padding_y = 0u, .color = RGB565{ 0xFFu, 0xD0u, 0x40u },
+        .background = test_case.opaque ? std::optional<RGB565>{ background_color } : std::nullopt };
+}
+
+// One frame's worth: the dirty regions start out empty, as they do after each present()
+template <typename TTarget>
+void draw_before_blitter(TTarget& target, const Case& test_case)
+{
+    target.dirty_regions.clear();
+    before_blitter::print_text<TTarget>(target, sample, get_settings<TTarget>(test_case));
+}
+template <typename TTarget>
+void draw(TTarget& target, const Case& test_case)
+{
+    target.dirty_regions.clear();
+    gfx::text::print_text<TTarget>(target, sample, get_settings<TTarget>(test_case));
+}
+// Drawing alone, without laying the text out each time
+template <typename TTarget>
+void draw(TTarget& target, const gfx::text::TextLayout<TTarget>& layout)
+{
+    target.dirty_regions.clear();
+    layout.render(target);
+}
+}
+
+int main()
+{
+    std::printf("%-18s %22s %15s %15s\n", "Mchars per second", "before the blitter", "print_text()", "TextLayout");
+    for (const Case& test_case : cases)
+    {
+        PixelTarget before;
+        RowTarget blitted;
+        // Before the blitter, the background also covered the spacing row under the last line. Starting both from
+        //   the background color leaves that the only difference.
+        if (test_case.opaque)
+        {
+            before.canvas.fill(background_color);
+            blitted.canvas.fill(background_color);
+        }
+        // Both draw the same text, or the comparison means nothing
+        draw_before_blitter(before, test_case);
+        draw(blitted, test_case);
+        if (!(before.canvas == blitted.canvas))
+        {
+            std::printf("%s: the blitter draws different pixels to print_text() before it\n", test_case.name);
+            return 1;
+        }
+        const gfx::text::TextLayout<RowTarget> blitted_layout{ sample, get_settings<RowTarget>(test_case) };
+        const double characters{ static_cast<double>(sample.size()) / 1e6 };
+        std::printf("%-18s %22.2f %15.2f %15.2f\n", test_case.name,
+            test::calls_per_second([&]() { draw_before_blitter(before, test_case); }) * characters,
+            test::calls_per_second([&]() { draw(blitted, test_case); }) * characters,
+            test::calls_per_second([&]() { draw(blitted, blitted_layout); }) * characters);
+    }
+    return 0;
+}
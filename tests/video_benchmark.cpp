@@ -0,0 +1,207 @@
+// Host frames per second for PVID videos encoded by tools/video_encoder.py (see video_cases.py), decoded into a
+//   160x128 framebuffer with pvid::decode_frame() as VideoPlayer does. Every decoded frame is first checked against
+//   the frames the encoder was given. "decode fps" is decoding alone, from chunks already in memory; "read+decode fps"
+//   also reads each chunk with SDCard::FileReader, as VideoPlayer::read_chunk() does, through FatFS on a RAM disk.
+//   A RAM disk reads far faster than a real SD card, so the read cost here is mostly FatFS's own; on the device the
+//   SD bus adds to it, as VideoPlayer::Stats reports.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+#include "gfx/color.h"
+#include "pvid.h"
+#include "interfaces/SD.h"
+#include "canvas.h"
+#include "ram_disk.h"
+#include "test.h"
+
+namespace
+{
+constexpr std::size_t screen_width{ 160 };
+constexpr std::size_t screen_height{ 128 };
+
+struct Video
+{
+    std::string name;
+    pvid::FileHeader header;
+    std::vector<std::uint8_t> file;
+    // Each frame's video operations within `file`
+    std::vector<std::span<const std::uint8_t>> frames;
+    std::size_t total_chunk_size{ 0 };
+    std::size_t max_chunk_size{ 0 };
+};
+
+std::vector<std::uint8_t> read_host_file(const std::string& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    return { std::istreambuf_iterator<char>{ file }, {} };
+}
+
+// Walks the chain of chunks the way VideoPlayer reads them; false if the file isn't a well formed PVID
+bool parse(Video& video)
+{
+    const std::vector<std::uint8_t>& file{ video.file };
+    if (file.size() < sizeof(pvid::FileHeader))
+    {
+        return false;
+    }
+    std::memcpy(&video.header, file.data(), sizeof(pvid::FileHeader));
+    const pvid::FileHeader& header{ video.header };
+    if (header.magic != pvid::file_magic || header.version != pvid::file_version
+        || header.width > screen_width || header.height > screen_height)
+    {
+        return false;
+    }
+    std::size_t offset{ header.data_offset };
+    std::uint32_t chunk_size{ header.first_chunk_size };
+    for (std::uint32_t frame{ 0u }; frame < header.frame_count; ++frame)
+    {
+        if (chunk_size < sizeof(pvid::ChunkHeader) || offset + chunk_size > file.size())
+        {
+            return false;
+        }
+        pvid::ChunkHeader chunk;
+        std::memcpy(&chunk, file.data() + offset, sizeof(chunk));
+        const std::size_t audio_size{ static_cast<std::size_t>(chunk.audio_frames) * header.audio_channels * 2u };
+        if (sizeof(chunk) + audio_size + chunk.video_size > chunk_size)
+        {
+            return false;
+        }
+        video.frames.push_back({ file.data() + offset + sizeof(chunk) + audio_size, chunk.video_size });
+        video.total_chunk_size += chunk_size;
+        video.max_chunk_size = std::max<std::size_t>(video.max_chunk_size, chunk_size);
+        offset += chunk_size;
+        chunk_size = chunk.next_chunk_size;
+    }
+    return chunk_size == 0u;
+}
+
+// Decodes every frame in order, as the player does, and compares the frame's area of the screen with `raw`
+bool check_frames(const Video& video, const std::vector<std::uint8_t>& raw)
+{
+    const std::size_t width{ video.header.width };
+    const std::size_t height{ video.header.height };
+    const std::size_t x{ (screen_width - width) / 2u };
+    const std::size_t y{ (screen_height - height) / 2u };
+    if (raw.size() != video.frames.size() * width * height * sizeof(RGB565))
+    {
+        std::printf("%s: %zu bytes of raw frames for %zu frames\n", video.name.c_str(), raw.size(), video.frames.size());
+        return false;
+    }
+    test::Canvas<RGB565> canvas{ screen_width, screen_height };
+    for (std::size_t frame{ 0 }; frame < video.frames.size(); ++frame)
+    {
+        if (!pvid::decode_frame(canvas, x, y, width, height, video.frames[frame]))
+        {
+            std::printf("%s: frame %zu failed to decode\n", video.name.c_str(), frame);
+            return false;
+        }
+        const std::uint8_t* expected{ raw.data() + frame * width * height * sizeof(RGB565) };
+        for (std::size_t row{ 0 }; row < height; ++row)
+        {
+            if (std::memcmp(canvas.get_row(y + row).data() + x, expected + row * width * sizeof(RGB565),
+                width * sizeof(RGB565)) != 0)
+            {
+                std::printf("%s: row %zu of frame %zu decoded wrong\n", video.name.c_str(), row, frame);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Reads the chunks of the video on the RAM disk at `path` one at a time into `chunk_buffer`, decoding each as it
+//   arrives, as VideoPlayer plays it
+bool read_and_decode(const Video& video, const char* path, std::vector<std::uint8_t>& chunk_buffer,
+    test::Canvas<RGB565>& canvas, std::size_t x, std::size_t y)
+{
+    SDCard::FileReader reader{ path };
+    if (!reader.is_valid())
+    {
+        return false;
+    }
+    reader.seek_absolute(video.header.data_offset);
+    std::uint32_t chunk_size{ video.header.first_chunk_size };
+    for (std::uint32_t frame{ 0u }; frame < video.header.frame_count; ++frame)
+    {
+        if (!reader.read_bytes(std::span<std::uint8_t>{ chunk_buffer.data(), chunk_size }))
+        {
+            return false;
+        }
+        pvid::ChunkHeader chunk;
+        std::memcpy(&chunk, chunk_buffer.data(), sizeof(chunk));
+        const std::size_t audio_size{ static_cast<std::size_t>(chunk.audio_frames) * video.header.audio_channels * 2u };
+        pvid::decode_frame(canvas, x, y, video.header.width, video.header.height,
+            std::span<const std::uint8_t>{ chunk_buffer.data() + sizeof(chunk) + audio_size, chunk.video_size });
+        chunk_size = chunk.next_chunk_size;
+    }
+    return true;
+}
+}
+
+int main()
+{
+    if (!test::mount_ram_disk())
+    {
+        std::printf("Couldn't mount the RAM disk\n");
+        return 1;
+    }
+    std::ifstream list{ VIDEO_CASES_FILE };
+    std::string video_path;
+    std::string raw_path;
+    std::printf("%-22s %8s %7s %14s %14s %14s %16s\n", "video", "size", "frames", "chunk KB avg", "chunk KB max",
+        "decode fps", "read+decode fps");
+    while (list >> video_path >> raw_path)
+    {
+        Video video{ .name = video_path.substr(video_path.find_last_of('/') + 1), .header = {},
+            .file = read_host_file(video_path), .frames = {} };
+        if (!parse(video))
+        {
+            std::printf("%s: not a well formed PVID file\n", video.name.c_str());
+            return 1;
+        }
+        if (!check_frames(video, read_host_file(raw_path)))
+        {
+            return 1;
+        }
+        if (!test::write_file("video.pvid", video.file))
+        {
+            std::printf("%s: couldn't write the video to the RAM disk\n", video.name.c_str());
+            return 1;
+        }
+        const std::size_t x{ (screen_width - video.header.width) / 2u };
+        const std::size_t y{ (screen_height - video.header.height) / 2u };
+        test::Canvas<RGB565> canvas{ screen_width, screen_height };
+        const double videos_per_second{ test::calls_per_second([&]()
+            {
+                for (const std::span<const std::uint8_t> frame : video.frames)
+                {
+                    pvid::decode_frame(canvas, x, y, video.header.width, video.header.height, frame);
+                }
+            }) };
+        // Read back, the video ends on the same frame the in memory decode did
+        std::vector<std::uint8_t> chunk_buffer(video.max_chunk_size);
+        test::Canvas<RGB565> read_canvas{ screen_width, screen_height };
+        if (!read_and_decode(video, "video.pvid", chunk_buffer, read_canvas, x, y) || !(read_canvas == canvas))
+        {
+            std::printf("%s: couldn't read the video back from the RAM disk\n", video.name.c_str());
+            return 1;
+        }
+        const double read_videos_per_second{ test::calls_per_second([&]()
+            {
+                read_and_decode(video, "video.pvid", chunk_buffer, read_canvas, x, y);
+            }) };
+        char size[16];
+        std::snprintf(size, sizeof(size), "%ux%u", video.header.width, video.header.height);
+        const double frame_count{ static_cast<double>(video.frames.size()) };
+        std::printf("%-22s %8s %7zu %14.1f %14.1f %14.0f %16.0f\n", video.name.c_str(), size, video.frames.size(),
+            static_cast<double>(video.total_chunk_size) / frame_count / 1024.0,
+            static_cast<double>(video.max_chunk_size) / 1024.0, videos_per_second * frame_count,
+            read_videos_per_second * frame_count);
+    }
+    return 0;
+}
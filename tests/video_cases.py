@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Writes PVID videos encoded by tools/video_encoder.py, for video_benchmark to decode.
+
+Each video comes with its frames as the encoder was given them, in the framebuffer's RGB565 layout, so the benchmark
+can check every decoded frame before timing anything. The cases file lists one video per line: the PVID file and its
+raw frames, both in the output directory.
+
+Example:
+    video_cases.py build/tests/video_cases
+"""
+import math
+import random
+import struct
+import sys
+from pathlib import Path
+
+# Run from the build, so leave no bytecode behind in the source tree
+sys.dont_write_bytecode = True
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "tools"))
+import video_encoder  # noqa: E402
+
+FRAME_COUNT = 30
+FPS = 30
+KEYFRAME_INTERVAL = 10
+
+
+def make_frames(width, height, color_at):
+    return [[video_encoder.to_rgb565(color_at(x, y, number) + (255,)) for y in range(height) for x in range(width)]
+        for number in range(FRAME_COUNT)]
+
+
+def make_cases():
+    rng = random.Random(20)
+    width, height = video_encoder.SCREEN_SIZE
+
+    def sprite(x, y, number):
+        # A 16x16 square moving over a still background: small deltas, like most of a cutscene
+        sprite_x, sprite_y = number * 4 % (width - 16), number * 3 % (height - 16)
+        if sprite_x <= x < sprite_x + 16 and sprite_y <= y < sprite_y + 16:
+            return (255, 255, 0)
+        return (x * 255 // width, y * 255 // height, 64)
+
+    def flat(x, y, number):
+        # Big blocks of flat color that change every frame, like a cartoon: mostly fills
+        return ((x // 40 + number) * 60 % 256, (y // 32 + number) * 80 % 256, 128)
+
+    def pan(x, y, number):
+        # A detailed picture scrolling sideways, changing every pixel: mostly literals
+        return ((x + number * 2) * 3 % 256, (y * 5 + x + number * 2) % 256, ((x + number * 2) ^ y) % 256)
+
+    noise_frames = [[video_encoder.to_rgb565((rng.randrange(256), rng.randrange(256), rng.randrange(256), 255))
+        for _ in range(width * height)] for _ in range(FRAME_COUNT)]
+    # 22 kHz mono, which every chunk carries a frame's worth of
+    tone = b"".join(struct.pack("<h", int(8000 * math.sin(i * 0.05))) for i in range(22050 * FRAME_COUNT // FPS))
+    return {
+        "sprite": (make_frames(width, height, sprite), (width, height), None),
+        "flat": (make_frames(width, height, flat), (width, height), None),
+        "pan": (make_frames(width, height, pan), (width, height), None),
+        # Nothing repeats, so every pixel is a literal in every frame
+        "noise": (noise_frames, (width, height), None),
+        # Smaller than the screen, so it's drawn centered, and with sound to skip over
+        "small_with_sound": (make_frames(96, 72, pan), (96, 72), (tone, 1, 22050)),
+    }
+
+
+def main():
+    out_dir = Path(sys.argv[1])
+    out_dir.mkdir(parents=True, exist_ok=True)
+    lines = []
+    for name, (frames, size, audio) in make_cases().items():
+        video, _ = video_encoder.encode(frames, size, FPS, KEYFRAME_INTERVAL, audio, 40)
+        video_path = out_dir / f"{name}.pvid"
+        video_path.write_bytes(video)
+        raw_path = out_dir / f"{name}.raw"
+        raw_path.write_bytes(b"".join(struct.pack(f"<{len(frame)}H", *frame) for frame in frames))
+        lines.append(f"{video_path} {raw_path}\n")
+    (out_dir / "cases.txt").write_text("".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+"""Compiles BDF fonts or PNG font sheets into the packed gfx::Font format (see os/inc/gfx/font.h).
+
+The output is either a C++ header with the font as constexpr data or a binary blob that Font::from_blob() can use
+in place, e.g. straight out of flash or a file on the SD card.
+
+Examples:
+    font_compiler.py os/src/gfx/fonts/ascii_5px.bdf --name ascii_5px -o os/inc/gfx/fonts/ascii_5px.h
+    font_compiler.py sheet.png --cell 8x8 --sheet-first 32 --name big -o big.h
+    font_compiler.py sheet.png --cell 8x8 --sheet-first 32 --format blob -o big.pfnt
+"""
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+import png_reader
+
+BLOB_MAGIC = b"PFNT"
+BLOB_VERSION = 1
+MAX_GLYPH_WIDTH = 8
+# Glyph advances are streamed through a 32 bit accumulator
+MAX_ADVANCE = 24
+
+
+class FontError(Exception):
+    pass
+
+
+class Glyph:
+    def __init__(self, rows, width, advance, bearing):
+        # One int per font row, leftmost pixel in the highest of `width` bits
+        self.rows = rows
+        self.width = width
+        self.advance = advance
+        self.bearing = bearing
+
+
+def trim(bitmap, origin_x, advance, height, codepoint):
+    """Trims blank columns off a glyph given as rows of 0/1 lists and returns its Glyph."""
+    columns = [x for x in range(len(bitmap[0]) if bitmap else 0) if any(row[x] for row in bitmap)]
+    if not columns:
+        return Glyph([], 0, advance, 0)
+    left, right = columns[0], columns[-1] + 1
+    width = right - left
+    if width > MAX_GLYPH_WIDTH:
+        raise FontError(f"glyph {codepoint} is {width} pixels wide; at most {MAX_GLYPH_WIDTH} are supported")
+    bearing = origin_x + left
+    if bearing < 0:
+        raise FontError(f"glyph {codepoint} starts left of its origin, which isn't supported")
+    advance = max(advance, bearing + width)
+    if advance > MAX_ADVANCE:
+        raise FontError(f"glyph {codepoint} advances {advance} pixels; at most {MAX_ADVANCE} are supported")
+    rows = []
+    for row in bitmap:
+        value = 0
+        for x in range(left, right):
+            value = value << 1 | (1 if row[x] else 0)
+        rows.append(value)
+    rows += [0] * (height - len(rows))
+    return Glyph(rows, width, advance, bearing)
+
+
+def read_bdf(path):
+    """Returns (height, {codepoint: Glyph}) for a BDF font."""
+    lines = iter(Path(path).read_text(encoding="latin-1").splitlines())
+    ascent = descent = None
+    bounding_box = None
+    glyphs = {}
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "FONTBOUNDINGBOX":
+            bounding_box = [int(v) for v in fields[1:5]]
+        elif fields[0] == "FONT_ASCENT":
+            ascent = int(fields[1])
+        elif fields[0] == "FONT_DESCENT":
+            descent = int(fields[1])
+        elif fields[0] == "STARTCHAR":
+            encoding = advance = None
+            bbx = [0, 0, 0, 0]
+            for line in lines:
+                fields = line.split()
+                if not fields:
+                    continue
+                if fields[0] == "ENCODING":
+                    encoding = int(fields[1])
+                elif fields[0] == "DWIDTH":
+                    advance = int(fields[1])
+                elif fields[0] == "BBX":
+                    bbx = [int(v) for v in fields[1:5]]
+                elif fields[0] == "BITMAP":
+                    break
+            bitmap = []
+            for line in lines:
+                if line.strip() == "ENDCHAR":
+                    break
+                value = int(line.strip(), 16)
+                bits = len(line.strip()) * 4
+                bitmap.append([(value >> (bits - 1 - x)) & 1 for x in range(bbx[0])])
+            if encoding is None or encoding < 0:
+                continue
+            glyphs[encoding] = (bitmap, bbx, advance)
+    if bounding_box is None:
+        raise FontError("BDF has no FONTBOUNDINGBOX")
+    if ascent is None or descent is None:
+        ascent, descent = bounding_box[1] + bounding_box[3], -bounding_box[3]
+    height = ascent + descent
+    result = {}
+    for encoding, (bitmap, (width, rows, x_offset, y_offset), advance) in glyphs.items():
+        # Place the bitmap's rows within the font's full height, top row first
+        top = ascent - (y_offset + rows)
+        if top < 0 or top + rows > height:
+            raise FontError(f"glyph {encoding} doesn't fit within the font's ascent and descent")
+        full = [[0] * width for _ in range(top)] + bitmap + [[0] * width for _ in range(height - top - rows)]
+        result[encoding] = trim(full, x_offset, advance if advance is not None else width, height, encoding)
+    return height, result
+
+
+def read_png(path):
+    """Returns rows of booleans, True for ink, from a PNG font sheet."""
+    try:
+        pixels = png_reader.read_rgba(path)
+    except png_reader.PngError as error:
+        raise FontError(str(error)) from error
+    # Anything that isn't the background (the top left pixel) or fully transparent is ink
+    background = pixels[0][0]
+    return [[pixel != background and pixel[3] != 0 for pixel in row] for row in pixels]
+
+
+def read_sheet(path, cell_width, cell_height, first, spacing, monospace):
+    """Returns (height, {codepoint: Glyph}) for a grid of cells read left to right, top to bottom."""
+    pixels = read_png(path)
+    columns = len(pixels[0]) // cell_width
+    rows = len(pixels) // cell_height
+    glyphs = {}
+    for index in range(columns * rows):
+        cell_x = (index % columns) * cell_width
+        cell_y = (index // columns) * cell_height
+        bitmap = [row[cell_x:cell_x + cell_width] for row in pixels[cell_y:cell_y + cell_height]]
+        codepoint = first + index
+        glyph = trim(bitmap, 0, 0, cell_height, codepoint)
+        if monospace:
+            glyph.advance = max(glyph.advance, cell_width + spacing)
+        elif glyph.width == 0:
+            glyph.advance = max(1, cell_width // 2)
+        else:
+            # Proportional: the bitmap without its leading blank columns, plus spacing
+            glyph.advance = glyph.width + spacing
+            glyph.bearing = 0
+        glyphs[codepoint] = glyph
+    return cell_height, glyphs
+
+
+def select(glyphs, first, last):
+    first = min(glyphs) if first is None else first
+    last = max(glyphs) if last is None else last
+    if first > last or last > 0xFF:
+        raise FontError("fonts cover a range of 8 bit codepoints")
+    blank = Glyph([], 0, glyphs[32].advance if 32 in glyphs else 0, 0)
+    return first, last, [glyphs.get(codepoint, blank) for codepoint in range(first, last + 1)]
+
+
+def pack(height, glyphs):
+    """Returns the glyph table as (row_offset, width, advance, bearing) tuples and the rows shared by every glyph."""
+    table = []
+    rows = []
+    for glyph in glyphs:
+        if glyph.width == 0:
+            table.append((0, 0, glyph.advance, glyph.bearing))
+            continue
+        # Leftmost pixel in bit 7
+        packed = [row << (8 - glyph.width) for row in glyph.rows]
+        table.append((len(rows), glyph.width, glyph.advance, glyph.bearing))
+        rows += packed
+    if len(rows) > 0xFFFF:
+        raise FontError("font has too many rows")
+    return table, rows
+
+
+def character_name(codepoint):
+    character = chr(codepoint)
+    if character == " ":
+        return "space"
+    if character == "\\":
+        return "backslash"
+    return character if character.isprintable() else f"U+{codepoint:04X}"
+
+
+def write_header(output, name, source, height, line_spacing, first, last, table, rows, glyph_rows):
+    lines = [
+        "#pragma once",
+        f"// Generated by tools/font_compiler.py from {source}; regenerate rather than editing by hand",
+        "#include <array>",
+        "#include <cstdint>",
+        '#include "gfx/font.h"',
+        "",
+        "namespace gfx::fonts",
+        "{",
+        f"constexpr inline std::array<Glyph, {len(table)}> {name}_glyphs{{ {{",
+    ]
+    for codepoint, (row_offset, width, advance, bearing) in zip(range(first, last + 1), table):
+        lines.append(f"    {{ .row_offset = {row_offset}, .width = {width}, .advance = {advance}, .bearing = {bearing} }},"
+            f" // {character_name(codepoint)}")
+    lines.append("} };")
+    lines.append(f"constexpr inline std::array<std::uint8_t, {len(rows)}> {name}_rows{{ {{")
+    for codepoint, (row_offset, width, _, _) in zip(range(first, last + 1), table):
+        if width == 0:
+            continue
+        glyph = rows[row_offset:row_offset + glyph_rows]
+        lines.append("    " + ", ".join(f"0b{row:08b}" for row in glyph) + f", // {character_name(codepoint)}")
+    lines.append("} };")
+    lines += [
+        f"constexpr inline Font {name}{{",
+        f"    .height = {height}, .line_spacing = {line_spacing},",
+        f"    .first = static_cast<char>({first}), .last = static_cast<char>({last}),",
+        f"    .glyphs = {name}_glyphs, .rows = {name}_rows",
+        "};",
+        "}",
+        "",
+    ]
+    Path(output).write_text("\n".join(lines))
+
+
+def write_blob(output, height, line_spacing, first, last, table, rows):
+    blob = bytearray(BLOB_MAGIC)
+    blob += struct.pack("<BBBBBBH", BLOB_VERSION, height, line_spacing, first, last, 0, len(rows))
+    for row_offset, width, advance, bearing in table:
+        blob += struct.pack("<HBBBB", row_offset, width, advance, bearing, 0)
+    blob += bytes(rows)
+    Path(output).write_bytes(blob)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="BDF font or PNG font sheet")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--format", choices=("header", "blob"), default="header")
+    parser.add_argument("--name", help="C++ name of the font in headers (defaults to the source's name)")
+    parser.add_argument("--first", type=int, help="first codepoint to include (defaults to the font's first)")
+    parser.add_argument("--last", type=int, help="last codepoint to include (defaults to the font's last)")
+    parser.add_argument("--line-spacing", type=int, default=1, help="blank rows between lines of text")
+    sheet = parser.add_argument_group("PNG sheets")
+    sheet.add_argument("--cell", help="size of each glyph's cell as WIDTHxHEIGHT")
+    sheet.add_argument("--sheet-first", type=int, default=32, help="codepoint of the sheet's first cell")
+    sheet.add_argument("--spacing", type=int, default=1, help="blank columns after each glyph")
+    sheet.add_argument("--monospace", action="store_true", help="advance every glyph by the full cell width")
+    args = parser.parse_args()
+
+    try:
+        if args.source.lower().endswith(".png"):
+            if not args.cell:
+                raise FontError("PNG sheets need --cell")
+            cell_width, cell_height = (int(v) for v in args.cell.lower().split("x"))
+            height, glyphs = read_sheet(args.source, cell_width, cell_height, args.sheet_first, args.spacing,
+                args.monospace)
+        else:
+            height, glyphs = read_bdf(args.source)
+        first, last, selected = select(glyphs, args.first, args.last)
+        table, rows = pack(height, selected)
+        if args.format == "header":
+            name = args.name or Path(args.source).stem
+            write_header(args.output, name, Path(args.source).name, height, args.line_spacing, first, last, table,
+                rows, height)
+        else:
+            write_blob(args.output, height, args.line_spacing, first, last, table, rows)
+    except FontError as error:
+        print(f"{args.source}: {error}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
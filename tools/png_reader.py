@@ -0,0 +1,71 @@
+"""Minimal PNG decoder shared by the asset tools, so they only need the Python standard library."""
+import struct
+import zlib
+from pathlib import Path
+
+
+class PngError(Exception):
+    pass
+
+
+def read_rgba(path):
+    """Returns rows of (r, g, b, a) tuples from a non-interlaced 8 bit PNG."""
+    data = Path(path).read_bytes()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise PngError(f"{path} isn't a PNG")
+    offset = 8
+    idat = b""
+    palette = None
+    transparency = None
+    while offset < len(data):
+        length, kind = struct.unpack(">I4s", data[offset:offset + 8])
+        chunk = data[offset + 8:offset + 8 + length]
+        offset += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"PLTE":
+            palette = [chunk[i:i + 3] for i in range(0, len(chunk), 3)]
+        elif kind == b"tRNS":
+            transparency = chunk
+        elif kind == b"IDAT":
+            idat += chunk
+        elif kind == b"IEND":
+            break
+    if depth != 8 or interlace != 0:
+        raise PngError("only non-interlaced 8 bit PNGs are supported")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    stride = width * channels
+    raw = zlib.decompress(idat)
+    pixels = []
+    previous = bytearray(stride)
+    for y in range(height):
+        filter_type = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            left = line[i - channels] if i >= channels else 0
+            up = previous[i]
+            up_left = previous[i - channels] if i >= channels else 0
+            if filter_type == 1:
+                line[i] = (line[i] + left) & 0xFF
+            elif filter_type == 2:
+                line[i] = (line[i] + up) & 0xFF
+            elif filter_type == 3:
+                line[i] = (line[i] + (left + up) // 2) & 0xFF
+            elif filter_type == 4:
+                estimate = left + up - up_left
+                distances = (abs(estimate - left), abs(estimate - up), abs(estimate - up_left))
+                predictor = (left, up, up_left)[distances.index(min(distances))]
+                line[i] = (line[i] + predictor) & 0xFF
+        previous = line
+        row = []
+        for x in range(width):
+            pixel = line[x * channels:(x + 1) * channels]
+            if color_type == 3:
+                index = pixel[0]
+                alpha = transparency[index] if transparency and index < len(transparency) else 255
+                pixel = bytes(palette[index]) + bytes([alpha])
+            elif color_type in (0, 4):
+                pixel = bytes([pixel[0]] * 3) + bytes(pixel[1:])
+            row.append(tuple(pixel[:3]) + (pixel[3] if len(pixel) > 3 else 255,))
+        pixels.append(row)
+    return pixels
@@ -0,0 +1,452 @@
+#!/usr/bin/env python3
+"""Packs a program's ELF so OS::load_program has fewer bytes to read from the SD card and nothing to parse (see
+PackedSegmentTable and LoadManifest in os/inc/program.h).
+
+Each segment loaded into program flash is compressed on its own in the LZ4 block format, and unpacked by the loader
+as it goes into flash. Matches reach back no more than --history-bits worth of bytes, which is all the loader keeps
+of what it has unpacked; more history compresses a little better but takes more of the OS's RAM while loading.
+Segments loaded straight into RAM are stored as they are, as the loader unpacks in RAM they'd overwrite.
+Straight after the ELF header goes a load manifest: every range to write into flash or RAM or clear, where its bytes
+are in the file, where the program starts, and the sorted relocation sites for moving it between flash slots. The
+loader follows it without reading any other headers. It's checked against the program's memory the way the loader
+checks it, so an ELF the loader would refuse isn't written.
+The result is still an ELF with the same program headers and entry point, plus one listing the packed sizes, which
+the loader falls back on if the manifest is for another version of it. Only the sections the loader reads are kept:
+the relocations if the program can be moved, and the section headers and names. Symbols and debug info are dropped, so
+keep the original ELF for debugging. A program whose code in RAM calls into flash through linker veneers can't be
+moved, as the veneers hold flash addresses with no relocations, so it keeps no relocations either. Every packed segment is unpacked again and checked before the file is written.
+
+Examples:
+    program_packer.py build/example_program/piconsole_example_program.elf -o boot.elf
+    program_packer.py game.elf --history-bits 13 -o /media/sd/programs/game.elf
+    program_packer.py game.elf --store -o game.elf.manifest
+"""
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+ELF_HEADER = struct.Struct("<16sHHIIIIIHHHHHH")
+SEGMENT_HEADER = struct.Struct("<IIIIIIII")
+SECTION_HEADER = struct.Struct("<IIIIIIIIII")
+PT_LOAD = 1
+# Must match SegmentHeader::Type::PackedSegments
+PT_PACKED_SEGMENTS = 0x6050434B
+SHT_NULL, SHT_SYMTAB, SHT_STRTAB, SHT_NOBITS, SHT_REL = 0, 2, 3, 8, 9
+SHF_ALLOC = 0x2
+RELOCATION = struct.Struct("<II")
+SYMBOL = struct.Struct("<IIIBBH")
+STT_FUNC = 2
+# Must match PackedSegmentTable
+TABLE = struct.Struct("<4sBBH")
+TABLE_MAGIC = b"PPAK"
+LZ4_CODEC = 1
+MIN_HISTORY_BITS, MAX_HISTORY_BITS = 8, 14
+
+# Must match LoadManifest, LoadRange and RelocationSite
+MANIFEST = struct.Struct("<IHHIIIB3xII")
+MANIFEST_MAGIC = 0x4D444C50
+MANIFEST_VERSION = 1
+MAX_RANGES = 16
+LOAD_RANGE = struct.Struct("<IIIIII")
+RANGE_FLASH, RANGE_RAM, RANGE_FLASH_TO_RAM, RANGE_ZERO = range(4)
+SITE_ABSOLUTE, SITE_RELATIVE32, SITE_RELATIVE31 = range(3)
+# RelocationEntry::Type
+SITE_KINDS = {2: SITE_ABSOLUTE, 38: SITE_ABSOLUTE, 3: SITE_RELATIVE32, 42: SITE_RELATIVE31}
+# Must match os/inc/program.h
+PROGRAM_FLASH_START, PROGRAM_FLASH_END = 0x10080000, 0x101FF000
+PROGRAM_RAM_START, PROGRAM_RAM_END = 0x20018000, 0x2003E000
+
+MIN_MATCH = 4
+RUN_ON_LENGTH = 15
+# The LZ4 block format's own end rules: the last match starts at least 12 bytes from the end and the last 5 bytes are
+#   always literals, so standard decoders can read it too
+MATCH_START_LIMIT = 12
+LAST_LITERALS = 5
+# Earlier positions with the same four bytes tried for each match
+MAX_CANDIDATES = 32
+
+
+class PackError(Exception):
+    pass
+
+
+def encode_run_on(out, length):
+    while length >= 0xFF:
+        out.append(0xFF)
+        length -= 0xFF
+    out.append(length)
+
+
+def encode_sequence(out, literals, offset=0, match_length=0):
+    match_code = match_length - MIN_MATCH if offset else 0
+    out.append(min(len(literals), RUN_ON_LENGTH) << 4 | min(match_code, RUN_ON_LENGTH))
+    if len(literals) >= RUN_ON_LENGTH:
+        encode_run_on(out, len(literals) - RUN_ON_LENGTH)
+    out += literals
+    if offset:
+        out += struct.pack("<H", offset)
+        if match_code >= RUN_ON_LENGTH:
+            encode_run_on(out, match_code - RUN_ON_LENGTH)
+
+
+def compress(data, history_size):
+    """`data` as an LZ4 block with no match reaching back further than `history_size` bytes."""
+    out = bytearray()
+    candidates = {}
+    match_end_limit = len(data) - LAST_LITERALS
+    match_start_limit = len(data) - MATCH_START_LIMIT
+
+    def remember(position):
+        earlier = candidates.setdefault(data[position:position + MIN_MATCH], [])
+        earlier.append(position)
+        if len(earlier) > MAX_CANDIDATES:
+            del earlier[0]
+
+    def find_match(position):
+        best_length, best_offset = 0, 0
+        for candidate in reversed(candidates.get(data[position:position + MIN_MATCH], ())):
+            offset = position - candidate
+            if offset > history_size:
+                break
+            length = MIN_MATCH
+            while position + length + 8 <= match_end_limit \
+                    and data[candidate + length:candidate + length + 8] == data[position + length:position + length + 8]:
+                length += 8
+            while position + length < match_end_limit and data[candidate + length] == data[position + length]:
+                length += 1
+            if length > best_length:
+                best_length, best_offset = length, offset
+        return best_length, best_offset
+
+    anchor = 0
+    position = 0
+    while position < match_start_limit:
+        length, offset = find_match(position)
+        remember(position)
+        if length < MIN_MATCH:
+            position += 1
+            continue
+        # A longer match starting a byte later is worth a literal
+        while position + 1 < match_start_limit:
+            next_length, next_offset = find_match(position + 1)
+            if next_length <= length + 1:
+                break
+            position += 1
+            remember(position)
+            length, offset = next_length, next_offset
+        encode_sequence(out, data[anchor:position], offset, length)
+        for inside in range(position + 1, min(position + length, match_start_limit)):
+            remember(inside)
+        position += length
+        anchor = position
+    encode_sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def decompress(packed, size, history_size):
+    """Unpacks an LZ4 block the way the loader does, including its limit on how far back matches reach."""
+    out = bytearray()
+    position = 0
+
+    def read_run_on(length):
+        nonlocal position
+        while True:
+            byte = packed[position]
+            position += 1
+            length += byte
+            if byte != 0xFF:
+                return length
+
+    while position < len(packed):
+        token = packed[position]
+        position += 1
+        literal_count = token >> 4
+        if literal_count == RUN_ON_LENGTH:
+            literal_count = read_run_on(literal_count)
+        out += packed[position:position + literal_count]
+        position += literal_count
+        if position == len(packed):
+            break
+        offset = packed[position] | packed[position + 1] << 8
+        position += 2
+        match_length = token & 0x0F
+        if match_length == RUN_ON_LENGTH:
+            match_length = read_run_on(match_length)
+        match_length += MIN_MATCH
+        if not 0 < offset <= min(history_size, len(out)):
+            raise PackError(f"match reaches back {offset} bytes")
+        for _ in range(match_length):
+            out.append(out[-offset])
+    if len(out) != size:
+        raise PackError(f"unpacked to {len(out)} bytes rather than {size}")
+    return bytes(out)
+
+
+def read_elf(data):
+    if len(data) < ELF_HEADER.size or data[:4] != b"\x7fELF":
+        raise PackError("not an ELF")
+    header = list(ELF_HEADER.unpack_from(data))
+    identifier = header[0]
+    if identifier[4] != 1 or identifier[5] != 1:
+        raise PackError("only 32 bit little endian ELFs can be loaded")
+    segment_offset, section_offset = header[5], header[6]
+    segment_entry_size, segment_count = header[9], header[10]
+    section_entry_size, section_count = header[11], header[12]
+    if segment_entry_size != SEGMENT_HEADER.size or (section_count and section_entry_size != SECTION_HEADER.size):
+        raise PackError("unexpected program or section header size")
+    segments = [list(SEGMENT_HEADER.unpack_from(data, segment_offset + i * SEGMENT_HEADER.size))
+        for i in range(segment_count)]
+    sections = [list(SECTION_HEADER.unpack_from(data, section_offset + i * SECTION_HEADER.size))
+        for i in range(section_count)]
+    if any(segment[0] == PT_PACKED_SEGMENTS for segment in segments):
+        raise PackError("already packed")
+    return header, segments, sections
+
+
+def align(data, alignment=4):
+    data += bytes(-len(data) % alignment)
+
+
+def hash_bytes(data, value=0x811C9DC5):
+    """32 bit FNV-1a, as hash_bytes() in os/inc/program.h."""
+    for byte in data:
+        value = (value ^ byte) * 0x01000193 & 0xFFFFFFFF
+    return value
+
+
+def is_within(address, size, start, end):
+    return start <= address <= end and size <= end - address
+
+
+def plan_ranges(segments):
+    """The manifest's ranges as the loader would work them out from the program headers, flash ones first, each with
+    the number of the segment its bytes come from."""
+    ranges = []
+    loadable = [(number, segment) for number, segment in enumerate(segments) if segment[0] == PT_LOAD]
+    for number, segment in loadable:
+        if PROGRAM_FLASH_START <= segment[3] < PROGRAM_FLASH_END:
+            ranges.append([RANGE_FLASH, segment[3], segment[4], 0, 0, segment[2], number])
+    for number, segment in loadable:
+        _, _, virtual_address, physical_address, size, memory_size = segment[:6]
+        if memory_size < size:
+            continue
+        if PROGRAM_FLASH_START <= physical_address < PROGRAM_FLASH_END:
+            if virtual_address == physical_address:
+                continue
+            ranges.append([RANGE_FLASH_TO_RAM, virtual_address, size, physical_address, 0, 0, None])
+        elif PROGRAM_RAM_START <= physical_address < PROGRAM_RAM_END:
+            ranges.append([RANGE_RAM, virtual_address, size, 0, 0, 0, number])
+        else:
+            continue
+        if memory_size != size:
+            ranges.append([RANGE_ZERO, virtual_address + size, memory_size - size, 0, 0, 0, None])
+    if len(ranges) > MAX_RANGES:
+        raise PackError(f"{len(ranges)} load ranges, more than the loader's {MAX_RANGES}")
+    return ranges
+
+
+def check_ranges(ranges, image_end, entry_point, file_size):
+    """Refuses anything the loader would, so it's found here rather than at launch."""
+    if not PROGRAM_FLASH_START < image_end <= PROGRAM_FLASH_END:
+        raise PackError("nothing to put in program flash, or more than fits")
+    if not PROGRAM_FLASH_START <= entry_point < image_end:
+        raise PackError(f"entry point {entry_point:#010x} isn't in the flash image")
+    for number, (range_type, address, size, source, packed_size, _, _) in enumerate(ranges):
+        in_file = is_within(source, packed_size or size, 0, file_size)
+        in_ram = is_within(address, size, PROGRAM_RAM_START, PROGRAM_RAM_END)
+        if range_type == RANGE_FLASH:
+            valid = is_within(address, size, PROGRAM_FLASH_START, image_end) and in_file
+        elif range_type == RANGE_RAM:
+            valid = in_ram and in_file and not packed_size
+        elif range_type == RANGE_FLASH_TO_RAM:
+            valid = in_ram and is_within(source, size, PROGRAM_FLASH_START, image_end)
+        else:
+            valid = in_ram
+        if not valid:
+            raise PackError(f"load range {number} ({size:#x} bytes at {address:#010x}) is outside program memory")
+
+
+def find_sites(data, sections, ranges):
+    """The program's relocation sites as words, sorted as the loader wants them, or None if it can't be moved."""
+    relocation_sections = [section for section in sections if section[1] == SHT_REL
+        and section[7] < len(sections) and sections[section[7]][2] & SHF_ALLOC]
+    if not relocation_sections:
+        return None
+    sites = []
+    for section in relocation_sections:
+        for offset, info in RELOCATION.iter_unpack(data[section[4]:section[4] + section[5]]):
+            kind = SITE_KINDS.get(info & 0xFF)
+            if kind is None:
+                continue
+            for number, (range_type, address, size, _, _, run_address, _) in enumerate(ranges):
+                if range_type == RANGE_RAM:
+                    run_address = address
+                elif range_type != RANGE_FLASH:
+                    continue
+                if run_address <= offset < run_address + size:
+                    if range_type == RANGE_RAM:
+                        # The loader doesn't relocate what it copies straight into RAM
+                        return None
+                    sites.append(offset - run_address + address - PROGRAM_FLASH_START | kind << 24 | number << 26)
+                    break
+    return sorted(sites, key=lambda site: site & 0xFFFFFF)
+
+
+def has_flash_veneers(data, sections):
+    """Whether code in program RAM calls into flash through a veneer, as the loader checks too. The linker names each
+    one __<callee>_veneer, and the flash address it holds has no relocation."""
+    for symbol_table in sections:
+        if symbol_table[1] != SHT_SYMTAB or symbol_table[6] >= len(sections):
+            continue
+        names_offset = sections[symbol_table[6]][4]
+        for name, value, _, info, _, _ in SYMBOL.iter_unpack(data[symbol_table[4]:symbol_table[4] + symbol_table[5]]):
+            if info & 0xF == STT_FUNC and PROGRAM_RAM_START <= value < PROGRAM_RAM_END:
+                name_start = names_offset + name
+                if data[name_start:data.find(b"\0", name_start)].endswith(b"_veneer"):
+                    return True
+    return False
+
+
+def find_entry_point(data, header, sections):
+    """Where the program's main is, by its section; the start of program flash if there's no such section."""
+    if 0 < header[13] < len(sections):
+        names_offset = sections[header[13]][4]
+        for section in sections:
+            name_start = names_offset + section[0]
+            if data[name_start:data.find(b"\0", name_start)] == b".text.main":
+                return section[3]
+    return PROGRAM_FLASH_START
+
+
+def pack(data, history_bits, store=False):
+    header, segments, sections = read_elf(data)
+    history_size = 1 << history_bits
+    ranges = plan_ranges(segments)
+    image_end = max((address + size for range_type, address, size, *_ in ranges if range_type == RANGE_FLASH),
+        default=PROGRAM_FLASH_START)
+    entry_point = find_entry_point(data, header, sections)
+    sites = find_sites(data, sections, ranges)
+    if sites is not None and has_flash_veneers(data, sections):
+        sites = None
+    flash_segments = {segment_number for range_type, *_, segment_number in ranges if range_type == RANGE_FLASH}
+
+    manifest_size = MANIFEST.size + len(ranges) * LOAD_RANGE.size
+    segment_offset = ELF_HEADER.size + manifest_size
+    table_offset = segment_offset + (len(segments) + 1) * SEGMENT_HEADER.size
+    table_size = TABLE.size + (len(segments) + 1) * 4
+    out = bytearray(table_offset + table_size)
+    align(out)
+
+    packed_sizes = []
+    for number, segment in enumerate(segments):
+        segment_type, offset, size = segment[0], segment[1], segment[4]
+        if segment_type != PT_LOAD:
+            # Anything else only describes part of a loadable segment, whose bytes are now packed
+            segment[1], segment[4] = 0, 0
+            packed_sizes.append(0)
+            continue
+        contents = data[offset:offset + size]
+        if len(contents) != size:
+            raise PackError(f"segment {number} runs past the end of the file")
+        packed = compress(contents, history_size) if size and not store and number in flash_segments else b""
+        if packed and decompress(packed, size, history_size) != contents:
+            raise PackError(f"segment {number} didn't unpack to what it was packed from")
+        segment[1] = len(out)
+        if packed and len(packed) < size:
+            packed_sizes.append(len(packed))
+            out += packed
+        else:
+            # Not worth unpacking, so it's stored as it is
+            packed_sizes.append(0)
+            out += contents
+        align(out)
+    packed_sizes.append(0)
+    for load_range in ranges:
+        segment_number = load_range[6]
+        if segment_number is not None:
+            load_range[3], load_range[4] = segments[segment_number][1], packed_sizes[segment_number]
+
+    sites_offset = len(out) if sites is not None else 0
+    for site in sites or ():
+        out += struct.pack("<I", site)
+
+    # Sections the loader doesn't read lose their bytes, and those it doesn't read at all go; loaded sections' bytes
+    #   are in their packed segments
+    kept = [number for number, section in enumerate(sections)
+        if number == 0 or number == header[13] or section[2] & SHF_ALLOC
+        or (sites is not None and section[1] == SHT_REL and section[7] < len(sections)
+            and sections[section[7]][2] & SHF_ALLOC)]
+    new_numbers = {old: new for new, old in enumerate(kept)}
+    new_sections = []
+    for old in kept:
+        section = list(sections[old])
+        if section[1] == SHT_REL:
+            # Symbols are dropped; the loader only needs where each relocation is and its type
+            section[6], section[7] = 0, new_numbers[section[7]]
+        elif section[1] != SHT_NULL and section[2] & SHF_ALLOC:
+            section[1], section[4] = SHT_NOBITS, 0
+        else:
+            section[6] = 0
+        if section[1] in (SHT_REL, SHT_STRTAB) and old != 0:
+            section_bytes = data[section[4]:section[4] + section[5]]
+            section[4] = len(out)
+            out += section_bytes
+            align(out)
+        new_sections.append(section)
+    section_offset = len(out)
+    for section in new_sections:
+        out += SECTION_HEADER.pack(*section)
+    check_ranges(ranges, image_end, entry_point, len(out))
+
+    header[5], header[6] = segment_offset, section_offset if len(new_sections) > 1 else 0
+    header[10], header[12] = len(segments) + 1, len(new_sections) if len(new_sections) > 1 else 0
+    header[13] = new_numbers.get(header[13], 0) if len(new_sections) > 1 else 0
+    out[:ELF_HEADER.size] = ELF_HEADER.pack(*header)
+    table_segment = [PT_PACKED_SEGMENTS, table_offset, 0, 0, table_size, 0, 0x4, 4]
+    for number, segment in enumerate(segments + [table_segment]):
+        SEGMENT_HEADER.pack_into(out, segment_offset + number * SEGMENT_HEADER.size, *segment)
+    TABLE.pack_into(out, table_offset, TABLE_MAGIC, LZ4_CODEC, history_bits, len(segments) + 1)
+    struct.pack_into(f"<{len(packed_sizes)}I", out, table_offset + TABLE.size, *packed_sizes)
+
+    def pack_manifest(hash_value):
+        manifest = bytearray(MANIFEST.pack(MANIFEST_MAGIC, MANIFEST_VERSION, len(ranges), hash_value, entry_point,
+            image_end, history_bits if any(packed_sizes) else 0, sites_offset, len(sites or ())))
+        for load_range in ranges:
+            manifest += LOAD_RANGE.pack(*load_range[:6])
+        return manifest
+    out[ELF_HEADER.size:segment_offset] = pack_manifest(hash_bytes(pack_manifest(0)))
+
+    loaded = sum(segment[4] for segment in segments if segment[0] == PT_LOAD)
+    read = sum(packed or segment[4] for packed, segment in zip(packed_sizes, segments) if segment[0] == PT_LOAD)
+    return bytes(out), loaded, read, len(ranges), sites
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="program ELF as linked")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--history-bits", type=int, default=12,
+        help=f"log2 of how far back matches reach, {MIN_HISTORY_BITS} to {MAX_HISTORY_BITS} (default 12, 4 KB)")
+    parser.add_argument("--store", action="store_true",
+        help="only add the load manifest, leaving every segment as it is")
+    args = parser.parse_args()
+
+    try:
+        if not MIN_HISTORY_BITS <= args.history_bits <= MAX_HISTORY_BITS:
+            raise PackError(f"the history must be {MIN_HISTORY_BITS} to {MAX_HISTORY_BITS} bits")
+        data = Path(args.elf).read_bytes()
+        packed, loaded, read, range_count, sites = pack(data, args.history_bits, args.store)
+    except (OSError, PackError, struct.error) as error:
+        print(f"{args.elf}: {error}", file=sys.stderr)
+        return 1
+    Path(args.output).write_bytes(packed)
+    print(f"{args.output}: {loaded} bytes of segments packed into {read} ({100 * read // max(loaded, 1)}%), "
+        f"{len(packed)} bytes in all from {len(data)}")
+    print(f"{args.output}: {range_count} load ranges, " + (f"{len(sites)} relocation sites" if sites is not None
+        else "can't be moved from where it was linked"))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Packs PNG images into a sprite atlas for gfx::SpriteAtlas (see os/inc/gfx/sprite_atlas.h).
+
+Every PNG is one frame, or a grid of frames read left to right, top to bottom with --cell. Frames are numbered in
+the order they're given, so keep each animation's frames together: they then share pages and load together.
+Pixels that are less than half opaque become the frame's transparent color (RGB565) or palette index 0 (indexed).
+
+Examples:
+    sprite_atlas.py player.png enemies.png --cell 16x16 -o sprites.patl
+    sprite_atlas.py tiles.png --cell 8x8 --format indexed4 --page-size 2048 -o tiles.patl
+"""
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+import png_reader
+
+MAGIC = b"PATL"
+VERSION = 1
+FORMATS = {"rgb565": 0, "indexed8": 1, "indexed4": 2}
+PALETTE_SIZES = {"rgb565": 0, "indexed8": 256, "indexed4": 16}
+HAS_COLOR_KEY = 0b1
+HEADER = struct.Struct("<4sBBHHHI")
+FRAME = struct.Struct("<IIHHHBB")
+# Pages start on an SD sector so reading one never touches more sectors than it needs to
+SECTOR_SIZE = 512
+
+
+class AtlasError(Exception):
+    pass
+
+
+def to_rgb565(pixel):
+    """The framebuffer's byte swapped RGB565 value for an (r, g, b, a) pixel, as RGB565::data holds it."""
+    r, g, b = pixel[0] >> 3, pixel[1] >> 2, pixel[2] >> 3
+    value = r << 11 | g << 5 | b
+    return (value & 0xFF) << 8 | value >> 8
+
+
+def is_transparent(pixel):
+    return pixel[3] < 128
+
+
+def read_frames(paths, cell):
+    frames = []
+    for path in paths:
+        try:
+            pixels = png_reader.read_rgba(path)
+        except png_reader.PngError as error:
+            raise AtlasError(f"{path}: {error}") from error
+        height, width = len(pixels), len(pixels[0])
+        cell_width, cell_height = cell or (width, height)
+        if cell_width > width or cell_height > height:
+            raise AtlasError(f"{path} is smaller than one {cell_width}x{cell_height} cell")
+        for cell_y in range(0, height - cell_height + 1, cell_height):
+            for cell_x in range(0, width - cell_width + 1, cell_width):
+                frames.append([row[cell_x:cell_x + cell_width] for row in pixels[cell_y:cell_y + cell_height]])
+    return frames
+
+
+def encode_rgb565(frame):
+    """Returns (pixel bytes, color key or None) for one frame."""
+    transparent = any(is_transparent(pixel) for row in frame for pixel in row)
+    key = None
+    if transparent:
+        used = {to_rgb565(pixel) for row in frame for pixel in row if not is_transparent(pixel)}
+        # Magenta, unless the frame actually uses it
+        key = next(candidate for candidate in [to_rgb565((255, 0, 255, 255))] + list(range(0x10000))
+            if candidate not in used)
+    data = bytearray()
+    for row in frame:
+        for pixel in row:
+            data += struct.pack("<H", key if is_transparent(pixel) else to_rgb565(pixel))
+    return bytes(data), key
+
+
+def build_palette(frames, palette_size):
+    transparent = any(is_transparent(pixel) for frame in frames for row in frame for pixel in row)
+    # Index 0 is kept for transparency if anything needs it
+    palette = [0] if transparent else []
+    indices = {}
+    for frame in frames:
+        for row in frame:
+            for pixel in row:
+                color = to_rgb565(pixel)
+                if not is_transparent(pixel) and color not in indices:
+                    indices[color] = len(palette)
+                    palette.append(color)
+    if len(palette) > palette_size:
+        raise AtlasError(f"{len(palette)} colors don't fit in a {palette_size} color palette")
+    return palette + [0] * (palette_size - len(palette)), indices, 0 if transparent else None
+
+
+def encode_indexed(frame, indices, key, bits):
+    data = bytearray()
+    for row in frame:
+        row_indices = [key if is_transparent(pixel) else indices[to_rgb565(pixel)] for pixel in row]
+        if bits == 8:
+            data += bytes(row_indices)
+        else:
+            row_indices += [0] * (len(row_indices) % 2)
+            data += bytes(high << 4 | low for high, low in zip(row_indices[0::2], row_indices[1::2]))
+    return bytes(data), key if key is not None and any(is_transparent(pixel) for row in frame for pixel in row) else None
+
+
+def pack(frames, pixel_format, page_size):
+    palette_size = PALETTE_SIZES[pixel_format]
+    palette, indices, palette_key = build_palette(frames, palette_size) if palette_size else ([], None, None)
+    index = bytearray()
+    data = bytearray()
+    for number, frame in enumerate(frames):
+        if pixel_format == "rgb565":
+            pixels, key = encode_rgb565(frame)
+        else:
+            pixels, key = encode_indexed(frame, indices, palette_key, 8 if pixel_format == "indexed8" else 4)
+        if len(pixels) > page_size:
+            raise AtlasError(f"frame {number} is {len(pixels)} bytes, more than the {page_size} byte page size")
+        # Word aligned so RGB565 rows can be copied a word at a time, and never split across pages
+        offset = (len(data) + 3) & ~3
+        if offset % page_size + len(pixels) > page_size:
+            offset = (offset + page_size - 1) // page_size * page_size
+        data += bytes(offset - len(data)) + pixels
+        index += FRAME.pack(offset, len(pixels), len(frame[0]), len(frame), key or 0,
+            HAS_COLOR_KEY if key is not None else 0, 0)
+    data += bytes(-len(data) % page_size)
+    data_offset = HEADER.size + len(palette) * 2 + len(index)
+    data_offset += -data_offset % SECTOR_SIZE
+    header = HEADER.pack(MAGIC, VERSION, FORMATS[pixel_format], len(frames), len(palette), page_size, data_offset)
+    atlas = header + b"".join(struct.pack("<H", color) for color in palette) + bytes(index)
+    return atlas + bytes(data_offset - len(atlas)) + bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("sources", nargs="+", help="PNG images")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--cell", help="split images into frames of WIDTHxHEIGHT")
+    parser.add_argument("--format", choices=FORMATS, default="rgb565")
+    parser.add_argument("--page-size", type=int, default=4096,
+        help="bytes per cache page; must fit the SpriteAtlas's TPageSize (default 4096)")
+    args = parser.parse_args()
+
+    try:
+        if not 0 < args.page_size <= 0xFFFF:
+            raise AtlasError("page size must be between 1 and 65535 bytes")
+        cell = tuple(int(v) for v in args.cell.lower().split("x")) if args.cell else None
+        frames = read_frames(args.sources, cell)
+        if not frames or len(frames) > 0xFFFF:
+            raise AtlasError(f"{len(frames)} frames; atlases hold 1 to 65535")
+        atlas = pack(frames, args.format, args.page_size)
+    except AtlasError as error:
+        print(f"{args.output}: {error}", file=sys.stderr)
+        return 1
+    Path(args.output).write_bytes(atlas)
+    print(f"{args.output}: {len(frames)} frames, {len(atlas)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""Encodes PNG frames, and optionally a WAV soundtrack, into a PVID video for VideoPlayer (see os/inc/pvid.h).
+
+Frames are played in the order they're given and must all be the same size, no bigger than the screen. Every
+--keyframe-interval frames is a keyframe that run length encodes the whole picture, so a damaged or dropped chunk
+only spoils the video up to the next one; the rest only store the pixels that changed since the frame before.
+The soundtrack must be 16 bit PCM, mono or stereo, and is played at its own sample rate; it's cut off after the last
+frame.
+
+Examples:
+    video_encoder.py frames/*.png --fps 15 -o intro.pvid
+    video_encoder.py frames/*.png --fps 20 --audio intro.wav --keyframe-interval 40 -o intro.pvid
+"""
+import argparse
+import struct
+import sys
+import wave
+from pathlib import Path
+
+import png_reader
+
+MAGIC = b"PVID"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHHHIIIII")
+CHUNK = struct.Struct("<IBBHI")
+KEY_FRAME, DELTA_FRAME = 0, 1
+SKIP, LITERAL, FILL = 0, 1, 2
+MAX_INLINE_COUNT = 0x3F
+MAX_COUNT = 0xFFFF
+# Shortest run worth a fill rather than more literal pixels
+MIN_FILL = 3
+SCREEN_SIZE = (160, 128)
+# Must match VideoPlayer::audio_ring_size
+AUDIO_RING_SIZE = 4096
+# The chunks start on an SD sector
+SECTOR_SIZE = 512
+
+
+class VideoError(Exception):
+    pass
+
+
+def to_rgb565(pixel):
+    """The framebuffer's byte swapped RGB565 value for an (r, g, b, a) pixel, as RGB565::data holds it."""
+    r, g, b = pixel[0] >> 3, pixel[1] >> 2, pixel[2] >> 3
+    value = r << 11 | g << 5 | b
+    return (value & 0xFF) << 8 | value >> 8
+
+
+def read_frames(paths):
+    frames = []
+    size = None
+    for path in paths:
+        try:
+            pixels = png_reader.read_rgba(path)
+        except png_reader.PngError as error:
+            raise VideoError(f"{path}: {error}") from error
+        frame_size = (len(pixels[0]), len(pixels))
+        if size is None:
+            size = frame_size
+        elif frame_size != size:
+            raise VideoError(f"{path} is {frame_size[0]}x{frame_size[1]}, not {size[0]}x{size[1]} like the first frame")
+        frames.append([to_rgb565(pixel) for row in pixels for pixel in row])
+    if size[0] > SCREEN_SIZE[0] or size[1] > SCREEN_SIZE[1]:
+        raise VideoError(f"frames are {size[0]}x{size[1]}, bigger than the {SCREEN_SIZE[0]}x{SCREEN_SIZE[1]} screen")
+    return frames, size
+
+
+def read_audio(path):
+    try:
+        with wave.open(str(path), "rb") as wav:
+            if wav.getsampwidth() != 2 or wav.getnchannels() not in (1, 2):
+                raise VideoError(f"{path} must be 16 bit mono or stereo PCM")
+            return wav.readframes(wav.getnframes()), wav.getnchannels(), wav.getframerate()
+    except (wave.Error, EOFError) as error:
+        raise VideoError(f"{path}: {error}") from error
+
+
+def encode_operation(data, operation, count):
+    if count <= MAX_INLINE_COUNT:
+        data.append(operation << 6 | count)
+    else:
+        data.append(operation << 6)
+        data += struct.pack("<H", count)
+
+
+def encode_pixels(data, pixels):
+    """Literal and fill operations for a run of changed pixels."""
+    start = 0
+    literal_start = 0
+    while start < len(pixels):
+        end = start + 1
+        while end < len(pixels) and pixels[end] == pixels[start] and end - start < MAX_COUNT:
+            end += 1
+        if end - start >= MIN_FILL:
+            encode_literal(data, pixels[literal_start:start])
+            encode_operation(data, FILL, end - start)
+            data += struct.pack("<H", pixels[start])
+            literal_start = end
+        start = end
+    encode_literal(data, pixels[literal_start:])
+
+
+def encode_literal(data, pixels):
+    for start in range(0, len(pixels), MAX_COUNT):
+        part = pixels[start:start + MAX_COUNT]
+        encode_operation(data, LITERAL, len(part))
+        data += struct.pack(f"<{len(part)}H", *part)
+
+
+def encode_frame(frame, previous):
+    """The operations drawing `frame`, over `previous` for a delta frame or from scratch for a keyframe."""
+    data = bytearray()
+    if previous is None:
+        encode_pixels(data, frame)
+        return bytes(data)
+    position = 0
+    while position < len(frame):
+        start = position
+        while position < len(frame) and frame[position] == previous[position]:
+            position += 1
+        if position == len(frame):
+            # Whatever's left is unchanged, so there's no need to skip over it
+            break
+        for skip_start in range(start, position, MAX_COUNT):
+            encode_operation(data, SKIP, min(position - skip_start, MAX_COUNT))
+        start = position
+        while position < len(frame) and frame[position] != previous[position]:
+            position += 1
+        encode_pixels(data, frame[start:position])
+    return bytes(data)
+
+
+def encode(frames, size, fps, keyframe_interval, audio, audio_lead):
+    samples, channels, sample_rate = audio or (b"", 0, 0)
+    frame_bytes = channels * 2
+    # Sound running past the last frame is cut off with it
+    total_audio_frames = min(len(samples) // frame_bytes, len(frames) * sample_rate // fps) if channels else 0
+    if channels and sample_rate // fps + audio_lead * sample_rate // 1000 > AUDIO_RING_SIZE:
+        raise VideoError(f"{sample_rate} Hz audio at {fps} fps with a {audio_lead} ms lead overflows the player's "
+            f"{AUDIO_RING_SIZE} frame audio buffer; lower the sample rate or raise the frame rate")
+    chunks = []
+    previous = None
+    queued_audio = 0
+    for number, frame in enumerate(frames):
+        is_key = number % keyframe_interval == 0
+        video = encode_frame(frame, None if is_key else previous)
+        previous = frame
+        # Each chunk carries the sound up to the end of its frame plus the lead, so the speaker never waits on the
+        #   SD card; the last carries whatever's left
+        if number == len(frames) - 1:
+            audio_end = total_audio_frames
+        else:
+            audio_end = min(total_audio_frames, (number + 1) * sample_rate // fps + audio_lead * sample_rate // 1000)
+        audio_frames = audio_end - queued_audio
+        if audio_frames > 0xFFFF:
+            raise VideoError(f"frame {number} needs {audio_frames} audio frames; a chunk holds at most 65535")
+        audio_bytes = samples[queued_audio * frame_bytes:audio_end * frame_bytes]
+        queued_audio = audio_end
+        payload = audio_bytes + video
+        chunks.append((KEY_FRAME if is_key else DELTA_FRAME, audio_frames, len(video), payload))
+
+    # The chunks are word aligned so the player's reads land on aligned memory
+    sizes = [(CHUNK.size + len(payload) + 3) & ~3 for _, _, _, payload in chunks]
+    data = bytearray()
+    for number, (frame_type, audio_frames, video_size, payload) in enumerate(chunks):
+        next_size = sizes[number + 1] if number + 1 < len(chunks) else 0
+        chunk = CHUNK.pack(next_size, frame_type, 0, audio_frames, video_size) + payload
+        data += chunk + bytes(sizes[number] - len(chunk))
+    header = HEADER.pack(MAGIC, VERSION, channels, size[0], size[1], fps, len(frames), sample_rate, max(sizes), sizes[0],
+        SECTOR_SIZE)
+    return header + bytes(SECTOR_SIZE - len(header)) + bytes(data), sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("frames", nargs="+", help="PNG images, one per frame")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--fps", type=int, default=15)
+    parser.add_argument("--audio", help="16 bit PCM WAV soundtrack")
+    parser.add_argument("--keyframe-interval", type=int, default=30, help="frames between keyframes (default 30)")
+    parser.add_argument("--audio-lead", type=int, default=40,
+        help="milliseconds of sound each chunk carries beyond its own frame (default 40)")
+    args = parser.parse_args()
+
+    try:
+        if not 0 < args.fps <= 0xFFFF:
+            raise VideoError("the frame rate must be between 1 and 65535")
+        if args.keyframe_interval < 1:
+            raise VideoError("the keyframe interval must be at least 1")
+        frames, size = read_frames(args.frames)
+        audio = read_audio(args.audio) if args.audio else None
+        video, sizes = encode(frames, size, args.fps, args.keyframe_interval, audio, max(0, args.audio_lead))
+    except VideoError as error:
+        print(f"{args.output}: {error}", file=sys.stderr)
+        return 1
+    Path(args.output).write_bytes(video)
+    print(f"{args.output}: {len(frames)} frames at {size[0]}x{size[1]}, {len(video)} bytes, "
+        f"{sum(sizes) // len(sizes)} bytes per chunk on average, {max(sizes)} at most")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())